@@ -89,6 +89,7 @@ static char* _role_autocomplete(ProfWin *window, const char *const input, gboole
 static char* _resource_autocomplete(ProfWin *window, const char *const input, gboolean previous);
 static char* _wintitle_autocomplete(ProfWin *window, const char *const input, gboolean previous);
 static char* _inpblock_autocomplete(ProfWin *window, const char *const input, gboolean previous);
+static char* _scrollback_autocomplete(ProfWin *window, const char *const input, gboolean previous);
 static char* _time_autocomplete(ProfWin *window, const char *const input, gboolean previous);
 static char* _receipts_autocomplete(ProfWin *window, const char *const input, gboolean previous);
 static char* _help_autocomplete(ProfWin *window, const char *const input, gboolean previous);
@@ -198,6 +199,7 @@ static Autocomplete time_ac;
 static Autocomplete time_format_ac;
 static Autocomplete resource_ac;
 static Autocomplete inpblock_ac;
+static Autocomplete scrollback_ac;
 static Autocomplete receipts_ac;
 static Autocomplete pgp_ac;
 static Autocomplete pgp_log_ac;
@@ -231,6 +233,7 @@ static Autocomplete invite_ac;
 static Autocomplete status_ac;
 static Autocomplete status_state_ac;
 static Autocomplete logging_ac;
+static Autocomplete logging_sync_ac;
 static Autocomplete color_ac;
 
 void
@@ -751,6 +754,17 @@ cmd_ac_init(void)
     autocomplete_add(inpblock_ac, "timeout");
     autocomplete_add(inpblock_ac, "dynamic");
 
+    scrollback_ac = autocomplete_new();
+    autocomplete_add(scrollback_ac, "console");
+    autocomplete_add(scrollback_ac, "chat");
+    autocomplete_add(scrollback_ac, "muc");
+    autocomplete_add(scrollback_ac, "private");
+    autocomplete_add(scrollback_ac, "xmlconsole");
+    autocomplete_add(scrollback_ac, "config");
+    autocomplete_add(scrollback_ac, "plugin");
+    autocomplete_add(scrollback_ac, "memory");
+    autocomplete_add(scrollback_ac, "spill");
+
     receipts_ac = autocomplete_new();
     autocomplete_add(receipts_ac, "send");
     autocomplete_add(receipts_ac, "request");
@@ -908,6 +922,12 @@ cmd_ac_init(void)
     logging_ac = autocomplete_new();
     autocomplete_add(logging_ac, "chat");
     autocomplete_add(logging_ac, "group");
+    autocomplete_add(logging_ac, "sync");
+
+    logging_sync_ac = autocomplete_new();
+    autocomplete_add(logging_sync_ac, "none");
+    autocomplete_add(logging_sync_ac, "interval");
+    autocomplete_add(logging_sync_ac, "message");
 
     color_ac = autocomplete_new();
     autocomplete_add(color_ac, "on");
@@ -1189,6 +1209,7 @@ cmd_ac_reset(ProfWin *window)
     autocomplete_reset(time_format_ac);
     autocomplete_reset(resource_ac);
     autocomplete_reset(inpblock_ac);
+    autocomplete_reset(scrollback_ac);
     autocomplete_reset(receipts_ac);
     autocomplete_reset(pgp_ac);
     autocomplete_reset(pgp_log_ac);
@@ -1216,6 +1237,7 @@ cmd_ac_reset(ProfWin *window)
     autocomplete_reset(status_ac);
     autocomplete_reset(status_state_ac);
     autocomplete_reset(logging_ac);
+    autocomplete_reset(logging_sync_ac);
     autocomplete_reset(color_ac);
 
     autocomplete_reset(script_ac);
@@ -1329,6 +1351,7 @@ cmd_ac_uninit(void)
     autocomplete_free(time_format_ac);
     autocomplete_free(resource_ac);
     autocomplete_free(inpblock_ac);
+    autocomplete_free(scrollback_ac);
     autocomplete_free(receipts_ac);
     autocomplete_free(pgp_ac);
     autocomplete_free(pgp_log_ac);
@@ -1361,6 +1384,7 @@ cmd_ac_uninit(void)
     autocomplete_free(status_ac);
     autocomplete_free(status_state_ac);
     autocomplete_free(logging_ac);
+    autocomplete_free(logging_sync_ac);
     autocomplete_free(color_ac);
 }
 
@@ -1589,6 +1613,7 @@ _cmd_ac_complete_params(ProfWin *window, const char *const input, gboolean previ
     g_hash_table_insert(ac_funcs, "/resource",      _resource_autocomplete);
     g_hash_table_insert(ac_funcs, "/wintitle",      _wintitle_autocomplete);
     g_hash_table_insert(ac_funcs, "/inpblock",      _inpblock_autocomplete);
+    g_hash_table_insert(ac_funcs, "/scrollback",    _scrollback_autocomplete);
     g_hash_table_insert(ac_funcs, "/time",          _time_autocomplete);
     g_hash_table_insert(ac_funcs, "/receipts",      _receipts_autocomplete);
     g_hash_table_insert(ac_funcs, "/wins",          _wins_autocomplete);
@@ -2541,6 +2566,24 @@ _inpblock_autocomplete(ProfWin *window, const char *const input, gboolean previo
     return NULL;
 }
 
+static char*
+_scrollback_autocomplete(ProfWin *window, const char *const input, gboolean previous)
+{
+    char *found = NULL;
+
+    found = autocomplete_param_with_func(input, "/scrollback spill", prefs_autocomplete_boolean_choice, previous);
+    if (found) {
+        return found;
+    }
+
+    found = autocomplete_param_with_ac(input, "/scrollback", scrollback_ac, FALSE, previous);
+    if (found) {
+        return found;
+    }
+
+    return NULL;
+}
+
 static char*
 _form_autocomplete(ProfWin *window, const char *const input, gboolean previous)
 {
@@ -3617,6 +3660,11 @@ _logging_autocomplete(ProfWin *window, const char *const input, gboolean previou
         return result;
     }
 
+    result = autocomplete_param_with_ac(input, "/logging sync", logging_sync_ac, TRUE, previous);
+    if (result) {
+        return result;
+    }
+
     return NULL;
 }
 
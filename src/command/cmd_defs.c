@@ -1278,13 +1278,38 @@ static struct cmd_t command_defs[] =
             "/inpblock timeout <millis>",
             "/inpblock dynamic on|off")
         CMD_DESC(
-            "How long to wait for keyboard input before checking for new messages or checking for state changes such as 'idle'.")
+            "How long to wait for keyboard input or new messages before checking for state changes such as 'idle'. "
+            "Input and messages are handled as soon as they arrive, the dynamic setting only applies while the connection is being established.")
         CMD_ARGS(
             { "timeout <millis>", "Time to wait (1-1000) in milliseconds before reading input from the terminal buffer, default: 1000." },
             { "dynamic on|off", "Start with 0 millis and dynamically increase up to timeout when no activity, default: on." })
         CMD_NOEXAMPLES
     },
 
+    { "/scrollback",
+        parse_args, 2, 2, &cons_scrollback_setting,
+        CMD_NOSUBFUNCS
+        CMD_MAINFUNC(cmd_scrollback)
+        CMD_TAGS(
+            CMD_TAG_UI)
+        CMD_SYN(
+            "/scrollback console|chat|muc|private|xmlconsole|config|plugin <lines>",
+            "/scrollback memory <kilobytes>",
+            "/scrollback spill on|off")
+        CMD_DESC(
+            "Limit how much history windows keep in memory. "
+            "Older entries are discarded, or written to a scrollback file in the data directory when spill is enabled, "
+            "from where paging up past the top of a window brings them back.")
+        CMD_ARGS(
+            { "console|chat|muc|private|xmlconsole|config|plugin <lines>", "Entries kept in memory for new windows of that type (100-100000), default: 1200." },
+            { "memory <kilobytes>", "Total memory for all windows, trimming the largest windows first, 0 for no limit, default: 0." },
+            { "spill on|off", "Write entries leaving memory to a scrollback file instead of discarding them, default: off." })
+        CMD_EXAMPLES(
+            "/scrollback muc 300",
+            "/scrollback memory 65536",
+            "/scrollback spill on")
+    },
+
     { "/titlebar",
         parse_args, 1, 2, &cons_titlebar_setting,
         CMD_SUBFUNCS(
@@ -1604,18 +1629,24 @@ static struct cmd_t command_defs[] =
         CMD_TAGS(
             CMD_TAG_CHAT)
         CMD_SYN(
-            "/logging chat|group on|off")
+            "/logging chat|group on|off",
+            "/logging sync none|interval|message")
         CMD_DESC(
             "Switch logging on or off. "
             "Chat logging will be enabled if /history is set to on. "
-            "When disabling this option, /history will also be disabled. ")
+            "When disabling this option, /history will also be disabled. "
+            "Log files are kept open and written in batches, the sync setting controls how often they are forced to disk.")
         CMD_ARGS(
             { "chat", "Regular chat logging" },
             { "group", "Groupchat (room) logging" },
-            { "on|off", "Enable or disable logging." })
+            { "on|off", "Enable or disable logging." },
+            { "sync none", "Never force logs to disk, buffered lines are still written out every few seconds." },
+            { "sync interval", "Write out and sync logs to disk every few seconds, the default." },
+            { "sync message", "Write out and sync logs to disk after every message." })
         CMD_EXAMPLES(
             "/logging chat on",
-            "/logging group off" )
+            "/logging group off",
+            "/logging sync message" )
     },
 
     { "/states",
@@ -2141,6 +2172,33 @@ static struct cmd_t command_defs[] =
             "/theme load forest")
     },
 
+    { "/search",
+        parse_args_with_freetext, 0, 1, NULL,
+        CMD_NOSUBFUNCS
+        CMD_MAINFUNC(cmd_search)
+        CMD_TAGS(
+            CMD_TAG_CHAT,
+            CMD_TAG_GROUPCHAT)
+        CMD_SYN(
+            "/search [<words>] [with:<contact>] [room:<room>] [since:<date>] [until:<date>]")
+        CMD_DESC(
+            "Search the chat and groupchat logs and show the most recent matches in the search window. "
+            "Every word must match, case is ignored. "
+            "The logs are indexed in the background, so new messages may take a few seconds to be found. "
+            "Text typed into the search window runs a new search.")
+        CMD_ARGS(
+            { "<words>", "Words to search for." },
+            { "with:<contact>", "Only search chats with this contact." },
+            { "room:<room>", "Only search this room." },
+            { "since:<date>", "Only search messages on or after this date, as YYYY-MM-DD." },
+            { "until:<date>", "Only search messages on or before this date, as YYYY-MM-DD." })
+        CMD_EXAMPLES(
+            "/search",
+            "/search release date",
+            "/search with:buddy@server.org holiday",
+            "/search room:dev@conference.server.org since:2019-01-01 until:2019-06-30 crash")
+    },
+
     { "/xmlconsole",
         parse_args, 0, 0, NULL,
         CMD_NOSUBFUNCS
@@ -5932,6 +5932,65 @@ cmd_inpblock(ProfWin *window, const char *const command, gchar **args)
     return TRUE;
 }
 
+gboolean
+cmd_scrollback(ProfWin *window, const char *const command, gchar **args)
+{
+    char *subcmd = args[0];
+    char *value = args[1];
+
+    if (g_strcmp0(subcmd, "spill") == 0) {
+        if (g_strcmp0(value, "on") != 0 && g_strcmp0(value, "off") != 0) {
+            cons_bad_cmd_usage(command);
+            return TRUE;
+        }
+
+        _cmd_set_boolean_preference(value, command, "Scrollback spill", PREF_SCROLLBACK_SPILL);
+        ui_scrollback_update();
+        return TRUE;
+    }
+
+    if (g_strcmp0(subcmd, "memory") == 0) {
+        int intval = 0;
+        char *err_msg = NULL;
+        gboolean res = strtoi_range(value, &intval, 0, G_MAXINT / 1024, &err_msg);
+        if (res) {
+            if (intval == 0) {
+                cons_show("Scrollback memory limit disabled.");
+            } else {
+                cons_show("Scrollback memory limit set to %d kilobytes.", intval);
+            }
+            prefs_set_scrollback_memory(intval);
+            ui_scrollback_update();
+        } else {
+            cons_show(err_msg);
+            free(err_msg);
+        }
+
+        return TRUE;
+    }
+
+    if (g_strcmp0(subcmd, "console") == 0 || g_strcmp0(subcmd, "chat") == 0 || g_strcmp0(subcmd, "muc") == 0 ||
+            g_strcmp0(subcmd, "private") == 0 || g_strcmp0(subcmd, "xmlconsole") == 0 ||
+            g_strcmp0(subcmd, "config") == 0 || g_strcmp0(subcmd, "plugin") == 0) {
+        int intval = 0;
+        char *err_msg = NULL;
+        gboolean res = strtoi_range(value, &intval, PREFS_MIN_SCROLLBACK, PREFS_MAX_SCROLLBACK, &err_msg);
+        if (res) {
+            cons_show("Scrollback for new %s windows set to %d entries.", subcmd, intval);
+            prefs_set_scrollback(subcmd, intval);
+        } else {
+            cons_show(err_msg);
+            free(err_msg);
+        }
+
+        return TRUE;
+    }
+
+    cons_bad_cmd_usage(command);
+
+    return TRUE;
+}
+
 gboolean
 cmd_titlebar(ProfWin *window, const char *const command, gchar **args)
 {
@@ -6290,6 +6349,7 @@ cmd_log(ProfWin *window, const char *const command, gchar **args)
         gboolean res = strtoi_range(value, &intval, PREFS_MIN_LOG_SIZE, INT_MAX, &err_msg);
         if (res) {
             prefs_set_max_log_size(intval);
+            log_reinit();
             cons_show("Log maximum size set to %d bytes", intval);
         } else {
             cons_show(err_msg);
@@ -6304,6 +6364,7 @@ cmd_log(ProfWin *window, const char *const command, gchar **args)
             return TRUE;
         }
         _cmd_set_boolean_preference(value, command, "Log rotate", PREF_LOG_ROTATE);
+        log_reinit();
         return TRUE;
     }
 
@@ -6592,6 +6653,22 @@ cmd_xmlconsole(ProfWin *window, const char *const command, gchar **args)
     return TRUE;
 }
 
+gboolean
+cmd_search(ProfWin *window, const char *const command, gchar **args)
+{
+    ProfSearchWin *searchwin = wins_get_search();
+    if (searchwin == NULL) {
+        searchwin = (ProfSearchWin*)wins_new_search();
+    }
+    ui_focus_win((ProfWin*)searchwin);
+
+    if (args[0]) {
+        searchwin_search(searchwin, args[0]);
+    }
+
+    return TRUE;
+}
+
 gboolean
 cmd_flash(ProfWin *window, const char *const command, gchar **args)
 {
@@ -6721,6 +6798,14 @@ cmd_logging(ProfWin *window, const char *const command, gchar **args)
         }
     } else if (strcmp(args[0], "group") == 0) {
         _cmd_set_boolean_preference(args[1], command, "Groupchat logging", PREF_GRLOG);
+    } else if (strcmp(args[0], "sync") == 0) {
+        if ((g_strcmp0(args[1], "none") != 0) && (g_strcmp0(args[1], "interval") != 0) && (g_strcmp0(args[1], "message") != 0)) {
+            cons_bad_cmd_usage(command);
+            return TRUE;
+        }
+        prefs_set_string(PREF_LOG_SYNC, args[1]);
+        chat_log_flush();
+        cons_show("Log sync set to: %s.", args[1]);
     } else {
         cons_bad_cmd_usage(command);
     }
@@ -8000,7 +8085,7 @@ _cmd_execute_default(ProfWin *window, const char *inp)
     }
 
     // handle non commands in non chat or plugin windows
-    if (window->type != WIN_CHAT && window->type != WIN_MUC && window->type != WIN_PRIVATE && window->type != WIN_PLUGIN && window->type != WIN_XML) {
+    if (window->type != WIN_CHAT && window->type != WIN_MUC && window->type != WIN_PRIVATE && window->type != WIN_PLUGIN && window->type != WIN_XML && window->type != WIN_SEARCH) {
         cons_show("Unknown command: %s", inp);
         return TRUE;
     }
@@ -8012,6 +8097,12 @@ _cmd_execute_default(ProfWin *window, const char *inp)
         return TRUE;
     }
 
+    // handle search window, searching does not need a connection
+    if (window->type == WIN_SEARCH) {
+        searchwin_search((ProfSearchWin*)window, inp);
+        return TRUE;
+    }
+
     jabber_conn_status_t status = connection_get_status();
     if (status != JABBER_CONNECTED) {
         win_println(window, THEME_DEFAULT, '-', "You are not currently connected.");
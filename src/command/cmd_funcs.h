@@ -130,6 +130,7 @@ gboolean cmd_who(ProfWin *window, const char *const command, gchar **args);
 gboolean cmd_win(ProfWin *window, const char *const command, gchar **args);
 gboolean cmd_alias(ProfWin *window, const char *const command, gchar **args);
 gboolean cmd_xmlconsole(ProfWin *window, const char *const command, gchar **args);
+gboolean cmd_search(ProfWin *window, const char *const command, gchar **args);
 gboolean cmd_ping(ProfWin *window, const char *const command, gchar **args);
 gboolean cmd_form(ProfWin *window, const char *const command, gchar **args);
 gboolean cmd_occupants(ProfWin *window, const char *const command, gchar **args);
@@ -144,6 +145,7 @@ gboolean cmd_wrap(ProfWin *window, const char *const command, gchar **args);
 gboolean cmd_time(ProfWin *window, const char *const command, gchar **args);
 gboolean cmd_resource(ProfWin *window, const char *const command, gchar **args);
 gboolean cmd_inpblock(ProfWin *window, const char *const command, gchar **args);
+gboolean cmd_scrollback(ProfWin *window, const char *const command, gchar **args);
 gboolean cmd_titlebar(ProfWin *window, const char *const command, gchar **args);
 gboolean cmd_titlebar_show_hide(ProfWin *window, const char *const command, gchar **args);
 gboolean cmd_mainwin(ProfWin *window, const char *const command, gchar **args);
@@ -405,38 +405,43 @@ is_notify_enabled(void)
 GSList*
 prof_occurrences(const char *const needle, const char *const haystack, int offset, gboolean whole_word, GSList **result)
 {
-    if (needle == NULL || haystack == NULL) {
+    if (needle == NULL || haystack == NULL || needle[0] == '\0') {
         return *result;
     }
 
-    gchar *haystack_curr = g_utf8_offset_to_pointer(haystack, offset);
-    if (g_str_has_prefix(haystack_curr, needle)) {
+    // a plain scan, compiling a matcher for a single needle costs more than it saves
+    gsize needle_len = strlen(needle);
+    GSList *found = NULL;
+    const gchar *prev = g_utf8_offset_to_pointer(haystack, offset);
+    const gchar *match = strstr(prev, needle);
+    while (match) {
+        offset += g_utf8_pointer_to_offset(prev, match);
+        prev = match;
+
+        gboolean matched = TRUE;
         if (whole_word) {
             gunichar before = 0;
-            gchar *haystack_before_ch = g_utf8_find_prev_char(haystack, haystack_curr);
-            if (haystack_before_ch) {
-                before = g_utf8_get_char(haystack_before_ch);
+            gchar *before_ch = g_utf8_find_prev_char(haystack, match);
+            if (before_ch) {
+                before = g_utf8_get_char(before_ch);
             }
 
             gunichar after = 0;
-            gchar *haystack_after_ch = haystack_curr + strlen(needle);
-            if (haystack_after_ch[0] != '\0') {
-                after = g_utf8_get_char(haystack_after_ch);
+            if (match[needle_len] != '\0') {
+                after = g_utf8_get_char(match + needle_len);
             }
 
-            if (!g_unichar_isalnum(before) && !g_unichar_isalnum(after)) {
-                *result = g_slist_append(*result, GINT_TO_POINTER(offset));
-            }
-        } else {
-            *result = g_slist_append(*result, GINT_TO_POINTER(offset));
+            matched = !g_unichar_isalnum(before) && !g_unichar_isalnum(after);
+        }
+        if (matched) {
+            found = g_slist_prepend(found, GINT_TO_POINTER(offset));
         }
-    }
 
-    offset++;
-    if (g_strcmp0(g_utf8_offset_to_pointer(haystack, offset), "\0") != 0) {
-        *result = prof_occurrences(needle, haystack, offset, whole_word, result);
+        match = strstr(g_utf8_next_char(match), needle);
     }
 
+    *result = g_slist_concat(*result, g_slist_reverse(found));
+
     return *result;
 }
 
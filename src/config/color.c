@@ -57,8 +57,18 @@ struct color_pair_cache
     struct { int16_t fg, bg; } *pairs;
     int size;
     int capacity;
+    /* (fg, bg) key to pair id + 1 */
+    GHashTable *index;
+    /* per profile, hashed string to pair id + 1 */
+    GHashTable *hashed[COLOR_PROFILE_BLUE_BLINDNESS + 1];
 } cache = {0};
 
+/* bound on hashed strings remembered per profile */
+#define COLOR_HASH_CACHE_MAX 2048
+
+/* -1 (default) to 255 fit in 16 bits once offset */
+#define PAIR_KEY(fg, bg) GINT_TO_POINTER((((fg) + 1) << 16) | ((bg) + 1))
+
 /*
  * xterm default 256 colors
  * XXX: there are many duplicates... (eg blue3)
@@ -424,9 +434,28 @@ static int color_hash(const char *str, color_profile profile)
 
 void color_pair_cache_reset(void)
 {
+    int i;
+
+    /* pair ids are reassigned, so forget the strings hashed to them */
+    for (i = 0; i <= COLOR_PROFILE_BLUE_BLINDNESS; i++) {
+        if (cache.hashed[i]) {
+            g_hash_table_remove_all(cache.hashed[i]);
+        } else {
+            cache.hashed[i] = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+        }
+    }
+
+    if (cache.index) {
+        g_hash_table_remove_all(cache.index);
+    } else {
+        cache.index = g_hash_table_new(g_direct_hash, g_direct_equal);
+    }
+
     if (cache.pairs) {
         free(cache.pairs);
-        memset(&cache, 0, sizeof(cache));
+        cache.pairs = NULL;
+        cache.size = 0;
+        cache.capacity = 0;
     }
 
     /*
@@ -445,6 +474,7 @@ void color_pair_cache_reset(void)
         cache.pairs[0].fg = -1;
         cache.pairs[0].bg = -1;
         cache.size = 1;
+        g_hash_table_insert(cache.index, PAIR_KEY(-1, -1), GINT_TO_POINTER(1));
     } else {
         log_error("Color: unable to allocate memory");
     }
@@ -462,10 +492,9 @@ static int _color_pair_cache_get(int fg, int bg)
     }
 
     /* try to find pair in cache */
-    for (i = 0; i < cache.size; i++) {
-        if (fg == cache.pairs[i].fg && bg == cache.pairs[i].bg) {
-            return i;
-        }
+    gpointer found = cache.index ? g_hash_table_lookup(cache.index, PAIR_KEY(fg, bg)) : NULL;
+    if (found) {
+        return GPOINTER_TO_INT(found) - 1;
     }
 
     /* otherwise cache new pair */
@@ -481,6 +510,7 @@ static int _color_pair_cache_get(int fg, int bg)
     cache.pairs[i].bg = bg;
     /* (re-)define the new pair in curses */
     init_pair(i, fg, bg);
+    g_hash_table_insert(cache.index, PAIR_KEY(fg, bg), GINT_TO_POINTER(i + 1));
 
     cache.size++;
 
@@ -498,10 +528,25 @@ static int _color_pair_cache_get(int fg, int bg)
  */
 int color_pair_cache_hash_str(const char *str, color_profile profile)
 {
+    /* remembered per string, the sha1 and palette search are costly */
+    GHashTable *hashed = cache.hashed[profile];
+    gpointer found = hashed ? g_hash_table_lookup(hashed, str) : NULL;
+    if (found) {
+        return GPOINTER_TO_INT(found) - 1;
+    }
+
     int fg = color_hash(str, profile);
     int bg = -1;
 
-    return _color_pair_cache_get(fg, bg);
+    int pair = _color_pair_cache_get(fg, bg);
+    if (hashed && pair >= 0) {
+        if (g_hash_table_size(hashed) >= COLOR_HASH_CACHE_MAX) {
+            g_hash_table_remove_all(hashed);
+        }
+        g_hash_table_insert(hashed, g_strdup(str), GINT_TO_POINTER(pair + 1));
+    }
+
+    return pair;
 }
 
 /**
@@ -55,6 +55,8 @@
 #define DIR_PGP "pgp"
 #define DIR_OMEMO "omemo"
 #define DIR_PLUGINS "plugins"
+#define DIR_SCROLLBACK "scrollback"
+#define DIR_SEARCH "searchindex"
 
 void files_create_directories(void);
 
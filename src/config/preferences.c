@@ -47,6 +47,7 @@
 #include "log.h"
 #include "preferences.h"
 #include "tools/autocomplete.h"
+#include "tools/matcher.h"
 #include "config/files.h"
 #include "config/conflists.h"
 
@@ -65,6 +66,7 @@
 #define PREF_GROUP_PLUGINS "plugins"
 
 #define INPBLOCK_DEFAULT 1000
+#define SCROLLBACK_DEFAULT 1200
 
 static char *prefs_loc;
 static GKeyFile *prefs;
@@ -73,11 +75,32 @@ gint log_maxsize = 0;
 static Autocomplete boolean_choice_ac;
 static Autocomplete room_trigger_ac;
 
+// room triggers compiled into one matcher over their lowercase form, built on
+// first use and dropped whenever the trigger list changes
+static gchar **room_triggers;
+static gsize room_triggers_len;
+static Matcher room_trigger_matcher;
+
+// typed copy of the enum preferences, filled in on first read so that hot
+// paths such as printing a line do not go through the GKeyFile each time
+typedef struct prefs_snapshot_t {
+    gboolean boolean_loaded;
+    gboolean boolean;
+    gboolean string_loaded;
+    char *string;
+} PrefsSnapshot;
+
+static PrefsSnapshot snapshot[PREF_COUNT];
+
 static void _save_prefs(void);
 static const char* _get_group(preference_t pref);
 static const char* _get_key(preference_t pref);
 static gboolean _get_default_boolean(preference_t pref);
 static char* _get_default_string(preference_t pref);
+static void _snapshot_invalidate(preference_t pref);
+static void _snapshot_invalidate_all(void);
+static void _room_triggers_invalidate(void);
+static void _room_triggers_build(void);
 
 void _prefs_load(void)
 {
@@ -175,6 +198,8 @@ prefs_reload(void)
     g_key_file_load_from_file(prefs, prefs_loc, G_KEY_FILE_KEEP_COMMENTS, NULL);
 
     _prefs_load();
+    _snapshot_invalidate_all();
+    _room_triggers_invalidate();
 }
 
 void
@@ -195,6 +220,8 @@ prefs_load(char *config_file)
     g_key_file_load_from_file(prefs, prefs_loc, G_KEY_FILE_KEEP_COMMENTS, NULL);
 
     _prefs_load();
+    _snapshot_invalidate_all();
+    _room_triggers_invalidate();
 }
 
 void
@@ -208,6 +235,8 @@ prefs_close(void)
 {
     autocomplete_free(boolean_choice_ac);
     autocomplete_free(room_trigger_ac);
+    _snapshot_invalidate_all();
+    _room_triggers_invalidate();
 
     g_key_file_free(prefs);
     prefs = NULL;
@@ -257,23 +286,38 @@ prefs_do_chat_notify(gboolean current_win)
 GList*
 prefs_message_get_triggers(const char *const message)
 {
-    GList *result = NULL;
+    if (room_trigger_matcher == NULL) {
+        _room_triggers_build();
+    }
+    if (room_triggers_len == 0) {
+        return NULL;
+    }
+
+    gboolean *found = g_new0(gboolean, room_triggers_len);
 
     char *message_lower = g_utf8_strdown(message, -1);
-    gsize len = 0;
-    gchar **triggers = g_key_file_get_string_list(prefs, PREF_GROUP_NOTIFICATIONS, "room.trigger.list", &len, NULL);
+    GSList *hits = matcher_find(room_trigger_matcher, message_lower);
+    g_free(message_lower);
+
+    GSList *curr = hits;
+    while (curr) {
+        MatcherHit *hit = curr->data;
+        found[hit->id] = TRUE;
+        curr = g_slist_next(curr);
+    }
+    g_slist_free_full(hits, free);
+
+    GList *result = NULL;
     int i;
-    for (i = 0; i < len; i++) {
-        char *trigger_lower = g_utf8_strdown(triggers[i], -1);
-        if (g_strrstr(message_lower, trigger_lower)) {
-            result = g_list_append(result, strdup(triggers[i]));
+    for (i = 0; i < room_triggers_len; i++) {
+        // an empty trigger matches any message
+        if (found[i] || room_triggers[i][0] == '\0') {
+            result = g_list_prepend(result, strdup(room_triggers[i]));
         }
-        g_free(trigger_lower);
     }
-    g_strfreev(triggers);
-    g_free(message_lower);
+    g_free(found);
 
-    return result;
+    return g_list_reverse(result);
 }
 
 gboolean
@@ -430,15 +474,22 @@ prefs_reset_room_notify(const char *const roomjid)
 gboolean
 prefs_get_boolean(preference_t pref)
 {
+    PrefsSnapshot *cached = &snapshot[pref];
+    if (cached->boolean_loaded) {
+        return cached->boolean;
+    }
+
     const char *group = _get_group(pref);
     const char *key = _get_key(pref);
-    gboolean def = _get_default_boolean(pref);
 
     if (!g_key_file_has_key(prefs, group, key, NULL)) {
-        return def;
+        cached->boolean = _get_default_boolean(pref);
+    } else {
+        cached->boolean = g_key_file_get_boolean(prefs, group, key, NULL);
     }
+    cached->boolean_loaded = TRUE;
 
-    return g_key_file_get_boolean(prefs, group, key, NULL);
+    return cached->boolean;
 }
 
 void
@@ -447,26 +498,39 @@ prefs_set_boolean(preference_t pref, gboolean value)
     const char *group = _get_group(pref);
     const char *key = _get_key(pref);
     g_key_file_set_boolean(prefs, group, key, value);
+    _snapshot_invalidate(pref);
 }
 
 char*
 prefs_get_string(preference_t pref)
 {
+    return g_strdup(prefs_get_string_cached(pref));
+}
+
+// the returned string is owned by the preferences and only valid until the
+// preference is next set or the preferences are reloaded
+const char*
+prefs_get_string_cached(preference_t pref)
+{
+    PrefsSnapshot *cached = &snapshot[pref];
+    if (cached->string_loaded) {
+        return cached->string;
+    }
+
     const char *group = _get_group(pref);
     const char *key = _get_key(pref);
-    char *def = _get_default_string(pref);
-
     char *result = g_key_file_get_string(prefs, group, key, NULL);
 
     if (result == NULL) {
+        char *def = _get_default_string(pref);
         if (def) {
-            return g_strdup(def);
-        } else {
-            return NULL;
+            result = g_strdup(def);
         }
-    } else {
-        return result;
     }
+    cached->string = result;
+    cached->string_loaded = TRUE;
+
+    return cached->string;
 }
 
 void
@@ -487,6 +551,7 @@ prefs_set_string(preference_t pref, char *value)
     } else {
         g_key_file_set_string(prefs, group, key, value);
     }
+    _snapshot_invalidate(pref);
 }
 
 char*
@@ -867,6 +932,40 @@ prefs_get_roster_size(void)
     }
 }
 
+void
+prefs_set_scrollback(const char *const wintype, gint value)
+{
+    char *key = g_strdup_printf("scrollback.%s", wintype);
+    g_key_file_set_integer(prefs, PREF_GROUP_UI, key, value);
+    g_free(key);
+}
+
+gint
+prefs_get_scrollback(const char *const wintype)
+{
+    char *key = g_strdup_printf("scrollback.%s", wintype);
+    gint result = g_key_file_get_integer(prefs, PREF_GROUP_UI, key, NULL);
+    g_free(key);
+
+    if (result < PREFS_MIN_SCROLLBACK || result > PREFS_MAX_SCROLLBACK) {
+        return SCROLLBACK_DEFAULT;
+    } else {
+        return result;
+    }
+}
+
+void
+prefs_set_scrollback_memory(gint value)
+{
+    g_key_file_set_integer(prefs, PREF_GROUP_UI, "scrollback.memory", value);
+}
+
+gint
+prefs_get_scrollback_memory(void)
+{
+    return g_key_file_get_integer(prefs, PREF_GROUP_UI, "scrollback.memory", NULL);
+}
+
 char
 prefs_get_otr_char(void)
 {
@@ -1207,6 +1306,7 @@ prefs_add_room_notify_trigger(const char * const text)
 
     if (res) {
         autocomplete_add(room_trigger_ac, text);
+        _room_triggers_invalidate();
     }
 
     return res;
@@ -1220,6 +1320,7 @@ prefs_remove_room_notify_trigger(const char * const text)
 
     if (res) {
         autocomplete_remove(room_trigger_ac, text);
+        _room_triggers_invalidate();
     }
 
     return res;
@@ -1643,6 +1744,53 @@ _save_prefs(void)
     g_free(g_prefs_data);
 }
 
+static void
+_snapshot_invalidate(preference_t pref)
+{
+    g_free(snapshot[pref].string);
+    snapshot[pref].string = NULL;
+    snapshot[pref].string_loaded = FALSE;
+    snapshot[pref].boolean_loaded = FALSE;
+}
+
+static void
+_snapshot_invalidate_all(void)
+{
+    int i;
+    for (i = 0; i < PREF_COUNT; i++) {
+        _snapshot_invalidate(i);
+    }
+}
+
+static void
+_room_triggers_invalidate(void)
+{
+    matcher_free(room_trigger_matcher);
+    room_trigger_matcher = NULL;
+    g_strfreev(room_triggers);
+    room_triggers = NULL;
+    room_triggers_len = 0;
+}
+
+static void
+_room_triggers_build(void)
+{
+    _room_triggers_invalidate();
+
+    room_triggers = g_key_file_get_string_list(prefs, PREF_GROUP_NOTIFICATIONS, "room.trigger.list", &room_triggers_len, NULL);
+    if (room_triggers == NULL) {
+        room_triggers_len = 0;
+    }
+
+    room_trigger_matcher = matcher_new();
+    int i;
+    for (i = 0; i < room_triggers_len; i++) {
+        char *trigger_lower = g_utf8_strdown(room_triggers[i], -1);
+        matcher_add(room_trigger_matcher, trigger_lower, i, FALSE);
+        g_free(trigger_lower);
+    }
+}
+
 // get the preference group for a specific preference
 // for example the PREF_BEEP setting ("beep" in .profrc, see _get_key) belongs
 // to the [ui] section.
@@ -1718,6 +1866,7 @@ _get_group(preference_t pref)
         case PREF_STATUSBAR_SELF:
         case PREF_STATUSBAR_CHAT:
         case PREF_STATUSBAR_ROOM:
+        case PREF_SCROLLBACK_SPILL:
             return PREF_GROUP_UI;
         case PREF_STATES:
         case PREF_OUTTYPE:
@@ -1743,6 +1892,7 @@ _get_group(preference_t pref)
         case PREF_GRLOG:
         case PREF_LOG_ROTATE:
         case PREF_LOG_SHARED:
+        case PREF_LOG_SYNC:
             return PREF_GROUP_LOGGING;
         case PREF_AUTOAWAY_CHECK:
         case PREF_AUTOAWAY_MODE:
@@ -1884,6 +2034,8 @@ _get_key(preference_t pref)
             return "rotate";
         case PREF_LOG_SHARED:
             return "shared";
+        case PREF_LOG_SYNC:
+            return "sync";
         case PREF_PRESENCE:
             return "presence";
         case PREF_WRAP:
@@ -1998,6 +2150,8 @@ _get_key(preference_t pref)
             return "log";
         case PREF_OMEMO_POLICY:
             return "policy";
+        case PREF_SCROLLBACK_SPILL:
+            return "scrollback.spill";
         default:
             return NULL;
     }
@@ -2064,6 +2218,8 @@ _get_default_string(preference_t pref)
             return "off";
         case PREF_OTR_LOG:
             return "redact";
+        case PREF_LOG_SYNC:
+            return "interval";
         case PREF_OTR_POLICY:
             return "manual";
         case PREF_STATUSES_CONSOLE:
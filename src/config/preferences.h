@@ -44,6 +44,9 @@
 #define PREFS_MIN_LOG_SIZE 64
 #define PREFS_MAX_LOG_SIZE 1048580
 
+#define PREFS_MIN_SCROLLBACK 100
+#define PREFS_MAX_SCROLLBACK 100000
+
 // represents all settings in .profrc
 // each enum value is mapped to a group and key in .profrc (see preferences.c)
 typedef enum {
@@ -157,6 +160,10 @@ typedef enum {
     PREF_OMEMO_LOG,
     PREF_OMEMO_POLICY,
     PREF_OCCUPANTS_WRAP,
+    PREF_SCROLLBACK_SPILL,
+    PREF_LOG_SYNC,
+    // number of preferences, keep last
+    PREF_COUNT
 } preference_t;
 
 typedef struct prof_alias_t {
@@ -213,6 +220,11 @@ gint prefs_get_occupants_size(void);
 void prefs_set_roster_size(gint value);
 gint prefs_get_roster_size(void);
 
+void prefs_set_scrollback(const char *const wintype, gint value);
+gint prefs_get_scrollback(const char *const wintype);
+void prefs_set_scrollback_memory(gint value);
+gint prefs_get_scrollback_memory(void);
+
 gint prefs_get_autoaway_time(void);
 void prefs_set_autoaway_time(gint value);
 gint prefs_get_autoxa_time(void);
@@ -296,6 +308,7 @@ void prefs_save_win_placement(ProfWinPlacement *placement);
 gboolean prefs_get_boolean(preference_t pref);
 void prefs_set_boolean(preference_t pref, gboolean value);
 char* prefs_get_string(preference_t pref);
+const char* prefs_get_string_cached(preference_t pref);
 void prefs_free_string(char *pref);
 void prefs_set_string(preference_t pref, char *value);
 
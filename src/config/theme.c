@@ -59,10 +59,17 @@ static GKeyFile *theme;
 static GHashTable *bold_items;
 static GHashTable *defaults;
 
+// ncurses attributes of each theme item, resolved on its first lookup after
+// the theme or colours change
+static int attrs_table[THEME_COUNT];
+static gboolean attrs_resolved[THEME_COUNT];
+
 static void _load_preferences(void);
 void _theme_list_dir(const gchar *const dir, GSList **result);
 static GString* _theme_find(const char *const theme_name);
 static gboolean _theme_load_file(const char *const theme_name);
+static int _theme_resolve_attrs(theme_item_t attrs);
+static void _theme_invalidate_attrs(void);
 
 void
 theme_init(const char *const theme_name)
@@ -153,6 +160,7 @@ theme_init(const char *const theme_name)
     g_hash_table_insert(defaults, strdup("untrusted"),               strdup("red"));
     g_hash_table_insert(defaults, strdup("cmd.wins.unread"),         strdup("default"));
 
+    _theme_invalidate_attrs();
     _load_preferences();
 }
 
@@ -176,6 +184,7 @@ gboolean
 theme_load(const char *const theme_name)
 {
     color_pair_cache_reset();
+    _theme_invalidate_attrs();
 
     if (_theme_load_file(theme_name)) {
         _load_preferences();
@@ -251,6 +260,7 @@ theme_close(void)
         g_hash_table_destroy(defaults);
         defaults = NULL;
     }
+    _theme_invalidate_attrs();
 }
 
 void
@@ -258,6 +268,7 @@ theme_init_colours(void)
 {
     assume_default_colors(-1, -1);
     color_pair_cache_reset();
+    _theme_invalidate_attrs();
 }
 
 static void
@@ -661,19 +672,35 @@ theme_hash_attrs(const char *str)
 {
     color_profile profile = COLOR_PROFILE_DEFAULT;
 
-    char *color_pref = prefs_get_string(PREF_COLOR_NICK);
-    if (strcmp(color_pref, "redgreen") == 0) {
+    const char *color_pref = prefs_get_string_cached(PREF_COLOR_NICK);
+    if (g_strcmp0(color_pref, "redgreen") == 0) {
         profile = COLOR_PROFILE_REDGREEN_BLINDNESS;
-    } else if (strcmp(color_pref, "blue") == 0) {
+    } else if (g_strcmp0(color_pref, "blue") == 0) {
         profile = COLOR_PROFILE_BLUE_BLINDNESS;
     }
-    prefs_free_string(color_pref);
 
     return COLOR_PAIR(color_pair_cache_hash_str(str, profile));
 }
 
 int
 theme_attrs(theme_item_t attrs)
+{
+    if (!attrs_resolved[attrs]) {
+        attrs_table[attrs] = _theme_resolve_attrs(attrs);
+        attrs_resolved[attrs] = TRUE;
+    }
+
+    return attrs_table[attrs];
+}
+
+static void
+_theme_invalidate_attrs(void)
+{
+    memset(attrs_resolved, 0, sizeof(attrs_resolved));
+}
+
+static int
+_theme_resolve_attrs(theme_item_t attrs)
 {
     int result = 0;
 
@@ -139,6 +139,8 @@ typedef enum {
     THEME_MAGENTA_BOLD,
     THEME_TEXT_HISTORY,
     THEME_CMD_WINS_UNREAD,
+    // number of theme items, keep last
+    THEME_COUNT
 } theme_item_t;
 
 void theme_init(const char *const theme_name);
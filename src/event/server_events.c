@@ -321,14 +321,8 @@ sv_ev_room_message(ProfMessage *message)
 
     gboolean whole_word = prefs_get_boolean(PREF_NOTIFY_MENTION_WHOLE_WORD);
     gboolean case_sensitive = prefs_get_boolean(PREF_NOTIFY_MENTION_CASE_SENSITIVE);
-    char *message_search = case_sensitive ? strdup(message->plain) : g_utf8_strdown(message->plain, -1);
-    char *mynick_search = case_sensitive ? strdup(mynick) : g_utf8_strdown(mynick, -1);
-
-    GSList *mentions = NULL;
-    mentions = prof_occurrences(mynick_search, message_search, 0, whole_word, &mentions);
-    gboolean mention = g_slist_length(mentions) > 0;
-    g_free(message_search);
-    g_free(mynick_search);
+    GSList *mentions = muc_nick_mentions(mucwin->roomjid, message->plain, whole_word, case_sensitive);
+    gboolean mention = mentions != NULL;
 
     GList *triggers = prefs_message_get_triggers(message->plain);
 
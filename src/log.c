@@ -37,33 +37,51 @@
 #include <assert.h>
 #include <errno.h>
 #include <fcntl.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #include <unistd.h>
+#include <sys/stat.h>
 
 #include "glib.h"
 #include "glib/gstdio.h"
 
 #include "log.h"
 #include "common.h"
+#include "search.h"
 #include "config/files.h"
 #include "config/preferences.h"
+#include "tools/history_file.h"
+#include "tools/log_writer.h"
 #include "xmpp/xmpp.h"
 #include "xmpp/muc.h"
 
 #define PROF "prof"
 
-static FILE *logp;
+// open chat log handles kept at once, least recently written closed first
+#define CHAT_LOG_MAX_OPEN 32
+// seconds between flushes of buffered chat log lines
+#define CHAT_LOG_FLUSH_INTERVAL 5
+// records queued for the writer thread before producers wait for space
+#define CHAT_LOG_QUEUE_MAX 4096
+// milliseconds a producer waits for queue space before dropping a record
+#define CHAT_LOG_QUEUE_WAIT 100
+// main log messages up to this size are formatted without allocating
+#define LOG_LINE_MAX 512
+
 GString *mainlogfile;
 
-static GTimeZone *tz;
-static GDateTime *dt;
 static log_level_t level_filter;
 
+// the main log, the lock keeps a line logged by another thread from reaching
+// a writer being closed
+static LogWriter log_writer;
+static pthread_rwlock_t log_writer_lock = PTHREAD_RWLOCK_INITIALIZER;
+
 static GHashTable *logs;
 static GHashTable *groupchat_logs;
-static GDateTime *session_started;
 
 enum {
     STDERR_BUFSIZE = 4000,
@@ -75,21 +93,97 @@ static int stderr_pipe[2];
 static char *stderr_buf;
 static GString *stderr_msg;
 
+// index_dir is the contact's log directory for chat logs, whose size and
+// message count are recorded in the history index on each flush
 struct dated_chat_log {
     gchar *filename;
     GDateTime *date;
+    FILE *fp;
+    GList *open_link;
+    gboolean dirty;
+    gchar *index_dir;
+    int count;
 };
 
+typedef enum {
+    LOG_SYNC_NONE,
+    LOG_SYNC_INTERVAL,
+    LOG_SYNC_MESSAGE
+} log_sync_t;
+
+typedef enum {
+    CHAT_LOG_CHAT,
+    CHAT_LOG_GROUPCHAT
+} chat_log_kind_t;
+
+// a formatted line waiting to be written by the writer thread
+typedef struct chat_log_record_t {
+    chat_log_kind_t kind;
+    gchar *login;
+    gchar *name;
+    gchar *line;
+} ChatLogRecord;
+
+// per contact index of log files, newest first
+struct chat_log_history_t {
+    GPtrArray *files;
+    guint current;
+};
+
+// owned by the writer thread while it runs
+static GQueue *open_logs;
+static GTimer *flush_timer;
+// resolved before the writer starts, so the writer never reads the environment
+static char *chatlogs_dir;
+static log_sync_t writer_sync;
+
+// shared with the writer thread, guarded by queue_lock
+static pthread_t writer;
+static gboolean writer_running;
+static pthread_mutex_t queue_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t queue_ready = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t queue_space = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t queue_drained = PTHREAD_COND_INITIALIZER;
+static GQueue queue = G_QUEUE_INIT;
+static gboolean writer_stop;
+static gboolean flush_requested;
+static gchar *flush_name;
+static guint flush_seq;
+static guint flushed_seq;
+static log_sync_t sync_level;
+static guint queue_peak;
+static guint queue_dropped;
+static GSList *writer_errors;
+
 static gboolean _log_roll_needed(struct dated_chat_log *dated_log);
 static struct dated_chat_log* _create_log(const char *const other, const char *const login);
 static struct dated_chat_log* _create_groupchat_log(const char *const room, const char *const login);
 static void _free_chat_log(struct dated_chat_log *dated_log);
+static FILE* _chat_log_open(struct dated_chat_log *dated_log);
+static void _chat_log_close_handle(struct dated_chat_log *dated_log);
+static void _chat_log_flush_handle(struct dated_chat_log *dated_log, gboolean sync);
+static void _chat_log_written(struct dated_chat_log *dated_log);
+static log_sync_t _chat_log_sync_level(void);
+static void _chat_log_enqueue(chat_log_kind_t kind, const char *const login, const char *const name, gchar *line);
+static void _chat_log_flush_one(const char *const name);
+static void* _chat_log_writer(void *arg);
+static void _chat_log_write_record(ChatLogRecord *record);
+static void _chat_log_flush_all(void);
+static void _chat_log_free_record(ChatLogRecord *record);
+static void _chat_log_writer_error(const char *const fmt, ...);
+static void _chat_log_report_errors(void);
+static void _chat_log_deadline(struct timespec *ts, long msec);
+static gboolean _chat_log_dirty(void);
+static gboolean _chat_log_create_dir(const char *const path);
+static int _chat_log_index_count(const char *const dir, GDateTime *date, const char *const filename);
+static void _chat_log_index_update(struct dated_chat_log *dated_log);
 static gboolean _key_equals(void *key1, void *key2);
+static char* _get_log_dir(const char *const other, const char *const login, gboolean create);
 static char* _get_log_filename(const char *const other, const char *const login, GDateTime *dt, gboolean create);
 static char* _get_groupchat_log_filename(const char *const room, const char *const login, GDateTime *dt,
     gboolean create);
-static void _rotate_log_file(void);
-static char* _log_string_from_level(log_level_t level);
+static void _log_vmsg(log_level_t level, const char *const msg, va_list arg);
+static void _log_append(log_level_t level, const char *const area, const char *const msg);
 static void _chat_log_chat(const char *const login, const char *const other, const gchar *const msg,
     chat_log_direction_t direction, GDateTime *timestamp, const char *const resourcepart);
 static void _groupchat_log_chat(const gchar *const login, const gchar *const room, const gchar *const nick,
@@ -98,36 +192,39 @@ static void _groupchat_log_chat(const gchar *const login, const gchar *const roo
 void
 log_debug(const char *const msg, ...)
 {
+    if (PROF_LEVEL_DEBUG < level_filter) {
+        return;
+    }
+
     va_list arg;
     va_start(arg, msg);
-    GString *fmt_msg = g_string_new(NULL);
-    g_string_vprintf(fmt_msg, msg, arg);
-    log_msg(PROF_LEVEL_DEBUG, PROF, fmt_msg->str);
-    g_string_free(fmt_msg, TRUE);
+    _log_vmsg(PROF_LEVEL_DEBUG, msg, arg);
     va_end(arg);
 }
 
 void
 log_info(const char *const msg, ...)
 {
+    if (PROF_LEVEL_INFO < level_filter) {
+        return;
+    }
+
     va_list arg;
     va_start(arg, msg);
-    GString *fmt_msg = g_string_new(NULL);
-    g_string_vprintf(fmt_msg, msg, arg);
-    log_msg(PROF_LEVEL_INFO, PROF, fmt_msg->str);
-    g_string_free(fmt_msg, TRUE);
+    _log_vmsg(PROF_LEVEL_INFO, msg, arg);
     va_end(arg);
 }
 
 void
 log_warning(const char *const msg, ...)
 {
+    if (PROF_LEVEL_WARN < level_filter) {
+        return;
+    }
+
     va_list arg;
     va_start(arg, msg);
-    GString *fmt_msg = g_string_new(NULL);
-    g_string_vprintf(fmt_msg, msg, arg);
-    log_msg(PROF_LEVEL_WARN, PROF, fmt_msg->str);
-    g_string_free(fmt_msg, TRUE);
+    _log_vmsg(PROF_LEVEL_WARN, msg, arg);
     va_end(arg);
 }
 
@@ -136,10 +233,7 @@ log_error(const char *const msg, ...)
 {
     va_list arg;
     va_start(arg, msg);
-    GString *fmt_msg = g_string_new(NULL);
-    g_string_vprintf(fmt_msg, msg, arg);
-    log_msg(PROF_LEVEL_ERROR, PROF, fmt_msg->str);
-    g_string_free(fmt_msg, TRUE);
+    _log_vmsg(PROF_LEVEL_ERROR, msg, arg);
     va_end(arg);
 }
 
@@ -147,12 +241,16 @@ void
 log_init(log_level_t filter)
 {
     level_filter = filter;
-    tz = g_time_zone_new_local();
     char *log_file = files_get_log_file();
-    logp = fopen(log_file, "a");
-    g_chmod(log_file, S_IRUSR | S_IWUSR);
     mainlogfile = g_string_new(log_file);
+
+    LogWriter writer = log_writer_open(log_file, PROF, filter, prefs_get_boolean(PREF_LOG_ROTATE),
+        prefs_get_max_log_size());
     free(log_file);
+
+    pthread_rwlock_wrlock(&log_writer_lock);
+    log_writer = writer;
+    pthread_rwlock_unlock(&log_writer_lock);
 }
 
 void
@@ -177,35 +275,20 @@ log_get_filter(void)
 void
 log_close(void)
 {
+    pthread_rwlock_wrlock(&log_writer_lock);
+    LogWriter writer = log_writer;
+    log_writer = NULL;
+    pthread_rwlock_unlock(&log_writer_lock);
+
+    log_writer_close(writer);
     g_string_free(mainlogfile, TRUE);
-    g_time_zone_unref(tz);
-    if (logp) {
-        fclose(logp);
-    }
 }
 
 void
 log_msg(log_level_t level, const char *const area, const char *const msg)
 {
-    if (level >= level_filter && logp) {
-        dt = g_date_time_new_now(tz);
-
-        char *level_str = _log_string_from_level(level);
-
-        gchar *date_fmt = g_date_time_format(dt, "%d/%m/%Y %H:%M:%S");
-
-        fprintf(logp, "%s: %s: %s: %s\n", date_fmt, area, level_str, msg);
-        g_date_time_unref(dt);
-
-        fflush(logp);
-        g_free(date_fmt);
-
-        if (prefs_get_boolean(PREF_LOG_ROTATE)) {
-            long result = ftell(logp);
-            if (result != -1 && result >= prefs_get_max_log_size()) {
-                _rotate_log_file();
-            }
-        }
+    if (level >= level_filter) {
+        _log_append(level, area, msg);
     }
 }
 
@@ -227,36 +310,52 @@ log_level_from_string(char *log_level)
 }
 
 static void
-_rotate_log_file(void)
+_log_vmsg(log_level_t level, const char *const msg, va_list arg)
 {
-    gchar *log_file = files_get_log_file();
-    size_t len = strlen(log_file);
-    gchar *log_file_new = malloc(len + 4);
-    int i = 1;
-
-    // find an empty name. from .log -> log.01 -> log.99
-    for(; i<100; i++) {
-        g_sprintf(log_file_new, "%s.%02d", log_file, i);
-        if (!g_file_test(log_file_new, G_FILE_TEST_EXISTS))
-            break;
+    char buf[LOG_LINE_MAX];
+    va_list copy;
+    va_copy(copy, arg);
+    int len = g_vsnprintf(buf, sizeof(buf), msg, copy);
+    va_end(copy);
+
+    if (len >= 0 && (size_t)len < sizeof(buf)) {
+        _log_append(level, PROF, buf);
+    } else {
+        gchar *long_msg = g_strdup_vprintf(msg, arg);
+        _log_append(level, PROF, long_msg);
+        g_free(long_msg);
     }
+}
 
-    log_close();
-    rename(log_file, log_file_new);
-    log_init(log_get_filter());
-
-    free(log_file_new);
-    free(log_file);
-    log_info("Log has been rotated");
+static void
+_log_append(log_level_t level, const char *const area, const char *const msg)
+{
+    pthread_rwlock_rdlock(&log_writer_lock);
+    if (log_writer) {
+        log_writer_append(log_writer, level, area, msg);
+    }
+    pthread_rwlock_unlock(&log_writer_lock);
 }
 
 void
 chat_log_init(void)
 {
-    session_started = g_date_time_new_now_local();
     log_info("Initialising chat logs");
+    open_logs = g_queue_new();
+    flush_timer = g_timer_new();
+    chatlogs_dir = files_get_data_path(DIR_CHATLOGS);
     logs = g_hash_table_new_full(g_str_hash, (GEqualFunc) _key_equals, free,
         (GDestroyNotify)_free_chat_log);
+
+    search_init();
+
+    writer_stop = FALSE;
+    sync_level = _chat_log_sync_level();
+    if (pthread_create(&writer, NULL, _chat_log_writer, NULL) == 0) {
+        writer_running = TRUE;
+    } else {
+        log_error("Could not start chat log writer thread, chat logs will be written directly");
+    }
 }
 
 void
@@ -437,28 +536,6 @@ _chat_log_chat(const char *const login, const char *const other, const char *con
         other_name = (char*)other;
     }
 
-    struct dated_chat_log *dated_log = g_hash_table_lookup(logs, other_name);
-
-    // no log for user
-    if (dated_log == NULL) {
-        dated_log = _create_log(other_name, login);
-        g_hash_table_insert(logs, strdup(other_name), dated_log);
-
-    // log entry exists but file removed
-    } else if (!g_file_test(dated_log->filename, G_FILE_TEST_EXISTS)) {
-        dated_log = _create_log(other_name, login);
-        g_hash_table_replace(logs, strdup(other_name), dated_log);
-
-    // log file needs rolling
-    } else if (_log_roll_needed(dated_log)) {
-        dated_log = _create_log(other_name, login);
-        g_hash_table_replace(logs, strdup(other_name), dated_log);
-    }
-
-    if (resourcepart) {
-            g_string_free(other_str, TRUE);
-    }
-
     if (timestamp == NULL) {
         timestamp = g_date_time_new_now_local();
     } else {
@@ -466,37 +543,35 @@ _chat_log_chat(const char *const login, const char *const other, const char *con
     }
 
     gchar *date_fmt = g_date_time_format(timestamp, "%H:%M:%S");
-    FILE *logp = fopen(dated_log->filename, "a");
-    g_chmod(dated_log->filename, S_IRUSR | S_IWUSR);
-    if (logp) {
-        if (direction == PROF_IN_LOG) {
-            if (strncmp(msg, "/me ", 4) == 0) {
-                if (resourcepart) {
-                    fprintf(logp, "%s - *%s %s\n", date_fmt, resourcepart, msg + 4);
-                } else {
-                    fprintf(logp, "%s - *%s %s\n", date_fmt, other, msg + 4);
-                }
+    gchar *line;
+    if (direction == PROF_IN_LOG) {
+        if (strncmp(msg, "/me ", 4) == 0) {
+            if (resourcepart) {
+                line = g_strdup_printf("%s - *%s %s\n", date_fmt, resourcepart, msg + 4);
             } else {
-                if (resourcepart) {
-                    fprintf(logp, "%s - %s: %s\n", date_fmt, resourcepart, msg);
-                } else {
-                    fprintf(logp, "%s - %s: %s\n", date_fmt, other, msg);
-                }
+                line = g_strdup_printf("%s - *%s %s\n", date_fmt, other, msg + 4);
             }
         } else {
-            if (strncmp(msg, "/me ", 4) == 0) {
-                fprintf(logp, "%s - *me %s\n", date_fmt, msg + 4);
+            if (resourcepart) {
+                line = g_strdup_printf("%s - %s: %s\n", date_fmt, resourcepart, msg);
             } else {
-                fprintf(logp, "%s - me: %s\n", date_fmt, msg);
+                line = g_strdup_printf("%s - %s: %s\n", date_fmt, other, msg);
             }
         }
-        fflush(logp);
-        int result = fclose(logp);
-        if (result == EOF) {
-            log_error("Error closing file %s, errno = %d", dated_log->filename, errno);
+    } else {
+        if (strncmp(msg, "/me ", 4) == 0) {
+            line = g_strdup_printf("%s - *me %s\n", date_fmt, msg + 4);
+        } else {
+            line = g_strdup_printf("%s - me: %s\n", date_fmt, msg);
         }
     }
 
+    _chat_log_enqueue(CHAT_LOG_CHAT, login, other_name, line);
+
+    if (resourcepart) {
+        g_string_free(other_str, TRUE);
+    }
+
     g_free(date_fmt);
     g_date_time_unref(timestamp);
 }
@@ -563,110 +638,523 @@ void
 _groupchat_log_chat(const gchar *const login, const gchar *const room, const gchar *const nick,
     const gchar *const msg)
 {
-    struct dated_chat_log *dated_log = g_hash_table_lookup(groupchat_logs, room);
-
-    // no log for room
-    if (dated_log == NULL) {
-        dated_log = _create_groupchat_log(room, login);
-        g_hash_table_insert(groupchat_logs, strdup(room), dated_log);
+    GDateTime *dt = g_date_time_new_now_local();
 
-    // log exists but needs rolling
-    } else if (_log_roll_needed(dated_log)) {
-        dated_log = _create_groupchat_log(room, login);
-        g_hash_table_replace(logs, strdup(room), dated_log);
+    gchar *date_fmt = g_date_time_format(dt, "%H:%M:%S");
+    gchar *line;
+    if (strncmp(msg, "/me ", 4) == 0) {
+        line = g_strdup_printf("%s - *%s %s\n", date_fmt, nick, msg + 4);
+    } else {
+        line = g_strdup_printf("%s - %s: %s\n", date_fmt, nick, msg);
     }
 
-    GDateTime *dt = g_date_time_new_now_local();
+    _chat_log_enqueue(CHAT_LOG_GROUPCHAT, login, room, line);
 
-    gchar *date_fmt = g_date_time_format(dt, "%H:%M:%S");
+    g_free(date_fmt);
+    g_date_time_unref(dt);
+}
 
-    FILE *logp = fopen(dated_log->filename, "a");
-    g_chmod(dated_log->filename, S_IRUSR | S_IWUSR);
-    if (logp) {
-        if (strncmp(msg, "/me ", 4) == 0) {
-            fprintf(logp, "%s - *%s %s\n", date_fmt, nick, msg + 4);
-        } else {
-            fprintf(logp, "%s - %s: %s\n", date_fmt, nick, msg);
-        }
+ChatLogHistory*
+chat_log_history_new(const gchar *const login, const gchar *const recipient)
+{
+    // make sure lines still queued for the writer are in the file
+    _chat_log_flush_one(recipient);
+
+    ChatLogHistory *history = malloc(sizeof(ChatLogHistory));
+    history->files = g_ptr_array_new_with_free_func((GDestroyNotify)history_file_free);
+    history->current = 0;
+
+    // the index records how much of each day's log was written, without it
+    // fall back to listing the logs
+    char *dir_name = _get_log_dir(recipient, login, FALSE);
+    GArray *days = history_index_read(dir_name, NULL);
+    if (days == NULL) {
+        days = history_index_scan(dir_name, FALSE);
+    }
 
-        fflush(logp);
-        int result = fclose(logp);
-        if (result == EOF) {
-            log_error("Error closing file %s, errno = %d", dated_log->filename, errno);
+    guint i;
+    for (i = 0; i < days->len; i++) {
+        HistoryDay *day = &g_array_index(days, HistoryDay, i);
+        if (day->size == 0 || day->count == 0) {
+            continue;
         }
+        gchar *filename = history_day_filename(dir_name, day);
+        g_ptr_array_add(history->files, history_file_new(filename, day->year, day->month, day->day, day->size));
+        g_free(filename);
     }
+    g_array_free(days, TRUE);
+    free(dir_name);
 
-    g_free(date_fmt);
-    g_date_time_unref(dt);
+    return history;
 }
 
 GSList*
-chat_log_get_previous(const gchar *const login, const gchar *const recipient)
+chat_log_history_previous(ChatLogHistory *history, int count)
 {
-    GSList *history = NULL;
-    GDateTime *now = g_date_time_new_now_local();
-    GDateTime *log_date = g_date_time_new(tz,
-        g_date_time_get_year(session_started),
-        g_date_time_get_month(session_started),
-        g_date_time_get_day_of_month(session_started),
-        g_date_time_get_hour(session_started),
-        g_date_time_get_minute(session_started),
-        g_date_time_get_second(session_started));
-
-    // get data from all logs from the day the session was started to today
-    while (g_date_time_compare(log_date, now) != 1) {
-        char *filename = _get_log_filename(recipient, login, log_date, FALSE);
-
-        FILE *logp = fopen(filename, "r");
-        if (logp) {
-            GString *header = g_string_new("");
-            g_string_append_printf(header, "%d/%d/%d:",
-                g_date_time_get_day_of_month(log_date),
-                g_date_time_get_month(log_date),
-                g_date_time_get_year(log_date));
-            history = g_slist_append(history, header->str);
-            g_string_free(header, FALSE);
-
-            char *line;
-            while ((line = file_getline(logp)) != NULL) {
-                history = g_slist_append(history, line);
-            }
-
-            fclose(logp);
+    GSList *entries = NULL;
+    int found = 0;
+
+    while (found < count && history->current < history->files->len) {
+        HistoryFile *file = g_ptr_array_index(history->files, history->current);
+        found += history_file_read_back(file, count - found, &entries);
+        if (history_file_done(file)) {
+            history->current++;
         }
+    }
 
-        free(filename);
+    return entries;
+}
 
-        GDateTime *next = g_date_time_add_days(log_date, 1);
-        g_date_time_unref(log_date);
-        log_date = next;
+gboolean
+chat_log_history_has_more(ChatLogHistory *history)
+{
+    return history && history->current < history->files->len;
+}
+
+void
+chat_log_history_free_entries(GSList *entries)
+{
+    GSList *curr = entries;
+    while (curr) {
+        ProfHistoryEntry *entry = curr->data;
+        g_date_time_unref(entry->timestamp);
+        g_free(entry->message);
+        free(entry);
+        curr = g_slist_next(curr);
     }
+    g_slist_free(entries);
+}
 
-    g_date_time_unref(log_date);
-    g_date_time_unref(now);
+void
+chat_log_history_free(ChatLogHistory *history)
+{
+    if (history) {
+        g_ptr_array_free(history->files, TRUE);
+        free(history);
+    }
+}
 
-    return history;
+void
+chat_log_flush(void)
+{
+    pthread_mutex_lock(&queue_lock);
+    sync_level = _chat_log_sync_level();
+    flush_requested = TRUE;
+    pthread_cond_signal(&queue_ready);
+    pthread_mutex_unlock(&queue_lock);
+
+    if (!writer_running && open_logs) {
+        writer_sync = sync_level;
+        _chat_log_flush_all();
+        _chat_log_report_errors();
+    }
+}
+
+void
+chat_log_poll(void)
+{
+    _chat_log_report_errors();
+}
+
+guint
+chat_log_queue_depth(void)
+{
+    pthread_mutex_lock(&queue_lock);
+    guint depth = g_queue_get_length(&queue);
+    pthread_mutex_unlock(&queue_lock);
+
+    return depth;
+}
+
+guint
+chat_log_queue_peak(void)
+{
+    pthread_mutex_lock(&queue_lock);
+    guint peak = queue_peak;
+    pthread_mutex_unlock(&queue_lock);
+
+    return peak;
+}
+
+guint
+chat_log_dropped(void)
+{
+    pthread_mutex_lock(&queue_lock);
+    guint dropped = queue_dropped;
+    pthread_mutex_unlock(&queue_lock);
+
+    return dropped;
 }
 
 void
 chat_log_close(void)
 {
+    if (writer_running) {
+        pthread_mutex_lock(&queue_lock);
+        sync_level = _chat_log_sync_level();
+        writer_stop = TRUE;
+        pthread_cond_signal(&queue_ready);
+        pthread_mutex_unlock(&queue_lock);
+
+        pthread_join(writer, NULL);
+        writer_running = FALSE;
+    }
+    search_close();
+
     g_hash_table_destroy(logs);
     g_hash_table_destroy(groupchat_logs);
-    g_date_time_unref(session_started);
+    g_queue_free(open_logs);
+    open_logs = NULL;
+    g_timer_destroy(flush_timer);
+    flush_timer = NULL;
+    free(chatlogs_dir);
+    chatlogs_dir = NULL;
+
+    _chat_log_report_errors();
+    if (queue_dropped > 0) {
+        log_warning("Chat log writer dropped %u records, queue peaked at %u", queue_dropped, queue_peak);
+    }
+}
+
+static void
+_chat_log_enqueue(chat_log_kind_t kind, const char *const login, const char *const name, gchar *line)
+{
+    ChatLogRecord *record = malloc(sizeof(ChatLogRecord));
+    record->kind = kind;
+    record->login = strdup(login);
+    record->name = strdup(name);
+    record->line = line;
+
+    if (!writer_running) {
+        writer_sync = _chat_log_sync_level();
+        _chat_log_write_record(record);
+        _chat_log_free_record(record);
+        _chat_log_report_errors();
+        return;
+    }
+
+    log_sync_t level = _chat_log_sync_level();
+
+    pthread_mutex_lock(&queue_lock);
+
+    // queue full, give the writer a moment before dropping the record
+    if (g_queue_get_length(&queue) >= CHAT_LOG_QUEUE_MAX) {
+        struct timespec deadline;
+        _chat_log_deadline(&deadline, CHAT_LOG_QUEUE_WAIT);
+        int res = 0;
+        while (g_queue_get_length(&queue) >= CHAT_LOG_QUEUE_MAX && res != ETIMEDOUT) {
+            res = pthread_cond_timedwait(&queue_space, &queue_lock, &deadline);
+        }
+        if (g_queue_get_length(&queue) >= CHAT_LOG_QUEUE_MAX) {
+            queue_dropped++;
+            pthread_mutex_unlock(&queue_lock);
+            _chat_log_free_record(record);
+            return;
+        }
+    }
+
+    sync_level = level;
+    g_queue_push_tail(&queue, record);
+    if (g_queue_get_length(&queue) > queue_peak) {
+        queue_peak = g_queue_get_length(&queue);
+    }
+    pthread_cond_signal(&queue_ready);
+
+    pthread_mutex_unlock(&queue_lock);
+}
+
+// write out the queued lines and flush the open log of one contact, without
+// syncing or flushing the other logs, so the wait is only for buffered writes
+static void
+_chat_log_flush_one(const char *const name)
+{
+    if (!writer_running) {
+        struct dated_chat_log *dated_log = logs ? g_hash_table_lookup(logs, name) : NULL;
+        if (dated_log && dated_log->fp) {
+            _chat_log_flush_handle(dated_log, FALSE);
+            _chat_log_report_errors();
+        }
+        return;
+    }
+
+    pthread_mutex_lock(&queue_lock);
+    g_free(flush_name);
+    flush_name = g_strdup(name);
+    guint seq = ++flush_seq;
+    pthread_cond_signal(&queue_ready);
+    while (flushed_seq < seq) {
+        pthread_cond_wait(&queue_drained, &queue_lock);
+    }
+    pthread_mutex_unlock(&queue_lock);
+}
+
+static void*
+_chat_log_writer(void *arg)
+{
+    pthread_mutex_lock(&queue_lock);
+    while (TRUE) {
+        while (g_queue_is_empty(&queue) && !flush_requested && flush_name == NULL && !writer_stop) {
+            // only wake for the interval flush when there is something to flush
+            if (!_chat_log_dirty()) {
+                pthread_cond_wait(&queue_ready, &queue_lock);
+                continue;
+            }
+            long remaining = (CHAT_LOG_FLUSH_INTERVAL - g_timer_elapsed(flush_timer, NULL)) * 1000;
+            struct timespec deadline;
+            _chat_log_deadline(&deadline, MAX(remaining, 0));
+            if (pthread_cond_timedwait(&queue_ready, &queue_lock, &deadline) == ETIMEDOUT) {
+                break;
+            }
+        }
+
+        // take the whole batch so producers never wait on file I/O
+        GQueue batch = queue;
+        g_queue_init(&queue);
+        gboolean flush = flush_requested || writer_stop;
+        gboolean stop = writer_stop;
+        flush_requested = FALSE;
+        gchar *flush_one = flush_name;
+        guint flush_one_seq = flush_seq;
+        flush_name = NULL;
+        writer_sync = sync_level;
+        pthread_cond_broadcast(&queue_space);
+        pthread_mutex_unlock(&queue_lock);
+
+        ChatLogRecord *record;
+        while ((record = g_queue_pop_head(&batch)) != NULL) {
+            _chat_log_write_record(record);
+            _chat_log_free_record(record);
+        }
+
+        if (flush || g_timer_elapsed(flush_timer, NULL) >= CHAT_LOG_FLUSH_INTERVAL) {
+            _chat_log_flush_all();
+        } else if (flush_one) {
+            struct dated_chat_log *dated_log = g_hash_table_lookup(logs, flush_one);
+            if (dated_log && dated_log->fp) {
+                _chat_log_flush_handle(dated_log, FALSE);
+            }
+        }
+        g_free(flush_one);
+
+        pthread_mutex_lock(&queue_lock);
+        flushed_seq = flush_one_seq;
+        pthread_cond_broadcast(&queue_drained);
+        if (stop && g_queue_is_empty(&queue)) {
+            break;
+        }
+    }
+    pthread_mutex_unlock(&queue_lock);
+
+    return NULL;
+}
+
+static void
+_chat_log_write_record(ChatLogRecord *record)
+{
+    GHashTable *table = record->kind == CHAT_LOG_CHAT ? logs : groupchat_logs;
+    struct dated_chat_log *dated_log = g_hash_table_lookup(table, record->name);
+
+    // no log for user or room, log entry exists but file removed, or log file needs rolling
+    // the file is only checked when the handle is not open
+    if (dated_log == NULL
+            || (dated_log->fp == NULL && !g_file_test(dated_log->filename, G_FILE_TEST_EXISTS))
+            || _log_roll_needed(dated_log)) {
+        if (record->kind == CHAT_LOG_CHAT) {
+            dated_log = _create_log(record->name, record->login);
+        } else {
+            dated_log = _create_groupchat_log(record->name, record->login);
+        }
+        g_hash_table_replace(table, strdup(record->name), dated_log);
+    }
+
+    FILE *logp = _chat_log_open(dated_log);
+    if (logp) {
+        fputs(record->line, logp);
+        dated_log->count++;
+        _chat_log_written(dated_log);
+    }
+}
+
+static void
+_chat_log_flush_all(void)
+{
+    // close handles whose file was removed, the next message recreates it
+    GList *curr = g_queue_peek_head_link(open_logs);
+    while (curr) {
+        GList *next = g_list_next(curr);
+        struct dated_chat_log *dated_log = curr->data;
+        struct stat st;
+        if (fstat(fileno(dated_log->fp), &st) == 0 && st.st_nlink == 0) {
+            _chat_log_close_handle(dated_log);
+        } else {
+            _chat_log_flush_handle(dated_log, writer_sync != LOG_SYNC_NONE);
+        }
+        curr = next;
+    }
+
+    g_timer_start(flush_timer);
+}
+
+static void
+_chat_log_free_record(ChatLogRecord *record)
+{
+    free(record->login);
+    free(record->name);
+    g_free(record->line);
+    free(record);
+}
+
+static void
+_chat_log_writer_error(const char *const fmt, ...)
+{
+    va_list arg;
+    va_start(arg, fmt);
+    gchar *msg = g_strdup_vprintf(fmt, arg);
+    va_end(arg);
+
+    // the main log is not thread safe, errors are reported from the main thread
+    pthread_mutex_lock(&queue_lock);
+    writer_errors = g_slist_append(writer_errors, msg);
+    pthread_mutex_unlock(&queue_lock);
+}
+
+static void
+_chat_log_report_errors(void)
+{
+    pthread_mutex_lock(&queue_lock);
+    GSList *errors = writer_errors;
+    writer_errors = NULL;
+    pthread_mutex_unlock(&queue_lock);
+
+    GSList *curr = errors;
+    while (curr) {
+        log_error("%s", curr->data);
+        curr = g_slist_next(curr);
+    }
+    g_slist_free_full(errors, g_free);
+}
+
+static void
+_chat_log_deadline(struct timespec *ts, long msec)
+{
+    clock_gettime(CLOCK_REALTIME, ts);
+    ts->tv_sec += msec / 1000;
+    ts->tv_nsec += (msec % 1000) * 1000000;
+    if (ts->tv_nsec >= 1000000000) {
+        ts->tv_sec++;
+        ts->tv_nsec -= 1000000000;
+    }
+}
+
+// whether an open log has writes not yet flushed, only the writer touches the handles
+static gboolean
+_chat_log_dirty(void)
+{
+    GList *curr = g_queue_peek_head_link(open_logs);
+    while (curr) {
+        struct dated_chat_log *dated_log = curr->data;
+        if (dated_log->dirty) {
+            return TRUE;
+        }
+        curr = g_list_next(curr);
+    }
+
+    return FALSE;
+}
+
+// create_dir logs, this reports through the main thread instead
+static gboolean
+_chat_log_create_dir(const char *const path)
+{
+    if (g_mkdir(path, S_IRWXU) != 0 && errno != EEXIST) {
+        _chat_log_writer_error("Error creating directory %s, errno = %d", path, errno);
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+// messages already in the day's log, taken from the index while it matches
+// the file, the index is rebuilt when missing and compacted when it holds
+// more than one record for a day
+static int
+_chat_log_index_count(const char *const dir, GDateTime *date, const char *const filename)
+{
+    guint records;
+    GArray *days = history_index_read(dir, &records);
+    if (days == NULL) {
+        days = history_index_scan(dir, TRUE);
+        records = 0;
+    }
+    if (records != days->len && !history_index_write(dir, days)) {
+        _chat_log_writer_error("Error writing history index in %s, errno = %d", dir, errno);
+    }
+
+    GStatBuf st;
+    goffset size = g_stat(filename, &st) == 0 ? st.st_size : 0;
+    int count = -1;
+    guint i;
+    for (i = 0; i < days->len; i++) {
+        HistoryDay *day = &g_array_index(days, HistoryDay, i);
+        if (day->year == g_date_time_get_year(date) && day->month == g_date_time_get_month(date)
+                && day->day == g_date_time_get_day_of_month(date)) {
+            if (day->size == size && day->count >= 0) {
+                count = day->count;
+            }
+            break;
+        }
+    }
+    g_array_free(days, TRUE);
+
+    if (count == -1) {
+        count = history_file_count(filename, &size);
+    }
+
+    return count;
+}
+
+static void
+_chat_log_index_update(struct dated_chat_log *dated_log)
+{
+    if (dated_log->index_dir == NULL) {
+        return;
+    }
+
+    struct stat st;
+    if (fstat(fileno(dated_log->fp), &st) != 0) {
+        _chat_log_writer_error("Error reading size of file %s, errno = %d", dated_log->filename, errno);
+        return;
+    }
+
+    HistoryDay day;
+    day.year = g_date_time_get_year(dated_log->date);
+    day.month = g_date_time_get_month(dated_log->date);
+    day.day = g_date_time_get_day_of_month(dated_log->date);
+    day.size = st.st_size;
+    day.count = dated_log->count;
+    if (!history_index_append(dated_log->index_dir, &day)) {
+        _chat_log_writer_error("Error writing history index in %s, errno = %d", dated_log->index_dir, errno);
+    }
 }
 
 static struct dated_chat_log*
 _create_log(const char *const other, const char *const login)
 {
     GDateTime *now = g_date_time_new_now_local();
+    char *dir = _get_log_dir(other, login, TRUE);
     char *filename = _get_log_filename(other, login, now, TRUE);
 
     struct dated_chat_log *new_log = malloc(sizeof(struct dated_chat_log));
     new_log->filename = strdup(filename);
     new_log->date = now;
+    new_log->fp = NULL;
+    new_log->open_link = NULL;
+    new_log->dirty = FALSE;
+    new_log->index_dir = g_strdup(dir);
+    new_log->count = _chat_log_index_count(dir, now, filename);
 
     free(filename);
+    free(dir);
 
     return new_log;
 }
@@ -680,6 +1168,11 @@ _create_groupchat_log(const char * const room, const char *const login)
     struct dated_chat_log *new_log = malloc(sizeof(struct dated_chat_log));
     new_log->filename = strdup(filename);
     new_log->date = now;
+    new_log->fp = NULL;
+    new_log->open_link = NULL;
+    new_log->dirty = FALSE;
+    new_log->index_dir = NULL;
+    new_log->count = 0;
 
     free(filename);
 
@@ -700,14 +1193,100 @@ _log_roll_needed(struct dated_chat_log *dated_log)
     return result;
 }
 
+static FILE*
+_chat_log_open(struct dated_chat_log *dated_log)
+{
+    if (dated_log->fp) {
+        g_queue_unlink(open_logs, dated_log->open_link);
+        g_queue_push_head_link(open_logs, dated_log->open_link);
+        return dated_log->fp;
+    }
+
+    if (g_queue_get_length(open_logs) >= CHAT_LOG_MAX_OPEN) {
+        _chat_log_close_handle(g_queue_peek_tail(open_logs));
+    }
+
+    dated_log->fp = fopen(dated_log->filename, "a");
+    if (dated_log->fp == NULL) {
+        _chat_log_writer_error("Error opening file %s, errno = %d", dated_log->filename, errno);
+        return NULL;
+    }
+    g_chmod(dated_log->filename, S_IRUSR | S_IWUSR);
+
+    g_queue_push_head(open_logs, dated_log);
+    dated_log->open_link = g_queue_peek_head_link(open_logs);
+
+    return dated_log->fp;
+}
+
+static void
+_chat_log_close_handle(struct dated_chat_log *dated_log)
+{
+    if (dated_log->fp == NULL) {
+        return;
+    }
+
+    _chat_log_flush_handle(dated_log, writer_sync != LOG_SYNC_NONE);
+    if (fclose(dated_log->fp) == EOF) {
+        _chat_log_writer_error("Error closing file %s, errno = %d", dated_log->filename, errno);
+    }
+    dated_log->fp = NULL;
+
+    g_queue_delete_link(open_logs, dated_log->open_link);
+    dated_log->open_link = NULL;
+}
+
+static void
+_chat_log_flush_handle(struct dated_chat_log *dated_log, gboolean sync)
+{
+    if (!dated_log->dirty) {
+        return;
+    }
+
+    if (fflush(dated_log->fp) == EOF) {
+        _chat_log_writer_error("Error writing file %s, errno = %d", dated_log->filename, errno);
+    } else {
+        if (sync && fsync(fileno(dated_log->fp)) != 0) {
+            _chat_log_writer_error("Error syncing file %s, errno = %d", dated_log->filename, errno);
+        }
+        _chat_log_index_update(dated_log);
+    }
+    search_log_updated(dated_log->filename);
+    dated_log->dirty = FALSE;
+}
+
+static void
+_chat_log_written(struct dated_chat_log *dated_log)
+{
+    dated_log->dirty = TRUE;
+    if (writer_sync == LOG_SYNC_MESSAGE) {
+        _chat_log_flush_handle(dated_log, TRUE);
+    }
+}
+
+static log_sync_t
+_chat_log_sync_level(void)
+{
+    const char *sync = prefs_get_string_cached(PREF_LOG_SYNC);
+    if (g_strcmp0(sync, "none") == 0) {
+        return LOG_SYNC_NONE;
+    } else if (g_strcmp0(sync, "message") == 0) {
+        return LOG_SYNC_MESSAGE;
+    } else {
+        return LOG_SYNC_INTERVAL;
+    }
+}
+
 static void
 _free_chat_log(struct dated_chat_log *dated_log)
 {
     if (dated_log) {
+        _chat_log_close_handle(dated_log);
         if (dated_log->filename) {
             g_free(dated_log->filename);
             dated_log->filename = NULL;
         }
+        g_free(dated_log->index_dir);
         if (dated_log->date) {
             g_date_time_unref(dated_log->date);
             dated_log->date = NULL;
@@ -726,26 +1305,37 @@ gboolean _key_equals(void *key1, void *key2)
 }
 
 static char*
-_get_log_filename(const char *const other, const char *const login, GDateTime *dt, gboolean create)
+_get_log_dir(const char *const other, const char *const login, gboolean create)
 {
-    char *chatlogs_dir = files_get_data_path(DIR_CHATLOGS);
     GString *log_file = g_string_new(chatlogs_dir);
-    free(chatlogs_dir);
 
     gchar *login_dir = str_replace(login, "@", "_at_");
     g_string_append_printf(log_file, "/%s", login_dir);
     if (create) {
-        create_dir(log_file->str);
+        _chat_log_create_dir(log_file->str);
     }
     free(login_dir);
 
     gchar *other_file = str_replace(other, "@", "_at_");
     g_string_append_printf(log_file, "/%s", other_file);
     if (create) {
-        create_dir(log_file->str);
+        _chat_log_create_dir(log_file->str);
     }
     free(other_file);
 
+    char *result = strdup(log_file->str);
+    g_string_free(log_file, TRUE);
+
+    return result;
+}
+
+static char*
+_get_log_filename(const char *const other, const char *const login, GDateTime *dt, gboolean create)
+{
+    char *log_dir = _get_log_dir(other, login, create);
+    GString *log_file = g_string_new(log_dir);
+    free(log_dir);
+
     gchar *date = g_date_time_format(dt, "/%Y_%m_%d.log");
     g_string_append(log_file, date);
     g_free(date);
@@ -759,26 +1349,24 @@ _get_log_filename(const char *const other, const char *const login, GDateTime *d
 static char*
 _get_groupchat_log_filename(const char *const room, const char *const login, GDateTime *dt, gboolean create)
 {
-    char *chatlogs_dir = files_get_data_path(DIR_CHATLOGS);
     GString *log_file = g_string_new(chatlogs_dir);
-    free(chatlogs_dir);
 
     gchar *login_dir = str_replace(login, "@", "_at_");
     g_string_append_printf(log_file, "/%s", login_dir);
     if (create) {
-        create_dir(log_file->str);
+        _chat_log_create_dir(log_file->str);
     }
     free(login_dir);
 
     g_string_append(log_file, "/rooms");
     if (create) {
-        create_dir(log_file->str);
+        _chat_log_create_dir(log_file->str);
     }
 
     gchar *room_file = str_replace(room, "@", "_at_");
     g_string_append_printf(log_file, "/%s", room_file);
     if (create) {
-        create_dir(log_file->str);
+        _chat_log_create_dir(log_file->str);
     }
     free(room_file);
 
@@ -792,24 +1380,6 @@ _get_groupchat_log_filename(const char *const room, const char *const login, GDa
     return result;
 }
 
-static char*
-_log_string_from_level(log_level_t level)
-{
-    switch (level)
-    {
-        case PROF_LEVEL_ERROR:
-            return "ERR";
-        case PROF_LEVEL_WARN:
-            return "WRN";
-        case PROF_LEVEL_INFO:
-            return "INF";
-        case PROF_LEVEL_DEBUG:
-            return "DBG";
-        default:
-            return "LOG";
-    }
-}
-
 void
 log_stderr_handler(void)
 {
@@ -844,6 +1414,12 @@ log_stderr_handler(void)
     }
 }
 
+int
+log_stderr_fd(void)
+{
+    return stderr_inited ? stderr_pipe[0] : -1;
+}
+
 static int log_stderr_nonblock_set(int fd)
 {
     int rc;
@@ -53,6 +53,14 @@ typedef enum {
     PROF_OUT_LOG
 } chat_log_direction_t;
 
+// a message read back from a chat log
+typedef struct prof_history_entry_t {
+    GDateTime *timestamp;
+    gchar *message;
+} ProfHistoryEntry;
+
+typedef struct chat_log_history_t ChatLogHistory;
+
 void log_init(log_level_t filter);
 log_level_t log_get_filter(void);
 void log_close(void);
@@ -68,6 +76,7 @@ log_level_t log_level_from_string(char *log_level);
 void log_stderr_init(log_level_t level);
 void log_stderr_close(void);
 void log_stderr_handler(void);
+int log_stderr_fd(void);
 
 void chat_log_init(void);
 
@@ -81,8 +90,19 @@ void chat_log_otr_msg_in(ProfMessage *message);
 void chat_log_pgp_msg_in(ProfMessage *message);
 void chat_log_omemo_msg_in(ProfMessage *message);
 
+void chat_log_flush(void);
+void chat_log_poll(void);
+guint chat_log_queue_depth(void);
+guint chat_log_queue_peak(void);
+guint chat_log_dropped(void);
 void chat_log_close(void);
-GSList* chat_log_get_previous(const gchar *const login, const gchar *const recipient);
+
+// history is read backwards from the newest log, entries are returned oldest first
+ChatLogHistory* chat_log_history_new(const gchar *const login, const gchar *const recipient);
+GSList* chat_log_history_previous(ChatLogHistory *history, int count);
+gboolean chat_log_history_has_more(ChatLogHistory *history);
+void chat_log_history_free_entries(GSList *entries);
+void chat_log_history_free(ChatLogHistory *history);
 
 void groupchat_log_init(void);
 
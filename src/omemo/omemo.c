@@ -40,6 +40,9 @@
 #include <errno.h>
 #include <glib.h>
 #include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
 #include <signal/key_helper.h>
 #include <signal/protocol.h>
 #include <signal/signal_protocol.h>
@@ -54,6 +57,8 @@
 #include "omemo/crypto.h"
 #include "omemo/omemo.h"
 #include "omemo/store.h"
+#include "tools/keyfile_journal.h"
+#include "tools/worker_pool.h"
 #include "ui/ui.h"
 #include "ui/window_list.h"
 #include "xmpp/connection.h"
@@ -62,8 +67,34 @@
 #include "xmpp/roster_list.h"
 #include "xmpp/xmpp.h"
 
+// upper bound on threads encrypting message keys alongside the main thread
+#define OMEMO_KEY_WORKERS_MAX 8
+// devices per worker thread before another one joins in
+#define OMEMO_KEY_JOBS_PER_WORKER 8
+
 static gboolean loaded;
 
+// encryption of the message key for one recipient device
+typedef struct omemo_key_job_t {
+    const char *name;
+    uint32_t device_id;
+    omemo_key_t *key;
+    gboolean cipher_failed;
+} OmemoKeyJob;
+
+// a signal context and store context of a thread encrypting message keys
+typedef struct omemo_key_worker_t {
+    signal_context *signal;
+    signal_protocol_store_context *store;
+} OmemoKeyWorker;
+
+typedef struct omemo_key_jobs_t {
+    OmemoKeyJob *jobs;
+    gint count;
+    gint next;
+    const unsigned char *key_tag;
+} OmemoKeyJobs;
+
 static void _generate_pre_keys(int count);
 static void _generate_signed_pre_key(void);
 static gboolean _load_identity(void);
@@ -80,12 +111,26 @@ static unsigned char *_omemo_fingerprint_decode(const char *const fingerprint, s
 static char * _omemo_unformat_fingerprint(const char *const fingerprint_formatted);
 static void _cache_device_identity(const char *const jid, uint32_t device_id, ec_public_key *identity);
 static void _g_hash_table_free(GHashTable *hash_table);
+static void _keyfile_save(KeyfileJournal *journal, GKeyFile *keyfile, const char *const what);
+static void _keyfile_record(KeyfileJournal *journal, GKeyFile *keyfile, const char *const what,
+    const char *const group, const char *const key);
+static void _journal_sync(KeyfileJournal *journal, gboolean force);
+static void _journal_close(KeyfileJournal *journal);
+static void _store_report_errors(void);
+static signal_protocol_store_context* _store_context_new(signal_context *signal);
+static void _key_jobs_add(GArray *jobs, GHashTable *added, const char *const name, GList *device_ids);
+static GList* _encrypt_keys(GArray *jobs, const unsigned char *const key_tag);
+static void _encrypt_keys_run(void *state, void *data);
+static void* _key_worker_new(void *userdata);
+static void _key_worker_free(void *state);
 
 typedef gboolean (*OmemoDeviceListHandler)(const char *const jid, GList *device_list);
 
 struct omemo_context_t {
     pthread_mutexattr_t attr;
     pthread_mutex_t lock;
+    // guards the session and identity stores, which key encryption workers share
+    pthread_mutex_t store_lock;
     signal_context *signal;
     uint32_t device_id;
     GHashTable *device_list;
@@ -108,11 +153,34 @@ struct omemo_context_t {
     GHashTable *known_devices;
     GString *known_devices_filename;
     GKeyFile *known_devices_keyfile;
+    KeyfileJournal identity_journal;
+    KeyfileJournal trust_journal;
+    KeyfileJournal sessions_journal;
+    KeyfileJournal known_devices_journal;
+    // errors writing the stores, logged from the main thread
+    GSList *store_errors;
+    // started on the first message with enough devices to share out
+    WorkerPool key_pool;
     Autocomplete fingerprint_ac;
 };
 
 static omemo_context omemo_ctx;
 
+static const signal_crypto_provider crypto_provider = {
+    .random_func = omemo_random_func,
+    .hmac_sha256_init_func = omemo_hmac_sha256_init_func,
+    .hmac_sha256_update_func = omemo_hmac_sha256_update_func,
+    .hmac_sha256_final_func = omemo_hmac_sha256_final_func,
+    .hmac_sha256_cleanup_func = omemo_hmac_sha256_cleanup_func,
+    .sha512_digest_init_func = omemo_sha512_digest_init_func,
+    .sha512_digest_update_func = omemo_sha512_digest_update_func,
+    .sha512_digest_final_func = omemo_sha512_digest_final_func,
+    .sha512_digest_cleanup_func = omemo_sha512_digest_cleanup_func,
+    .encrypt_func = omemo_encrypt_func,
+    .decrypt_func = omemo_decrypt_func,
+    .user_data = NULL
+};
+
 void
 omemo_init(void)
 {
@@ -124,6 +192,7 @@ omemo_init(void)
     pthread_mutexattr_init(&omemo_ctx.attr);
     pthread_mutexattr_settype(&omemo_ctx.attr, PTHREAD_MUTEX_RECURSIVE);
     pthread_mutex_init(&omemo_ctx.lock, &omemo_ctx.attr);
+    pthread_mutex_init(&omemo_ctx.store_lock, &omemo_ctx.attr);
 
     omemo_ctx.fingerprint_ac = autocomplete_new();
 }
@@ -151,21 +220,6 @@ omemo_on_connect(ProfAccount *account)
         cons_show("Error initializing OMEMO log");
     }
 
-    signal_crypto_provider crypto_provider = {
-        .random_func = omemo_random_func,
-        .hmac_sha256_init_func = omemo_hmac_sha256_init_func,
-        .hmac_sha256_update_func = omemo_hmac_sha256_update_func,
-        .hmac_sha256_final_func = omemo_hmac_sha256_final_func,
-        .hmac_sha256_cleanup_func = omemo_hmac_sha256_cleanup_func,
-        .sha512_digest_init_func = omemo_sha512_digest_init_func,
-        .sha512_digest_update_func = omemo_sha512_digest_update_func,
-        .sha512_digest_final_func = omemo_sha512_digest_final_func,
-        .sha512_digest_cleanup_func = omemo_sha512_digest_cleanup_func,
-        .encrypt_func = omemo_encrypt_func,
-        .decrypt_func = omemo_decrypt_func,
-        .user_data = NULL
-    };
-
     if (signal_context_set_crypto_provider(omemo_ctx.signal, &crypto_provider) != 0) {
         cons_show("Error initializing OMEMO crypto");
         return;
@@ -173,54 +227,12 @@ omemo_on_connect(ProfAccount *account)
 
     signal_context_set_locking_functions(omemo_ctx.signal, _lock, _unlock);
 
-    signal_protocol_store_context_create(&omemo_ctx.store, omemo_ctx.signal);
-
     omemo_ctx.session_store = session_store_new();
-    signal_protocol_session_store session_store = {
-        .load_session_func = load_session,
-        .get_sub_device_sessions_func = get_sub_device_sessions,
-        .store_session_func = store_session,
-        .contains_session_func = contains_session,
-        .delete_session_func = delete_session,
-        .delete_all_sessions_func = delete_all_sessions,
-        .destroy_func = NULL,
-        .user_data = omemo_ctx.session_store
-    };
-    signal_protocol_store_context_set_session_store(omemo_ctx.store, &session_store);
-
     omemo_ctx.pre_key_store = pre_key_store_new();
-    signal_protocol_pre_key_store pre_key_store = {
-        .load_pre_key = load_pre_key,
-        .store_pre_key = store_pre_key,
-        .contains_pre_key = contains_pre_key,
-        .remove_pre_key = remove_pre_key,
-        .destroy_func = NULL,
-        .user_data = omemo_ctx.pre_key_store
-    };
-    signal_protocol_store_context_set_pre_key_store(omemo_ctx.store, &pre_key_store);
-
     omemo_ctx.signed_pre_key_store = signed_pre_key_store_new();
-    signal_protocol_signed_pre_key_store signed_pre_key_store = {
-        .load_signed_pre_key = load_signed_pre_key,
-        .store_signed_pre_key = store_signed_pre_key,
-        .contains_signed_pre_key = contains_signed_pre_key,
-        .remove_signed_pre_key = remove_signed_pre_key,
-        .destroy_func = NULL,
-        .user_data = omemo_ctx.signed_pre_key_store
-    };
-    signal_protocol_store_context_set_signed_pre_key_store(omemo_ctx.store, &signed_pre_key_store);
-
     identity_key_store_new(&omemo_ctx.identity_key_store);
-    signal_protocol_identity_key_store identity_key_store = {
-        .get_identity_key_pair = get_identity_key_pair,
-        .get_local_registration_id = get_local_registration_id,
-        .save_identity = save_identity,
-        .is_trusted_identity = is_trusted_identity,
-        .destroy_func = NULL,
-        .user_data = &omemo_ctx.identity_key_store
-    };
-    signal_protocol_store_context_set_identity_key_store(omemo_ctx.store, &identity_key_store);
 
+    omemo_ctx.store = _store_context_new(omemo_ctx.signal);
 
     loaded = FALSE;
     omemo_ctx.device_list = g_hash_table_new_full(g_str_hash, g_str_equal, free, (GDestroyNotify)g_list_free);
@@ -265,8 +277,12 @@ omemo_on_connect(ProfAccount *account)
     omemo_ctx.trust_keyfile = g_key_file_new();
     omemo_ctx.sessions_keyfile = g_key_file_new();
     omemo_ctx.known_devices_keyfile = g_key_file_new();
+    keyfile_journal_init(&omemo_ctx.identity_journal, omemo_ctx.identity_filename->str);
+    keyfile_journal_init(&omemo_ctx.trust_journal, omemo_ctx.trust_filename->str);
+    keyfile_journal_init(&omemo_ctx.sessions_journal, omemo_ctx.sessions_filename->str);
+    keyfile_journal_init(&omemo_ctx.known_devices_journal, omemo_ctx.known_devices_filename->str);
 
-    if (g_key_file_load_from_file(omemo_ctx.identity_keyfile, omemo_ctx.identity_filename->str, G_KEY_FILE_KEEP_COMMENTS, &error)) {
+    if (keyfile_journal_load(&omemo_ctx.identity_journal, omemo_ctx.identity_keyfile, &error)) {
         if (!_load_identity()) {
             return;
         }
@@ -276,21 +292,21 @@ omemo_on_connect(ProfAccount *account)
     }
 
     error = NULL;
-    if (g_key_file_load_from_file(omemo_ctx.trust_keyfile, omemo_ctx.trust_filename->str, G_KEY_FILE_KEEP_COMMENTS, &error)) {
+    if (keyfile_journal_load(&omemo_ctx.trust_journal, omemo_ctx.trust_keyfile, &error)) {
         _load_trust();
     } else if (error->code != G_FILE_ERROR_NOENT) {
         log_warning("OMEMO: error loading trust from: %s, %s", omemo_ctx.trust_filename->str, error->message);
     }
 
     error = NULL;
-    if (g_key_file_load_from_file(omemo_ctx.sessions_keyfile, omemo_ctx.sessions_filename->str, G_KEY_FILE_KEEP_COMMENTS, &error)) {
+    if (keyfile_journal_load(&omemo_ctx.sessions_journal, omemo_ctx.sessions_keyfile, &error)) {
         _load_sessions();
     } else if (error->code != G_FILE_ERROR_NOENT) {
         log_warning("OMEMO: error loading sessions from: %s, %s", omemo_ctx.sessions_filename->str, error->message);
     }
 
     error = NULL;
-    if (g_key_file_load_from_file(omemo_ctx.known_devices_keyfile, omemo_ctx.known_devices_filename->str, G_KEY_FILE_KEEP_COMMENTS, &error)) {
+    if (keyfile_journal_load(&omemo_ctx.known_devices_journal, omemo_ctx.known_devices_keyfile, &error)) {
         _load_known_devices();
     } else if (error->code != G_FILE_ERROR_NOENT) {
         log_warning("OMEMO: error loading known devices from: %s, %s", omemo_ctx.known_devices_filename->str, error->message);
@@ -308,6 +324,20 @@ omemo_on_disconnect(void)
     _g_hash_table_free(omemo_ctx.pre_key_store);
     _g_hash_table_free(omemo_ctx.device_list_handler);
 
+    worker_pool_free(omemo_ctx.key_pool);
+    omemo_ctx.key_pool = NULL;
+
+    // fold the journals back into the store files
+    omemo_identity_keyfile_save();
+    omemo_trust_keyfile_save();
+    omemo_sessions_keyfile_save();
+    omemo_known_devices_keyfile_save();
+    _journal_close(&omemo_ctx.identity_journal);
+    _journal_close(&omemo_ctx.trust_journal);
+    _journal_close(&omemo_ctx.sessions_journal);
+    _journal_close(&omemo_ctx.known_devices_journal);
+    _store_report_errors();
+
     g_string_free(omemo_ctx.identity_filename, TRUE);
     g_key_file_free(omemo_ctx.identity_keyfile);
     g_string_free(omemo_ctx.trust_filename, TRUE);
@@ -557,11 +587,13 @@ omemo_identity_keyfile(void)
 void
 omemo_identity_keyfile_save(void)
 {
-    GError *error = NULL;
+    _keyfile_save(&omemo_ctx.identity_journal, omemo_ctx.identity_keyfile, "identity");
+}
 
-    if (!g_key_file_save_to_file(omemo_ctx.identity_keyfile, omemo_ctx.identity_filename->str, &error)) {
-        log_error("OMEMO: error saving identity to: %s, %s", omemo_ctx.identity_filename->str, error->message);
-    }
+void
+omemo_identity_keyfile_record(const char *const group, const char *const key)
+{
+    _keyfile_record(&omemo_ctx.identity_journal, omemo_ctx.identity_keyfile, "identity", group, key);
 }
 
 GKeyFile *
@@ -573,11 +605,13 @@ omemo_trust_keyfile(void)
 void
 omemo_trust_keyfile_save(void)
 {
-    GError *error = NULL;
+    _keyfile_save(&omemo_ctx.trust_journal, omemo_ctx.trust_keyfile, "trust");
+}
 
-    if (!g_key_file_save_to_file(omemo_ctx.trust_keyfile, omemo_ctx.trust_filename->str, &error)) {
-        log_error("OMEMO: error saving trust to: %s, %s", omemo_ctx.trust_filename->str, error->message);
-    }
+void
+omemo_trust_keyfile_record(const char *const group, const char *const key)
+{
+    _keyfile_record(&omemo_ctx.trust_journal, omemo_ctx.trust_keyfile, "trust", group, key);
 }
 
 GKeyFile *
@@ -589,21 +623,49 @@ omemo_sessions_keyfile(void)
 void
 omemo_sessions_keyfile_save(void)
 {
-    GError *error = NULL;
+    _keyfile_save(&omemo_ctx.sessions_journal, omemo_ctx.sessions_keyfile, "sessions");
+}
 
-    if (!g_key_file_save_to_file(omemo_ctx.sessions_keyfile, omemo_ctx.sessions_filename->str, &error)) {
-        log_error("OMEMO: error saving sessions to: %s, %s", omemo_ctx.sessions_filename->str, error->message);
-    }
+void
+omemo_sessions_keyfile_record(const char *const group, const char *const key)
+{
+    _keyfile_record(&omemo_ctx.sessions_journal, omemo_ctx.sessions_keyfile, "sessions", group, key);
 }
 
 void
 omemo_known_devices_keyfile_save(void)
 {
-    GError *error = NULL;
+    _keyfile_save(&omemo_ctx.known_devices_journal, omemo_ctx.known_devices_keyfile, "known devices");
+}
+
+void
+omemo_store_lock(void)
+{
+    pthread_mutex_lock(&omemo_ctx.store_lock);
+}
 
-    if (!g_key_file_save_to_file(omemo_ctx.known_devices_keyfile, omemo_ctx.known_devices_filename->str, &error)) {
-        log_error("OMEMO: error saving known devices to: %s, %s", omemo_ctx.known_devices_filename->str, error->message);
+void
+omemo_store_unlock(void)
+{
+    pthread_mutex_unlock(&omemo_ctx.store_lock);
+}
+
+/*
+ * Make journalled store changes durable, at most once every
+ * KEYFILE_JOURNAL_SYNC_INTERVAL seconds
+ */
+void
+omemo_poll(void)
+{
+    if (!loaded) {
+        return;
     }
+
+    _journal_sync(&omemo_ctx.identity_journal, FALSE);
+    _journal_sync(&omemo_ctx.trust_journal, FALSE);
+    _journal_sync(&omemo_ctx.sessions_journal, FALSE);
+    _journal_sync(&omemo_ctx.known_devices_journal, FALSE);
+    _store_report_errors();
 }
 
 void
@@ -731,10 +793,11 @@ omemo_on_message_send(ProfWin *win, const char *const message, gboolean request_
         recipients = g_list_append(recipients, strdup(chatwin->barejid));
     }
 
-    GList *device_ids_iter;
-
     omemo_ctx.identity_key_store.recv = false;
 
+    GArray *jobs = g_array_new(FALSE, FALSE, sizeof(OmemoKeyJob));
+    GHashTable *added = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+
     GList *recipients_iter;
     for (recipients_iter = recipients; recipients_iter != NULL; recipients_iter = recipients_iter->next) {
         GList *recipient_device_id = NULL;
@@ -744,78 +807,20 @@ omemo_on_message_send(ProfWin *win, const char *const message, gboolean request_
             continue;
         }
 
-        for (device_ids_iter = recipient_device_id; device_ids_iter != NULL; device_ids_iter = device_ids_iter->next) {
-            int res;
-            ciphertext_message *ciphertext;
-            session_cipher *cipher;
-            signal_protocol_address address = {
-                .name = recipients_iter->data,
-                .name_len = strlen(recipients_iter->data),
-                .device_id = GPOINTER_TO_INT(device_ids_iter->data)
-            };
-
-            res = session_cipher_create(&cipher, omemo_ctx.store, &address, omemo_ctx.signal);
-            if (res != 0) {
-                log_error("OMEMO: cannot create cipher for %s device id %d", address.name, address.device_id);
-                continue;
-            }
-
-            res = session_cipher_encrypt(cipher, key_tag, AES128_GCM_KEY_LENGTH + AES128_GCM_TAG_LENGTH, &ciphertext);
-            session_cipher_free(cipher);
-            if (res != 0) {
-                log_error("OMEMO: cannot encrypt key for %s device id %d", address.name, address.device_id);
-                continue;
-            }
-            signal_buffer *buffer = ciphertext_message_get_serialized(ciphertext);
-            omemo_key_t *key = malloc(sizeof(omemo_key_t));
-            key->length = signal_buffer_len(buffer);
-            key->data = malloc(key->length);
-            memcpy(key->data, signal_buffer_data(buffer), key->length);
-            key->device_id = GPOINTER_TO_INT(device_ids_iter->data);
-            key->prekey = ciphertext_message_get_type(ciphertext) == CIPHERTEXT_PREKEY_TYPE;
-            keys = g_list_append(keys, key);
-            SIGNAL_UNREF(ciphertext);
-        }
+        _key_jobs_add(jobs, added, recipients_iter->data, recipient_device_id);
     }
 
-    g_list_free_full(recipients, free);
-
     if (!muc) {
         GList *sender_device_id = g_hash_table_lookup(omemo_ctx.device_list, jid->barejid);
-        for (device_ids_iter = sender_device_id; device_ids_iter != NULL; device_ids_iter = device_ids_iter->next) {
-            int res;
-            ciphertext_message *ciphertext;
-            session_cipher *cipher;
-            signal_protocol_address address = {
-                .name = jid->barejid,
-                .name_len = strlen(jid->barejid),
-                .device_id = GPOINTER_TO_INT(device_ids_iter->data)
-            };
-
-            res = session_cipher_create(&cipher, omemo_ctx.store, &address, omemo_ctx.signal);
-            if (res != 0) {
-                log_error("OMEMO: cannot create cipher for %s device id %d", address.name, address.device_id);
-                continue;
-            }
-
-            res = session_cipher_encrypt(cipher, key_tag, AES128_GCM_KEY_LENGTH + AES128_GCM_TAG_LENGTH, &ciphertext);
-            session_cipher_free(cipher);
-            if (res != 0) {
-                log_error("OMEMO: cannot encrypt key for %s device id %d", address.name, address.device_id);
-                continue;
-            }
-            signal_buffer *buffer = ciphertext_message_get_serialized(ciphertext);
-            omemo_key_t *key = malloc(sizeof(omemo_key_t));
-            key->length = signal_buffer_len(buffer);
-            key->data = malloc(key->length);
-            memcpy(key->data, signal_buffer_data(buffer), key->length);
-            key->device_id = GPOINTER_TO_INT(device_ids_iter->data);
-            key->prekey = ciphertext_message_get_type(ciphertext) == CIPHERTEXT_PREKEY_TYPE;
-            keys = g_list_append(keys, key);
-            SIGNAL_UNREF(ciphertext);
-        }
+        _key_jobs_add(jobs, added, jid->barejid, sender_device_id);
     }
 
+    keys = _encrypt_keys(jobs, key_tag);
+    g_array_free(jobs, TRUE);
+    g_hash_table_destroy(added);
+
+    g_list_free_full(recipients, free);
+
     if (muc) {
         ProfMucWin *mucwin = (ProfMucWin *)win;
         assert(mucwin->memcheck == PROFMUCWIN_MEMCHECK);
@@ -1231,8 +1236,8 @@ omemo_untrust(const char *const jid, const char *const fingerprint_formatted)
     /* Remove from keyfile */
     char *device_id_str = g_strdup_printf("%d", device_id);
     g_key_file_remove_key(omemo_ctx.trust_keyfile, jid, device_id_str, NULL);
+    omemo_trust_keyfile_record(jid, device_id_str);
     g_free(device_id_str);
-    omemo_trust_keyfile_save();
 
 out:
     free(fingerprint);
@@ -1603,8 +1608,9 @@ _cache_device_identity(const char *const jid, uint32_t device_id, ec_public_key
 
     char *device_id_str = g_strdup_printf("%d", device_id);
     g_key_file_set_string(omemo_ctx.known_devices_keyfile, jid, device_id_str, fingerprint);
+    _keyfile_record(&omemo_ctx.known_devices_journal, omemo_ctx.known_devices_keyfile, "known devices",
+        jid, device_id_str);
     g_free(device_id_str);
-    omemo_known_devices_keyfile_save();
 
     char *formatted_fingerprint = omemo_format_fingerprint(fingerprint);
     autocomplete_add(omemo_ctx.fingerprint_ac, formatted_fingerprint);
@@ -1648,3 +1654,274 @@ _generate_signed_pre_key(void)
     signal_protocol_signed_pre_key_store_key(omemo_ctx.store, signed_pre_key);
     SIGNAL_UNREF(signed_pre_key);
 }
+
+static void
+_keyfile_save(KeyfileJournal *journal, GKeyFile *keyfile, const char *const what)
+{
+    GError *error = NULL;
+    if (!keyfile_journal_save(journal, keyfile, &error)) {
+        log_error("OMEMO: error saving %s, %s", what, error->message);
+        g_error_free(error);
+    }
+}
+
+static void
+_keyfile_record(KeyfileJournal *journal, GKeyFile *keyfile, const char *const what,
+    const char *const group, const char *const key)
+{
+    GError *error = NULL;
+    if (!keyfile_journal_record(journal, keyfile, group, key, &error)) {
+        // key encryption workers get here, they leave logging to the main thread
+        gchar *message = g_strdup_printf("OMEMO: error recording %s change, %s", what, error->message);
+        pthread_mutex_lock(&omemo_ctx.store_lock);
+        omemo_ctx.store_errors = g_slist_append(omemo_ctx.store_errors, message);
+        pthread_mutex_unlock(&omemo_ctx.store_lock);
+        g_error_free(error);
+    }
+}
+
+static void
+_journal_sync(KeyfileJournal *journal, gboolean force)
+{
+    GError *error = NULL;
+    if (!keyfile_journal_sync(journal, force, &error)) {
+        log_error("OMEMO: %s", error->message);
+        g_error_free(error);
+    }
+}
+
+static void
+_journal_close(KeyfileJournal *journal)
+{
+    GError *error = NULL;
+    if (!keyfile_journal_close(journal, &error)) {
+        log_error("OMEMO: %s", error->message);
+        g_error_free(error);
+    }
+}
+
+static void
+_store_report_errors(void)
+{
+    pthread_mutex_lock(&omemo_ctx.store_lock);
+    GSList *errors = omemo_ctx.store_errors;
+    omemo_ctx.store_errors = NULL;
+    pthread_mutex_unlock(&omemo_ctx.store_lock);
+
+    GSList *curr;
+    for (curr = errors; curr != NULL; curr = g_slist_next(curr)) {
+        log_error("%s", (char *)curr->data);
+    }
+    g_slist_free_full(errors, g_free);
+}
+
+/*
+ * Create a store context over the shared omemo stores, each signal context
+ * encrypting keys needs its own
+ */
+static signal_protocol_store_context*
+_store_context_new(signal_context *signal)
+{
+    signal_protocol_store_context *store = NULL;
+    if (signal_protocol_store_context_create(&store, signal) != 0) {
+        return NULL;
+    }
+
+    signal_protocol_session_store session_store = {
+        .load_session_func = load_session,
+        .get_sub_device_sessions_func = get_sub_device_sessions,
+        .store_session_func = store_session,
+        .contains_session_func = contains_session,
+        .delete_session_func = delete_session,
+        .delete_all_sessions_func = delete_all_sessions,
+        .destroy_func = NULL,
+        .user_data = omemo_ctx.session_store
+    };
+    signal_protocol_store_context_set_session_store(store, &session_store);
+
+    signal_protocol_pre_key_store pre_key_store = {
+        .load_pre_key = load_pre_key,
+        .store_pre_key = store_pre_key,
+        .contains_pre_key = contains_pre_key,
+        .remove_pre_key = remove_pre_key,
+        .destroy_func = NULL,
+        .user_data = omemo_ctx.pre_key_store
+    };
+    signal_protocol_store_context_set_pre_key_store(store, &pre_key_store);
+
+    signal_protocol_signed_pre_key_store signed_pre_key_store = {
+        .load_signed_pre_key = load_signed_pre_key,
+        .store_signed_pre_key = store_signed_pre_key,
+        .contains_signed_pre_key = contains_signed_pre_key,
+        .remove_signed_pre_key = remove_signed_pre_key,
+        .destroy_func = NULL,
+        .user_data = omemo_ctx.signed_pre_key_store
+    };
+    signal_protocol_store_context_set_signed_pre_key_store(store, &signed_pre_key_store);
+
+    signal_protocol_identity_key_store identity_key_store = {
+        .get_identity_key_pair = get_identity_key_pair,
+        .get_local_registration_id = get_local_registration_id,
+        .save_identity = save_identity,
+        .is_trusted_identity = is_trusted_identity,
+        .destroy_func = NULL,
+        .user_data = &omemo_ctx.identity_key_store
+    };
+    signal_protocol_store_context_set_identity_key_store(store, &identity_key_store);
+
+    return store;
+}
+
+/*
+ * Add a job for each device of name not already added, a contact can be both
+ * a recipient and ourselves, or in a room under several nicks
+ */
+static void
+_key_jobs_add(GArray *jobs, GHashTable *added, const char *const name, GList *device_ids)
+{
+    GList *curr;
+    for (curr = device_ids; curr != NULL; curr = curr->next) {
+        uint32_t device_id = GPOINTER_TO_INT(curr->data);
+        gchar *address = g_strdup_printf("%u:%s", device_id, name);
+        if (g_hash_table_contains(added, address)) {
+            g_free(address);
+            continue;
+        }
+        g_hash_table_add(added, address);
+
+        OmemoKeyJob job = {
+            .name = name,
+            .device_id = device_id,
+            .key = NULL,
+            .cipher_failed = FALSE
+        };
+        g_array_append_val(jobs, job);
+    }
+}
+
+/*
+ * Encrypt the message key for every device in jobs. Large fan-outs are
+ * shared with a pool of threads, each with its own signal context, while the
+ * main thread holds the omemo lock. Keys are returned in job order.
+ */
+static GList*
+_encrypt_keys(GArray *jobs, const unsigned char *const key_tag)
+{
+    OmemoKeyJobs key_jobs = {
+        .jobs = (OmemoKeyJob *)jobs->data,
+        .count = jobs->len,
+        .next = 0,
+        .key_tag = key_tag
+    };
+
+    int workers = key_jobs.count / OMEMO_KEY_JOBS_PER_WORKER;
+    if (workers > 0 && !omemo_ctx.key_pool) {
+        long cores = sysconf(_SC_NPROCESSORS_ONLN);
+        omemo_ctx.key_pool = worker_pool_new(CLAMP(cores - 1, 0, OMEMO_KEY_WORKERS_MAX), _key_worker_new,
+            _key_worker_free, NULL);
+    }
+
+    OmemoKeyWorker main_worker = {
+        .signal = omemo_ctx.signal,
+        .store = omemo_ctx.store
+    };
+
+    _lock(&omemo_ctx);
+    if (workers > 0) {
+        worker_pool_run(omemo_ctx.key_pool, workers, _encrypt_keys_run, &key_jobs, &main_worker);
+    } else {
+        _encrypt_keys_run(&main_worker, &key_jobs);
+    }
+    _unlock(&omemo_ctx);
+
+    _store_report_errors();
+
+    GList *keys = NULL;
+    int i;
+    for (i = 0; i < key_jobs.count; i++) {
+        OmemoKeyJob *job = &key_jobs.jobs[i];
+        if (job->key) {
+            keys = g_list_prepend(keys, job->key);
+        } else if (job->cipher_failed) {
+            log_error("OMEMO: cannot create cipher for %s device id %d", job->name, job->device_id);
+        } else {
+            log_error("OMEMO: cannot encrypt key for %s device id %d", job->name, job->device_id);
+        }
+    }
+
+    return g_list_reverse(keys);
+}
+
+static void
+_encrypt_keys_run(void *state, void *data)
+{
+    OmemoKeyWorker *worker = state;
+    OmemoKeyJobs *jobs = data;
+    gint i;
+    while ((i = g_atomic_int_add(&jobs->next, 1)) < jobs->count) {
+        OmemoKeyJob *job = &jobs->jobs[i];
+        ciphertext_message *ciphertext;
+        session_cipher *cipher;
+        signal_protocol_address address = {
+            .name = job->name,
+            .name_len = strlen(job->name),
+            .device_id = job->device_id
+        };
+
+        int res = session_cipher_create(&cipher, worker->store, &address, worker->signal);
+        if (res != 0) {
+            job->cipher_failed = TRUE;
+            continue;
+        }
+
+        res = session_cipher_encrypt(cipher, jobs->key_tag, AES128_GCM_KEY_LENGTH + AES128_GCM_TAG_LENGTH, &ciphertext);
+        session_cipher_free(cipher);
+        if (res != 0) {
+            continue;
+        }
+        signal_buffer *buffer = ciphertext_message_get_serialized(ciphertext);
+        omemo_key_t *key = malloc(sizeof(omemo_key_t));
+        key->length = signal_buffer_len(buffer);
+        key->data = malloc(key->length);
+        memcpy(key->data, signal_buffer_data(buffer), key->length);
+        key->device_id = job->device_id;
+        key->prekey = ciphertext_message_get_type(ciphertext) == CIPHERTEXT_PREKEY_TYPE;
+        job->key = key;
+        SIGNAL_UNREF(ciphertext);
+    }
+}
+
+// signal contexts are not shared between threads, so workers have no locking
+// or logging functions of their own, errors are logged by the main thread
+static void*
+_key_worker_new(void *userdata)
+{
+    signal_context *signal = NULL;
+    if (signal_context_create(&signal, NULL) != 0) {
+        return NULL;
+    }
+
+    signal_protocol_store_context *store = NULL;
+    if (signal_context_set_crypto_provider(signal, &crypto_provider) == 0) {
+        store = _store_context_new(signal);
+    }
+    if (!store) {
+        signal_context_destroy(signal);
+        return NULL;
+    }
+
+    OmemoKeyWorker *worker = malloc(sizeof(OmemoKeyWorker));
+    worker->signal = signal;
+    worker->store = store;
+
+    return worker;
+}
+
+static void
+_key_worker_free(void *state)
+{
+    OmemoKeyWorker *worker = state;
+    signal_protocol_store_context_destroy(worker->store);
+    signal_context_destroy(worker->signal);
+    free(worker);
+}
@@ -72,10 +72,17 @@ void omemo_prekeys(GList **prekeys, GList **ids, GList **lengths);
 void omemo_set_device_list(const char *const jid, GList * device_list);
 GKeyFile *omemo_identity_keyfile(void);
 void omemo_identity_keyfile_save(void);
+void omemo_identity_keyfile_record(const char *const group, const char *const key);
 GKeyFile *omemo_trust_keyfile(void);
 void omemo_trust_keyfile_save(void);
+void omemo_trust_keyfile_record(const char *const group, const char *const key);
 GKeyFile *omemo_sessions_keyfile(void);
 void omemo_sessions_keyfile_save(void);
+void omemo_sessions_keyfile_record(const char *const group, const char *const key);
+void omemo_known_devices_keyfile_save(void);
+void omemo_poll(void);
+void omemo_store_lock(void);
+void omemo_store_unlock(void);
 char *omemo_format_fingerprint(const char *const fingerprint);
 char *omemo_own_fingerprint(gboolean formatted);
 void omemo_trust(const char *const jid, const char *const fingerprint);
@@ -77,21 +77,25 @@ load_session(signal_buffer **record, signal_buffer **user_record,
     const signal_protocol_address *address, void *user_data)
 #endif
 {
+    omemo_store_lock();
     GHashTable *session_store = (GHashTable *)user_data;
     GHashTable *device_store = NULL;
 
     device_store = g_hash_table_lookup(session_store, address->name);
     if (!device_store) {
         *record = NULL;
+        omemo_store_unlock();
         return 0;
     }
 
     signal_buffer *original = g_hash_table_lookup(device_store, GINT_TO_POINTER(address->device_id));
     if (!original) {
         *record = NULL;
+        omemo_store_unlock();
         return 0;
     }
     *record = signal_buffer_copy(original);
+    omemo_store_unlock();
     return 1;
 }
 
@@ -99,6 +103,7 @@ int
 get_sub_device_sessions(signal_int_list **sessions, const char *name,
     size_t name_len, void *user_data)
 {
+    omemo_store_lock();
     GHashTable *session_store = (GHashTable *)user_data;
     GHashTable *device_store = NULL;
     GHashTableIter iter;
@@ -106,6 +111,7 @@ get_sub_device_sessions(signal_int_list **sessions, const char *name,
 
     device_store = g_hash_table_lookup(session_store, name);
     if (!device_store) {
+        omemo_store_unlock();
         return SG_SUCCESS;
     }
 
@@ -116,6 +122,7 @@ get_sub_device_sessions(signal_int_list **sessions, const char *name,
     }
 
 
+    omemo_store_unlock();
     return SG_SUCCESS;
 }
 
@@ -131,6 +138,7 @@ store_session(const signal_protocol_address *address,
     void *user_data)
 #endif
 {
+    omemo_store_lock();
     GHashTable *session_store = (GHashTable *)user_data;
     GHashTable *device_store = NULL;
 
@@ -147,40 +155,46 @@ store_session(const signal_protocol_address *address,
     char *record_b64 = g_base64_encode(record, record_len);
     char *device_id = g_strdup_printf("%d", address->device_id);
     g_key_file_set_string(omemo_sessions_keyfile(), address->name, device_id, record_b64);
+    omemo_sessions_keyfile_record(address->name, device_id);
     free(device_id);
     g_free(record_b64);
 
-    omemo_sessions_keyfile_save();
-
+    omemo_store_unlock();
     return SG_SUCCESS;
 }
 
 int
 contains_session(const signal_protocol_address *address, void *user_data)
 {
+    omemo_store_lock();
     GHashTable *session_store = (GHashTable *)user_data;
     GHashTable *device_store = NULL;
 
     device_store = g_hash_table_lookup(session_store, address->name);
     if (!device_store) {
+        omemo_store_unlock();
         return 0;
     }
 
     if (!g_hash_table_lookup(device_store, GINT_TO_POINTER(address->device_id))) {
+        omemo_store_unlock();
         return 0;
     }
 
+    omemo_store_unlock();
     return 1;
 }
 
 int
 delete_session(const signal_protocol_address *address, void *user_data)
 {
+    omemo_store_lock();
     GHashTable *session_store = (GHashTable *)user_data;
     GHashTable *device_store = NULL;
 
     device_store = g_hash_table_lookup(session_store, address->name);
     if (!device_store) {
+        omemo_store_unlock();
         return SG_SUCCESS;
     }
 
@@ -188,25 +202,29 @@ delete_session(const signal_protocol_address *address, void *user_data)
 
     char *device_id_str = g_strdup_printf("%d", address->device_id);
     g_key_file_remove_key(omemo_sessions_keyfile(), address->name, device_id_str, NULL);
+    omemo_sessions_keyfile_record(address->name, device_id_str);
     g_free(device_id_str);
-    omemo_sessions_keyfile_save();
 
+    omemo_store_unlock();
     return SG_SUCCESS;
 }
 
 int
 delete_all_sessions(const char *name, size_t name_len, void *user_data)
 {
+    omemo_store_lock();
     GHashTable *session_store = (GHashTable *)user_data;
     GHashTable *device_store = NULL;
 
     device_store = g_hash_table_lookup(session_store, name);
     if (!device_store) {
+        omemo_store_unlock();
         return SG_SUCCESS;
     }
 
     guint len = g_hash_table_size(device_store);
     g_hash_table_remove_all(device_store);
+    omemo_store_unlock();
     return len;
 }
 
@@ -238,11 +256,10 @@ store_pre_key(uint32_t pre_key_id, uint8_t *record, size_t record_len,
     char *pre_key_id_str = g_strdup_printf("%d", pre_key_id);
     char *record_b64 = g_base64_encode(record, record_len);
     g_key_file_set_string(omemo_identity_keyfile(), OMEMO_STORE_GROUP_PREKEYS, pre_key_id_str, record_b64);
+    omemo_identity_keyfile_record(OMEMO_STORE_GROUP_PREKEYS, pre_key_id_str);
     g_free(pre_key_id_str);
     g_free(record_b64);
 
-    omemo_identity_keyfile_save();
-
     return SG_SUCCESS;
 }
 
@@ -264,10 +281,9 @@ remove_pre_key(uint32_t pre_key_id, void *user_data)
     /* Long term storage */
     char *pre_key_id_str = g_strdup_printf("%d", pre_key_id);
     g_key_file_remove_key(omemo_identity_keyfile(), OMEMO_STORE_GROUP_PREKEYS, pre_key_id_str, NULL);
+    omemo_identity_keyfile_record(OMEMO_STORE_GROUP_PREKEYS, pre_key_id_str);
     g_free(pre_key_id_str);
 
-    omemo_identity_keyfile_save();
-
     if (ret > 0) {
         return SG_SUCCESS;
     } else {
@@ -304,11 +320,10 @@ store_signed_pre_key(uint32_t signed_pre_key_id, uint8_t *record,
     char *signed_pre_key_id_str = g_strdup_printf("%d", signed_pre_key_id);
     char *record_b64 = g_base64_encode(record, record_len);
     g_key_file_set_string(omemo_identity_keyfile(), OMEMO_STORE_GROUP_SIGNED_PREKEYS, signed_pre_key_id_str, record_b64);
+    omemo_identity_keyfile_record(OMEMO_STORE_GROUP_SIGNED_PREKEYS, signed_pre_key_id_str);
     g_free(signed_pre_key_id_str);
     g_free(record_b64);
 
-    omemo_identity_keyfile_save();
-
     return SG_SUCCESS;
 }
 
@@ -330,10 +345,9 @@ remove_signed_pre_key(uint32_t signed_pre_key_id, void *user_data)
     /* Long term storage */
     char *signed_pre_key_id_str = g_strdup_printf("%d", signed_pre_key_id);
     g_key_file_remove_key(omemo_identity_keyfile(), OMEMO_STORE_GROUP_PREKEYS, signed_pre_key_id_str, NULL);
+    omemo_identity_keyfile_record(OMEMO_STORE_GROUP_PREKEYS, signed_pre_key_id_str);
     g_free(signed_pre_key_id_str);
 
-    omemo_identity_keyfile_save();
-
     return ret;
 }
 
@@ -363,6 +377,7 @@ int
 save_identity(const signal_protocol_address *address, uint8_t *key_data,
     size_t key_len, void *user_data)
 {
+    omemo_store_lock();
     identity_key_store_t *identity_key_store = (identity_key_store_t *)user_data;
 
     if (identity_key_store->recv) {
@@ -373,6 +388,7 @@ save_identity(const signal_protocol_address *address, uint8_t *key_data,
         identity_key_store->recv = true;
         if (trusted == 0) {
             /* If not trusted we just don't save the identity */
+            omemo_store_unlock();
             return SG_SUCCESS;
         }
     }
@@ -390,11 +406,11 @@ save_identity(const signal_protocol_address *address, uint8_t *key_data,
     char *key_b64 = g_base64_encode(key_data, key_len);
     char *device_id = g_strdup_printf("%d", address->device_id);
     g_key_file_set_string(omemo_trust_keyfile(), address->name, device_id, key_b64);
+    omemo_trust_keyfile_record(address->name, device_id);
     g_free(device_id);
     g_free(key_b64);
 
-    omemo_trust_keyfile_save();
-
+    omemo_store_unlock();
     return SG_SUCCESS;
 }
 
@@ -402,14 +418,17 @@ int
 is_trusted_identity(const signal_protocol_address *address, uint8_t *key_data,
     size_t key_len, void *user_data)
 {
+    omemo_store_lock();
     int ret;
     identity_key_store_t *identity_key_store = (identity_key_store_t *)user_data;
 
     GHashTable *trusted = g_hash_table_lookup(identity_key_store->trusted, address->name);
     if (!trusted) {
         if (identity_key_store->recv) {
+            omemo_store_unlock();
             return 1;
         } else {
+            omemo_store_unlock();
             return 0;
         }
     }
@@ -423,8 +442,10 @@ is_trusted_identity(const signal_protocol_address *address, uint8_t *key_data,
 
 
     if (identity_key_store->recv) {
+        omemo_store_unlock();
         return 1;
     } else {
+        omemo_store_unlock();
         return ret;
     }
 }
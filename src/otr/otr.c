@@ -44,6 +44,7 @@
 #include "config/files.h"
 #include "otr/otr.h"
 #include "otr/otrlib.h"
+#include "tools/worker.h"
 #include "ui/ui.h"
 #include "ui/window_list.h"
 #include "xmpp/chat_session.h"
@@ -61,6 +62,24 @@ static char *jid;
 static gboolean data_loaded;
 static GHashTable *smp_initiators;
 
+#define OTR_KEYGEN_PROGRESS_SECS 5
+
+typedef struct otr_keygen_t {
+    void *newkey;
+    GString *basedir;
+    gcry_error_t err;
+} OtrKeygen;
+
+static Worker keygen_worker;
+static OtrKeygen *keygen;
+static GTimer *keygen_timer;
+static int keygen_reported;
+static gboolean keygen_abandoned;
+
+static void _otr_keygen_calculate(void *data);
+static void _otr_keygen_complete(void *data);
+static void _otr_keygen_abandon(void);
+
 OtrlUserState
 otr_userstate(void)
 {
@@ -194,6 +213,8 @@ otr_init(void)
 void
 otr_shutdown(void)
 {
+    _otr_keygen_abandon();
+
     if (jid) {
         free(jid);
         jid = NULL;
@@ -204,6 +225,20 @@ void
 otr_poll(void)
 {
     otrlib_poll();
+
+    if (keygen_worker == NULL) {
+        return;
+    }
+
+    if (keygen) {
+        int elapsed = g_timer_elapsed(keygen_timer, NULL);
+        if (elapsed / OTR_KEYGEN_PROGRESS_SECS > keygen_reported) {
+            keygen_reported = elapsed / OTR_KEYGEN_PROGRESS_SECS;
+            cons_show("Still generating private key (%d seconds)...", elapsed);
+        }
+    }
+
+    worker_poll(keygen_worker);
 }
 
 void
@@ -232,6 +267,8 @@ otr_on_connect(ProfAccount *account)
     }
 
     if (user_state) {
+        // a pending key belongs to the old user state, finish with it first
+        _otr_keygen_abandon();
         otrl_userstate_free(user_state);
     }
     user_state = otrl_userstate_create();
@@ -386,6 +423,11 @@ otr_keygen(ProfAccount *account)
         return;
     }
 
+    if (keygen) {
+        cons_show("OTR key generation already in progress.");
+        return;
+    }
+
     if (jid) {
         free(jid);
     }
@@ -408,63 +450,31 @@ otr_keygen(ProfAccount *account)
         return;
     }
 
-    gcry_error_t err = 0;
-
-    GString *keysfilename = g_string_new(basedir->str);
-    g_string_append(keysfilename, "keys.txt");
-    log_debug("Generating private key file %s for %s", keysfilename->str, jid);
-    cons_show("Generating private key, this may take some time.");
-    cons_show("Moving the mouse randomly around the screen may speed up the process!");
-    ui_update();
-    err = otrl_privkey_generate(user_state, keysfilename->str, account->jid, "xmpp");
+    void *newkey = NULL;
+    gcry_error_t err = otrlib_keygen_start(user_state, account->jid, &newkey);
     if (err != GPG_ERR_NO_ERROR) {
         g_string_free(basedir, TRUE);
-        g_string_free(keysfilename, TRUE);
-        log_error("Failed to generate private key");
+        log_error("Failed to start private key generation");
         cons_show_error("Failed to generate private key");
         return;
     }
-    log_info("Private key generated");
-    cons_show("");
-    cons_show("Private key generation complete.");
 
-    GString *fpsfilename = g_string_new(basedir->str);
-    g_string_append(fpsfilename, "fingerprints.txt");
-    log_debug("Generating fingerprints file %s for %s", fpsfilename->str, jid);
-    err = otrl_privkey_write_fingerprints(user_state, fpsfilename->str);
-    if (err != GPG_ERR_NO_ERROR) {
-        g_string_free(basedir, TRUE);
-        g_string_free(keysfilename, TRUE);
-        log_error("Failed to create fingerprints file");
-        cons_show_error("Failed to create fingerprints file");
-        return;
-    }
-    log_info("Fingerprints file created");
+    log_debug("Generating private key for %s", jid);
+    cons_show("Generating private key, this may take some time.");
+    cons_show("Moving the mouse randomly around the screen may speed up the process!");
 
-    err = otrl_privkey_read(user_state, keysfilename->str);
-    if (err != GPG_ERR_NO_ERROR) {
-        g_string_free(basedir, TRUE);
-        g_string_free(keysfilename, TRUE);
-        log_error("Failed to load private key");
-        data_loaded = FALSE;
-        return;
-    }
+    // the key is calculated on the worker thread, finished in otr_poll
+    keygen = malloc(sizeof(OtrKeygen));
+    keygen->newkey = newkey;
+    keygen->basedir = basedir;
+    keygen->err = GPG_ERR_NO_ERROR;
+    keygen_timer = g_timer_new();
+    keygen_reported = 0;
 
-    err = otrl_privkey_read_fingerprints(user_state, fpsfilename->str, NULL, NULL);
-    if (err != GPG_ERR_NO_ERROR) {
-        g_string_free(basedir, TRUE);
-        g_string_free(keysfilename, TRUE);
-        log_error("Failed to load fingerprints");
-        data_loaded = FALSE;
-        return;
+    if (keygen_worker == NULL) {
+        keygen_worker = worker_new();
     }
-
-    data_loaded = TRUE;
-
-    g_string_free(basedir, TRUE);
-    g_string_free(keysfilename, TRUE);
-    g_string_free(fpsfilename, TRUE);
-    return;
+    worker_submit(keygen_worker, _otr_keygen_calculate, _otr_keygen_complete, keygen);
 }
 
 gboolean
@@ -797,3 +807,100 @@ otr_free_message(char *message)
 {
     otrl_message_free(message);
 }
+
+static void
+_otr_keygen_calculate(void *data)
+{
+    OtrKeygen *job = data;
+    job->err = otrlib_keygen_calculate(job->newkey);
+}
+
+static void
+_otr_keygen_abandon(void)
+{
+    if (keygen_worker == NULL) {
+        return;
+    }
+
+    // waits for a key still being calculated, which is then discarded
+    keygen_abandoned = TRUE;
+    worker_free(keygen_worker);
+    keygen_worker = NULL;
+    keygen_abandoned = FALSE;
+}
+
+static void
+_otr_keygen_complete(void *data)
+{
+    OtrKeygen *job = data;
+    keygen = NULL;
+    g_timer_destroy(keygen_timer);
+    keygen_timer = NULL;
+
+    GString *basedir = job->basedir;
+    gcry_error_t err = job->err;
+
+    if (keygen_abandoned || err != GPG_ERR_NO_ERROR) {
+        otrlib_keygen_cancel(user_state, job->newkey);
+        free(job);
+        g_string_free(basedir, TRUE);
+        if (!keygen_abandoned) {
+            log_error("Failed to generate private key");
+            cons_show_error("Failed to generate private key");
+        }
+        return;
+    }
+
+    GString *keysfilename = g_string_new(basedir->str);
+    g_string_append(keysfilename, "keys.txt");
+    log_debug("Writing private key file %s", keysfilename->str);
+    err = otrlib_keygen_finish(user_state, job->newkey, keysfilename->str);
+    free(job);
+    if (err != GPG_ERR_NO_ERROR) {
+        g_string_free(basedir, TRUE);
+        g_string_free(keysfilename, TRUE);
+        log_error("Failed to generate private key");
+        cons_show_error("Failed to generate private key");
+        return;
+    }
+    log_info("Private key generated");
+    cons_show("");
+    cons_show("Private key generation complete.");
+
+    GString *fpsfilename = g_string_new(basedir->str);
+    g_string_append(fpsfilename, "fingerprints.txt");
+    log_debug("Generating fingerprints file %s", fpsfilename->str);
+    err = otrl_privkey_write_fingerprints(user_state, fpsfilename->str);
+    if (err != GPG_ERR_NO_ERROR) {
+        g_string_free(basedir, TRUE);
+        g_string_free(keysfilename, TRUE);
+        log_error("Failed to create fingerprints file");
+        cons_show_error("Failed to create fingerprints file");
+        return;
+    }
+    log_info("Fingerprints file created");
+
+    err = otrl_privkey_read(user_state, keysfilename->str);
+    if (err != GPG_ERR_NO_ERROR) {
+        g_string_free(basedir, TRUE);
+        g_string_free(keysfilename, TRUE);
+        log_error("Failed to load private key");
+        data_loaded = FALSE;
+        return;
+    }
+
+    err = otrl_privkey_read_fingerprints(user_state, fpsfilename->str, NULL, NULL);
+    if (err != GPG_ERR_NO_ERROR) {
+        g_string_free(basedir, TRUE);
+        g_string_free(keysfilename, TRUE);
+        log_error("Failed to load fingerprints");
+        data_loaded = FALSE;
+        return;
+    }
+
+    data_loaded = TRUE;
+
+    g_string_free(basedir, TRUE);
+    g_string_free(keysfilename, TRUE);
+    g_string_free(fpsfilename, TRUE);
+}
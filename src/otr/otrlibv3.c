@@ -32,6 +32,9 @@
  * source files in the program, then also delete it here.
  *
  */
+#include <stdlib.h>
+#include <string.h>
+
 #include <libotr/proto.h>
 #include <libotr/privkey.h>
 #include <libotr/message.h>
@@ -77,6 +80,35 @@ otrlib_init_ops(OtrlMessageAppOps *ops)
     ops->display_otr_message = cb_display_otr_message;
 }
 
+gcry_error_t
+otrlib_keygen_start(OtrlUserState user_state, const char *const accountname, void **newkey)
+{
+    *newkey = strdup(accountname);
+    return GPG_ERR_NO_ERROR;
+}
+
+gcry_error_t
+otrlib_keygen_calculate(void *newkey)
+{
+    // libotr 3 generates the key in one step, done in otrlib_keygen_finish
+    return GPG_ERR_NO_ERROR;
+}
+
+gcry_error_t
+otrlib_keygen_finish(OtrlUserState user_state, void *newkey, const char *const filename)
+{
+    gcry_error_t err = otrl_privkey_generate(user_state, filename, newkey, "xmpp");
+    free(newkey);
+
+    return err;
+}
+
+void
+otrlib_keygen_cancel(OtrlUserState user_state, void *newkey)
+{
+    free(newkey);
+}
+
 ConnContext*
 otrlib_context_find(OtrlUserState user_state, const char *const recipient, char *jid)
 {
@@ -254,6 +254,30 @@ otrlib_init_ops(OtrlMessageAppOps *ops)
     ops->timer_control = cb_timer_control;
 }
 
+gcry_error_t
+otrlib_keygen_start(OtrlUserState user_state, const char *const accountname, void **newkey)
+{
+    return otrl_privkey_generate_start(user_state, accountname, "xmpp", newkey);
+}
+
+gcry_error_t
+otrlib_keygen_calculate(void *newkey)
+{
+    return otrl_privkey_generate_calculate(newkey);
+}
+
+gcry_error_t
+otrlib_keygen_finish(OtrlUserState user_state, void *newkey, const char *const filename)
+{
+    return otrl_privkey_generate_finish(user_state, newkey, filename);
+}
+
+void
+otrlib_keygen_cancel(OtrlUserState user_state, void *newkey)
+{
+    otrl_privkey_generate_cancelled(user_state, newkey);
+}
+
 ConnContext*
 otrlib_context_find(OtrlUserState user_state, const char *const recipient, char *jid)
 {
@@ -50,6 +50,7 @@
 #include "pgp/gpg.h"
 #include "config/files.h"
 #include "tools/autocomplete.h"
+#include "tools/worker.h"
 #include "ui/ui.h"
 
 #define PGP_SIGNATURE_HEADER "-----BEGIN PGP SIGNATURE-----"
@@ -68,9 +69,37 @@ static char *passphrase_attempt;
 
 static Autocomplete key_ac;
 
+// key lookups and encryption run here, results are applied in p_gpg_poll
+static Worker worker;
+static guint connection_id;
+
+typedef struct gpg_keyload_t {
+    guint connection_id;
+    gchar **jids;
+    gchar **keyids;
+    gboolean *found;
+    gsize len;
+} GPGKeyLoad;
+
+typedef struct gpg_encrypt_t {
+    guint connection_id;
+    char *keyid;
+    char *message;
+    char *fp;
+    char *encrypted;
+    char *err_str;
+    p_gpg_encrypted_cb callback;
+    void *userdata;
+} GPGEncrypt;
+
 static char* _remove_header_footer(char *str, const char *const footer);
 static char* _add_header_footer(const char *const str, const char *const header, const char *const footer);
 static void _save_pubkeys(void);
+static char* _p_gpg_encrypt_to(const char *const keyid, const char *const message, const char *const fp, char **err_str);
+static void _p_gpg_keyload_run(void *data);
+static void _p_gpg_keyload_done(void *data);
+static void _p_gpg_encrypt_run(void *data);
+static void _p_gpg_encrypt_done(void *data);
 
 void
 _p_gpg_free_pubkeyid(ProfPGPPubKeyId *pubkeyid)
@@ -123,11 +152,19 @@ p_gpg_init(void)
 
     passphrase = NULL;
     passphrase_attempt = NULL;
+
+    worker = worker_new();
 }
 
 void
 p_gpg_close(void)
 {
+    if (worker) {
+        connection_id++;
+        worker_free(worker);
+        worker = NULL;
+    }
+
     if (pubkeys) {
         g_hash_table_destroy(pubkeys);
         pubkeys = NULL;
@@ -190,47 +227,29 @@ p_gpg_on_connect(const char *const barejid)
     pubkeyfile = g_key_file_new();
     g_key_file_load_from_file(pubkeyfile, pubsloc, G_KEY_FILE_KEEP_COMMENTS, NULL);
 
-    // load each keyid
-    gsize len = 0;
-    gchar **jids = g_key_file_get_groups(pubkeyfile, &len);
-
-    gpgme_ctx_t ctx;
-    gpgme_error_t error = gpgme_new(&ctx);
-
-    if (error) {
-        log_error("GPG: Failed to create gpgme context. %s %s", gpgme_strsource(error), gpgme_strerror(error));
-        g_strfreev(jids);
-        return;
-    }
+    // look up each keyid in the background, gpgme_get_key may have to
+    // start gpg-agent or read a large keyring
+    GPGKeyLoad *keyload = malloc(sizeof(GPGKeyLoad));
+    keyload->connection_id = connection_id;
+    keyload->jids = g_key_file_get_groups(pubkeyfile, &keyload->len);
+    keyload->keyids = g_new0(gchar*, keyload->len);
+    keyload->found = g_new0(gboolean, keyload->len);
 
     int i = 0;
-    for (i = 0; i < len; i++) {
+    for (i = 0; i < keyload->len; i++) {
         GError *gerr = NULL;
-        gchar *jid = jids[i];
+        gchar *jid = keyload->jids[i];
         gchar *keyid = g_key_file_get_string(pubkeyfile, jid, "keyid", &gerr);
         if (gerr) {
             log_error("Error loading PGP key id for %s", jid);
             g_error_free(gerr);
             g_free(keyid);
-        } else {
-            gpgme_key_t key = NULL;
-            error = gpgme_get_key(ctx, keyid, &key, 0);
-            if (error || key == NULL) {
-                log_warning("GPG: Failed to get key for %s: %s %s", jid, gpgme_strsource(error), gpgme_strerror(error));
-                continue;
-            }
-
-            ProfPGPPubKeyId *pubkeyid = malloc(sizeof(ProfPGPPubKeyId));
-            pubkeyid->id = strdup(keyid);
-            pubkeyid->received = FALSE;
-            g_hash_table_replace(pubkeys, strdup(jid), pubkeyid);
-            g_free(keyid);
-            gpgme_key_unref(key);
+            keyid = NULL;
         }
+        keyload->keyids[i] = keyid;
     }
 
-    gpgme_release(ctx);
-    g_strfreev(jids);
+    worker_submit(worker, _p_gpg_keyload_run, _p_gpg_keyload_done, keyload);
 
     _save_pubkeys();
 }
@@ -238,6 +257,9 @@ p_gpg_on_connect(const char *const barejid)
 void
 p_gpg_on_disconnect(void)
 {
+    // key lookups still running belong to the old connection
+    connection_id++;
+
     if (pubkeys) {
         g_hash_table_destroy(pubkeys);
         pubkeys = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, (GDestroyNotify)_p_gpg_free_pubkeyid);
@@ -607,6 +629,57 @@ p_gpg_encrypt(const char *const barejid, const char *const message, const char *
         return NULL;
     }
 
+    char *err_str = NULL;
+    char *result = _p_gpg_encrypt_to(pubkeyid->id, message, fp, &err_str);
+    if (err_str) {
+        log_error("%s", err_str);
+        g_free(err_str);
+    }
+
+    return result;
+}
+
+void
+p_gpg_encrypt_async(const char *const barejid, const char *const message, const char *const fp,
+    p_gpg_encrypted_cb callback, void *userdata)
+{
+    // jobs without a key still go through the worker, so callbacks keep
+    // the order messages were sent in
+    ProfPGPPubKeyId *pubkeyid = g_hash_table_lookup(pubkeys, barejid);
+
+    GPGEncrypt *job = malloc(sizeof(GPGEncrypt));
+    job->connection_id = connection_id;
+    job->keyid = pubkeyid && pubkeyid->id ? strdup(pubkeyid->id) : NULL;
+    job->message = strdup(message);
+    job->fp = strdup(fp);
+    job->encrypted = NULL;
+    job->err_str = NULL;
+    job->callback = callback;
+    job->userdata = userdata;
+
+    worker_submit(worker, _p_gpg_encrypt_run, _p_gpg_encrypt_done, job);
+}
+
+int
+p_gpg_poll(void)
+{
+    if (worker == NULL) {
+        return 0;
+    }
+
+    return worker_poll(worker);
+}
+
+gboolean
+p_gpg_pending(void)
+{
+    return worker && worker_pending(worker) > 0;
+}
+
+static char*
+_p_gpg_encrypt_to(const char *const keyid, const char *const message, const char *const fp, char **err_str)
+{
+    // may run on the worker thread, so errors are returned rather than logged
     gpgme_key_t keys[3];
 
     keys[0] = NULL;
@@ -616,14 +689,14 @@ p_gpg_encrypt(const char *const barejid, const char *const message, const char *
     gpgme_ctx_t ctx;
     gpgme_error_t error = gpgme_new(&ctx);
     if (error) {
-        log_error("GPG: Failed to create gpgme context. %s %s", gpgme_strsource(error), gpgme_strerror(error));
+        *err_str = g_strdup_printf("GPG: Failed to create gpgme context. %s %s", gpgme_strsource(error), gpgme_strerror(error));
         return NULL;
     }
 
     gpgme_key_t receiver_key;
-    error = gpgme_get_key(ctx, pubkeyid->id, &receiver_key, 0);
+    error = gpgme_get_key(ctx, keyid, &receiver_key, 0);
     if (error || receiver_key == NULL) {
-        log_error("GPG: Failed to get receiver_key. %s %s", gpgme_strsource(error), gpgme_strerror(error));
+        *err_str = g_strdup_printf("GPG: Failed to get receiver_key. %s %s", gpgme_strsource(error), gpgme_strerror(error));
         gpgme_release(ctx);
         return NULL;
     }
@@ -632,7 +705,7 @@ p_gpg_encrypt(const char *const barejid, const char *const message, const char *
     gpgme_key_t sender_key = NULL;
     error = gpgme_get_key(ctx, fp, &sender_key, 0);
     if (error || sender_key == NULL) {
-        log_error("GPG: Failed to get sender_key. %s %s", gpgme_strsource(error), gpgme_strerror(error));
+        *err_str = g_strdup_printf("GPG: Failed to get sender_key. %s %s", gpgme_strsource(error), gpgme_strerror(error));
         gpgme_release(ctx);
         return NULL;
     }
@@ -652,7 +725,7 @@ p_gpg_encrypt(const char *const barejid, const char *const message, const char *
     gpgme_key_unref(sender_key);
 
     if (error) {
-        log_error("GPG: Failed to encrypt message. %s %s", gpgme_strsource(error), gpgme_strerror(error));
+        *err_str = g_strdup_printf("GPG: Failed to encrypt message. %s %s", gpgme_strsource(error), gpgme_strerror(error));
         return NULL;
     }
 
@@ -837,3 +910,99 @@ _save_pubkeys(void)
     g_chmod(pubsloc, S_IRUSR | S_IWUSR);
     g_free(g_pubkeys_data);
 }
+
+static void
+_p_gpg_keyload_run(void *data)
+{
+    GPGKeyLoad *keyload = data;
+
+    gpgme_ctx_t ctx;
+    gpgme_error_t error = gpgme_new(&ctx);
+    if (error) {
+        return;
+    }
+
+    int i = 0;
+    for (i = 0; i < keyload->len; i++) {
+        if (keyload->keyids[i] == NULL) {
+            continue;
+        }
+
+        gpgme_key_t key = NULL;
+        error = gpgme_get_key(ctx, keyload->keyids[i], &key, 0);
+        if (!error && key) {
+            keyload->found[i] = TRUE;
+            gpgme_key_unref(key);
+        }
+    }
+
+    gpgme_release(ctx);
+}
+
+static void
+_p_gpg_keyload_done(void *data)
+{
+    GPGKeyLoad *keyload = data;
+    int i = 0;
+
+    if (keyload->connection_id == connection_id) {
+        for (i = 0; i < keyload->len; i++) {
+            gchar *jid = keyload->jids[i];
+            gchar *keyid = keyload->keyids[i];
+            if (keyid == NULL) {
+                continue;
+            }
+            if (!keyload->found[i]) {
+                log_warning("GPG: Failed to get key for %s", jid);
+                continue;
+            }
+
+            // keep keys added or received while the lookup was running
+            if (g_hash_table_contains(pubkeys, jid)) {
+                continue;
+            }
+
+            ProfPGPPubKeyId *pubkeyid = malloc(sizeof(ProfPGPPubKeyId));
+            pubkeyid->id = strdup(keyid);
+            pubkeyid->received = FALSE;
+            g_hash_table_replace(pubkeys, strdup(jid), pubkeyid);
+        }
+    }
+
+    // keyids has a NULL for each unreadable entry, so is not a strv
+    for (i = 0; i < keyload->len; i++) {
+        g_free(keyload->keyids[i]);
+    }
+    g_free(keyload->keyids);
+    g_strfreev(keyload->jids);
+    g_free(keyload->found);
+    free(keyload);
+}
+
+static void
+_p_gpg_encrypt_run(void *data)
+{
+    GPGEncrypt *job = data;
+    if (job->keyid) {
+        job->encrypted = _p_gpg_encrypt_to(job->keyid, job->message, job->fp, &job->err_str);
+    }
+}
+
+static void
+_p_gpg_encrypt_done(void *data)
+{
+    GPGEncrypt *job = data;
+
+    if (job->err_str) {
+        log_error("%s", job->err_str);
+        g_free(job->err_str);
+    }
+
+    job->callback(job->encrypted, job->connection_id == connection_id, job->userdata);
+
+    free(job->encrypted);
+    free(job->keyid);
+    free(job->message);
+    free(job->fp);
+    free(job);
+}
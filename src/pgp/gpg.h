@@ -52,6 +52,10 @@ typedef struct pgp_pubkeyid_t {
     gboolean received;
 } ProfPGPPubKeyId;
 
+// encrypted is NULL when encryption failed, and is freed after the call
+// current is FALSE when the connection the message was queued on has closed
+typedef void (*p_gpg_encrypted_cb)(const char *const encrypted, gboolean current, void *userdata);
+
 void p_gpg_init(void);
 void p_gpg_close(void);
 void p_gpg_on_connect(const char *const barejid);
@@ -66,6 +70,10 @@ const char* p_gpg_libver(void);
 char* p_gpg_sign(const char *const str, const char *const fp);
 void p_gpg_verify(const char *const barejid, const char *const sign);
 char* p_gpg_encrypt(const char *const barejid, const char *const message, const char *const fp);
+void p_gpg_encrypt_async(const char *const barejid, const char *const message, const char *const fp,
+    p_gpg_encrypted_cb callback, void *userdata);
+int p_gpg_poll(void);
+gboolean p_gpg_pending(void);
 char* p_gpg_decrypt(const char *const cipher);
 void p_gpg_free_decrypted(char *decrypted);
 char* p_gpg_autocomplete_key(const char *const search_str, gboolean previous);
@@ -353,6 +353,36 @@ plugins_run_timed(void)
     g_list_free(timed_functions_lists);
 }
 
+gint
+plugins_timed_timeout(void)
+{
+    gint timeout = -1;
+    GList *timed_functions_lists = g_hash_table_get_values(p_timed_functions);
+
+    GList *curr_list = timed_functions_lists;
+    while (curr_list) {
+        GList *curr = curr_list->data;
+        while (curr) {
+            PluginTimedFunction *timed_function = curr->data;
+
+            if (timed_function->interval_seconds > 0) {
+                gdouble remaining = timed_function->interval_seconds - g_timer_elapsed(timed_function->timer, NULL);
+                gint millis = remaining > 0 ? (gint)(remaining * 1000) + 1 : 0;
+                if (timeout < 0 || millis < timeout) {
+                    timeout = millis;
+                }
+            }
+
+            curr = g_list_next(curr);
+        }
+        curr_list = g_list_next(curr_list);
+    }
+
+    g_list_free(timed_functions_lists);
+
+    return timeout;
+}
+
 GList*
 plugins_get_command_names(void)
 {
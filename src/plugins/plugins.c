@@ -65,10 +65,52 @@
 
 static GHashTable *plugins;
 
+// plugin function names for each plugin_hook_t
+static const char *hook_names[PLUGIN_HOOK_COUNT] = {
+    "prof_on_start",
+    "prof_on_shutdown",
+    "prof_on_connect",
+    "prof_on_disconnect",
+    "prof_pre_chat_message_display",
+    "prof_post_chat_message_display",
+    "prof_pre_chat_message_send",
+    "prof_post_chat_message_send",
+    "prof_pre_room_message_display",
+    "prof_post_room_message_display",
+    "prof_pre_room_message_send",
+    "prof_post_room_message_send",
+    "prof_on_room_history_message",
+    "prof_pre_priv_message_display",
+    "prof_post_priv_message_display",
+    "prof_pre_priv_message_send",
+    "prof_post_priv_message_send",
+    "prof_on_message_stanza_send",
+    "prof_on_message_stanza_receive",
+    "prof_on_presence_stanza_send",
+    "prof_on_presence_stanza_receive",
+    "prof_on_iq_stanza_send",
+    "prof_on_iq_stanza_receive",
+    "prof_on_contact_offline",
+    "prof_on_contact_presence",
+    "prof_on_chat_win_focus",
+    "prof_on_room_win_focus"
+};
+
+// loaded plugins implementing each hook
+static GPtrArray *hook_subscribers[PLUGIN_HOOK_COUNT];
+
+static void _plugins_hooks_update(void);
+static char* _plugins_stanza_send(plugin_hook_t hook, const char *const text);
+static gboolean _plugins_stanza_receive(plugin_hook_t hook, const char *const text);
+
 void
 plugins_init(void)
 {
     plugins = g_hash_table_new_full(g_str_hash, g_str_equal, free, NULL);
+    int hook;
+    for (hook = 0; hook < PLUGIN_HOOK_COUNT; hook++) {
+        hook_subscribers[hook] = g_ptr_array_new();
+    }
     callbacks_init();
     autocompleters_init();
     plugin_themes_init();
@@ -114,6 +156,8 @@ plugins_init(void)
             }
         }
 
+        _plugins_hooks_update();
+
         // initialise plugins
         GList *values = g_hash_table_get_values(plugins);
         GList *curr = values;
@@ -260,6 +304,7 @@ plugins_load(const char *const name, GString *error_message)
     }
     if (plugin) {
         g_hash_table_insert(plugins, strdup(name), plugin);
+        _plugins_hooks_update();
         if (connection_get_status() == JABBER_CONNECTED) {
             const char *account_name = session_get_account_name();
             const char *fulljid = connection_get_fulljid();
@@ -320,6 +365,7 @@ plugins_unload(const char *const name)
 #endif
         prefs_remove_plugin(name);
         g_hash_table_remove(plugins, name);
+        _plugins_hooks_update();
 
         caps_reset_ver();
         // resend presence to update server's disco info data for this client
@@ -434,74 +480,82 @@ plugins_close_win(const char *const plugin_name, const char *const tag)
 void
 plugins_on_start(void)
 {
-    GList *values = g_hash_table_get_values(plugins);
-    GList *curr = values;
-    while (curr) {
-        ProfPlugin *plugin = curr->data;
+    if (!plugins_hook_subscribed(PLUGIN_HOOK_ON_START)) {
+        return;
+    }
+
+    GPtrArray *subscribers = hook_subscribers[PLUGIN_HOOK_ON_START];
+    guint i;
+    for (i = 0; i < subscribers->len; i++) {
+        ProfPlugin *plugin = g_ptr_array_index(subscribers, i);
         plugin->on_start_func(plugin);
-        curr = g_list_next(curr);
     }
-    g_list_free(values);
 }
 
 void
 plugins_on_shutdown(void)
 {
-    GList *values = g_hash_table_get_values(plugins);
-    GList *curr = values;
-    while (curr) {
-        ProfPlugin *plugin = curr->data;
+    if (!plugins_hook_subscribed(PLUGIN_HOOK_ON_SHUTDOWN)) {
+        return;
+    }
+
+    GPtrArray *subscribers = hook_subscribers[PLUGIN_HOOK_ON_SHUTDOWN];
+    guint i;
+    for (i = 0; i < subscribers->len; i++) {
+        ProfPlugin *plugin = g_ptr_array_index(subscribers, i);
         plugin->on_shutdown_func(plugin);
-        curr = g_list_next(curr);
     }
-    g_list_free(values);
 }
 
 void
 plugins_on_connect(const char * const account_name, const char * const fulljid)
 {
-    GList *values = g_hash_table_get_values(plugins);
-    GList *curr = values;
-    while (curr) {
-        ProfPlugin *plugin = curr->data;
+    if (!plugins_hook_subscribed(PLUGIN_HOOK_ON_CONNECT)) {
+        return;
+    }
+
+    GPtrArray *subscribers = hook_subscribers[PLUGIN_HOOK_ON_CONNECT];
+    guint i;
+    for (i = 0; i < subscribers->len; i++) {
+        ProfPlugin *plugin = g_ptr_array_index(subscribers, i);
         plugin->on_connect_func(plugin, account_name, fulljid);
-        curr = g_list_next(curr);
     }
-    g_list_free(values);
 }
 
 void
 plugins_on_disconnect(const char * const account_name, const char * const fulljid)
 {
-    GList *values = g_hash_table_get_values(plugins);
-    GList *curr = values;
-    while (curr) {
-        ProfPlugin *plugin = curr->data;
+    if (!plugins_hook_subscribed(PLUGIN_HOOK_ON_DISCONNECT)) {
+        return;
+    }
+
+    GPtrArray *subscribers = hook_subscribers[PLUGIN_HOOK_ON_DISCONNECT];
+    guint i;
+    for (i = 0; i < subscribers->len; i++) {
+        ProfPlugin *plugin = g_ptr_array_index(subscribers, i);
         plugin->on_disconnect_func(plugin, account_name, fulljid);
-        curr = g_list_next(curr);
     }
-    g_list_free(values);
 }
 
 char*
 plugins_pre_chat_message_display(const char * const barejid, const char *const resource, const char *message)
 {
-    char *new_message = NULL;
     char *curr_message = strdup(message);
 
-    GList *values = g_hash_table_get_values(plugins);
-    GList *curr = values;
-    while (curr) {
-        ProfPlugin *plugin = curr->data;
-        new_message = plugin->pre_chat_message_display(plugin, barejid, resource, curr_message);
+    if (!plugins_hook_subscribed(PLUGIN_HOOK_PRE_CHAT_MESSAGE_DISPLAY)) {
+        return curr_message;
+    }
+
+    GPtrArray *subscribers = hook_subscribers[PLUGIN_HOOK_PRE_CHAT_MESSAGE_DISPLAY];
+    guint i;
+    for (i = 0; i < subscribers->len; i++) {
+        ProfPlugin *plugin = g_ptr_array_index(subscribers, i);
+        char *new_message = plugin->pre_chat_message_display(plugin, barejid, resource, curr_message);
         if (new_message) {
             free(curr_message);
-            curr_message = strdup(new_message);
-            free(new_message);
+            curr_message = new_message;
         }
-        curr = g_list_next(curr);
     }
-    g_list_free(values);
 
     return curr_message;
 }
@@ -509,42 +563,38 @@ plugins_pre_chat_message_display(const char * const barejid, const char *const r
 void
 plugins_post_chat_message_display(const char * const barejid, const char *const resource, const char *message)
 {
-    GList *values = g_hash_table_get_values(plugins);
-    GList *curr = values;
-    while (curr) {
-        ProfPlugin *plugin = curr->data;
+    if (!plugins_hook_subscribed(PLUGIN_HOOK_POST_CHAT_MESSAGE_DISPLAY)) {
+        return;
+    }
+
+    GPtrArray *subscribers = hook_subscribers[PLUGIN_HOOK_POST_CHAT_MESSAGE_DISPLAY];
+    guint i;
+    for (i = 0; i < subscribers->len; i++) {
+        ProfPlugin *plugin = g_ptr_array_index(subscribers, i);
         plugin->post_chat_message_display(plugin, barejid, resource, message);
-        curr = g_list_next(curr);
     }
-    g_list_free(values);
 }
 
 char*
 plugins_pre_chat_message_send(const char * const barejid, const char *message)
 {
-    char *new_message = NULL;
     char *curr_message = strdup(message);
 
-    GList *values = g_hash_table_get_values(plugins);
-    GList *curr = values;
-    while (curr) {
-        ProfPlugin *plugin = curr->data;
-        if (plugin->contains_hook(plugin, "prof_pre_chat_message_send")) {
-            new_message = plugin->pre_chat_message_send(plugin, barejid, curr_message);
-            if (new_message) {
-                free(curr_message);
-                curr_message = strdup(new_message);
-                free(new_message);
-            } else {
-                free(curr_message);
-                g_list_free(values);
+    if (!plugins_hook_subscribed(PLUGIN_HOOK_PRE_CHAT_MESSAGE_SEND)) {
+        return curr_message;
+    }
 
-                return NULL;
-            }
+    GPtrArray *subscribers = hook_subscribers[PLUGIN_HOOK_PRE_CHAT_MESSAGE_SEND];
+    guint i;
+    for (i = 0; i < subscribers->len; i++) {
+        ProfPlugin *plugin = g_ptr_array_index(subscribers, i);
+        char *new_message = plugin->pre_chat_message_send(plugin, barejid, curr_message);
+        free(curr_message);
+        if (!new_message) {
+            return NULL;
         }
-        curr = g_list_next(curr);
+        curr_message = new_message;
     }
-    g_list_free(values);
 
     return curr_message;
 }
@@ -552,35 +602,37 @@ plugins_pre_chat_message_send(const char * const barejid, const char *message)
 void
 plugins_post_chat_message_send(const char * const barejid, const char *message)
 {
-    GList *values = g_hash_table_get_values(plugins);
-    GList *curr = values;
-    while (curr) {
-        ProfPlugin *plugin = curr->data;
+    if (!plugins_hook_subscribed(PLUGIN_HOOK_POST_CHAT_MESSAGE_SEND)) {
+        return;
+    }
+
+    GPtrArray *subscribers = hook_subscribers[PLUGIN_HOOK_POST_CHAT_MESSAGE_SEND];
+    guint i;
+    for (i = 0; i < subscribers->len; i++) {
+        ProfPlugin *plugin = g_ptr_array_index(subscribers, i);
         plugin->post_chat_message_send(plugin, barejid, message);
-        curr = g_list_next(curr);
     }
-    g_list_free(values);
 }
 
 char*
 plugins_pre_room_message_display(const char * const barejid, const char * const nick, const char *message)
 {
-    char *new_message = NULL;
     char *curr_message = strdup(message);
 
-    GList *values = g_hash_table_get_values(plugins);
-    GList *curr = values;
-    while (curr) {
-        ProfPlugin *plugin = curr->data;
-        new_message = plugin->pre_room_message_display(plugin, barejid, nick, curr_message);
+    if (!plugins_hook_subscribed(PLUGIN_HOOK_PRE_ROOM_MESSAGE_DISPLAY)) {
+        return curr_message;
+    }
+
+    GPtrArray *subscribers = hook_subscribers[PLUGIN_HOOK_PRE_ROOM_MESSAGE_DISPLAY];
+    guint i;
+    for (i = 0; i < subscribers->len; i++) {
+        ProfPlugin *plugin = g_ptr_array_index(subscribers, i);
+        char *new_message = plugin->pre_room_message_display(plugin, barejid, nick, curr_message);
         if (new_message) {
             free(curr_message);
-            curr_message = strdup(new_message);
-            free(new_message);
+            curr_message = new_message;
         }
-        curr = g_list_next(curr);
     }
-    g_list_free(values);
 
     return curr_message;
 }
@@ -588,42 +640,38 @@ plugins_pre_room_message_display(const char * const barejid, const char * const
 void
 plugins_post_room_message_display(const char * const barejid, const char * const nick, const char *message)
 {
-    GList *values = g_hash_table_get_values(plugins);
-    GList *curr = values;
-    while (curr) {
-        ProfPlugin *plugin = curr->data;
+    if (!plugins_hook_subscribed(PLUGIN_HOOK_POST_ROOM_MESSAGE_DISPLAY)) {
+        return;
+    }
+
+    GPtrArray *subscribers = hook_subscribers[PLUGIN_HOOK_POST_ROOM_MESSAGE_DISPLAY];
+    guint i;
+    for (i = 0; i < subscribers->len; i++) {
+        ProfPlugin *plugin = g_ptr_array_index(subscribers, i);
         plugin->post_room_message_display(plugin, barejid, nick, message);
-        curr = g_list_next(curr);
     }
-    g_list_free(values);
 }
 
 char*
 plugins_pre_room_message_send(const char * const barejid, const char *message)
 {
-    char *new_message = NULL;
     char *curr_message = strdup(message);
 
-    GList *values = g_hash_table_get_values(plugins);
-    GList *curr = values;
-    while (curr) {
-        ProfPlugin *plugin = curr->data;
-        if (plugin->contains_hook(plugin, "prof_pre_room_message_send")) {
-            new_message = plugin->pre_room_message_send(plugin, barejid, curr_message);
-            if (new_message) {
-                free(curr_message);
-                curr_message = strdup(new_message);
-                free(new_message);
-            } else {
-                free(curr_message);
-                g_list_free(values);
+    if (!plugins_hook_subscribed(PLUGIN_HOOK_PRE_ROOM_MESSAGE_SEND)) {
+        return curr_message;
+    }
 
-                return NULL;
-            }
+    GPtrArray *subscribers = hook_subscribers[PLUGIN_HOOK_PRE_ROOM_MESSAGE_SEND];
+    guint i;
+    for (i = 0; i < subscribers->len; i++) {
+        ProfPlugin *plugin = g_ptr_array_index(subscribers, i);
+        char *new_message = plugin->pre_room_message_send(plugin, barejid, curr_message);
+        free(curr_message);
+        if (!new_message) {
+            return NULL;
         }
-        curr = g_list_next(curr);
+        curr_message = new_message;
     }
-    g_list_free(values);
 
     return curr_message;
 }
@@ -631,20 +679,26 @@ plugins_pre_room_message_send(const char * const barejid, const char *message)
 void
 plugins_post_room_message_send(const char * const barejid, const char *message)
 {
-    GList *values = g_hash_table_get_values(plugins);
-    GList *curr = values;
-    while (curr) {
-        ProfPlugin *plugin = curr->data;
+    if (!plugins_hook_subscribed(PLUGIN_HOOK_POST_ROOM_MESSAGE_SEND)) {
+        return;
+    }
+
+    GPtrArray *subscribers = hook_subscribers[PLUGIN_HOOK_POST_ROOM_MESSAGE_SEND];
+    guint i;
+    for (i = 0; i < subscribers->len; i++) {
+        ProfPlugin *plugin = g_ptr_array_index(subscribers, i);
         plugin->post_room_message_send(plugin, barejid, message);
-        curr = g_list_next(curr);
     }
-    g_list_free(values);
 }
 
 void
 plugins_on_room_history_message(const char *const barejid, const char *const nick, const char *const message,
     GDateTime *timestamp)
 {
+    if (!plugins_hook_subscribed(PLUGIN_HOOK_ON_ROOM_HISTORY_MESSAGE)) {
+        return;
+    }
+
     char *timestamp_str = NULL;
     GTimeVal timestamp_tv;
     gboolean res = g_date_time_to_timeval(timestamp, &timestamp_tv);
@@ -652,14 +706,12 @@ plugins_on_room_history_message(const char *const barejid, const char *const nic
         timestamp_str = g_time_val_to_iso8601(&timestamp_tv);
     }
 
-    GList *values = g_hash_table_get_values(plugins);
-    GList *curr = values;
-    while (curr) {
-        ProfPlugin *plugin = curr->data;
+    GPtrArray *subscribers = hook_subscribers[PLUGIN_HOOK_ON_ROOM_HISTORY_MESSAGE];
+    guint i;
+    for (i = 0; i < subscribers->len; i++) {
+        ProfPlugin *plugin = g_ptr_array_index(subscribers, i);
         plugin->on_room_history_message(plugin, barejid, nick, message, timestamp_str);
-        curr = g_list_next(curr);
     }
-    g_list_free(values);
 
     free(timestamp_str);
 }
@@ -667,23 +719,24 @@ plugins_on_room_history_message(const char *const barejid, const char *const nic
 char*
 plugins_pre_priv_message_display(const char * const fulljid, const char *message)
 {
-    Jid *jidp = jid_create(fulljid);
-    char *new_message = NULL;
     char *curr_message = strdup(message);
 
-    GList *values = g_hash_table_get_values(plugins);
-    GList *curr = values;
-    while (curr) {
-        ProfPlugin *plugin = curr->data;
-        new_message = plugin->pre_priv_message_display(plugin, jidp->barejid, jidp->resourcepart, curr_message);
+    if (!plugins_hook_subscribed(PLUGIN_HOOK_PRE_PRIV_MESSAGE_DISPLAY)) {
+        return curr_message;
+    }
+
+    GPtrArray *subscribers = hook_subscribers[PLUGIN_HOOK_PRE_PRIV_MESSAGE_DISPLAY];
+    Jid *jidp = jid_create(fulljid);
+
+    guint i;
+    for (i = 0; i < subscribers->len; i++) {
+        ProfPlugin *plugin = g_ptr_array_index(subscribers, i);
+        char *new_message = plugin->pre_priv_message_display(plugin, jidp->barejid, jidp->resourcepart, curr_message);
         if (new_message) {
             free(curr_message);
-            curr_message = strdup(new_message);
-            free(new_message);
+            curr_message = new_message;
         }
-        curr = g_list_next(curr);
     }
-    g_list_free(values);
 
     jid_destroy(jidp);
     return curr_message;
@@ -692,16 +745,18 @@ plugins_pre_priv_message_display(const char * const fulljid, const char *message
 void
 plugins_post_priv_message_display(const char * const fulljid, const char *message)
 {
+    if (!plugins_hook_subscribed(PLUGIN_HOOK_POST_PRIV_MESSAGE_DISPLAY)) {
+        return;
+    }
+
+    GPtrArray *subscribers = hook_subscribers[PLUGIN_HOOK_POST_PRIV_MESSAGE_DISPLAY];
     Jid *jidp = jid_create(fulljid);
 
-    GList *values = g_hash_table_get_values(plugins);
-    GList *curr = values;
-    while (curr) {
-        ProfPlugin *plugin = curr->data;
+    guint i;
+    for (i = 0; i < subscribers->len; i++) {
+        ProfPlugin *plugin = g_ptr_array_index(subscribers, i);
         plugin->post_priv_message_display(plugin, jidp->barejid, jidp->resourcepart, message);
-        curr = g_list_next(curr);
     }
-    g_list_free(values);
 
     jid_destroy(jidp);
 }
@@ -709,31 +764,26 @@ plugins_post_priv_message_display(const char * const fulljid, const char *messag
 char*
 plugins_pre_priv_message_send(const char * const fulljid, const char * const message)
 {
-    Jid *jidp = jid_create(fulljid);
-    char *new_message = NULL;
     char *curr_message = strdup(message);
 
-    GList *values = g_hash_table_get_values(plugins);
-    GList *curr = values;
-    while (curr) {
-        ProfPlugin *plugin = curr->data;
-        if (plugin->contains_hook(plugin, "prof_pre_priv_message_send")) {
-            new_message = plugin->pre_priv_message_send(plugin, jidp->barejid, jidp->resourcepart, curr_message);
-            if (new_message) {
-                free(curr_message);
-                curr_message = strdup(new_message);
-                free(new_message);
-            } else {
-                free(curr_message);
-                g_list_free(values);
-                jid_destroy(jidp);
+    if (!plugins_hook_subscribed(PLUGIN_HOOK_PRE_PRIV_MESSAGE_SEND)) {
+        return curr_message;
+    }
 
-                return NULL;
-            }
+    GPtrArray *subscribers = hook_subscribers[PLUGIN_HOOK_PRE_PRIV_MESSAGE_SEND];
+    Jid *jidp = jid_create(fulljid);
+
+    guint i;
+    for (i = 0; i < subscribers->len; i++) {
+        ProfPlugin *plugin = g_ptr_array_index(subscribers, i);
+        char *new_message = plugin->pre_priv_message_send(plugin, jidp->barejid, jidp->resourcepart, curr_message);
+        free(curr_message);
+        if (!new_message) {
+            jid_destroy(jidp);
+            return NULL;
         }
-        curr = g_list_next(curr);
+        curr_message = new_message;
     }
-    g_list_free(values);
 
     jid_destroy(jidp);
     return curr_message;
@@ -742,16 +792,18 @@ plugins_pre_priv_message_send(const char * const fulljid, const char * const mes
 void
 plugins_post_priv_message_send(const char * const fulljid, const char * const message)
 {
+    if (!plugins_hook_subscribed(PLUGIN_HOOK_POST_PRIV_MESSAGE_SEND)) {
+        return;
+    }
+
+    GPtrArray *subscribers = hook_subscribers[PLUGIN_HOOK_POST_PRIV_MESSAGE_SEND];
     Jid *jidp = jid_create(fulljid);
 
-    GList *values = g_hash_table_get_values(plugins);
-    GList *curr = values;
-    while (curr) {
-        ProfPlugin *plugin = curr->data;
+    guint i;
+    for (i = 0; i < subscribers->len; i++) {
+        ProfPlugin *plugin = g_ptr_array_index(subscribers, i);
         plugin->post_priv_message_send(plugin, jidp->barejid, jidp->resourcepart, message);
-        curr = g_list_next(curr);
     }
-    g_list_free(values);
 
     jid_destroy(jidp);
 }
@@ -759,182 +811,97 @@ plugins_post_priv_message_send(const char * const fulljid, const char * const me
 char*
 plugins_on_message_stanza_send(const char *const text)
 {
-    char *new_stanza = NULL;
-    char *curr_stanza = strdup(text);
-
-    GList *values = g_hash_table_get_values(plugins);
-    GList *curr = values;
-    while (curr) {
-        ProfPlugin *plugin = curr->data;
-        new_stanza = plugin->on_message_stanza_send(plugin, curr_stanza);
-        if (new_stanza) {
-            free(curr_stanza);
-            curr_stanza = strdup(new_stanza);
-            free(new_stanza);
-        }
-        curr = g_list_next(curr);
-    }
-    g_list_free(values);
-
-    return curr_stanza;
+    return _plugins_stanza_send(PLUGIN_HOOK_MESSAGE_STANZA_SEND, text);
 }
 
 gboolean
 plugins_on_message_stanza_receive(const char *const text)
 {
-    gboolean cont = TRUE;
-
-    GList *values = g_hash_table_get_values(plugins);
-    GList *curr = values;
-    while (curr) {
-        ProfPlugin *plugin = curr->data;
-        gboolean res = plugin->on_message_stanza_receive(plugin, text);
-        if (res == FALSE) {
-            cont = FALSE;
-        }
-        curr = g_list_next(curr);
-    }
-    g_list_free(values);
-
-    return cont;
+    return _plugins_stanza_receive(PLUGIN_HOOK_MESSAGE_STANZA_RECEIVE, text);
 }
 
 char*
 plugins_on_presence_stanza_send(const char *const text)
 {
-    char *new_stanza = NULL;
-    char *curr_stanza = strdup(text);
-
-    GList *values = g_hash_table_get_values(plugins);
-    GList *curr = values;
-    while (curr) {
-        ProfPlugin *plugin = curr->data;
-        new_stanza = plugin->on_presence_stanza_send(plugin, curr_stanza);
-        if (new_stanza) {
-            free(curr_stanza);
-            curr_stanza = strdup(new_stanza);
-            free(new_stanza);
-        }
-        curr = g_list_next(curr);
-    }
-    g_list_free(values);
-
-    return curr_stanza;
+    return _plugins_stanza_send(PLUGIN_HOOK_PRESENCE_STANZA_SEND, text);
 }
 
 gboolean
 plugins_on_presence_stanza_receive(const char *const text)
 {
-    gboolean cont = TRUE;
-
-    GList *values = g_hash_table_get_values(plugins);
-    GList *curr = values;
-    while (curr) {
-        ProfPlugin *plugin = curr->data;
-        gboolean res = plugin->on_presence_stanza_receive(plugin, text);
-        if (res == FALSE) {
-            cont = FALSE;
-        }
-        curr = g_list_next(curr);
-    }
-    g_list_free(values);
-
-    return cont;
+    return _plugins_stanza_receive(PLUGIN_HOOK_PRESENCE_STANZA_RECEIVE, text);
 }
 
 char*
 plugins_on_iq_stanza_send(const char *const text)
 {
-    char *new_stanza = NULL;
-    char *curr_stanza = strdup(text);
-
-    GList *values = g_hash_table_get_values(plugins);
-    GList *curr = values;
-    while (curr) {
-        ProfPlugin *plugin = curr->data;
-        new_stanza = plugin->on_iq_stanza_send(plugin, curr_stanza);
-        if (new_stanza) {
-            free(curr_stanza);
-            curr_stanza = strdup(new_stanza);
-            free(new_stanza);
-        }
-        curr = g_list_next(curr);
-    }
-    g_list_free(values);
-
-    return curr_stanza;
+    return _plugins_stanza_send(PLUGIN_HOOK_IQ_STANZA_SEND, text);
 }
 
 gboolean
 plugins_on_iq_stanza_receive(const char *const text)
 {
-    gboolean cont = TRUE;
-
-    GList *values = g_hash_table_get_values(plugins);
-    GList *curr = values;
-    while (curr) {
-        ProfPlugin *plugin = curr->data;
-        gboolean res = plugin->on_iq_stanza_receive(plugin, text);
-        if (res == FALSE) {
-            cont = FALSE;
-        }
-        curr = g_list_next(curr);
-    }
-    g_list_free(values);
-
-    return cont;
+    return _plugins_stanza_receive(PLUGIN_HOOK_IQ_STANZA_RECEIVE, text);
 }
 
 void
 plugins_on_contact_offline(const char *const barejid, const char *const resource, const char *const status)
 {
-    GList *values = g_hash_table_get_values(plugins);
-    GList *curr = values;
-    while (curr) {
-        ProfPlugin *plugin = curr->data;
+    if (!plugins_hook_subscribed(PLUGIN_HOOK_ON_CONTACT_OFFLINE)) {
+        return;
+    }
+
+    GPtrArray *subscribers = hook_subscribers[PLUGIN_HOOK_ON_CONTACT_OFFLINE];
+    guint i;
+    for (i = 0; i < subscribers->len; i++) {
+        ProfPlugin *plugin = g_ptr_array_index(subscribers, i);
         plugin->on_contact_offline(plugin, barejid, resource, status);
-        curr = g_list_next(curr);
     }
-    g_list_free(values);
 }
 
 void
 plugins_on_contact_presence(const char *const barejid, const char *const resource, const char *const presence, const char *const status, const int priority)
 {
-    GList *values = g_hash_table_get_values(plugins);
-    GList *curr = values;
-    while (curr) {
-        ProfPlugin *plugin = curr->data;
+    if (!plugins_hook_subscribed(PLUGIN_HOOK_ON_CONTACT_PRESENCE)) {
+        return;
+    }
+
+    GPtrArray *subscribers = hook_subscribers[PLUGIN_HOOK_ON_CONTACT_PRESENCE];
+    guint i;
+    for (i = 0; i < subscribers->len; i++) {
+        ProfPlugin *plugin = g_ptr_array_index(subscribers, i);
         plugin->on_contact_presence(plugin, barejid, resource, presence, status, priority);
-        curr = g_list_next(curr);
     }
-    g_list_free(values);
 }
 
 void
 plugins_on_chat_win_focus(const char *const barejid)
 {
-    GList *values = g_hash_table_get_values(plugins);
-    GList *curr = values;
-    while (curr) {
-        ProfPlugin *plugin = curr->data;
+    if (!plugins_hook_subscribed(PLUGIN_HOOK_ON_CHAT_WIN_FOCUS)) {
+        return;
+    }
+
+    GPtrArray *subscribers = hook_subscribers[PLUGIN_HOOK_ON_CHAT_WIN_FOCUS];
+    guint i;
+    for (i = 0; i < subscribers->len; i++) {
+        ProfPlugin *plugin = g_ptr_array_index(subscribers, i);
         plugin->on_chat_win_focus(plugin, barejid);
-        curr = g_list_next(curr);
     }
-    g_list_free(values);
 }
 
 void
 plugins_on_room_win_focus(const char *const barejid)
 {
-    GList *values = g_hash_table_get_values(plugins);
-    GList *curr = values;
-    while (curr) {
-        ProfPlugin *plugin = curr->data;
+    if (!plugins_hook_subscribed(PLUGIN_HOOK_ON_ROOM_WIN_FOCUS)) {
+        return;
+    }
+
+    GPtrArray *subscribers = hook_subscribers[PLUGIN_HOOK_ON_ROOM_WIN_FOCUS];
+    guint i;
+    for (i = 0; i < subscribers->len; i++) {
+        ProfPlugin *plugin = g_ptr_array_index(subscribers, i);
         plugin->on_room_win_focus(plugin, barejid);
-        curr = g_list_next(curr);
     }
-    g_list_free(values);
 }
 
 GList*
@@ -978,4 +945,113 @@ plugins_shutdown(void)
     disco_close();
     g_hash_table_destroy(plugins);
     plugins = NULL;
+
+    int hook;
+    for (hook = 0; hook < PLUGIN_HOOK_COUNT; hook++) {
+        g_ptr_array_free(hook_subscribers[hook], TRUE);
+        hook_subscribers[hook] = NULL;
+    }
+}
+
+/*
+ * Returns TRUE when at least one loaded plugin implements the hook, callers
+ * use this to avoid preparing arguments nobody will receive
+ */
+gboolean
+plugins_hook_subscribed(plugin_hook_t hook)
+{
+    return hook_subscribers[hook] && hook_subscribers[hook]->len > 0;
+}
+
+static void
+_plugins_hooks_update(void)
+{
+    int hook;
+    for (hook = 0; hook < PLUGIN_HOOK_COUNT; hook++) {
+        g_ptr_array_set_size(hook_subscribers[hook], 0);
+    }
+
+    GHashTableIter iter;
+    gpointer key;
+    gpointer value;
+    g_hash_table_iter_init(&iter, plugins);
+    while (g_hash_table_iter_next(&iter, &key, &value)) {
+        ProfPlugin *plugin = value;
+        for (hook = 0; hook < PLUGIN_HOOK_COUNT; hook++) {
+            if (plugin->contains_hook(plugin, hook_names[hook])) {
+                g_ptr_array_add(hook_subscribers[hook], plugin);
+            }
+        }
+    }
+}
+
+static char*
+_plugins_stanza_send(plugin_hook_t hook, const char *const text)
+{
+    char *curr_stanza = strdup(text);
+
+    if (!plugins_hook_subscribed(hook)) {
+        return curr_stanza;
+    }
+
+    GPtrArray *subscribers = hook_subscribers[hook];
+    guint i;
+    for (i = 0; i < subscribers->len; i++) {
+        ProfPlugin *plugin = g_ptr_array_index(subscribers, i);
+        char *new_stanza = NULL;
+        switch (hook) {
+        case PLUGIN_HOOK_MESSAGE_STANZA_SEND:
+            new_stanza = plugin->on_message_stanza_send(plugin, curr_stanza);
+            break;
+        case PLUGIN_HOOK_PRESENCE_STANZA_SEND:
+            new_stanza = plugin->on_presence_stanza_send(plugin, curr_stanza);
+            break;
+        case PLUGIN_HOOK_IQ_STANZA_SEND:
+            new_stanza = plugin->on_iq_stanza_send(plugin, curr_stanza);
+            break;
+        default:
+            break;
+        }
+        if (new_stanza) {
+            free(curr_stanza);
+            curr_stanza = new_stanza;
+        }
+    }
+
+    return curr_stanza;
+}
+
+static gboolean
+_plugins_stanza_receive(plugin_hook_t hook, const char *const text)
+{
+    gboolean cont = TRUE;
+
+    if (!plugins_hook_subscribed(hook)) {
+        return cont;
+    }
+
+    GPtrArray *subscribers = hook_subscribers[hook];
+    guint i;
+    for (i = 0; i < subscribers->len; i++) {
+        ProfPlugin *plugin = g_ptr_array_index(subscribers, i);
+        gboolean res = TRUE;
+        switch (hook) {
+        case PLUGIN_HOOK_MESSAGE_STANZA_RECEIVE:
+            res = plugin->on_message_stanza_receive(plugin, text);
+            break;
+        case PLUGIN_HOOK_PRESENCE_STANZA_RECEIVE:
+            res = plugin->on_presence_stanza_receive(plugin, text);
+            break;
+        case PLUGIN_HOOK_IQ_STANZA_RECEIVE:
+            res = plugin->on_iq_stanza_receive(plugin, text);
+            break;
+        default:
+            break;
+        }
+        if (res == FALSE) {
+            cont = FALSE;
+        }
+    }
+
+    return cont;
 }
@@ -48,6 +48,38 @@ typedef struct prof_plugins_install_t {
     GSList *failed;
 } PluginsInstallResult;
 
+// hooks with a subscriber list, kept up to date as plugins are loaded and unloaded
+typedef enum {
+    PLUGIN_HOOK_ON_START,
+    PLUGIN_HOOK_ON_SHUTDOWN,
+    PLUGIN_HOOK_ON_CONNECT,
+    PLUGIN_HOOK_ON_DISCONNECT,
+    PLUGIN_HOOK_PRE_CHAT_MESSAGE_DISPLAY,
+    PLUGIN_HOOK_POST_CHAT_MESSAGE_DISPLAY,
+    PLUGIN_HOOK_PRE_CHAT_MESSAGE_SEND,
+    PLUGIN_HOOK_POST_CHAT_MESSAGE_SEND,
+    PLUGIN_HOOK_PRE_ROOM_MESSAGE_DISPLAY,
+    PLUGIN_HOOK_POST_ROOM_MESSAGE_DISPLAY,
+    PLUGIN_HOOK_PRE_ROOM_MESSAGE_SEND,
+    PLUGIN_HOOK_POST_ROOM_MESSAGE_SEND,
+    PLUGIN_HOOK_ON_ROOM_HISTORY_MESSAGE,
+    PLUGIN_HOOK_PRE_PRIV_MESSAGE_DISPLAY,
+    PLUGIN_HOOK_POST_PRIV_MESSAGE_DISPLAY,
+    PLUGIN_HOOK_PRE_PRIV_MESSAGE_SEND,
+    PLUGIN_HOOK_POST_PRIV_MESSAGE_SEND,
+    PLUGIN_HOOK_MESSAGE_STANZA_SEND,
+    PLUGIN_HOOK_MESSAGE_STANZA_RECEIVE,
+    PLUGIN_HOOK_PRESENCE_STANZA_SEND,
+    PLUGIN_HOOK_PRESENCE_STANZA_RECEIVE,
+    PLUGIN_HOOK_IQ_STANZA_SEND,
+    PLUGIN_HOOK_IQ_STANZA_RECEIVE,
+    PLUGIN_HOOK_ON_CONTACT_OFFLINE,
+    PLUGIN_HOOK_ON_CONTACT_PRESENCE,
+    PLUGIN_HOOK_ON_CHAT_WIN_FOCUS,
+    PLUGIN_HOOK_ON_ROOM_WIN_FOCUS,
+    PLUGIN_HOOK_COUNT
+} plugin_hook_t;
+
 typedef struct prof_plugin_t {
     char *name;
     lang_t lang;
@@ -107,6 +139,7 @@ typedef struct prof_plugin_t {
 } ProfPlugin;
 
 void plugins_init(void);
+gboolean plugins_hook_subscribed(plugin_hook_t hook);
 GSList *plugins_unloaded_list(void);
 GList *plugins_loaded_list(void);
 char* plugins_autocomplete(const char *const input, gboolean previous);
@@ -170,6 +203,7 @@ void plugins_on_room_win_focus(const char *const barejid);
 
 gboolean plugins_run_command(const char * const cmd);
 void plugins_run_timed(void);
+gint plugins_timed_timeout(void);
 GList* plugins_get_command_names(void);
 gchar * plugins_get_dir(void);
 CommandHelp* plugins_get_help(const char *const cmd);
@@ -86,9 +86,12 @@
 #include "omemo/omemo.h"
 #endif
 
+#define CRYPTO_POLL_TIMEOUT 10
+
 static void _init(char *log_level, char *config_file);
 static void _shutdown(void);
 static void _connect_default(const char * const account);
+static gint _loop_timeout(int xmpp_fd);
 
 static gboolean cont = TRUE;
 static gboolean force_quit = FALSE;
@@ -111,20 +114,31 @@ prof_run(char *log_level, char *account_name, char *config_file)
         log_stderr_handler();
         session_check_autoaway();
 
-        line = inp_readline();
+        int xmpp_fd = connection_get_fd();
+        line = inp_readline(_loop_timeout(xmpp_fd), xmpp_fd, log_stderr_fd());
         if (line) {
             ProfWin *window = wins_get_current();
             cont = cmd_process_input(window, line);
             free(line);
             line = NULL;
+
+            // commands can change any preference that affects drawing
+            ui_damage_all();
         } else {
             cont = TRUE;
         }
 
 #ifdef HAVE_LIBOTR
         otr_poll();
+#endif
+#ifdef HAVE_OMEMO
+        omemo_poll();
+#endif
+#ifdef HAVE_LIBGPGME
+        p_gpg_poll();
 #endif
         plugins_run_timed();
+        chat_log_poll();
         notify_remind();
         session_process_events();
         iq_autoping_check();
@@ -141,6 +155,54 @@ prof_set_quit(void)
     force_quit = TRUE;
 }
 
+// How long the main loop may sleep waiting for input or the XMPP socket,
+// -1 when nothing is scheduled and only an event can wake us
+static gint
+_loop_timeout(int xmpp_fd)
+{
+    // libstrophe only hands us its socket once connected, poll until then
+    if (xmpp_fd < 0 && connection_get_status() != JABBER_DISCONNECTED) {
+        return inp_get_timeout();
+    }
+
+    // session housekeeping (autoaway, autoping, chat states, reconnect,
+    // reminders) only needs checking at the /inpblock interval
+    gint timeout = -1;
+    gboolean housekeeping = connection_get_status() != JABBER_DISCONNECTED
+        || session_reconnect_pending()
+        || prefs_get_notify_remind() > 0;
+#ifdef HAVE_GTK
+    housekeeping = housekeeping || prefs_get_boolean(PREF_TRAY);
+#endif
+    if (housekeeping) {
+        timeout = prefs_get_inpblock();
+    }
+
+    gint timed = plugins_timed_timeout();
+    if (timed >= 0 && (timeout < 0 || timed < timeout)) {
+        timeout = timed;
+    }
+
+#ifdef HAVE_LIBGPGME
+    // pick up encrypted messages and loaded keys soon after they are ready
+    if (p_gpg_pending() && (timeout < 0 || timeout > CRYPTO_POLL_TIMEOUT)) {
+        timeout = CRYPTO_POLL_TIMEOUT;
+    }
+#endif
+
+    // wake up when the status bar clock next ticks over
+    char *time_pref = prefs_get_string(PREF_TIME_STATUSBAR);
+    if (g_strcmp0(time_pref, "off") != 0) {
+        gint tick = 1000 - (g_get_real_time() / 1000) % 1000;
+        if (timeout < 0 || tick < timeout) {
+            timeout = tick;
+        }
+    }
+    prefs_free_string(time_pref);
+
+    return timeout;
+}
+
 static void
 _connect_default(const char *const account)
 {
@@ -0,0 +1,1394 @@
+/*
+ * search.c
+ * vim: expandtab:ts=4:sts=4:sw=4
+ *
+ * Copyright (C) 2012 - 2019 James Booth <boothj5@gmail.com>
+ * Copyright (C) 2018 - 2019 Michael Vetter <jubalh@idoru.org>
+ *
+ * This file is part of Profanity.
+ *
+ * Profanity is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Profanity is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Profanity.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link the code of portions of this program with the OpenSSL library under
+ * certain conditions as described in each individual source file, and
+ * distribute linked combinations including the two.
+ *
+ * You must obey the GNU General Public License in all respects for all of the
+ * code used other than OpenSSL. If you modify file(s) with this exception, you
+ * may extend this exception to your version of the file(s), but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version. If you delete this exception statement from all
+ * source files in the program, then also delete it here.
+ *
+ */
+
+#include "config.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#include "log.h"
+#include "common.h"
+#include "search.h"
+#include "config/files.h"
+
+// Inverted index over the chat log archive.
+//
+// The index is a set of immutable segment files plus the postings of the
+// documents indexed since the last segment was written. A document is one
+// logged message, identified by its position in docs.dat, which records the
+// log directory (source), the day and the byte offset of the line. Segments
+// hold the sorted terms with the ids of the documents containing them, doc ids
+// only grow so postings of older segments always come first.
+//
+// Log files are indexed by a background thread, from the last indexed offset
+// to their last complete line. The chat log writer queues a file each time it
+// is flushed, and all existing logs are queued at start up. When the lines
+// read next continue the message indexed last, the whole message is indexed
+// again as a new document, results at the same position are only shown once.
+//
+// Segments are merged by size tier: once SEARCH_MERGE_FACTOR adjacent segments
+// are within SEARCH_MERGE_FACTOR times the size of each other, the run with
+// the fewest bytes is merged, so each posting is rewritten a logarithmic
+// number of times rather than on every merge.
+
+#define SEARCH_MAGIC "PSI1"
+// bytes of a segment footer: table offset, term count, magic
+#define SEARCH_FOOTER_SIZE 16
+// shortest and longest term indexed, in bytes
+#define SEARCH_MIN_TERM 2
+#define SEARCH_MAX_TERM 32
+// postings held in memory before they are written to a segment
+#define SEARCH_MAX_PENDING 262144
+// adjacent segments of a similar size merged at a time
+#define SEARCH_MERGE_FACTOR 4
+// segments kept before the smallest run is merged whatever its sizes
+#define SEARCH_MAX_SEGMENTS 32
+// seconds the indexer waits idle before writing pending postings
+#define SEARCH_IDLE_FLUSH 30
+// bytes read at a time when indexing a log file
+#define SEARCH_READ_CHUNK 65536
+// longest message text shown for a result
+#define SEARCH_MAX_MESSAGE 4096
+
+typedef struct search_doc_t {
+    guint32 source;
+    guint32 date;
+    guint64 offset;
+} SearchDoc;
+
+typedef struct search_segment_t {
+    guint id;
+    gchar *map;
+    gsize len;
+    guint32 term_count;
+    guint64 table;
+} SearchSegment;
+
+typedef struct search_postings_t {
+    const gchar *data;
+    guint32 count;
+} SearchPostings;
+
+// how far a log file has been indexed, message is where the last message
+// indexed starts, -1 before the first one
+typedef struct search_progress_t {
+    gint64 offset;
+    gint64 message;
+} SearchProgress;
+
+typedef struct search_candidate_t {
+    guint32 doc;
+    guint32 date;
+    guint32 source;
+    guint64 offset;
+} SearchCandidate;
+
+static gchar *index_dir;
+static gchar *chatlogs_dir;
+
+// index state, written by the indexer thread and read by queries, guarded by index_lock
+static pthread_mutex_t index_lock = PTHREAD_MUTEX_INITIALIZER;
+static GPtrArray *sources;
+static GHashTable *source_ids;
+static GHashTable *progress;
+static GPtrArray *segments;
+static guint next_segment;
+static gchar *docs_map;
+static gsize docs_mapped;
+static guint32 docs_count;
+static GHashTable *pending_terms;
+static GArray *pending_docs;
+static guint pending_postings;
+
+// files waiting for the indexer thread, guarded by queue_lock
+static pthread_t indexer;
+static gboolean indexer_running;
+static gboolean indexer_stop;
+static pthread_mutex_t queue_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t queue_ready = PTHREAD_COND_INITIALIZER;
+static GQueue queue = G_QUEUE_INIT;
+static GHashTable *queued;
+
+static void* _search_indexer(void *arg);
+static void _search_queue_all(void);
+static void _search_index_file(const char *const filename);
+static gboolean _search_continues(FILE *fp, goffset offset);
+static void _search_add_line(const gchar *line, gsize len, guint32 source, guint32 date, guint64 offset,
+    gint64 *message);
+static void _search_add_term(const gchar *term, guint32 doc);
+static void _search_tokenize(const gchar *text, gsize len, GPtrArray *terms);
+static guint32 _search_source_id(const char *const source);
+static void _search_flush_pending(void);
+static gboolean _search_pick_merge(guint *first, guint *count);
+static gboolean _search_merge_segments(guint first, guint count);
+static gboolean _search_write_segment_end(FILE *fp, GByteArray *dict, GArray *table, const char *const tmpname);
+static SearchSegment* _search_segment_open(guint id);
+static void _search_segment_free(SearchSegment *segment);
+static gboolean _search_segment_lookup(SearchSegment *segment, const gchar *term, SearchPostings *postings);
+static const gchar* _search_segment_term(SearchSegment *segment, guint32 index, guint32 *len);
+static gchar* _search_path(const char *const name);
+static void _search_load_state(void);
+static void _search_save_state(void);
+static void _search_map_docs(void);
+static gboolean _search_get_doc(guint32 doc, SearchDoc *result);
+static GArray* _search_term_docs(const gchar *term);
+static GArray* _search_intersect(GArray *a, GArray *b);
+static gint _search_candidate_cmp(gconstpointer a, gconstpointer b);
+static gint _search_candidate_position_cmp(gconstpointer a, gconstpointer b);
+static gint _search_term_cmp(gconstpointer a, gconstpointer b);
+static gboolean _search_parse_date(const char *const text, guint32 *date);
+static gboolean _search_is_entry(const gchar *line, gsize len);
+static SearchResult* _search_read_result(const char *const source, guint32 date, guint64 offset);
+static guint32 _read_u32(const gchar *p);
+static guint64 _read_u64(const gchar *p);
+
+void
+search_init(void)
+{
+    log_info("Initialising search index");
+
+    index_dir = files_get_data_path(DIR_SEARCH);
+    chatlogs_dir = files_get_data_path(DIR_CHATLOGS);
+    if (!mkdir_recursive(index_dir)) {
+        log_error("Could not create search index directory %s", index_dir);
+    }
+
+    sources = g_ptr_array_new_with_free_func(g_free);
+    source_ids = g_hash_table_new(g_str_hash, g_str_equal);
+    progress = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
+    segments = g_ptr_array_new_with_free_func((GDestroyNotify)_search_segment_free);
+    pending_terms = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, (GDestroyNotify)g_array_unref);
+    pending_docs = g_array_new(FALSE, FALSE, sizeof(SearchDoc));
+    pending_postings = 0;
+    next_segment = 0;
+    docs_count = 0;
+    queued = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+
+    _search_load_state();
+
+    indexer_stop = FALSE;
+    if (pthread_create(&indexer, NULL, _search_indexer, NULL) == 0) {
+        indexer_running = TRUE;
+    } else {
+        log_error("Could not start search indexer thread");
+    }
+}
+
+void
+search_close(void)
+{
+    if (indexer_running) {
+        pthread_mutex_lock(&queue_lock);
+        indexer_stop = TRUE;
+        pthread_cond_signal(&queue_ready);
+        pthread_mutex_unlock(&queue_lock);
+
+        pthread_join(indexer, NULL);
+        indexer_running = FALSE;
+    }
+
+    g_queue_clear_full(&queue, g_free);
+    g_hash_table_destroy(queued);
+    queued = NULL;
+
+    if (docs_map) {
+        munmap(docs_map, docs_mapped);
+        docs_map = NULL;
+    }
+    g_ptr_array_free(segments, TRUE);
+    g_hash_table_destroy(pending_terms);
+    g_array_free(pending_docs, TRUE);
+    g_hash_table_destroy(progress);
+    g_hash_table_destroy(source_ids);
+    g_ptr_array_free(sources, TRUE);
+
+    g_free(index_dir);
+    index_dir = NULL;
+    g_free(chatlogs_dir);
+    chatlogs_dir = NULL;
+}
+
+void
+search_log_updated(const char *const filename)
+{
+    pthread_mutex_lock(&queue_lock);
+    if (queued && !g_hash_table_contains(queued, filename)) {
+        gchar *name = g_strdup(filename);
+        g_hash_table_add(queued, g_strdup(filename));
+        g_queue_push_tail(&queue, name);
+        pthread_cond_signal(&queue_ready);
+    }
+    pthread_mutex_unlock(&queue_lock);
+}
+
+SearchQuery*
+search_query_parse(const char *const text)
+{
+    SearchQuery *query = malloc(sizeof(SearchQuery));
+    query->terms = g_ptr_array_new_with_free_func(g_free);
+    query->with = NULL;
+    query->room = NULL;
+    query->since = 0;
+    query->until = G_MAXUINT32;
+
+    gchar **words = g_strsplit_set(text, " \t", -1);
+    int i;
+    for (i = 0; words[i]; i++) {
+        gchar *word = words[i];
+        if (g_str_has_prefix(word, "with:") && strlen(word) > 5) {
+            g_free(query->with);
+            query->with = g_strdup(word + 5);
+        } else if (g_str_has_prefix(word, "room:") && strlen(word) > 5) {
+            g_free(query->room);
+            query->room = g_strdup(word + 5);
+        } else if (g_str_has_prefix(word, "since:")) {
+            if (!_search_parse_date(word + 6, &query->since)) {
+                g_strfreev(words);
+                search_query_free(query);
+                return NULL;
+            }
+        } else if (g_str_has_prefix(word, "until:")) {
+            if (!_search_parse_date(word + 6, &query->until)) {
+                g_strfreev(words);
+                search_query_free(query);
+                return NULL;
+            }
+        } else {
+            _search_tokenize(word, strlen(word), query->terms);
+        }
+    }
+    g_strfreev(words);
+
+    if (query->terms->len == 0) {
+        search_query_free(query);
+        return NULL;
+    }
+
+    return query;
+}
+
+void
+search_query_free(SearchQuery *query)
+{
+    if (query) {
+        g_ptr_array_free(query->terms, TRUE);
+        g_free(query->with);
+        g_free(query->room);
+        free(query);
+    }
+}
+
+GSList*
+search_run(SearchQuery *query, int max_results)
+{
+    gchar *with_dir = query->with ? str_replace(query->with, "@", "_at_") : NULL;
+    gchar *room_dir = query->room ? str_replace(query->room, "@", "_at_") : NULL;
+    GSList *results = NULL;
+
+    // copy what the query needs under the lock, the intersection, filters and
+    // ranking work on the copies so indexing is not held up by a slow query
+    GPtrArray *lists = g_ptr_array_new_with_free_func((GDestroyNotify)g_array_unref);
+    guint i;
+    pthread_mutex_lock(&index_lock);
+    for (i = 0; i < query->terms->len; i++) {
+        g_ptr_array_add(lists, _search_term_docs(g_ptr_array_index(query->terms, i)));
+    }
+    pthread_mutex_unlock(&index_lock);
+
+    // intersect from the rarest term so the candidate list stays short
+    g_ptr_array_sort(lists, _search_term_cmp);
+    GArray *docs = g_array_ref(g_ptr_array_index(lists, 0));
+    for (i = 1; i < lists->len && docs->len > 0; i++) {
+        GArray *next = _search_intersect(docs, g_ptr_array_index(lists, i));
+        g_array_unref(docs);
+        docs = next;
+    }
+    g_ptr_array_free(lists, TRUE);
+
+    GArray *candidates = g_array_new(FALSE, FALSE, sizeof(SearchCandidate));
+    GHashTable *source_names = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, g_free);
+    pthread_mutex_lock(&index_lock);
+    for (i = 0; i < docs->len; i++) {
+        guint32 doc_id = g_array_index(docs, guint32, i);
+        SearchDoc doc;
+        if (!_search_get_doc(doc_id, &doc) || doc.date < query->since || doc.date > query->until) {
+            continue;
+        }
+        SearchCandidate candidate = { doc_id, doc.date, doc.source, doc.offset };
+        g_array_append_val(candidates, candidate);
+        if (!g_hash_table_contains(source_names, GUINT_TO_POINTER(doc.source))) {
+            g_hash_table_insert(source_names, GUINT_TO_POINTER(doc.source),
+                g_strdup(g_ptr_array_index(sources, doc.source)));
+        }
+    }
+    pthread_mutex_unlock(&index_lock);
+    g_array_unref(docs);
+
+    // apply the contact and room filters
+    if (with_dir || room_dir) {
+        guint kept = 0;
+        for (i = 0; i < candidates->len; i++) {
+            SearchCandidate *candidate = &g_array_index(candidates, SearchCandidate, i);
+            const gchar *source = g_hash_table_lookup(source_names, GUINT_TO_POINTER(candidate->source));
+            gchar **parts = g_strsplit(source, "/", 3);
+            gboolean groupchat = g_strv_length(parts) == 3 && g_strcmp0(parts[1], "rooms") == 0;
+            const gchar *name = groupchat ? parts[2] : parts[1];
+            gboolean match = (with_dir && !groupchat && g_strcmp0(name, with_dir) == 0)
+                || (room_dir && groupchat && g_strcmp0(name, room_dir) == 0);
+            g_strfreev(parts);
+            if (match) {
+                g_array_index(candidates, SearchCandidate, kept++) = *candidate;
+            }
+        }
+        g_array_set_size(candidates, kept);
+    }
+
+    // a message indexed again when continued is kept as its latest document
+    g_array_sort(candidates, _search_candidate_position_cmp);
+    guint kept = 0;
+    for (i = 0; i < candidates->len; i++) {
+        SearchCandidate *candidate = &g_array_index(candidates, SearchCandidate, i);
+        SearchCandidate *previous = kept > 0 ? &g_array_index(candidates, SearchCandidate, kept - 1) : NULL;
+        if (previous && previous->source == candidate->source && previous->date == candidate->date
+                && previous->offset == candidate->offset) {
+            continue;
+        }
+        g_array_index(candidates, SearchCandidate, kept++) = *candidate;
+    }
+    g_array_set_size(candidates, kept);
+
+    g_array_sort(candidates, _search_candidate_cmp);
+
+    // candidates are newest first, results are returned oldest first
+    for (i = 0; i < candidates->len && i < (guint)max_results; i++) {
+        SearchCandidate *candidate = &g_array_index(candidates, SearchCandidate, i);
+        const gchar *source = g_hash_table_lookup(source_names, GUINT_TO_POINTER(candidate->source));
+        SearchResult *result = _search_read_result(source, candidate->date, candidate->offset);
+        if (result) {
+            results = g_slist_prepend(results, result);
+        }
+    }
+    g_array_free(candidates, TRUE);
+    g_hash_table_destroy(source_names);
+
+    free(with_dir);
+    free(room_dir);
+
+    return results;
+}
+
+void
+search_results_free(GSList *results)
+{
+    GSList *curr = results;
+    while (curr) {
+        SearchResult *result = curr->data;
+        g_date_time_unref(result->timestamp);
+        g_free(result->jid);
+        g_free(result->message);
+        free(result);
+        curr = g_slist_next(curr);
+    }
+    g_slist_free(results);
+}
+
+static void*
+_search_indexer(void *arg)
+{
+    _search_queue_all();
+
+    pthread_mutex_lock(&queue_lock);
+    while (TRUE) {
+        while (g_queue_is_empty(&queue) && !indexer_stop) {
+            struct timespec deadline;
+            clock_gettime(CLOCK_REALTIME, &deadline);
+            deadline.tv_sec += SEARCH_IDLE_FLUSH;
+            if (pthread_cond_timedwait(&queue_ready, &queue_lock, &deadline) == ETIMEDOUT) {
+                break;
+            }
+        }
+
+        // files still queued when stopping are picked up again at the next start
+        gboolean stop = indexer_stop;
+        gchar *filename = stop ? NULL : g_queue_pop_head(&queue);
+        if (filename) {
+            g_hash_table_remove(queued, filename);
+        }
+        pthread_mutex_unlock(&queue_lock);
+
+        if (filename) {
+            _search_index_file(filename);
+            g_free(filename);
+            if (pending_postings >= SEARCH_MAX_PENDING) {
+                _search_flush_pending();
+            }
+        } else if (pending_docs->len > 0) {
+            // idle or stopping
+            _search_flush_pending();
+        }
+
+        guint first, count;
+        while (_search_pick_merge(&first, &count) && _search_merge_segments(first, count)) {
+        }
+
+        pthread_mutex_lock(&queue_lock);
+        if (stop) {
+            break;
+        }
+    }
+    pthread_mutex_unlock(&queue_lock);
+
+    return NULL;
+}
+
+// queue every log file with data not yet in the index
+static void
+_search_queue_all(void)
+{
+    GQueue dirs = G_QUEUE_INIT;
+    g_queue_push_tail(&dirs, g_strdup(chatlogs_dir));
+
+    gchar *path;
+    while ((path = g_queue_pop_head(&dirs)) != NULL) {
+        GDir *dir = g_dir_open(path, 0, NULL);
+        if (dir) {
+            const gchar *name;
+            while ((name = g_dir_read_name(dir)) != NULL) {
+                gchar *child = g_build_filename(path, name, NULL);
+                if (g_file_test(child, G_FILE_TEST_IS_DIR)) {
+                    g_queue_push_tail(&dirs, child);
+                    continue;
+                }
+
+                GStatBuf st;
+                if (g_str_has_suffix(name, ".log") && g_stat(child, &st) == 0) {
+                    const gchar *rel = child + strlen(chatlogs_dir) + 1;
+                    pthread_mutex_lock(&index_lock);
+                    SearchProgress *indexed = g_hash_table_lookup(progress, rel);
+                    gboolean behind = indexed == NULL || indexed->offset < st.st_size;
+                    pthread_mutex_unlock(&index_lock);
+                    if (behind) {
+                        search_log_updated(child);
+                    }
+                }
+                g_free(child);
+            }
+            g_dir_close(dir);
+        }
+        g_free(path);
+    }
+}
+
+static void
+_search_index_file(const char *const filename)
+{
+    if (!g_str_has_prefix(filename, chatlogs_dir) || strlen(filename) <= strlen(chatlogs_dir) + 1) {
+        return;
+    }
+
+    // chatlogs/<login>/<contact>/YYYY_MM_DD.log or chatlogs/<login>/rooms/<room>/YYYY_MM_DD.log
+    const gchar *rel = filename + strlen(chatlogs_dir) + 1;
+    gchar *basename = g_path_get_basename(rel);
+    gchar *source = g_path_get_dirname(rel);
+    int year, month, day;
+    if (sscanf(basename, "%4d_%2d_%2d.log", &year, &month, &day) != 3) {
+        g_free(basename);
+        g_free(source);
+        return;
+    }
+    g_free(basename);
+    guint32 date = year * 10000 + month * 100 + day;
+
+    SearchProgress *indexed = g_hash_table_lookup(progress, rel);
+    goffset start = indexed ? indexed->offset : 0;
+    gint64 message = indexed ? indexed->message : -1;
+
+    FILE *fp = fopen(filename, "r");
+    if (fp != NULL && message >= 0 && message < start && _search_continues(fp, start)) {
+        start = message;
+    }
+    if (fp == NULL || fseeko(fp, start, SEEK_SET) != 0) {
+        if (fp) {
+            fclose(fp);
+        }
+        g_free(source);
+        return;
+    }
+
+    pthread_mutex_lock(&index_lock);
+    guint32 source_id = _search_source_id(source);
+    pthread_mutex_unlock(&index_lock);
+    g_free(source);
+
+    gchar *chunk = malloc(SEARCH_READ_CHUNK);
+    GString *carry = g_string_new(NULL);
+    goffset pos = start;
+    size_t read;
+
+    while ((read = fread(chunk, 1, SEARCH_READ_CHUNK, fp)) > 0) {
+        g_string_append_len(carry, chunk, read);
+
+        // index complete lines only, the rest is read again next time
+        gsize line_start = 0;
+        gchar *nl;
+        pthread_mutex_lock(&index_lock);
+        while ((nl = memchr(carry->str + line_start, '\n', carry->len - line_start)) != NULL) {
+            gsize len = nl - (carry->str + line_start);
+            _search_add_line(carry->str + line_start, len, source_id, date, pos, &message);
+            pos += len + 1;
+            line_start += len + 1;
+        }
+        pthread_mutex_unlock(&index_lock);
+        g_string_erase(carry, 0, line_start);
+    }
+
+    if (pos > start) {
+        SearchProgress *value = g_new(SearchProgress, 1);
+        value->offset = pos;
+        value->message = message;
+        pthread_mutex_lock(&index_lock);
+        g_hash_table_replace(progress, g_strdup(rel), value);
+        pthread_mutex_unlock(&index_lock);
+    }
+
+    g_string_free(carry, TRUE);
+    free(chunk);
+    fclose(fp);
+}
+
+// whether the complete line at offset continues a message, rather than
+// starting one or not being complete yet
+static gboolean
+_search_continues(FILE *fp, goffset offset)
+{
+    if (fseeko(fp, offset, SEEK_SET) != 0) {
+        return FALSE;
+    }
+
+    char *line = NULL;
+    size_t cap = 0;
+    ssize_t len = getline(&line, &cap, fp);
+    gboolean result = len > 0 && line[len - 1] == '\n' && !_search_is_entry(line, len - 1);
+    free(line);
+
+    return result;
+}
+
+// a line with a timestamp starts a new document, other lines continue the previous one
+static void
+_search_add_line(const gchar *line, gsize len, guint32 source, guint32 date, guint64 offset, gint64 *message)
+{
+    gsize text_start = 0;
+    if (_search_is_entry(line, len)) {
+        SearchDoc doc = { source, date, offset };
+        g_array_append_val(pending_docs, doc);
+        *message = offset;
+        text_start = 11;
+    } else if (*message < 0) {
+        return;
+    }
+
+    guint32 doc_id = docs_count + pending_docs->len - 1;
+    GPtrArray *terms = g_ptr_array_new_with_free_func(g_free);
+    _search_tokenize(line + text_start, len - text_start, terms);
+    guint i;
+    for (i = 0; i < terms->len; i++) {
+        _search_add_term(g_ptr_array_index(terms, i), doc_id);
+    }
+    g_ptr_array_free(terms, TRUE);
+}
+
+static void
+_search_add_term(const gchar *term, guint32 doc)
+{
+    GArray *postings = g_hash_table_lookup(pending_terms, term);
+    if (postings == NULL) {
+        postings = g_array_new(FALSE, FALSE, sizeof(guint32));
+        g_hash_table_insert(pending_terms, g_strdup(term), postings);
+    } else if (g_array_index(postings, guint32, postings->len - 1) == doc) {
+        return;
+    }
+
+    g_array_append_val(postings, doc);
+    pending_postings++;
+}
+
+// lower case runs of letters and digits
+static void
+_search_tokenize(const gchar *text, gsize len, GPtrArray *terms)
+{
+    const gchar *p = text;
+    const gchar *end = text + len;
+    GString *term = g_string_new(NULL);
+
+    while (p < end) {
+        gunichar c = g_utf8_get_char_validated(p, end - p);
+        if (c == (gunichar)-1 || c == (gunichar)-2) {
+            c = ' ';
+            p++;
+        } else {
+            p = g_utf8_next_char(p);
+        }
+
+        if (g_unichar_isalnum(c)) {
+            if (term->len < SEARCH_MAX_TERM) {
+                g_string_append_unichar(term, g_unichar_tolower(c));
+            }
+        } else {
+            if (term->len >= SEARCH_MIN_TERM) {
+                g_ptr_array_add(terms, g_strdup(term->str));
+            }
+            g_string_truncate(term, 0);
+        }
+    }
+    if (term->len >= SEARCH_MIN_TERM) {
+        g_ptr_array_add(terms, g_strdup(term->str));
+    }
+
+    g_string_free(term, TRUE);
+}
+
+static guint32
+_search_source_id(const char *const source)
+{
+    gpointer id = g_hash_table_lookup(source_ids, source);
+    if (id) {
+        return GPOINTER_TO_UINT(id) - 1;
+    }
+
+    gchar *name = g_strdup(source);
+    g_ptr_array_add(sources, name);
+    g_hash_table_insert(source_ids, name, GUINT_TO_POINTER(sources->len));
+
+    return sources->len - 1;
+}
+
+// write pending postings to a new segment, then the docs and progress they belong to
+static void
+_search_flush_pending(void)
+{
+    // only the indexer changes the pending state, so it can be read without the lock
+    GList *terms = g_list_sort(g_hash_table_get_keys(pending_terms), (GCompareFunc)g_strcmp0);
+    gchar *tmpname = _search_path("segment.tmp");
+    FILE *fp = fopen(tmpname, "w");
+    if (fp == NULL) {
+        g_list_free(terms);
+        g_free(tmpname);
+        return;
+    }
+
+    GByteArray *dict = g_byte_array_new();
+    GArray *table = g_array_new(FALSE, FALSE, sizeof(guint64));
+    guint64 pos = fwrite(SEARCH_MAGIC, 1, 4, fp);
+
+    GList *curr = terms;
+    while (curr) {
+        const gchar *term = curr->data;
+        GArray *postings = g_hash_table_lookup(pending_terms, term);
+        guint32 len = strlen(term);
+        guint32 count = postings->len;
+        guint64 entry = dict->len;
+
+        g_array_append_val(table, entry);
+        g_byte_array_append(dict, (guint8*)&len, sizeof(len));
+        g_byte_array_append(dict, (guint8*)term, len);
+        g_byte_array_append(dict, (guint8*)&pos, sizeof(pos));
+        g_byte_array_append(dict, (guint8*)&count, sizeof(count));
+
+        pos += fwrite(postings->data, sizeof(guint32), count, fp) * sizeof(guint32);
+        curr = g_list_next(curr);
+    }
+    g_list_free(terms);
+
+    gboolean written = _search_write_segment_end(fp, dict, table, tmpname);
+    g_byte_array_free(dict, TRUE);
+    g_array_free(table, TRUE);
+    if (!written) {
+        g_free(tmpname);
+        return;
+    }
+
+    // docs first, a segment never refers to docs that are not on disk
+    gchar *docs_name = _search_path("docs.dat");
+    FILE *docs = fopen(docs_name, "a");
+    g_free(docs_name);
+    if (docs == NULL) {
+        g_unlink(tmpname);
+        g_free(tmpname);
+        return;
+    }
+    fwrite(pending_docs->data, sizeof(SearchDoc), pending_docs->len, docs);
+    fflush(docs);
+    fsync(fileno(docs));
+    fclose(docs);
+
+    gchar *segname = g_strdup_printf("segment-%08u.idx", next_segment);
+    gchar *segpath = _search_path(segname);
+    g_free(segname);
+    g_rename(tmpname, segpath);
+    g_free(segpath);
+    g_free(tmpname);
+
+    pthread_mutex_lock(&index_lock);
+    SearchSegment *segment = _search_segment_open(next_segment++);
+    if (segment) {
+        g_ptr_array_add(segments, segment);
+    }
+    docs_count += pending_docs->len;
+    g_array_set_size(pending_docs, 0);
+    g_hash_table_remove_all(pending_terms);
+    pending_postings = 0;
+    _search_map_docs();
+    _search_save_state();
+    pthread_mutex_unlock(&index_lock);
+}
+
+// the run of SEARCH_MERGE_FACTOR adjacent segments with the fewest bytes,
+// among those of a similar size unless there are too many segments
+static gboolean
+_search_pick_merge(guint *first, guint *count)
+{
+    if (segments->len < SEARCH_MERGE_FACTOR) {
+        return FALSE;
+    }
+
+    gboolean found = FALSE;
+    gsize best = 0;
+    guint i;
+    for (i = 0; i + SEARCH_MERGE_FACTOR <= segments->len; i++) {
+        gsize total = 0;
+        gsize smallest = G_MAXSIZE;
+        gsize largest = 0;
+        guint j;
+        for (j = i; j < i + SEARCH_MERGE_FACTOR; j++) {
+            gsize len = ((SearchSegment*)g_ptr_array_index(segments, j))->len;
+            total += len;
+            smallest = MIN(smallest, len);
+            largest = MAX(largest, len);
+        }
+        gboolean similar = largest <= smallest * SEARCH_MERGE_FACTOR;
+        if ((similar || segments->len > SEARCH_MAX_SEGMENTS) && (!found || total < best)) {
+            found = TRUE;
+            best = total;
+            *first = i;
+        }
+    }
+    *count = SEARCH_MERGE_FACTOR;
+
+    return found;
+}
+
+// merge count segments from first into one in their place, terms are merged
+// in order and postings concatenated by segment age, adjacent segments hold
+// adjacent doc ids so the postings stay sorted
+static gboolean
+_search_merge_segments(guint first, guint count)
+{
+    // segments only change on this thread, so they can be read without the lock
+    guint32 *cursors = g_new0(guint32, count);
+    gchar *tmpname = _search_path("segment.tmp");
+    FILE *fp = fopen(tmpname, "w");
+    if (fp == NULL) {
+        g_free(cursors);
+        g_free(tmpname);
+        return FALSE;
+    }
+
+    GByteArray *dict = g_byte_array_new();
+    GArray *table = g_array_new(FALSE, FALSE, sizeof(guint64));
+    guint64 pos = fwrite(SEARCH_MAGIC, 1, 4, fp);
+
+    while (TRUE) {
+        // smallest term under the cursors
+        const gchar *term = NULL;
+        guint32 term_len = 0;
+        guint i;
+        for (i = 0; i < count; i++) {
+            SearchSegment *segment = g_ptr_array_index(segments, first + i);
+            if (cursors[i] >= segment->term_count) {
+                continue;
+            }
+            guint32 len;
+            const gchar *candidate = _search_segment_term(segment, cursors[i], &len);
+            int cmp = term ? memcmp(candidate, term, MIN(len, term_len)) : -1;
+            if (term == NULL || cmp < 0 || (cmp == 0 && len < term_len)) {
+                term = candidate;
+                term_len = len;
+            }
+        }
+        if (term == NULL) {
+            break;
+        }
+
+        gchar *current = g_strndup(term, term_len);
+        guint32 total = 0;
+        guint64 start = pos;
+        for (i = 0; i < count; i++) {
+            SearchSegment *segment = g_ptr_array_index(segments, first + i);
+            if (cursors[i] >= segment->term_count) {
+                continue;
+            }
+            guint32 len;
+            const gchar *candidate = _search_segment_term(segment, cursors[i], &len);
+            if (len != term_len || memcmp(candidate, current, len) != 0) {
+                continue;
+            }
+            guint64 offset = _read_u64(candidate + len);
+            guint32 postings = _read_u32(candidate + len + 8);
+            pos += fwrite(segment->map + offset, sizeof(guint32), postings, fp) * sizeof(guint32);
+            total += postings;
+            cursors[i]++;
+        }
+
+        guint64 entry = dict->len;
+        g_array_append_val(table, entry);
+        g_byte_array_append(dict, (guint8*)&term_len, sizeof(term_len));
+        g_byte_array_append(dict, (guint8*)current, term_len);
+        g_byte_array_append(dict, (guint8*)&start, sizeof(start));
+        g_byte_array_append(dict, (guint8*)&total, sizeof(total));
+        g_free(current);
+    }
+    g_free(cursors);
+
+    gboolean written = _search_write_segment_end(fp, dict, table, tmpname);
+    g_byte_array_free(dict, TRUE);
+    g_array_free(table, TRUE);
+    if (!written) {
+        g_free(tmpname);
+        return FALSE;
+    }
+
+    guint id = next_segment++;
+    gchar *segname = g_strdup_printf("segment-%08u.idx", id);
+    gchar *segpath = _search_path(segname);
+    g_free(segname);
+    g_rename(tmpname, segpath);
+    g_free(segpath);
+    g_free(tmpname);
+
+    SearchSegment *merged = _search_segment_open(id);
+    if (merged == NULL) {
+        return FALSE;
+    }
+
+    guint *old = g_new(guint, count);
+    guint i;
+    for (i = 0; i < count; i++) {
+        old[i] = ((SearchSegment*)g_ptr_array_index(segments, first + i))->id;
+    }
+
+    pthread_mutex_lock(&index_lock);
+    g_ptr_array_remove_range(segments, first, count);
+    g_ptr_array_insert(segments, first, merged);
+    _search_save_state();
+    pthread_mutex_unlock(&index_lock);
+
+    for (i = 0; i < count; i++) {
+        gchar *name = g_strdup_printf("segment-%08u.idx", old[i]);
+        gchar *path = _search_path(name);
+        g_unlink(path);
+        g_free(path);
+        g_free(name);
+    }
+    g_free(old);
+
+    return TRUE;
+}
+
+static gboolean
+_search_write_segment_end(FILE *fp, GByteArray *dict, GArray *table, const char *const tmpname)
+{
+    long dict_start = ftell(fp);
+    fwrite(dict->data, 1, dict->len, fp);
+
+    // table entries are stored as file offsets of the dictionary entries
+    guint64 table_offset = dict_start + dict->len;
+    guint i;
+    for (i = 0; i < table->len; i++) {
+        guint64 entry = dict_start + g_array_index(table, guint64, i);
+        fwrite(&entry, sizeof(entry), 1, fp);
+    }
+
+    guint32 term_count = table->len;
+    fwrite(&table_offset, sizeof(table_offset), 1, fp);
+    fwrite(&term_count, sizeof(term_count), 1, fp);
+    fwrite(SEARCH_MAGIC, 1, 4, fp);
+
+    gboolean ok = fflush(fp) == 0 && fsync(fileno(fp)) == 0 && !ferror(fp);
+    fclose(fp);
+    if (!ok) {
+        g_unlink(tmpname);
+    }
+
+    return ok;
+}
+
+static SearchSegment*
+_search_segment_open(guint id)
+{
+    gchar *name = g_strdup_printf("segment-%08u.idx", id);
+    gchar *path = _search_path(name);
+    g_free(name);
+
+    int fd = open(path, O_RDONLY);
+    g_free(path);
+    if (fd < 0) {
+        return NULL;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < 4 + SEARCH_FOOTER_SIZE) {
+        close(fd);
+        return NULL;
+    }
+
+    gchar *map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        return NULL;
+    }
+
+    const gchar *footer = map + st.st_size - SEARCH_FOOTER_SIZE;
+    if (memcmp(map, SEARCH_MAGIC, 4) != 0 || memcmp(footer + 12, SEARCH_MAGIC, 4) != 0) {
+        munmap(map, st.st_size);
+        return NULL;
+    }
+
+    SearchSegment *segment = malloc(sizeof(SearchSegment));
+    segment->id = id;
+    segment->map = map;
+    segment->len = st.st_size;
+    segment->table = _read_u64(footer);
+    segment->term_count = _read_u32(footer + 8);
+
+    return segment;
+}
+
+static void
+_search_segment_free(SearchSegment *segment)
+{
+    if (segment) {
+        munmap(segment->map, segment->len);
+        free(segment);
+    }
+}
+
+// binary search of the sorted term table
+static gboolean
+_search_segment_lookup(SearchSegment *segment, const gchar *term, SearchPostings *postings)
+{
+    guint32 term_len = strlen(term);
+    guint32 low = 0;
+    guint32 high = segment->term_count;
+
+    while (low < high) {
+        guint32 mid = low + (high - low) / 2;
+        guint32 len;
+        const gchar *candidate = _search_segment_term(segment, mid, &len);
+        int cmp = memcmp(candidate, term, MIN(len, term_len));
+        if (cmp == 0) {
+            cmp = (len > term_len) - (len < term_len);
+        }
+
+        if (cmp == 0) {
+            postings->data = segment->map + _read_u64(candidate + len);
+            postings->count = _read_u32(candidate + len + 8);
+            return TRUE;
+        } else if (cmp < 0) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+
+    return FALSE;
+}
+
+static const gchar*
+_search_segment_term(SearchSegment *segment, guint32 index, guint32 *len)
+{
+    guint64 entry = _read_u64(segment->map + segment->table + (guint64)index * sizeof(guint64));
+    *len = _read_u32(segment->map + entry);
+
+    return segment->map + entry + sizeof(guint32);
+}
+
+static gchar*
+_search_path(const char *const name)
+{
+    return g_build_filename(index_dir, name, NULL);
+}
+
+// sources, progress and segment list are kept in a key file next to the segments
+static void
+_search_load_state(void)
+{
+    gchar *path = _search_path("index.state");
+    GKeyFile *state = g_key_file_new();
+    if (g_key_file_load_from_file(state, path, G_KEY_FILE_NONE, NULL)) {
+        next_segment = g_key_file_get_integer(state, "index", "next_segment", NULL);
+        docs_count = g_key_file_get_uint64(state, "index", "docs", NULL);
+
+        gsize len = 0;
+        gchar **names = g_key_file_get_string_list(state, "index", "sources", &len, NULL);
+        gsize i;
+        for (i = 0; i < len; i++) {
+            _search_source_id(names[i]);
+        }
+        g_strfreev(names);
+
+        gint *ids = g_key_file_get_integer_list(state, "index", "segments", &len, NULL);
+        for (i = 0; i < len; i++) {
+            SearchSegment *segment = _search_segment_open(ids[i]);
+            if (segment) {
+                g_ptr_array_add(segments, segment);
+            }
+        }
+        g_free(ids);
+
+        gchar **files = g_key_file_get_keys(state, "progress", &len, NULL);
+        for (i = 0; i < len; i++) {
+            SearchProgress *value = g_new(SearchProgress, 1);
+            value->offset = g_key_file_get_int64(state, "progress", files[i], NULL);
+            value->message = -1;
+            if (g_key_file_has_key(state, "messages", files[i], NULL)) {
+                value->message = g_key_file_get_int64(state, "messages", files[i], NULL);
+            }
+            g_hash_table_insert(progress, g_strdup(files[i]), value);
+        }
+        g_strfreev(files);
+    }
+    g_key_file_free(state);
+    g_free(path);
+
+    // docs written after the state was last saved are not referred to by any segment
+    gchar *docs_name = _search_path("docs.dat");
+    if (truncate(docs_name, (off_t)docs_count * sizeof(SearchDoc)) != 0 && errno != ENOENT) {
+        log_error("Could not truncate search index docs %s, errno = %d", docs_name, errno);
+    }
+    g_free(docs_name);
+
+    _search_map_docs();
+}
+
+static void
+_search_save_state(void)
+{
+    GKeyFile *state = g_key_file_new();
+    g_key_file_set_integer(state, "index", "next_segment", next_segment);
+    g_key_file_set_uint64(state, "index", "docs", docs_count);
+    g_key_file_set_string_list(state, "index", "sources", (const gchar *const *)sources->pdata, sources->len);
+
+    gint *ids = g_new(gint, segments->len + 1);
+    guint i;
+    for (i = 0; i < segments->len; i++) {
+        ids[i] = ((SearchSegment*)g_ptr_array_index(segments, i))->id;
+    }
+    g_key_file_set_integer_list(state, "index", "segments", ids, segments->len);
+    g_free(ids);
+
+    GHashTableIter iter;
+    gpointer key, value;
+    g_hash_table_iter_init(&iter, progress);
+    while (g_hash_table_iter_next(&iter, &key, &value)) {
+        SearchProgress *indexed = value;
+        g_key_file_set_int64(state, "progress", key, indexed->offset);
+        if (indexed->message >= 0) {
+            g_key_file_set_int64(state, "messages", key, indexed->message);
+        }
+    }
+
+    gchar *path = _search_path("index.state");
+    GError *error = NULL;
+    if (!g_key_file_save_to_file(state, path, &error)) {
+        log_error("Could not save search index state: %s", error->message);
+        g_error_free(error);
+    }
+    g_free(path);
+    g_key_file_free(state);
+}
+
+static void
+_search_map_docs(void)
+{
+    if (docs_map) {
+        munmap(docs_map, docs_mapped);
+        docs_map = NULL;
+    }
+    if (docs_count == 0) {
+        return;
+    }
+
+    gchar *path = _search_path("docs.dat");
+    int fd = open(path, O_RDONLY);
+    g_free(path);
+    if (fd < 0) {
+        return;
+    }
+
+    docs_mapped = (gsize)docs_count * sizeof(SearchDoc);
+    gchar *map = mmap(NULL, docs_mapped, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map != MAP_FAILED) {
+        docs_map = map;
+    }
+}
+
+static gboolean
+_search_get_doc(guint32 doc, SearchDoc *result)
+{
+    if (doc < docs_count) {
+        if (docs_map == NULL) {
+            return FALSE;
+        }
+        memcpy(result, docs_map + (gsize)doc * sizeof(SearchDoc), sizeof(SearchDoc));
+        return TRUE;
+    }
+
+    guint32 pending = doc - docs_count;
+    if (pending < pending_docs->len) {
+        *result = g_array_index(pending_docs, SearchDoc, pending);
+        return TRUE;
+    }
+
+    return FALSE;
+}
+
+// all docs containing term, in segment order then pending, so sorted by id
+static GArray*
+_search_term_docs(const gchar *term)
+{
+    GArray *docs = g_array_new(FALSE, FALSE, sizeof(guint32));
+
+    guint i;
+    for (i = 0; i < segments->len; i++) {
+        SearchPostings postings;
+        if (_search_segment_lookup(g_ptr_array_index(segments, i), term, &postings)) {
+            guint old_len = docs->len;
+            g_array_set_size(docs, old_len + postings.count);
+            memcpy(&g_array_index(docs, guint32, old_len), postings.data, postings.count * sizeof(guint32));
+        }
+    }
+
+    GArray *pending = g_hash_table_lookup(pending_terms, term);
+    if (pending) {
+        g_array_append_vals(docs, pending->data, pending->len);
+    }
+
+    return docs;
+}
+
+static GArray*
+_search_intersect(GArray *a, GArray *b)
+{
+    GArray *result = g_array_new(FALSE, FALSE, sizeof(guint32));
+    guint i = 0, j = 0;
+
+    while (i < a->len && j < b->len) {
+        guint32 doc_a = g_array_index(a, guint32, i);
+        guint32 doc_b = g_array_index(b, guint32, j);
+        if (doc_a == doc_b) {
+            g_array_append_val(result, doc_a);
+            i++;
+            j++;
+        } else if (doc_a < doc_b) {
+            i++;
+        } else {
+            j++;
+        }
+    }
+
+    return result;
+}
+
+// newest first, by day then by the order indexed
+static gint
+_search_candidate_cmp(gconstpointer a, gconstpointer b)
+{
+    const SearchCandidate *candidate_a = a;
+    const SearchCandidate *candidate_b = b;
+
+    if (candidate_a->date != candidate_b->date) {
+        return candidate_a->date < candidate_b->date ? 1 : -1;
+    }
+    if (candidate_a->doc != candidate_b->doc) {
+        return candidate_a->doc < candidate_b->doc ? 1 : -1;
+    }
+    return 0;
+}
+
+// by position in the logs, the latest document of a position first
+static gint
+_search_candidate_position_cmp(gconstpointer a, gconstpointer b)
+{
+    const SearchCandidate *candidate_a = a;
+    const SearchCandidate *candidate_b = b;
+
+    if (candidate_a->source != candidate_b->source) {
+        return candidate_a->source < candidate_b->source ? -1 : 1;
+    }
+    if (candidate_a->date != candidate_b->date) {
+        return candidate_a->date < candidate_b->date ? -1 : 1;
+    }
+    if (candidate_a->offset != candidate_b->offset) {
+        return candidate_a->offset < candidate_b->offset ? -1 : 1;
+    }
+    if (candidate_a->doc != candidate_b->doc) {
+        return candidate_a->doc < candidate_b->doc ? 1 : -1;
+    }
+    return 0;
+}
+
+// shortest postings list first
+static gint
+_search_term_cmp(gconstpointer a, gconstpointer b)
+{
+    const GArray *docs_a = *(GArray *const *)a;
+    const GArray *docs_b = *(GArray *const *)b;
+
+    return (docs_a->len > docs_b->len) - (docs_a->len < docs_b->len);
+}
+
+// YYYY-MM-DD as YYYYMMDD
+static gboolean
+_search_parse_date(const char *const text, guint32 *date)
+{
+    int year, month, day;
+    if (sscanf(text, "%4d-%2d-%2d", &year, &month, &day) != 3 || !g_date_valid_dmy(day, month, year)) {
+        return FALSE;
+    }
+
+    *date = year * 10000 + month * 100 + day;
+    return TRUE;
+}
+
+// "HH:MM:SS - " at the start of a logged message
+static gboolean
+_search_is_entry(const gchar *line, gsize len)
+{
+    return len >= 11 && g_ascii_isdigit(line[0]) && g_ascii_isdigit(line[1]) && line[2] == ':'
+        && line[5] == ':' && line[8] == ' ' && line[9] == '-' && line[10] == ' ';
+}
+
+static SearchResult*
+_search_read_result(const char *const source, guint32 date, guint64 offset)
+{
+    gchar *logname = g_strdup_printf("%s/%s/%04u_%02u_%02u.log", chatlogs_dir, source,
+        date / 10000, (date / 100) % 100, date % 100);
+    FILE *fp = fopen(logname, "r");
+    g_free(logname);
+    if (fp == NULL) {
+        return NULL;
+    }
+
+    gchar *text = malloc(SEARCH_MAX_MESSAGE + 1);
+    size_t len = 0;
+    if (fseeko(fp, offset, SEEK_SET) == 0) {
+        len = fread(text, 1, SEARCH_MAX_MESSAGE, fp);
+    }
+    fclose(fp);
+    text[len] = '\0';
+
+    // the message runs until the next logged message
+    GString *message = g_string_new(NULL);
+    gchar **lines = g_strsplit(text, "\n", -1);
+    int i;
+    for (i = 0; lines[i]; i++) {
+        gsize line_len = strlen(lines[i]);
+        if (i > 0 && (_search_is_entry(lines[i], line_len) || lines[i + 1] == NULL)) {
+            break;
+        }
+        if (i > 0) {
+            g_string_append_c(message, '\n');
+        }
+        g_string_append(message, lines[i]);
+    }
+    g_strfreev(lines);
+    free(text);
+
+    if (!_search_is_entry(message->str, message->len)) {
+        g_string_free(message, TRUE);
+        return NULL;
+    }
+
+    int hh, mm, ss;
+    sscanf(message->str, "%2d:%2d:%2d", &hh, &mm, &ss);
+
+    gchar **parts = g_strsplit(source, "/", 3);
+    if (g_strv_length(parts) < 2) {
+        g_strfreev(parts);
+        g_string_free(message, TRUE);
+        return NULL;
+    }
+    gboolean groupchat = g_strv_length(parts) == 3 && g_strcmp0(parts[1], "rooms") == 0;
+
+    SearchResult *result = malloc(sizeof(SearchResult));
+    result->timestamp = g_date_time_new_local(date / 10000, (date / 100) % 100, date % 100, hh, mm, ss);
+    result->groupchat = groupchat;
+    result->jid = str_replace(groupchat ? parts[2] : parts[1], "_at_", "@");
+    result->message = g_strdup(message->str + 11);
+    g_strfreev(parts);
+    g_string_free(message, TRUE);
+
+    return result;
+}
+
+static guint32
+_read_u32(const gchar *p)
+{
+    guint32 value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+static guint64
+_read_u64(const gchar *p)
+{
+    guint64 value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
@@ -0,0 +1,68 @@
+/*
+ * search.h
+ * vim: expandtab:ts=4:sts=4:sw=4
+ *
+ * Copyright (C) 2012 - 2019 James Booth <boothj5@gmail.com>
+ * Copyright (C) 2018 - 2019 Michael Vetter <jubalh@idoru.org>
+ *
+ * This file is part of Profanity.
+ *
+ * Profanity is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Profanity is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Profanity.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link the code of portions of this program with the OpenSSL library under
+ * certain conditions as described in each individual source file, and
+ * distribute linked combinations including the two.
+ *
+ * You must obey the GNU General Public License in all respects for all of the
+ * code used other than OpenSSL. If you modify file(s) with this exception, you
+ * may extend this exception to your version of the file(s), but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version. If you delete this exception statement from all
+ * source files in the program, then also delete it here.
+ *
+ */
+
+#ifndef SEARCH_H
+#define SEARCH_H
+
+#include <glib.h>
+
+typedef struct search_query_t {
+    GPtrArray *terms;
+    gchar *with;
+    gchar *room;
+    guint32 since;
+    guint32 until;
+} SearchQuery;
+
+typedef struct search_result_t {
+    GDateTime *timestamp;
+    gchar *jid;
+    gboolean groupchat;
+    gchar *message;
+} SearchResult;
+
+void search_init(void);
+void search_close(void);
+void search_log_updated(const char *const filename);
+
+SearchQuery* search_query_parse(const char *const text);
+void search_query_free(SearchQuery *query);
+
+// matching messages, oldest first, at most max_results of the most recent
+GSList* search_run(SearchQuery *query, int max_results);
+void search_results_free(GSList *results);
+
+#endif
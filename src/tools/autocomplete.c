@@ -43,22 +43,44 @@
 #include "tools/parser.h"
 #include "ui/ui.h"
 
+typedef struct autocomplete_item_t {
+    char *value;
+    gchar *folded;
+    GSequenceIter *folded_iter;
+} AutocompleteItem;
+
 struct autocomplete_t {
-    GList *items;
-    GList *last_found;
+    // items ordered by value, owns the items
+    GSequence *items;
+    // the same items ordered by their lower case ascii form, for prefix seeks
+    GSequence *folded;
+    AutocompleteItem *last_found;
     gchar *search_str;
+    // items matching search_str in value order, rebuilt after changes
+    GPtrArray *matches;
+    guint match_pos;
 };
 
-static gchar* _search_next(Autocomplete ac, GList *curr, gboolean quote);
-static gchar* _search_prev(Autocomplete ac, GList *curr, gboolean quote);
+static gchar* _fold(const char *const str);
+static AutocompleteItem* _item_new(const char *const value);
+static void _item_free(AutocompleteItem *item);
+static gint _cmp_items(gconstpointer a, gconstpointer b, gpointer data);
+static gint _cmp_folded(gconstpointer a, gconstpointer b, gpointer data);
+static gint _cmp_matches(gconstpointer a, gconstpointer b);
+static AutocompleteItem* _lookup(Autocomplete ac, const char *const value);
+static void _find_matches(Autocomplete ac);
+static gchar* _complete_result(AutocompleteItem *item, gboolean quote);
 
 Autocomplete
 autocomplete_new(void)
 {
     Autocomplete new = malloc(sizeof(struct autocomplete_t));
-    new->items = NULL;
+    new->items = g_sequence_new((GDestroyNotify)_item_free);
+    new->folded = g_sequence_new(NULL);
     new->last_found = NULL;
     new->search_str = NULL;
+    new->matches = NULL;
+    new->match_pos = 0;
 
     return new;
 }
@@ -67,9 +89,11 @@ void
 autocomplete_clear(Autocomplete ac)
 {
     if (ac) {
-        if (ac->items) {
-            g_list_free_full(ac->items, free);
-            ac->items = NULL;
+        if (g_sequence_get_length(ac->items) > 0) {
+            g_sequence_free(ac->folded);
+            g_sequence_free(ac->items);
+            ac->items = g_sequence_new((GDestroyNotify)_item_free);
+            ac->folded = g_sequence_new(NULL);
         }
 
         autocomplete_reset(ac);
@@ -81,6 +105,10 @@ autocomplete_reset(Autocomplete ac)
 {
     ac->last_found = NULL;
     FREE_SET_NULL(ac->search_str);
+    if (ac->matches) {
+        g_ptr_array_free(ac->matches, TRUE);
+        ac->matches = NULL;
+    }
 }
 
 void
@@ -88,6 +116,8 @@ autocomplete_free(Autocomplete ac)
 {
     if (ac) {
         autocomplete_clear(ac);
+        g_sequence_free(ac->folded);
+        g_sequence_free(ac->items);
         free(ac);
     }
 }
@@ -97,10 +127,8 @@ autocomplete_length(Autocomplete ac)
 {
     if (!ac) {
         return 0;
-    } else if (!ac->items) {
-        return 0;
     } else {
-        return g_list_length(ac->items);
+        return g_sequence_get_length(ac->items);
     }
 }
 
@@ -111,7 +139,7 @@ autocomplete_update(Autocomplete ac, char **items)
     gchar *search_str = NULL;
 
     if (ac->last_found) {
-        last_found = strdup(ac->last_found->data);
+        last_found = strdup(ac->last_found->value);
     }
 
     if (ac->search_str) {
@@ -123,7 +151,7 @@ autocomplete_update(Autocomplete ac, char **items)
 
     if (last_found) {
         // NULL if last_found was removed on update.
-        ac->last_found = g_list_find_custom(ac->items, last_found, (GCompareFunc)strcmp);
+        ac->last_found = _lookup(ac, last_found);
         free(last_found);
     }
 
@@ -137,16 +165,20 @@ void
 autocomplete_add(Autocomplete ac, const char *item)
 {
     if (ac) {
-        char *item_cpy;
-        GList *curr = g_list_find_custom(ac->items, item, (GCompareFunc)strcmp);
-
         // if item already exists
-        if (curr) {
+        if (_lookup(ac, item)) {
             return;
         }
 
-        item_cpy = strdup(item);
-        ac->items = g_list_insert_sorted(ac->items, item_cpy, (GCompareFunc)strcmp);
+        AutocompleteItem *new_item = _item_new(item);
+        g_sequence_insert_sorted(ac->items, new_item, _cmp_items, NULL);
+        new_item->folded_iter = g_sequence_insert_sorted(ac->folded, new_item, _cmp_folded, NULL);
+
+        // matches are rebuilt on the next completion
+        if (ac->matches) {
+            g_ptr_array_free(ac->matches, TRUE);
+            ac->matches = NULL;
+        }
     }
 
     return;
@@ -156,7 +188,7 @@ void
 autocomplete_add_all(Autocomplete ac, char **items)
 {
     int i = 0;
-    for (i = 0; i < g_strv_length(items); i++) {
+    for (i = 0; items[i] != NULL; i++) {
         autocomplete_add(ac, items[i]);
     }
 }
@@ -165,19 +197,26 @@ void
 autocomplete_remove(Autocomplete ac, const char *const item)
 {
     if (ac) {
-        GList *curr = g_list_find_custom(ac->items, item, (GCompareFunc)strcmp);
+        AutocompleteItem probe = { (char*)item, NULL, NULL };
+        GSequenceIter *curr = g_sequence_lookup(ac->items, &probe, _cmp_items, NULL);
 
         if (!curr) {
             return;
         }
 
+        AutocompleteItem *found = g_sequence_get(curr);
+
         // reset last found if it points to the item to be removed
-        if (ac->last_found == curr) {
+        if (ac->last_found == found) {
             ac->last_found = NULL;
         }
+        if (ac->matches) {
+            g_ptr_array_free(ac->matches, TRUE);
+            ac->matches = NULL;
+        }
 
-        free(curr->data);
-        ac->items = g_list_delete_link(ac->items, curr);
+        g_sequence_remove(found->folded_iter);
+        g_sequence_remove(curr);
     }
 
     return;
@@ -196,11 +235,12 @@ GList*
 autocomplete_create_list(Autocomplete ac)
 {
     GList *copy = NULL;
-    GList *curr = ac->items;
+    GSequenceIter *curr = g_sequence_get_end_iter(ac->items);
 
-    while(curr) {
-        copy = g_list_append(copy, strdup(curr->data));
-        curr = g_list_next(curr);
+    while (!g_sequence_iter_is_begin(curr)) {
+        curr = g_sequence_iter_prev(curr);
+        AutocompleteItem *item = g_sequence_get(curr);
+        copy = g_list_prepend(copy, strdup(item->value));
     }
 
     return copy;
@@ -209,30 +249,19 @@ autocomplete_create_list(Autocomplete ac)
 gboolean
 autocomplete_contains(Autocomplete ac, const char *value)
 {
-    GList *curr = ac->items;
-
-    while(curr) {
-        if (strcmp(curr->data, value) == 0) {
-            return TRUE;
-        }
-        curr = g_list_next(curr);
-    }
-
-    return FALSE;
+    return _lookup(ac, value) != NULL;
 }
 
 gchar*
 autocomplete_complete(Autocomplete ac, const gchar *search_str, gboolean quote, gboolean previous)
 {
-    gchar *found = NULL;
-
     // no autocomplete to search
     if (!ac) {
         return NULL;
     }
 
     // no items to search
-    if (!ac->items) {
+    if (g_sequence_get_length(ac->items) == 0) {
         return NULL;
     }
 
@@ -243,44 +272,37 @@ autocomplete_complete(Autocomplete ac, const gchar *search_str, gboolean quote,
         }
 
         ac->search_str = strdup(search_str);
-        found = _search_next(ac, ac->items, quote);
+        _find_matches(ac);
+        if (ac->matches->len == 0) {
+            return NULL;
+        }
 
-        return found;
+        ac->match_pos = 0;
+        ac->last_found = g_ptr_array_index(ac->matches, 0);
+
+        return _complete_result(ac->last_found, quote);
 
     // subsequent search attempt
     } else {
-        if (previous) {
-            // search from here-1 to beginning
-            found = _search_prev(ac, g_list_previous(ac->last_found), quote);
-            if (found) {
-                return found;
-            }
-        } else {
-            // search from here+1 to end
-            found = _search_next(ac, g_list_next(ac->last_found), quote);
-            if (found) {
-                return found;
-            }
+        if (!ac->matches) {
+            _find_matches(ac);
+        }
+
+        // we found nothing, reset search
+        if (ac->matches->len == 0) {
+            autocomplete_reset(ac);
+            return NULL;
         }
 
+        // cycle from the last found item, wrapping at either end
         if (previous) {
-            // search from end
-            found = _search_prev(ac, g_list_last(ac->items), quote);
-            if (found) {
-                return found;
-            }
+            ac->match_pos = ac->match_pos == 0 ? ac->matches->len - 1 : ac->match_pos - 1;
         } else {
-            // search from beginning
-            found = _search_next(ac, ac->items, quote);
-            if (found) {
-                return found;
-            }
+            ac->match_pos = ac->match_pos + 1 >= ac->matches->len ? 0 : ac->match_pos + 1;
         }
+        ac->last_found = g_ptr_array_index(ac->matches, ac->match_pos);
 
-        // we found nothing, reset search
-        autocomplete_reset(ac);
-
-        return NULL;
+        return _complete_result(ac->last_found, quote);
     }
 }
 
@@ -386,95 +408,139 @@ autocomplete_param_no_with_func(const char *const input, char *command, int arg_
 }
 
 static gchar*
-_search_next(Autocomplete ac, GList *curr, gboolean quote)
+_fold(const char *const str)
 {
-    gchar *search_str_ascii = g_str_to_ascii(ac->search_str, NULL);
-    gchar *search_str_lower = g_ascii_strdown(search_str_ascii, -1);
-    g_free(search_str_ascii);
+    gchar *ascii = g_str_to_ascii(str, NULL);
+    gchar *lower = g_ascii_strdown(ascii, -1);
+    g_free(ascii);
 
-    while(curr) {
-        gchar *curr_ascii = g_str_to_ascii(curr->data, NULL);
-        gchar *curr_lower = g_ascii_strdown(curr_ascii, -1);
-        g_free(curr_ascii);
+    return lower;
+}
 
-        // match found
-        if (strncmp(curr_lower, search_str_lower, strlen(search_str_lower)) == 0) {
+static AutocompleteItem*
+_item_new(const char *const value)
+{
+    AutocompleteItem *item = malloc(sizeof(AutocompleteItem));
+    item->value = strdup(value);
+    item->folded = _fold(value);
+    item->folded_iter = NULL;
 
-            // set pointer to last found
-            ac->last_found = curr;
+    return item;
+}
 
-            // if contains space, quote before returning
-            if (quote && g_strrstr(curr->data, " ")) {
-                GString *quoted = g_string_new("\"");
-                g_string_append(quoted, curr->data);
-                g_string_append(quoted, "\"");
+static void
+_item_free(AutocompleteItem *item)
+{
+    free(item->value);
+    g_free(item->folded);
+    free(item);
+}
 
-                gchar *result = quoted->str;
-                g_string_free(quoted, FALSE);
+static gint
+_cmp_items(gconstpointer a, gconstpointer b, gpointer data)
+{
+    const AutocompleteItem *item_a = a;
+    const AutocompleteItem *item_b = b;
 
-                g_free(search_str_lower);
-                g_free(curr_lower);
-                return result;
+    return strcmp(item_a->value, item_b->value);
+}
 
-            // otherwise just return the string
-            } else {
-                g_free(search_str_lower);
-                g_free(curr_lower);
-                return strdup(curr->data);
-            }
-        }
+// A NULL value sorts before every item with the same folded form,
+// so it can be used to seek to the start of a prefix range
+static gint
+_cmp_folded(gconstpointer a, gconstpointer b, gpointer data)
+{
+    const AutocompleteItem *item_a = a;
+    const AutocompleteItem *item_b = b;
 
-        g_free(curr_lower);
-        curr = g_list_next(curr);
+    int result = strcmp(item_a->folded, item_b->folded);
+    if (result != 0) {
+        return result;
+    }
+    if (item_a->value == NULL) {
+        return item_b->value == NULL ? 0 : -1;
+    }
+    if (item_b->value == NULL) {
+        return 1;
     }
 
-    g_free(search_str_lower);
-    return NULL;
+    return strcmp(item_a->value, item_b->value);
 }
 
-static gchar*
-_search_prev(Autocomplete ac, GList *curr, gboolean quote)
+static gint
+_cmp_matches(gconstpointer a, gconstpointer b)
 {
-    gchar *search_str_ascii = g_str_to_ascii(ac->search_str, NULL);
-    gchar *search_str_lower = g_ascii_strdown(search_str_ascii, -1);
-    g_free(search_str_ascii);
+    const AutocompleteItem *item_a = *(AutocompleteItem**)a;
+    const AutocompleteItem *item_b = *(AutocompleteItem**)b;
 
-    while(curr) {
-        gchar *curr_ascii = g_str_to_ascii(curr->data, NULL);
-        gchar *curr_lower = g_ascii_strdown(curr_ascii, -1);
-        g_free(curr_ascii);
-
-        // match found
-        if (strncmp(curr_lower, search_str_lower, strlen(search_str_lower)) == 0) {
+    return strcmp(item_a->value, item_b->value);
+}
 
-            // set pointer to last found
-            ac->last_found = curr;
+static AutocompleteItem*
+_lookup(Autocomplete ac, const char *const value)
+{
+    AutocompleteItem probe = { (char*)value, NULL, NULL };
+    GSequenceIter *iter = g_sequence_lookup(ac->items, &probe, _cmp_items, NULL);
+    if (!iter) {
+        return NULL;
+    }
 
-            // if contains space, quote before returning
-            if (quote && g_strrstr(curr->data, " ")) {
-                GString *quoted = g_string_new("\"");
-                g_string_append(quoted, curr->data);
-                g_string_append(quoted, "\"");
+    return g_sequence_get(iter);
+}
 
-                gchar *result = quoted->str;
-                g_string_free(quoted, FALSE);
+static void
+_find_matches(Autocomplete ac)
+{
+    if (ac->matches) {
+        g_ptr_array_free(ac->matches, TRUE);
+    }
+    ac->matches = g_ptr_array_new();
+    ac->match_pos = 0;
+
+    // items sharing the folded prefix are contiguous in the folded sequence
+    gchar *search_folded = _fold(ac->search_str);
+    AutocompleteItem probe = { NULL, search_folded, NULL };
+    GSequenceIter *curr = g_sequence_search(ac->folded, &probe, _cmp_folded, NULL);
+    while (!g_sequence_iter_is_end(curr)) {
+        AutocompleteItem *item = g_sequence_get(curr);
+        if (!g_str_has_prefix(item->folded, search_folded)) {
+            break;
+        }
+        g_ptr_array_add(ac->matches, item);
+        curr = g_sequence_iter_next(curr);
+    }
+    g_free(search_folded);
 
-                g_free(search_str_lower);
-                g_free(curr_lower);
-                return result;
+    // cycle in the same order as the items themselves
+    g_ptr_array_sort(ac->matches, _cmp_matches);
 
-            // otherwise just return the string
-            } else {
-                g_free(search_str_lower);
-                g_free(curr_lower);
-                return strdup(curr->data);
+    if (ac->last_found) {
+        guint i;
+        for (i = 0; i < ac->matches->len; i++) {
+            if (g_ptr_array_index(ac->matches, i) == ac->last_found) {
+                ac->match_pos = i;
+                break;
             }
         }
-
-        g_free(curr_lower);
-        curr = g_list_previous(curr);
     }
+}
 
-    g_free(search_str_lower);
-    return NULL;
+static gchar*
+_complete_result(AutocompleteItem *item, gboolean quote)
+{
+    // if contains space, quote before returning
+    if (quote && g_strrstr(item->value, " ")) {
+        GString *quoted = g_string_new("\"");
+        g_string_append(quoted, item->value);
+        g_string_append(quoted, "\"");
+
+        gchar *result = quoted->str;
+        g_string_free(quoted, FALSE);
+
+        return result;
+
+    // otherwise just return the string
+    } else {
+        return strdup(item->value);
+    }
 }
@@ -0,0 +1,400 @@
+/*
+ * history_file.c
+ * vim: expandtab:ts=4:sts=4:sw=4
+ *
+ * Copyright (C) 2012 - 2019 James Booth <boothj5@gmail.com>
+ *
+ * This file is part of Profanity.
+ *
+ * Profanity is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Profanity is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Profanity.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link the code of portions of this program with the OpenSSL library under
+ * certain conditions as described in each individual source file, and
+ * distribute linked combinations including the two.
+ *
+ * You must obey the GNU General Public License in all respects for all of the
+ * code used other than OpenSSL. If you modify file(s) with this exception, you
+ * may extend this exception to your version of the file(s), but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version. If you delete this exception statement from all
+ * source files in the program, then also delete it here.
+ *
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#include "tools/history_file.h"
+
+struct history_file_t {
+    gchar *filename;
+    int year;
+    int month;
+    int day;
+    goffset pos;
+};
+
+static gboolean _history_is_message(const gchar *line, gsize len, int *hh, int *mm, int *ss);
+static gboolean _history_take_line(HistoryFile *file, const gchar *line, gsize len, GString *continuation,
+    GSList **entries);
+static gchar* _history_index_path(const char *const dir);
+static gint _history_day_cmp(gconstpointer a, gconstpointer b);
+
+HistoryFile*
+history_file_new(const char *const filename, int year, int month, int day, goffset size)
+{
+    HistoryFile *file = malloc(sizeof(HistoryFile));
+    file->filename = g_strdup(filename);
+    file->year = year;
+    file->month = month;
+    file->day = day;
+    file->pos = size;
+
+    return file;
+}
+
+void
+history_file_free(HistoryFile *file)
+{
+    if (file) {
+        g_free(file->filename);
+        free(file);
+    }
+}
+
+// file->pos is moved back to the start of the oldest message read
+int
+history_file_read_back(HistoryFile *file, int count, GSList **entries)
+{
+    FILE *fp = fopen(file->filename, "r");
+    if (fp == NULL) {
+        file->pos = 0;
+        return 0;
+    }
+
+    int found = 0;
+    gchar *chunk = malloc(HISTORY_FILE_CHUNK);
+    // unread bytes, always ending at the end of a message
+    GString *carry = g_string_new(NULL);
+    // lines without a timestamp belong to the message before them
+    GString *continuation = g_string_new(NULL);
+
+    while (found < count && (file->pos > 0 || carry->len > 0)) {
+        if (file->pos > 0) {
+            goffset start = MAX(0, file->pos - HISTORY_FILE_CHUNK);
+            size_t len = file->pos - start;
+            if (fseeko(fp, start, SEEK_SET) != 0 || fread(chunk, 1, len, fp) != len) {
+                file->pos = 0;
+                g_string_truncate(carry, 0);
+                break;
+            }
+            g_string_prepend_len(carry, chunk, len);
+            file->pos = start;
+        }
+
+        // take complete lines from the end, the first line is only complete at the start of the file
+        while (found < count && carry->len > 0) {
+            gsize end = carry->len;
+            if (carry->str[end - 1] == '\n') {
+                end--;
+            }
+            gchar *nl = g_strrstr_len(carry->str, end, "\n");
+            if (nl == NULL && file->pos > 0) {
+                break;
+            }
+
+            gsize line_start = nl ? (nl - carry->str) + 1 : 0;
+            if (_history_take_line(file, carry->str + line_start, end - line_start, continuation, entries)) {
+                found++;
+            }
+            g_string_truncate(carry, line_start);
+        }
+    }
+
+    // anything not consumed is read again next time
+    file->pos += carry->len;
+
+    g_string_free(continuation, TRUE);
+    g_string_free(carry, TRUE);
+    free(chunk);
+    fclose(fp);
+
+    return found;
+}
+
+gboolean
+history_file_done(HistoryFile *file)
+{
+    return file->pos == 0;
+}
+
+gint
+history_file_cmp(gconstpointer a, gconstpointer b)
+{
+    const HistoryFile *file_a = *(HistoryFile *const *)a;
+    const HistoryFile *file_b = *(HistoryFile *const *)b;
+
+    if (file_a->year != file_b->year) {
+        return file_b->year - file_a->year;
+    }
+    if (file_a->month != file_b->month) {
+        return file_b->month - file_a->month;
+    }
+    return file_b->day - file_a->day;
+}
+
+int
+history_file_count(const char *const filename, goffset *size)
+{
+    *size = 0;
+    FILE *fp = fopen(filename, "r");
+    if (fp == NULL) {
+        return 0;
+    }
+
+    int count = 0;
+    char *line = NULL;
+    size_t cap = 0;
+    ssize_t len;
+    while ((len = getline(&line, &cap, fp)) != -1) {
+        int hh, mm, ss;
+        if (_history_is_message(line, len, &hh, &mm, &ss)) {
+            count++;
+        }
+        *size += len;
+    }
+    free(line);
+    fclose(fp);
+
+    return count;
+}
+
+// one record per line, "YYYY_MM_DD <size> <count>", a later record for a day
+// replaces the earlier ones
+GArray*
+history_index_read(const char *const dir, guint *records)
+{
+    gchar *path = _history_index_path(dir);
+    gchar *contents = NULL;
+    gsize len = 0;
+    gboolean found = g_file_get_contents(path, &contents, &len, NULL);
+    g_free(path);
+    if (records) {
+        *records = 0;
+    }
+    if (!found) {
+        return NULL;
+    }
+
+    GArray *days = g_array_new(FALSE, FALSE, sizeof(HistoryDay));
+    // date -> position in days
+    GHashTable *positions = g_hash_table_new(g_direct_hash, g_direct_equal);
+
+    // a record without its newline was cut short by a crash, leave it out
+    gchar *line = contents;
+    gchar *nl;
+    while ((nl = memchr(line, '\n', len - (line - contents))) != NULL) {
+        *nl = '\0';
+        if (records) {
+            (*records)++;
+        }
+
+        HistoryDay day;
+        gint64 size;
+        int end = 0;
+        if (sscanf(line, "%4d_%2d_%2d %" G_GINT64_FORMAT " %d%n", &day.year, &day.month, &day.day, &size,
+                &day.count, &end) == 5 && line[end] == '\0') {
+            day.size = size;
+            gpointer key = GINT_TO_POINTER(day.year * 10000 + day.month * 100 + day.day);
+            gpointer pos;
+            if (g_hash_table_lookup_extended(positions, key, NULL, &pos)) {
+                g_array_index(days, HistoryDay, GPOINTER_TO_INT(pos)) = day;
+            } else {
+                g_hash_table_insert(positions, key, GINT_TO_POINTER(days->len));
+                g_array_append_val(days, day);
+            }
+        }
+        line = nl + 1;
+    }
+
+    g_hash_table_destroy(positions);
+    g_free(contents);
+    g_array_sort(days, _history_day_cmp);
+
+    return days;
+}
+
+GArray*
+history_index_scan(const char *const dir, gboolean count)
+{
+    GArray *days = g_array_new(FALSE, FALSE, sizeof(HistoryDay));
+
+    GDir *gdir = g_dir_open(dir, 0, NULL);
+    if (gdir == NULL) {
+        return days;
+    }
+
+    const gchar *name;
+    while ((name = g_dir_read_name(gdir)) != NULL) {
+        HistoryDay day;
+        if (strlen(name) != strlen("YYYY_MM_DD.log") || !g_str_has_suffix(name, ".log")
+                || sscanf(name, "%4d_%2d_%2d", &day.year, &day.month, &day.day) != 3) {
+            continue;
+        }
+
+        gchar *filename = g_build_filename(dir, name, NULL);
+        if (count) {
+            day.count = history_file_count(filename, &day.size);
+        } else {
+            GStatBuf st;
+            day.count = -1;
+            day.size = g_stat(filename, &st) == 0 ? st.st_size : 0;
+        }
+        g_free(filename);
+
+        g_array_append_val(days, day);
+    }
+    g_dir_close(gdir);
+
+    g_array_sort(days, _history_day_cmp);
+
+    return days;
+}
+
+gboolean
+history_index_write(const char *const dir, GArray *days)
+{
+    GString *contents = g_string_new(NULL);
+    guint i;
+    for (i = 0; i < days->len; i++) {
+        HistoryDay *day = &g_array_index(days, HistoryDay, i);
+        g_string_append_printf(contents, "%04d_%02d_%02d %" G_GINT64_FORMAT " %d\n", day->year, day->month,
+            day->day, (gint64)day->size, day->count);
+    }
+
+    // written to a temporary file and renamed, a crash leaves the old index
+    gchar *path = _history_index_path(dir);
+    gboolean result = g_file_set_contents(path, contents->str, contents->len, NULL);
+    if (result) {
+        g_chmod(path, S_IRUSR | S_IWUSR);
+    }
+    g_free(path);
+    g_string_free(contents, TRUE);
+
+    return result;
+}
+
+gboolean
+history_index_append(const char *const dir, const HistoryDay *const day)
+{
+    gchar *path = _history_index_path(dir);
+    int fd = open(path, O_RDWR | O_APPEND | O_CREAT, S_IRUSR | S_IWUSR);
+    g_free(path);
+    if (fd == -1) {
+        return FALSE;
+    }
+
+    // end a record cut short by a crash, so it is not joined to this one
+    char last = '\n';
+    if (lseek(fd, -1, SEEK_END) != -1 && read(fd, &last, 1) != 1) {
+        last = '\n';
+    }
+
+    // a single write, so a record is never split by another
+    gchar *record = g_strdup_printf("%s%04d_%02d_%02d %" G_GINT64_FORMAT " %d\n", last == '\n' ? "" : "\n",
+        day->year, day->month, day->day, (gint64)day->size, day->count);
+    size_t len = strlen(record);
+    ssize_t written;
+    do {
+        written = write(fd, record, len);
+    } while (written == -1 && errno == EINTR);
+    g_free(record);
+
+    int saved = errno;
+    close(fd);
+    errno = saved;
+
+    return written == (ssize_t)len;
+}
+
+gchar*
+history_day_filename(const char *const dir, const HistoryDay *const day)
+{
+    return g_strdup_printf("%s/%04d_%02d_%02d.log", dir, day->year, day->month, day->day);
+}
+
+static gchar*
+_history_index_path(const char *const dir)
+{
+    return g_build_filename(dir, HISTORY_INDEX_NAME, NULL);
+}
+
+static gint
+_history_day_cmp(gconstpointer a, gconstpointer b)
+{
+    const HistoryDay *day_a = a;
+    const HistoryDay *day_b = b;
+
+    if (day_a->year != day_b->year) {
+        return day_b->year - day_a->year;
+    }
+    if (day_a->month != day_b->month) {
+        return day_b->month - day_a->month;
+    }
+    return day_b->day - day_a->day;
+}
+
+// "HH:MM:SS - " followed by text
+static gboolean
+_history_is_message(const gchar *line, gsize len, int *hh, int *mm, int *ss)
+{
+    return len >= 11 && line[2] == ':' && line[5] == ':' && sscanf(line, "%2d:%2d:%2d - ", hh, mm, ss) == 3;
+}
+
+static gboolean
+_history_take_line(HistoryFile *file, const gchar *line, gsize len, GString *continuation, GSList **entries)
+{
+    int hh, mm, ss;
+
+    if (_history_is_message(line, len, &hh, &mm, &ss)) {
+        ProfHistoryEntry *entry = malloc(sizeof(ProfHistoryEntry));
+        entry->timestamp = g_date_time_new_local(file->year, file->month, file->day, hh, mm, ss);
+        GString *message = g_string_new_len(line + 11, len - 11);
+        if (continuation->len > 0) {
+            g_string_append(message, continuation->str);
+            g_string_truncate(continuation, 0);
+        }
+        entry->message = g_string_free(message, FALSE);
+        *entries = g_slist_prepend(*entries, entry);
+
+        return TRUE;
+    }
+
+    // continuation of a multi line message
+    g_string_prepend_len(continuation, line, len);
+    g_string_prepend_c(continuation, '\n');
+
+    return FALSE;
+}
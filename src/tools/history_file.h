@@ -0,0 +1,95 @@
+/*
+ * history_file.h
+ * vim: expandtab:ts=4:sts=4:sw=4
+ *
+ * Copyright (C) 2012 - 2019 James Booth <boothj5@gmail.com>
+ *
+ * This file is part of Profanity.
+ *
+ * Profanity is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Profanity is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Profanity.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link the code of portions of this program with the OpenSSL library under
+ * certain conditions as described in each individual source file, and
+ * distribute linked combinations including the two.
+ *
+ * You must obey the GNU General Public License in all respects for all of the
+ * code used other than OpenSSL. If you modify file(s) with this exception, you
+ * may extend this exception to your version of the file(s), but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version. If you delete this exception statement from all
+ * source files in the program, then also delete it here.
+ *
+ */
+
+#ifndef TOOLS_HISTORY_FILE_H
+#define TOOLS_HISTORY_FILE_H
+
+#include <glib.h>
+
+#include "log.h"
+
+// bytes read at a time when reading history backwards from a log file
+#define HISTORY_FILE_CHUNK 8192
+
+// a day of chat log for one contact, read backwards from the end
+typedef struct history_file_t HistoryFile;
+
+HistoryFile* history_file_new(const char *const filename, int year, int month, int day, goffset size);
+void history_file_free(HistoryFile *file);
+
+// read up to count messages before those already read, prepending them to
+// entries, returns how many were read
+int history_file_read_back(HistoryFile *file, int count, GSList **entries);
+
+// whether every message in the file has been read
+gboolean history_file_done(HistoryFile *file);
+
+// newest day first
+gint history_file_cmp(gconstpointer a, gconstpointer b);
+
+// count the messages in a log, setting size to the bytes counted
+int history_file_count(const char *const filename, goffset *size);
+
+// a contact's history index, kept with the logs of each day
+#define HISTORY_INDEX_NAME "history.idx"
+
+// the size of a day's log and the messages in it when last written,
+// count is -1 when not known
+typedef struct history_day_t {
+    int year;
+    int month;
+    int day;
+    goffset size;
+    int count;
+} HistoryDay;
+
+// the days recorded in the index in dir, newest first, NULL without an index
+// records is set to the number of records read, more than the days returned
+// when later records replaced earlier ones for a day
+GArray* history_index_read(const char *const dir, guint *records);
+
+// the days found by listing the logs in dir, newest first, messages are only
+// counted when count is set
+GArray* history_index_scan(const char *const dir, gboolean count);
+
+// replace the index in dir with one record per day
+gboolean history_index_write(const char *const dir, GArray *days);
+
+// append the latest size and message count of a day to the index in dir
+gboolean history_index_append(const char *const dir, const HistoryDay *const day);
+
+gchar* history_day_filename(const char *const dir, const HistoryDay *const day);
+
+#endif
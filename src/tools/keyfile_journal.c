@@ -0,0 +1,281 @@
+/*
+ * keyfile_journal.c
+ * vim: expandtab:ts=4:sts=4:sw=4
+ *
+ * Copyright (C) 2012 - 2019 James Booth <boothj5@gmail.com>
+ *
+ * This file is part of Profanity.
+ *
+ * Profanity is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Profanity is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Profanity.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link the code of portions of this program with the OpenSSL library under
+ * certain conditions as described in each individual source file, and
+ * distribute linked combinations including the two.
+ *
+ * You must obey the GNU General Public License in all respects for all of the
+ * code used other than OpenSSL. If you modify file(s) with this exception, you
+ * may extend this exception to your version of the file(s), but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version. If you delete this exception statement from all
+ * source files in the program, then also delete it here.
+ *
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+
+#include <glib.h>
+
+#include "tools/keyfile_journal.h"
+
+static int _journal_replay(KeyfileJournal *journal, GKeyFile *keyfile);
+static gboolean _journal_apply(GKeyFile *keyfile, const gchar *const line);
+static void _journal_set_error(GError **error, const char *const action, const char *const filename);
+
+void
+keyfile_journal_init(KeyfileJournal *journal, const char *const filename)
+{
+    memset(journal, 0, sizeof(KeyfileJournal));
+    journal->filename = g_strdup(filename);
+    journal->journal_filename = g_strdup_printf("%s.journal", filename);
+}
+
+gboolean
+keyfile_journal_close(KeyfileJournal *journal, GError **error)
+{
+    gboolean res = keyfile_journal_sync(journal, TRUE, error);
+    if (journal->fp) {
+        fclose(journal->fp);
+        journal->fp = NULL;
+    }
+    g_free(journal->filename);
+    journal->filename = NULL;
+    g_free(journal->journal_filename);
+    journal->journal_filename = NULL;
+
+    return res;
+}
+
+gboolean
+keyfile_journal_load(KeyfileJournal *journal, GKeyFile *keyfile, GError **error)
+{
+    GError *load_error = NULL;
+    gboolean res = g_key_file_load_from_file(keyfile, journal->filename, G_KEY_FILE_KEEP_COMMENTS, &load_error);
+    journal->loaded = res || g_error_matches(load_error, G_FILE_ERROR, G_FILE_ERROR_NOENT);
+
+    // the records of a store that could not be read are kept for when it can
+    int replayed = _journal_replay(journal, journal->loaded ? keyfile : NULL);
+    if (!res && journal->loaded && replayed > 0) {
+        g_error_free(load_error);
+        return TRUE;
+    }
+
+    if (load_error) {
+        g_propagate_error(error, load_error);
+    }
+
+    return res;
+}
+
+gboolean
+keyfile_journal_save(KeyfileJournal *journal, GKeyFile *keyfile, GError **error)
+{
+    if (!journal->loaded) {
+        g_set_error(error, G_FILE_ERROR, G_FILE_ERROR_FAILED, "%s could not be read, not overwriting it",
+            journal->filename);
+        return FALSE;
+    }
+
+    // the file is replaced atomically, a crash leaves either the old file and
+    // journal or the new file and a journal it already contains
+    if (!g_key_file_save_to_file(keyfile, journal->filename, error)) {
+        return FALSE;
+    }
+
+    if (journal->fp) {
+        fclose(journal->fp);
+    }
+    journal->fp = fopen(journal->journal_filename, "w");
+    journal->size = 0;
+    journal->unsynced = FALSE;
+    journal->last_sync = g_get_monotonic_time();
+
+    // the old records must not be appended to, they would be replayed over
+    // changes saved in full
+    journal->torn = journal->fp == NULL;
+    if (journal->torn) {
+        _journal_set_error(error, "opening", journal->journal_filename);
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+gboolean
+keyfile_journal_record(KeyfileJournal *journal, GKeyFile *keyfile, const char *const group,
+    const char *const key, GError **error)
+{
+    if (journal->torn) {
+        if (journal->loaded) {
+            return keyfile_journal_save(journal, keyfile, error);
+        }
+        g_set_error(error, G_FILE_ERROR, G_FILE_ERROR_FAILED, "%s ends in a partly written record",
+            journal->journal_filename);
+        return FALSE;
+    }
+
+    if (!journal->fp) {
+        journal->fp = fopen(journal->journal_filename, "a");
+        if (!journal->fp) {
+            if (journal->loaded) {
+                return keyfile_journal_save(journal, keyfile, error);
+            }
+            _journal_set_error(error, "opening", journal->journal_filename);
+            return FALSE;
+        }
+        journal->size = ftell(journal->fp);
+        journal->last_sync = g_get_monotonic_time();
+    }
+
+    gchar *group_esc = g_strescape(group, NULL);
+    gchar *key_esc = g_strescape(key, NULL);
+    gchar *value = g_key_file_get_string(keyfile, group, key, NULL);
+    int written;
+    if (value) {
+        gchar *value_esc = g_strescape(value, NULL);
+        written = fprintf(journal->fp, "+\t%s\t%s\t%s\n", group_esc, key_esc, value_esc);
+        g_free(value_esc);
+        g_free(value);
+    } else {
+        written = fprintf(journal->fp, "-\t%s\t%s\n", group_esc, key_esc);
+    }
+    g_free(group_esc);
+    g_free(key_esc);
+
+    if (written < 0 || fflush(journal->fp) != 0) {
+        // part of the record may have reached the file
+        journal->torn = TRUE;
+        if (journal->loaded) {
+            return keyfile_journal_save(journal, keyfile, error);
+        }
+        _journal_set_error(error, "writing", journal->journal_filename);
+        return FALSE;
+    }
+
+    journal->size += written;
+    journal->unsynced = TRUE;
+
+    if (journal->loaded && journal->size >= KEYFILE_JOURNAL_COMPACT_SIZE) {
+        return keyfile_journal_save(journal, keyfile, error);
+    }
+
+    return TRUE;
+}
+
+gboolean
+keyfile_journal_sync(KeyfileJournal *journal, gboolean force, GError **error)
+{
+    if (!journal->fp || !journal->unsynced) {
+        return TRUE;
+    }
+
+    gint64 now = g_get_monotonic_time();
+    if (!force && now - journal->last_sync < KEYFILE_JOURNAL_SYNC_INTERVAL * G_USEC_PER_SEC) {
+        return TRUE;
+    }
+
+    journal->unsynced = FALSE;
+    journal->last_sync = now;
+    if (fsync(fileno(journal->fp)) != 0) {
+        _journal_set_error(error, "syncing", journal->journal_filename);
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+/*
+ * Apply the journal to keyfile, or only check it when keyfile is NULL, returns
+ * the number of records applied. A partly written last record is cut off so
+ * the next append starts on a line of its own.
+ */
+static int
+_journal_replay(KeyfileJournal *journal, GKeyFile *keyfile)
+{
+    gchar *contents = NULL;
+    gsize length = 0;
+    int count = 0;
+
+    if (!g_file_get_contents(journal->journal_filename, &contents, &length, NULL)) {
+        return 0;
+    }
+
+    gchar *line = contents;
+    gchar *end = NULL;
+    while ((end = memchr(line, '\n', length - (line - contents))) != NULL) {
+        *end = '\0';
+        if (keyfile && _journal_apply(keyfile, line)) {
+            count++;
+        }
+        line = end + 1;
+    }
+
+    gsize complete = line - contents;
+    if (complete < length && truncate(journal->journal_filename, complete) != 0) {
+        journal->torn = TRUE;
+    }
+
+    g_free(contents);
+
+    return count;
+}
+
+static gboolean
+_journal_apply(GKeyFile *keyfile, const gchar *const line)
+{
+    gboolean applied = FALSE;
+    gchar **fields = g_strsplit(line, "\t", 4);
+    guint nfields = g_strv_length(fields);
+    if (nfields >= 3) {
+        gchar *group = g_strcompress(fields[1]);
+        gchar *key = g_strcompress(fields[2]);
+        if (g_strcmp0(fields[0], "+") == 0 && nfields == 4) {
+            gchar *value = g_strcompress(fields[3]);
+            g_key_file_set_string(keyfile, group, key, value);
+            g_free(value);
+            applied = TRUE;
+        } else if (g_strcmp0(fields[0], "-") == 0) {
+            g_key_file_remove_key(keyfile, group, key, NULL);
+            applied = TRUE;
+        }
+        g_free(group);
+        g_free(key);
+    }
+    g_strfreev(fields);
+
+    return applied;
+}
+
+static void
+_journal_set_error(GError **error, const char *const action, const char *const filename)
+{
+    int errsv = errno;
+    g_set_error(error, G_FILE_ERROR, g_file_error_from_errno(errsv), "error %s %s, %s", action, filename,
+        g_strerror(errsv));
+}
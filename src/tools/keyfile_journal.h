@@ -0,0 +1,85 @@
+/*
+ * keyfile_journal.h
+ * vim: expandtab:ts=4:sts=4:sw=4
+ *
+ * Copyright (C) 2012 - 2019 James Booth <boothj5@gmail.com>
+ *
+ * This file is part of Profanity.
+ *
+ * Profanity is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Profanity is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Profanity.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link the code of portions of this program with the OpenSSL library under
+ * certain conditions as described in each individual source file, and
+ * distribute linked combinations including the two.
+ *
+ * You must obey the GNU General Public License in all respects for all of the
+ * code used other than OpenSSL. If you modify file(s) with this exception, you
+ * may extend this exception to your version of the file(s), but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version. If you delete this exception statement from all
+ * source files in the program, then also delete it here.
+ *
+ */
+
+#ifndef TOOLS_KEYFILE_JOURNAL_H
+#define TOOLS_KEYFILE_JOURNAL_H
+
+#include <stdio.h>
+
+#include <glib.h>
+
+// bytes journalled before the store file is rewritten in full
+#define KEYFILE_JOURNAL_COMPACT_SIZE (256 * 1024)
+// seconds between fsyncs of a journal
+#define KEYFILE_JOURNAL_SYNC_INTERVAL 2
+
+// changes to a key file appended to <filename>.journal, replayed on load and
+// folded back into the file when it is saved
+typedef struct keyfile_journal_t {
+    gchar *filename;
+    gchar *journal_filename;
+    FILE *fp;
+    long size;
+    gboolean unsynced;
+    gint64 last_sync;
+    // the store file was read or did not exist, it is never rewritten otherwise
+    gboolean loaded;
+    // the journal ends in a partly written record nothing may be appended to
+    gboolean torn;
+} KeyfileJournal;
+
+void keyfile_journal_init(KeyfileJournal *journal, const char *const filename);
+
+// sync and close the journal, returns FALSE when the sync failed
+gboolean keyfile_journal_close(KeyfileJournal *journal, GError **error);
+
+// load the store file and replay its journal on top, a partly written last
+// record is cut off the journal. Returns FALSE when the file exists but could
+// not be read, the store is then kept on disk as it is
+gboolean keyfile_journal_load(KeyfileJournal *journal, GKeyFile *keyfile, GError **error);
+
+// write the whole store file and empty the journal
+gboolean keyfile_journal_save(KeyfileJournal *journal, GKeyFile *keyfile, GError **error);
+
+// append the current value of group/key, or its removal, saving in full when
+// the journal cannot be written or has grown past KEYFILE_JOURNAL_COMPACT_SIZE
+gboolean keyfile_journal_record(KeyfileJournal *journal, GKeyFile *keyfile, const char *const group,
+    const char *const key, GError **error);
+
+// make appended records durable, at most once every
+// KEYFILE_JOURNAL_SYNC_INTERVAL seconds unless forced
+gboolean keyfile_journal_sync(KeyfileJournal *journal, gboolean force, GError **error);
+
+#endif
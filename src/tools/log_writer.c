@@ -0,0 +1,302 @@
+/*
+ * log_writer.c
+ * vim: expandtab:ts=4:sts=4:sw=4
+ *
+ * Copyright (C) 2012 - 2019 James Booth <boothj5@gmail.com>
+ *
+ * This file is part of Profanity.
+ *
+ * Profanity is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Profanity is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Profanity.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link the code of portions of this program with the OpenSSL library under
+ * certain conditions as described in each individual source file, and
+ * distribute linked combinations including the two.
+ *
+ * You must obey the GNU General Public License in all respects for all of the
+ * code used other than OpenSSL. If you modify file(s) with this exception, you
+ * may extend this exception to your version of the file(s), but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version. If you delete this exception statement from all
+ * source files in the program, then also delete it here.
+ *
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/stat.h>
+
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <glib/gprintf.h>
+
+#include "tools/log_writer.h"
+
+struct log_writer_t {
+    gchar *filename;
+    gchar *area;
+    log_level_t filter;
+    gboolean rotate;
+    gint rotate_size;
+    // owned by the writer thread while it runs
+    FILE *fp;
+    long size;
+    pthread_t thread;
+    gboolean running;
+    pthread_mutex_t lock;
+    pthread_cond_t ready;
+    // guarded by lock
+    GString *pending;
+    GString *spare;
+    gboolean stop;
+    guint dropped;
+    time_t stamp_time;
+    char stamp[32];
+};
+
+static void _log_writer_append_locked(LogWriter writer, log_level_t level, const char *const area,
+    const char *const msg);
+static void* _log_writer_thread(void *userdata);
+static gboolean _log_writer_write(LogWriter writer, GString *lines);
+static void _log_writer_rotate(LogWriter writer);
+static void _log_writer_deadline(struct timespec *ts, long msec);
+static const char* _log_writer_level(log_level_t level);
+
+LogWriter
+log_writer_open(const char *const filename, const char *const area, log_level_t filter, gboolean rotate,
+    gint rotate_size)
+{
+    FILE *fp = fopen(filename, "a");
+    g_chmod(filename, S_IRUSR | S_IWUSR);
+    if (fp == NULL) {
+        return NULL;
+    }
+
+    LogWriter writer = malloc(sizeof(struct log_writer_t));
+    writer->filename = g_strdup(filename);
+    writer->area = g_strdup(area);
+    writer->filter = filter;
+    writer->rotate = rotate;
+    writer->rotate_size = rotate_size;
+    writer->fp = fp;
+    struct stat st;
+    writer->size = fstat(fileno(fp), &st) == 0 ? st.st_size : 0;
+    pthread_mutex_init(&writer->lock, NULL);
+    pthread_cond_init(&writer->ready, NULL);
+    writer->pending = g_string_sized_new(LOG_WRITER_FLUSH * 2);
+    writer->spare = g_string_sized_new(LOG_WRITER_FLUSH * 2);
+    writer->stop = FALSE;
+    writer->dropped = 0;
+    writer->stamp_time = 0;
+    writer->stamp[0] = '\0';
+
+    writer->running = pthread_create(&writer->thread, NULL, _log_writer_thread, writer) == 0;
+
+    return writer;
+}
+
+void
+log_writer_close(LogWriter writer)
+{
+    if (writer == NULL) {
+        return;
+    }
+
+    if (writer->running) {
+        pthread_mutex_lock(&writer->lock);
+        writer->stop = TRUE;
+        pthread_cond_signal(&writer->ready);
+        pthread_mutex_unlock(&writer->lock);
+
+        pthread_join(writer->thread, NULL);
+    }
+
+    g_string_free(writer->pending, TRUE);
+    g_string_free(writer->spare, TRUE);
+    pthread_cond_destroy(&writer->ready);
+    pthread_mutex_destroy(&writer->lock);
+    if (writer->fp) {
+        fclose(writer->fp);
+    }
+    g_free(writer->filename);
+    g_free(writer->area);
+    free(writer);
+}
+
+void
+log_writer_append(LogWriter writer, log_level_t level, const char *const area, const char *const msg)
+{
+    pthread_mutex_lock(&writer->lock);
+    _log_writer_append_locked(writer, level, area, msg);
+
+    if (!writer->running) {
+        if (_log_writer_write(writer, writer->pending)) {
+            g_string_truncate(writer->pending, 0);
+            if (PROF_LEVEL_INFO >= writer->filter) {
+                _log_writer_append_locked(writer, PROF_LEVEL_INFO, writer->area, "Log has been rotated");
+                _log_writer_write(writer, writer->pending);
+            }
+        }
+        g_string_truncate(writer->pending, 0);
+    } else if (level == PROF_LEVEL_ERROR || writer->pending->len >= LOG_WRITER_FLUSH) {
+        pthread_cond_signal(&writer->ready);
+    }
+
+    pthread_mutex_unlock(&writer->lock);
+}
+
+static void
+_log_writer_append_locked(LogWriter writer, log_level_t level, const char *const area, const char *const msg)
+{
+    GString *pending = writer->pending;
+    if (pending->len >= LOG_WRITER_MAX) {
+        writer->dropped++;
+        return;
+    }
+
+    time_t now = time(NULL);
+    if (now != writer->stamp_time) {
+        struct tm local;
+        localtime_r(&now, &local);
+        strftime(writer->stamp, sizeof(writer->stamp), "%d/%m/%Y %H:%M:%S", &local);
+        writer->stamp_time = now;
+    }
+
+    g_string_append(pending, writer->stamp);
+    g_string_append(pending, ": ");
+    g_string_append(pending, area);
+    g_string_append(pending, ": ");
+    g_string_append(pending, _log_writer_level(level));
+    g_string_append(pending, ": ");
+    g_string_append(pending, msg);
+    g_string_append_c(pending, '\n');
+}
+
+static void*
+_log_writer_thread(void *userdata)
+{
+    LogWriter writer = userdata;
+
+    pthread_mutex_lock(&writer->lock);
+    while (TRUE) {
+        if (writer->pending->len < LOG_WRITER_FLUSH && !writer->stop) {
+            struct timespec deadline;
+            _log_writer_deadline(&deadline, LOG_WRITER_INTERVAL);
+            pthread_cond_timedwait(&writer->ready, &writer->lock, &deadline);
+        }
+
+        // swap buffers so callers never wait on file I/O
+        GString *lines = writer->pending;
+        writer->pending = writer->spare;
+        writer->spare = lines;
+        gboolean stop = writer->stop;
+        pthread_mutex_unlock(&writer->lock);
+
+        gboolean rotated = _log_writer_write(writer, lines);
+        g_string_truncate(lines, 0);
+
+        pthread_mutex_lock(&writer->lock);
+        if (rotated && PROF_LEVEL_INFO >= writer->filter) {
+            _log_writer_append_locked(writer, PROF_LEVEL_INFO, writer->area, "Log has been rotated");
+        }
+        if (writer->dropped > 0) {
+            gchar *note = g_strdup_printf("Log writer fell behind, dropped %u lines", writer->dropped);
+            writer->dropped = 0;
+            _log_writer_append_locked(writer, PROF_LEVEL_WARN, writer->area, note);
+            g_free(note);
+        }
+        if (stop && writer->pending->len == 0) {
+            break;
+        }
+    }
+    pthread_mutex_unlock(&writer->lock);
+
+    return NULL;
+}
+
+static gboolean
+_log_writer_write(LogWriter writer, GString *lines)
+{
+    if (writer->fp == NULL || lines->len == 0) {
+        return FALSE;
+    }
+
+    writer->size += fwrite(lines->str, 1, lines->len, writer->fp);
+    fflush(writer->fp);
+
+    if (writer->rotate && writer->size >= writer->rotate_size) {
+        _log_writer_rotate(writer);
+        return TRUE;
+    }
+
+    return FALSE;
+}
+
+static void
+_log_writer_rotate(LogWriter writer)
+{
+    size_t len = strlen(writer->filename);
+    gchar *filename_new = malloc(len + 4);
+    int i = 1;
+
+    // find an empty name. from .log -> log.01 -> log.99
+    for(; i<100; i++) {
+        g_sprintf(filename_new, "%s.%02d", writer->filename, i);
+        if (!g_file_test(filename_new, G_FILE_TEST_EXISTS))
+            break;
+    }
+
+    fclose(writer->fp);
+    rename(writer->filename, filename_new);
+    writer->fp = fopen(writer->filename, "a");
+    g_chmod(writer->filename, S_IRUSR | S_IWUSR);
+    writer->size = 0;
+
+    free(filename_new);
+}
+
+static void
+_log_writer_deadline(struct timespec *ts, long msec)
+{
+    clock_gettime(CLOCK_REALTIME, ts);
+    ts->tv_sec += msec / 1000;
+    ts->tv_nsec += (msec % 1000) * 1000000;
+    if (ts->tv_nsec >= 1000000000) {
+        ts->tv_sec++;
+        ts->tv_nsec -= 1000000000;
+    }
+}
+
+static const char*
+_log_writer_level(log_level_t level)
+{
+    switch (level)
+    {
+        case PROF_LEVEL_ERROR:
+            return "ERR";
+        case PROF_LEVEL_WARN:
+            return "WRN";
+        case PROF_LEVEL_INFO:
+            return "INF";
+        case PROF_LEVEL_DEBUG:
+            return "DBG";
+        default:
+            return "LOG";
+    }
+}
@@ -0,0 +1,67 @@
+/*
+ * log_writer.h
+ * vim: expandtab:ts=4:sts=4:sw=4
+ *
+ * Copyright (C) 2012 - 2019 James Booth <boothj5@gmail.com>
+ *
+ * This file is part of Profanity.
+ *
+ * Profanity is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Profanity is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Profanity.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link the code of portions of this program with the OpenSSL library under
+ * certain conditions as described in each individual source file, and
+ * distribute linked combinations including the two.
+ *
+ * You must obey the GNU General Public License in all respects for all of the
+ * code used other than OpenSSL. If you modify file(s) with this exception, you
+ * may extend this exception to your version of the file(s), but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version. If you delete this exception statement from all
+ * source files in the program, then also delete it here.
+ *
+ */
+
+#ifndef TOOLS_LOG_WRITER_H
+#define TOOLS_LOG_WRITER_H
+
+#include <glib.h>
+
+#include "log.h"
+
+// buffered bytes before the writer thread is woken early
+#define LOG_WRITER_FLUSH 16384
+// buffered bytes before lines are dropped, if the writer falls behind
+#define LOG_WRITER_MAX (4 * 1024 * 1024)
+// milliseconds between writes of buffered lines
+#define LOG_WRITER_INTERVAL 1000
+
+typedef struct log_writer_t *LogWriter;
+
+// open filename for appending, NULL when it cannot be opened. Lines are
+// written by a thread of their own, or as they are appended when it cannot be
+// started. With rotate set the file is moved aside once it reaches
+// rotate_size bytes. The writer's own notes are logged under area, the
+// rotation note only when filter lets info through
+LogWriter log_writer_open(const char *const filename, const char *const area, log_level_t filter, gboolean rotate,
+    gint rotate_size);
+
+// write out buffered lines and close the file
+void log_writer_close(LogWriter writer);
+
+// append a timestamped line, safe from any thread. Errors are written
+// without waiting for the next interval in case we are about to crash
+void log_writer_append(LogWriter writer, log_level_t level, const char *const area, const char *const msg);
+
+#endif
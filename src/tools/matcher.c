@@ -0,0 +1,282 @@
+/*
+ * matcher.c
+ * vim: expandtab:ts=4:sts=4:sw=4
+ *
+ * Copyright (C) 2012 - 2019 James Booth <boothj5@gmail.com>
+ *
+ * This file is part of Profanity.
+ *
+ * Profanity is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Profanity is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Profanity.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link the code of portions of this program with the OpenSSL library under
+ * certain conditions as described in each individual source file, and
+ * distribute linked combinations including the two.
+ *
+ * You must obey the GNU General Public License in all respects for all of the
+ * code used other than OpenSSL. If you modify file(s) with this exception, you
+ * may extend this exception to your version of the file(s), but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version. If you delete this exception statement from all
+ * source files in the program, then also delete it here.
+ *
+ */
+
+#include "config.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <glib.h>
+
+#include "tools/matcher.h"
+
+// a node of the pattern trie, with the Aho-Corasick links
+typedef struct matcher_state_t {
+    int first_child;
+    int next_sibling;
+    guchar byte;
+    // longest proper suffix that is also in the trie
+    int fail;
+    // first pattern ending here, and the nearest state on the fail
+    // chain where another pattern ends
+    int pattern;
+    int output;
+} MatcherState;
+
+typedef struct matcher_pattern_t {
+    int id;
+    int bytes;
+    int chars;
+    gboolean whole_word;
+    // next pattern ending in the same state
+    int next;
+} MatcherPattern;
+
+struct matcher_t {
+    GArray *states;
+    GArray *patterns;
+    // state and byte to next state + 1
+    GHashTable *gotos;
+    gboolean built;
+};
+
+#define GOTO_KEY(state, byte) GUINT_TO_POINTER(((guint)(state) << 8) | (byte))
+
+static int _goto(Matcher matcher, int state, guchar byte);
+static int _state_new(Matcher matcher, int parent, guchar byte);
+static void _build(Matcher matcher);
+static gboolean _is_whole_word(const char *const text, gsize start, gsize end);
+
+Matcher
+matcher_new(void)
+{
+    Matcher matcher = malloc(sizeof(struct matcher_t));
+    matcher->states = g_array_new(FALSE, FALSE, sizeof(MatcherState));
+    matcher->patterns = g_array_new(FALSE, FALSE, sizeof(MatcherPattern));
+    matcher->gotos = g_hash_table_new(g_direct_hash, g_direct_equal);
+    matcher->built = FALSE;
+
+    // the root
+    _state_new(matcher, -1, 0);
+
+    return matcher;
+}
+
+void
+matcher_free(Matcher matcher)
+{
+    if (matcher) {
+        g_array_free(matcher->states, TRUE);
+        g_array_free(matcher->patterns, TRUE);
+        g_hash_table_destroy(matcher->gotos);
+        free(matcher);
+    }
+}
+
+void
+matcher_add(Matcher matcher, const char *const pattern, int id, gboolean whole_word)
+{
+    if (pattern == NULL || pattern[0] == '\0') {
+        return;
+    }
+
+    int state = 0;
+    const guchar *curr = (const guchar*)pattern;
+    while (*curr != '\0') {
+        int next = _goto(matcher, state, *curr);
+        if (next < 0) {
+            next = _state_new(matcher, state, *curr);
+        }
+        state = next;
+        curr++;
+    }
+
+    MatcherState *end = &g_array_index(matcher->states, MatcherState, state);
+    MatcherPattern new_pattern;
+    new_pattern.id = id;
+    new_pattern.bytes = strlen(pattern);
+    new_pattern.chars = g_utf8_strlen(pattern, -1);
+    new_pattern.whole_word = whole_word;
+    new_pattern.next = end->pattern;
+    g_array_append_val(matcher->patterns, new_pattern);
+    end->pattern = matcher->patterns->len - 1;
+
+    matcher->built = FALSE;
+}
+
+GSList*
+matcher_find(Matcher matcher, const char *const text)
+{
+    if (text == NULL || matcher->patterns->len == 0) {
+        return NULL;
+    }
+
+    if (!matcher->built) {
+        _build(matcher);
+    }
+
+    GSList *hits = NULL;
+    int state = 0;
+    int chars = 0;
+    gsize i = 0;
+
+    for (i = 0; text[i] != '\0'; i++) {
+        guchar byte = text[i];
+        if ((byte & 0xC0) != 0x80) {
+            chars++;
+        }
+
+        int next = _goto(matcher, state, byte);
+        while (next < 0 && state != 0) {
+            state = g_array_index(matcher->states, MatcherState, state).fail;
+            next = _goto(matcher, state, byte);
+        }
+        state = next < 0 ? 0 : next;
+
+        // every pattern ending at this byte, longest first
+        int out = state;
+        while (out > 0) {
+            MatcherState *out_state = &g_array_index(matcher->states, MatcherState, out);
+            int p = out_state->pattern;
+            while (p >= 0) {
+                MatcherPattern *pattern = &g_array_index(matcher->patterns, MatcherPattern, p);
+                gsize start = i + 1 - pattern->bytes;
+                if (!pattern->whole_word || _is_whole_word(text, start, i + 1)) {
+                    MatcherHit *hit = malloc(sizeof(MatcherHit));
+                    hit->id = pattern->id;
+                    hit->offset = chars - pattern->chars;
+                    hits = g_slist_prepend(hits, hit);
+                }
+                p = pattern->next;
+            }
+            out = out_state->output;
+        }
+    }
+
+    return g_slist_reverse(hits);
+}
+
+static int
+_goto(Matcher matcher, int state, guchar byte)
+{
+    gpointer next = g_hash_table_lookup(matcher->gotos, GOTO_KEY(state, byte));
+    return next ? GPOINTER_TO_INT(next) - 1 : -1;
+}
+
+static int
+_state_new(Matcher matcher, int parent, guchar byte)
+{
+    MatcherState state;
+    state.first_child = -1;
+    state.next_sibling = -1;
+    state.byte = byte;
+    state.fail = 0;
+    state.pattern = -1;
+    state.output = 0;
+    g_array_append_val(matcher->states, state);
+
+    int id = matcher->states->len - 1;
+    if (parent >= 0) {
+        MatcherState *parent_state = &g_array_index(matcher->states, MatcherState, parent);
+        g_array_index(matcher->states, MatcherState, id).next_sibling = parent_state->first_child;
+        parent_state->first_child = id;
+        g_hash_table_insert(matcher->gotos, GOTO_KEY(parent, byte), GINT_TO_POINTER(id + 1));
+    }
+
+    return id;
+}
+
+// set the fail and output links breadth first, so shorter suffixes are
+// always linked before the states that need them
+static void
+_build(Matcher matcher)
+{
+    GQueue queue = G_QUEUE_INIT;
+
+    int child = g_array_index(matcher->states, MatcherState, 0).first_child;
+    while (child >= 0) {
+        MatcherState *state = &g_array_index(matcher->states, MatcherState, child);
+        state->fail = 0;
+        state->output = 0;
+        g_queue_push_tail(&queue, GINT_TO_POINTER(child));
+        child = state->next_sibling;
+    }
+
+    while (!g_queue_is_empty(&queue)) {
+        int parent = GPOINTER_TO_INT(g_queue_pop_head(&queue));
+        int parent_fail = g_array_index(matcher->states, MatcherState, parent).fail;
+
+        child = g_array_index(matcher->states, MatcherState, parent).first_child;
+        while (child >= 0) {
+            guchar byte = g_array_index(matcher->states, MatcherState, child).byte;
+
+            int fail = parent_fail;
+            int next = _goto(matcher, fail, byte);
+            while (next < 0 && fail != 0) {
+                fail = g_array_index(matcher->states, MatcherState, fail).fail;
+                next = _goto(matcher, fail, byte);
+            }
+            fail = next < 0 ? 0 : next;
+
+            MatcherState *fail_state = &g_array_index(matcher->states, MatcherState, fail);
+            MatcherState *state = &g_array_index(matcher->states, MatcherState, child);
+            state->fail = fail;
+            state->output = fail_state->pattern >= 0 ? fail : fail_state->output;
+
+            g_queue_push_tail(&queue, GINT_TO_POINTER(child));
+            child = state->next_sibling;
+        }
+    }
+
+    matcher->built = TRUE;
+}
+
+// no letter or digit either side of text[start..end)
+static gboolean
+_is_whole_word(const char *const text, gsize start, gsize end)
+{
+    gunichar before = 0;
+    gchar *before_ch = g_utf8_find_prev_char(text, text + start);
+    if (before_ch) {
+        before = g_utf8_get_char(before_ch);
+    }
+
+    gunichar after = 0;
+    if (text[end] != '\0') {
+        after = g_utf8_get_char(text + end);
+    }
+
+    return !g_unichar_isalnum(before) && !g_unichar_isalnum(after);
+}
@@ -0,0 +1,61 @@
+/*
+ * matcher.h
+ * vim: expandtab:ts=4:sts=4:sw=4
+ *
+ * Copyright (C) 2012 - 2019 James Booth <boothj5@gmail.com>
+ *
+ * This file is part of Profanity.
+ *
+ * Profanity is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Profanity is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Profanity.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link the code of portions of this program with the OpenSSL library under
+ * certain conditions as described in each individual source file, and
+ * distribute linked combinations including the two.
+ *
+ * You must obey the GNU General Public License in all respects for all of the
+ * code used other than OpenSSL. If you modify file(s) with this exception, you
+ * may extend this exception to your version of the file(s), but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version. If you delete this exception statement from all
+ * source files in the program, then also delete it here.
+ *
+ */
+
+#ifndef TOOLS_MATCHER_H
+#define TOOLS_MATCHER_H
+
+#include <glib.h>
+
+// finds every occurrence of a set of patterns in one pass over a text,
+// patterns and text are compared byte for byte, so fold both for
+// case insensitive matching
+typedef struct matcher_t *Matcher;
+
+typedef struct matcher_hit_t {
+    int id;
+    // in characters from the start of the text
+    int offset;
+} MatcherHit;
+
+Matcher matcher_new(void);
+void matcher_free(Matcher matcher);
+
+// whole_word patterns only match with no letter or digit either side
+void matcher_add(Matcher matcher, const char *const pattern, int id, gboolean whole_word);
+
+// hits in the order they end in text, free with g_slist_free_full(hits, free)
+GSList* matcher_find(Matcher matcher, const char *const text);
+
+#endif
@@ -0,0 +1,149 @@
+/*
+ * worker.c
+ * vim: expandtab:ts=4:sts=4:sw=4
+ *
+ * Copyright (C) 2012 - 2019 James Booth <boothj5@gmail.com>
+ *
+ * This file is part of Profanity.
+ *
+ * Profanity is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Profanity is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Profanity.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link the code of portions of this program with the OpenSSL library under
+ * certain conditions as described in each individual source file, and
+ * distribute linked combinations including the two.
+ *
+ * You must obey the GNU General Public License in all respects for all of the
+ * code used other than OpenSSL. If you modify file(s) with this exception, you
+ * may extend this exception to your version of the file(s), but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version. If you delete this exception statement from all
+ * source files in the program, then also delete it here.
+ *
+ */
+
+#include "config.h"
+
+#include <stdlib.h>
+#include <pthread.h>
+
+#include <glib.h>
+
+#include "tools/worker.h"
+
+typedef struct worker_job_t {
+    worker_func run;
+    worker_func done;
+    void *data;
+} WorkerJob;
+
+struct worker_t {
+    pthread_t thread;
+    GAsyncQueue *jobs;
+    GAsyncQueue *finished;
+    gint pending;
+};
+
+// pushed by worker_free to stop the thread once the queue is drained
+static WorkerJob stop_job;
+
+static void* _worker_thread(void *userdata);
+
+Worker
+worker_new(void)
+{
+    Worker worker = malloc(sizeof(struct worker_t));
+    worker->jobs = g_async_queue_new();
+    worker->finished = g_async_queue_new();
+    worker->pending = 0;
+
+    pthread_create(&worker->thread, NULL, _worker_thread, worker);
+
+    return worker;
+}
+
+void
+worker_free(Worker worker)
+{
+    if (worker == NULL) {
+        return;
+    }
+
+    g_async_queue_push(worker->jobs, &stop_job);
+    pthread_join(worker->thread, NULL);
+    worker_poll(worker);
+
+    g_async_queue_unref(worker->jobs);
+    g_async_queue_unref(worker->finished);
+    free(worker);
+}
+
+void
+worker_submit(Worker worker, worker_func run, worker_func done, void *data)
+{
+    WorkerJob *job = malloc(sizeof(WorkerJob));
+    job->run = run;
+    job->done = done;
+    job->data = data;
+
+    g_atomic_int_inc(&worker->pending);
+    g_async_queue_push(worker->jobs, job);
+}
+
+int
+worker_poll(Worker worker)
+{
+    int count = 0;
+    WorkerJob *job = NULL;
+    while ((job = g_async_queue_try_pop(worker->finished)) != NULL) {
+        if (job->done) {
+            job->done(job->data);
+        }
+        free(job);
+        g_atomic_int_add(&worker->pending, -1);
+        count++;
+    }
+
+    return count;
+}
+
+gint
+worker_pending(Worker worker)
+{
+    if (worker == NULL) {
+        return 0;
+    }
+
+    return g_atomic_int_get(&worker->pending);
+}
+
+static void*
+_worker_thread(void *userdata)
+{
+    Worker worker = userdata;
+
+    while (TRUE) {
+        WorkerJob *job = g_async_queue_pop(worker->jobs);
+        if (job == &stop_job) {
+            break;
+        }
+
+        if (job->run) {
+            job->run(job->data);
+        }
+        g_async_queue_push(worker->finished, job);
+    }
+
+    return NULL;
+}
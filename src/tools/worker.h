@@ -0,0 +1,60 @@
+/*
+ * worker.h
+ * vim: expandtab:ts=4:sts=4:sw=4
+ *
+ * Copyright (C) 2012 - 2019 James Booth <boothj5@gmail.com>
+ *
+ * This file is part of Profanity.
+ *
+ * Profanity is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Profanity is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Profanity.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link the code of portions of this program with the OpenSSL library under
+ * certain conditions as described in each individual source file, and
+ * distribute linked combinations including the two.
+ *
+ * You must obey the GNU General Public License in all respects for all of the
+ * code used other than OpenSSL. If you modify file(s) with this exception, you
+ * may extend this exception to your version of the file(s), but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version. If you delete this exception statement from all
+ * source files in the program, then also delete it here.
+ *
+ */
+
+#ifndef TOOLS_WORKER_H
+#define TOOLS_WORKER_H
+
+#include <glib.h>
+
+typedef void (*worker_func)(void *data);
+typedef struct worker_t *Worker;
+
+// start a thread running submitted jobs one at a time, in order
+Worker worker_new(void);
+
+// finish all queued jobs, run their done callbacks and stop the thread
+void worker_free(Worker worker);
+
+// run run(data) on the worker thread, done(data) is called later from
+// worker_poll on the main thread, either may be NULL
+void worker_submit(Worker worker, worker_func run, worker_func done, void *data);
+
+// call the done callbacks of finished jobs, returns how many were called
+int worker_poll(Worker worker);
+
+// jobs submitted whose done callbacks have not been called yet
+gint worker_pending(Worker worker);
+
+#endif
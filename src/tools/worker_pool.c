@@ -0,0 +1,194 @@
+/*
+ * worker_pool.c
+ * vim: expandtab:ts=4:sts=4:sw=4
+ *
+ * Copyright (C) 2012 - 2019 James Booth <boothj5@gmail.com>
+ *
+ * This file is part of Profanity.
+ *
+ * Profanity is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Profanity is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Profanity.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link the code of portions of this program with the OpenSSL library under
+ * certain conditions as described in each individual source file, and
+ * distribute linked combinations including the two.
+ *
+ * You must obey the GNU General Public License in all respects for all of the
+ * code used other than OpenSSL. If you modify file(s) with this exception, you
+ * may extend this exception to your version of the file(s), but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version. If you delete this exception statement from all
+ * source files in the program, then also delete it here.
+ *
+ */
+
+#include "config.h"
+
+#include <stdlib.h>
+#include <pthread.h>
+
+#include <glib.h>
+
+#include "tools/worker_pool.h"
+
+typedef struct worker_pool_thread_t {
+    pthread_t thread;
+    void *state;
+    WorkerPool pool;
+} WorkerPoolThread;
+
+struct worker_pool_t {
+    pthread_mutex_t lock;
+    pthread_cond_t start;
+    pthread_cond_t finished;
+    WorkerPoolThread *threads;
+    int count;
+    worker_pool_free_func free_state;
+    // threads still to join the current run, and those in it
+    int slots;
+    int running;
+    worker_pool_run_func run;
+    void *data;
+    gboolean stopping;
+};
+
+static void* _worker_pool_thread(void *userdata);
+
+WorkerPool
+worker_pool_new(int count, worker_pool_init_func init, worker_pool_free_func free_state, void *userdata)
+{
+    WorkerPool pool = malloc(sizeof(struct worker_pool_t));
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->start, NULL);
+    pthread_cond_init(&pool->finished, NULL);
+    pool->threads = calloc(MAX(count, 1), sizeof(WorkerPoolThread));
+    pool->count = 0;
+    pool->free_state = free_state;
+    pool->slots = 0;
+    pool->running = 0;
+    pool->run = NULL;
+    pool->data = NULL;
+    pool->stopping = FALSE;
+
+    int i;
+    for (i = 0; i < count; i++) {
+        WorkerPoolThread *thread = &pool->threads[pool->count];
+        thread->state = init(userdata);
+        if (thread->state == NULL) {
+            continue;
+        }
+        thread->pool = pool;
+        if (pthread_create(&thread->thread, NULL, _worker_pool_thread, thread) != 0) {
+            free_state(thread->state);
+            break;
+        }
+        pool->count++;
+    }
+
+    return pool;
+}
+
+void
+worker_pool_free(WorkerPool pool)
+{
+    if (pool == NULL) {
+        return;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    pool->stopping = TRUE;
+    pthread_cond_broadcast(&pool->start);
+    pthread_mutex_unlock(&pool->lock);
+
+    int i;
+    for (i = 0; i < pool->count; i++) {
+        pthread_join(pool->threads[i].thread, NULL);
+        pool->free_state(pool->threads[i].state);
+    }
+
+    pthread_cond_destroy(&pool->start);
+    pthread_cond_destroy(&pool->finished);
+    pthread_mutex_destroy(&pool->lock);
+    free(pool->threads);
+    free(pool);
+}
+
+int
+worker_pool_size(WorkerPool pool)
+{
+    return pool ? pool->count : 0;
+}
+
+void
+worker_pool_run(WorkerPool pool, int workers, worker_pool_run_func run, void *data, void *caller_state)
+{
+    workers = CLAMP(workers, 0, pool->count);
+
+    if (workers > 0) {
+        pthread_mutex_lock(&pool->lock);
+        pool->run = run;
+        pool->data = data;
+        pool->slots = workers;
+        pthread_cond_broadcast(&pool->start);
+        pthread_mutex_unlock(&pool->lock);
+    }
+
+    run(caller_state, data);
+
+    if (workers > 0) {
+        pthread_mutex_lock(&pool->lock);
+        // threads that have not woken yet would find nothing left to take
+        pool->slots = 0;
+        while (pool->running > 0) {
+            pthread_cond_wait(&pool->finished, &pool->lock);
+        }
+        pool->run = NULL;
+        pool->data = NULL;
+        pthread_mutex_unlock(&pool->lock);
+    }
+}
+
+static void*
+_worker_pool_thread(void *userdata)
+{
+    WorkerPoolThread *thread = userdata;
+    WorkerPool pool = thread->pool;
+
+    pthread_mutex_lock(&pool->lock);
+    while (TRUE) {
+        while (!pool->stopping && pool->slots == 0) {
+            pthread_cond_wait(&pool->start, &pool->lock);
+        }
+        if (pool->stopping) {
+            break;
+        }
+
+        pool->slots--;
+        pool->running++;
+        worker_pool_run_func run = pool->run;
+        void *data = pool->data;
+        pthread_mutex_unlock(&pool->lock);
+
+        run(thread->state, data);
+
+        pthread_mutex_lock(&pool->lock);
+        pool->running--;
+        if (pool->running == 0) {
+            pthread_cond_signal(&pool->finished);
+        }
+    }
+    pthread_mutex_unlock(&pool->lock);
+
+    return NULL;
+}
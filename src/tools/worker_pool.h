@@ -0,0 +1,62 @@
+/*
+ * worker_pool.h
+ * vim: expandtab:ts=4:sts=4:sw=4
+ *
+ * Copyright (C) 2012 - 2019 James Booth <boothj5@gmail.com>
+ *
+ * This file is part of Profanity.
+ *
+ * Profanity is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Profanity is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Profanity.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link the code of portions of this program with the OpenSSL library under
+ * certain conditions as described in each individual source file, and
+ * distribute linked combinations including the two.
+ *
+ * You must obey the GNU General Public License in all respects for all of the
+ * code used other than OpenSSL. If you modify file(s) with this exception, you
+ * may extend this exception to your version of the file(s), but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version. If you delete this exception statement from all
+ * source files in the program, then also delete it here.
+ *
+ */
+
+#ifndef TOOLS_WORKER_POOL_H
+#define TOOLS_WORKER_POOL_H
+
+#include <glib.h>
+
+typedef void* (*worker_pool_init_func)(void *userdata);
+typedef void (*worker_pool_free_func)(void *state);
+typedef void (*worker_pool_run_func)(void *state, void *data);
+typedef struct worker_pool_t *WorkerPool;
+
+// start up to count threads that wait for work, each with the state returned
+// by init(userdata), threads whose init returns NULL are not started
+WorkerPool worker_pool_new(int count, worker_pool_init_func init, worker_pool_free_func free_state, void *userdata);
+
+// stop the threads and free their states
+void worker_pool_free(WorkerPool pool);
+
+// threads started
+int worker_pool_size(WorkerPool pool);
+
+// call run(state, data) on up to workers threads and run(caller_state, data)
+// on the calling thread, returning once every call has returned. Each call
+// should take work from data until none is left, work not taken by the time
+// the calling thread's call returns is not waited for
+void worker_pool_run(WorkerPool pool, int workers, worker_pool_run_func run, void *data, void *caller_state);
+
+#endif
@@ -39,49 +39,404 @@
 #include <string.h>
 #include <assert.h>
 #include <stdlib.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 #include <glib.h>
+#include <glib/gstdio.h>
 #ifdef HAVE_NCURSESW_NCURSES_H
 #include <ncursesw/ncurses.h>
 #elif HAVE_NCURSES_H
 #include <ncurses.h>
 #endif
 
+#include "common.h"
+#include "log.h"
+#include "config/files.h"
 #include "ui/window.h"
 #include "ui/buffer.h"
 
 #define BUFF_SIZE 1200
 
+// entries always kept in memory when trimming buffers to the memory budget
+#define BUFF_MIN_RESIDENT 100
+
+// rough per entry cost of the GDateTime and allocator overhead
+#define BUFF_ENTRY_OVERHEAD 64
+
+// entries kept in a scrollback file, the oldest half is dropped when reached
+#define BUFF_SPILL_MAX 50000
+
+// bytes copied at a time when compacting a scrollback file
+#define BUFF_SPILL_CHUNK 65536
+
+// Entries are kept in a fixed capacity ring, oldest entry at entries[head].
+// Each entry has a sequence number, base being the one at entries[head], and
+// ids maps message id -> queue of the sequence numbers carrying that id,
+// oldest first. Entries removed by id leave a NULL hole in their slot, holes
+// are closed up in one pass on the next access by position.
+// Entries evicted from the ring are appended to the spill file when spilling
+// is enabled, spill_offsets holds the file offset of each spilled entry.
+// origin counts entries dropped from before the oldest one, less those
+// prepended, so positions held by a window can be shifted to match.
 struct prof_buff_t {
-    GSList *entries;
+    ProfBuffEntry **entries;
+    int capacity;
+    int head;
+    int size;
+    int base;
+    int holes;
+    GHashTable *ids;
+    gsize bytes;
+    int spill_fd;
+    off_t spill_len;
+    char *spill_map;
+    size_t spill_mapped;
+    GArray *spill_offsets;
+    int origin;
 };
 
+// fixed size part of a spilled entry, followed by from, message and id
+// string lengths are -1 for NULL
+typedef struct spill_record_t {
+    gint64 time;
+    gint32 flags;
+    gint32 theme_item;
+    gint32 pad_indent;
+    gint32 from_len;
+    gint32 message_len;
+    gint32 id_len;
+    gint8 show_char;
+    gint8 receipt;
+} SpillRecord;
+
+static GList *buffers = NULL;
+static gsize resident_bytes = 0;
+static gsize memory_budget = 0;
+static gboolean spill_enabled = FALSE;
+
 static void _free_entry(ProfBuffEntry *entry);
+static gsize _entry_bytes(ProfBuffEntry *entry);
+static int _slot(ProfBuff buffer, int entry);
+static ProfBuffEntry* _create_entry(const char show_char, int pad_indent, GDateTime *time, int flags,
+    theme_item_t theme_item, const char *const from, const char *const message, DeliveryReceipt *receipt,
+    const char *const id);
+static void _account_added(ProfBuff buffer, ProfBuffEntry *entry);
+static void _index_add(ProfBuff buffer, ProfBuffEntry *entry, int seq);
+static void _index_remove(ProfBuff buffer, ProfBuffEntry *entry);
+static void _compact(ProfBuff buffer);
+static void _evict_oldest(ProfBuff buffer);
+static void _enforce_budget(void);
+static gboolean _spill_open(ProfBuff buffer);
+static void _spill_close(ProfBuff buffer);
+static void _spill_reset(ProfBuff buffer);
+static void _spill_write(ProfBuff buffer, ProfBuffEntry *entry);
+static void _spill_compact(ProfBuff buffer);
+static gboolean _write_all(int fd, const void *data, size_t len);
 
 ProfBuff
-buffer_create(void)
+buffer_create(int max_entries)
 {
     ProfBuff new_buff = malloc(sizeof(struct prof_buff_t));
-    new_buff->entries = NULL;
+    new_buff->capacity = max_entries > 0 ? max_entries : BUFF_SIZE;
+    new_buff->entries = calloc(new_buff->capacity, sizeof(ProfBuffEntry*));
+    new_buff->head = 0;
+    new_buff->size = 0;
+    new_buff->base = 0;
+    new_buff->holes = 0;
+    new_buff->ids = g_hash_table_new_full(g_str_hash, g_str_equal, free, (GDestroyNotify)g_queue_free);
+    new_buff->bytes = 0;
+    new_buff->spill_fd = -1;
+    new_buff->spill_len = 0;
+    new_buff->spill_map = NULL;
+    new_buff->spill_mapped = 0;
+    new_buff->spill_offsets = NULL;
+    new_buff->origin = 0;
+
+    buffers = g_list_prepend(buffers, new_buff);
+
     return new_buff;
 }
 
 int
 buffer_size(ProfBuff buffer)
 {
-    return g_slist_length(buffer->entries);
+    _compact(buffer);
+    return buffer->size;
 }
 
 void
 buffer_free(ProfBuff buffer)
 {
-    g_slist_free_full(buffer->entries, (GDestroyNotify)_free_entry);
+    int i;
+    for (i = 0; i < buffer->size; i++) {
+        ProfBuffEntry *entry = buffer->entries[_slot(buffer, i)];
+        if (entry) {
+            _free_entry(entry);
+        }
+    }
+    resident_bytes -= buffer->bytes;
+    buffers = g_list_remove(buffers, buffer);
+
+    _spill_close(buffer);
+    g_hash_table_destroy(buffer->ids);
+    free(buffer->entries);
     free(buffer);
 }
 
+void
+buffer_set_memory_budget(gsize bytes)
+{
+    memory_budget = bytes;
+    _enforce_budget();
+}
+
+void
+buffer_set_spill(gboolean spill)
+{
+    spill_enabled = spill;
+}
+
 void
 buffer_append(ProfBuff buffer, const char show_char, int pad_indent, GDateTime *time,
     int flags, theme_item_t theme_item, const char *const from, const char *const message, DeliveryReceipt *receipt, const char *const id)
+{
+    ProfBuffEntry *e = _create_entry(show_char, pad_indent, time, flags, theme_item, from, message, receipt, id);
+
+    _compact(buffer);
+    if (buffer->size == buffer->capacity) {
+        _evict_oldest(buffer);
+    }
+
+    buffer->entries[_slot(buffer, buffer->size)] = e;
+    _index_add(buffer, e, buffer->base + buffer->size);
+    buffer->size++;
+
+    _account_added(buffer, e);
+}
+
+gboolean
+buffer_prepend(ProfBuff buffer, const char show_char, int pad_indent, GDateTime *time,
+    int flags, theme_item_t theme_item, const char *const from, const char *const message)
+{
+    // older entries never push out newer ones
+    _compact(buffer);
+    if (buffer->size == buffer->capacity) {
+        return FALSE;
+    }
+
+    ProfBuffEntry *e = _create_entry(show_char, pad_indent, time, flags, theme_item, from, message, NULL, NULL);
+
+    buffer->head = (buffer->head + buffer->capacity - 1) % buffer->capacity;
+    buffer->entries[buffer->head] = e;
+    buffer->size++;
+    buffer->base--;
+    buffer->origin--;
+
+    _account_added(buffer, e);
+
+    return TRUE;
+}
+
+void
+buffer_remove_entry_by_id(ProfBuff buffer, const char *const id)
+{
+    if (!id) {
+        return;
+    }
+
+    gpointer key;
+    gpointer value;
+    if (!g_hash_table_lookup_extended(buffer->ids, id, &key, &value)) {
+        return;
+    }
+
+    // id may belong to one of the entries freed below
+    g_hash_table_steal(buffer->ids, id);
+
+    GQueue *seqs = value;
+    while (!g_queue_is_empty(seqs)) {
+        int seq = GPOINTER_TO_INT(g_queue_pop_head(seqs));
+        int slot = _slot(buffer, seq - buffer->base);
+        ProfBuffEntry *removed = buffer->entries[slot];
+        buffer->entries[slot] = NULL;
+        buffer->holes++;
+
+        gsize bytes = _entry_bytes(removed);
+        buffer->bytes -= bytes;
+        resident_bytes -= bytes;
+        _free_entry(removed);
+    }
+
+    g_queue_free(seqs);
+    free(key);
+}
+
+gboolean
+buffer_mark_received(ProfBuff buffer, const char *const id)
+{
+    ProfBuffEntry *entry = buffer_get_entry_by_id(buffer, id);
+    if (entry && entry->receipt && !entry->receipt->received) {
+        entry->receipt->received = TRUE;
+        return TRUE;
+    }
+
+    return FALSE;
+}
+
+ProfBuffEntry*
+buffer_get_entry(ProfBuff buffer, int entry)
+{
+    _compact(buffer);
+    if (entry < 0 || entry >= buffer->size) {
+        return NULL;
+    }
+
+    return buffer->entries[_slot(buffer, entry)];
+}
+
+ProfBuffEntry*
+buffer_get_entry_by_id(ProfBuff buffer, const char *const id)
+{
+    if (!id) {
+        return NULL;
+    }
+
+    GQueue *seqs = g_hash_table_lookup(buffer->ids, id);
+    if (!seqs) {
+        return NULL;
+    }
+
+    int seq = GPOINTER_TO_INT(g_queue_peek_head(seqs));
+    return buffer->entries[_slot(buffer, seq - buffer->base)];
+}
+
+gboolean
+buffer_update_entry_message(ProfBuff buffer, const char *const id, const char *const message)
+{
+    ProfBuffEntry *entry = buffer_get_entry_by_id(buffer, id);
+    if (!entry) {
+        return FALSE;
+    }
+
+    gsize old_bytes = _entry_bytes(entry);
+    free(entry->message);
+    entry->message = strdup(message);
+    free(entry->layout);
+    entry->layout = NULL;
+    entry->layout_bytes = 0;
+    gsize new_bytes = _entry_bytes(entry);
+
+    buffer->bytes = buffer->bytes - old_bytes + new_bytes;
+    resident_bytes = resident_bytes - old_bytes + new_bytes;
+
+    return TRUE;
+}
+
+void
+buffer_set_layout_bytes(ProfBuff buffer, ProfBuffEntry *entry, gsize bytes)
+{
+    buffer->bytes = buffer->bytes - entry->layout_bytes + bytes;
+    resident_bytes = resident_bytes - entry->layout_bytes + bytes;
+    entry->layout_bytes = bytes;
+}
+
+int
+buffer_origin(ProfBuff buffer)
+{
+    return buffer->origin;
+}
+
+int
+buffer_spilled_size(ProfBuff buffer)
+{
+    if (!buffer->spill_offsets) {
+        return 0;
+    }
+
+    return buffer->spill_offsets->len;
+}
+
+ProfBuffEntry*
+buffer_get_spilled_entry(ProfBuff buffer, int entry)
+{
+    if (entry < 0 || entry >= buffer_spilled_size(buffer)) {
+        return NULL;
+    }
+
+    // the file only grows, remap when entries were appended since the last read
+    if (buffer->spill_mapped < (size_t)buffer->spill_len) {
+        if (buffer->spill_map) {
+            munmap(buffer->spill_map, buffer->spill_mapped);
+            buffer->spill_map = NULL;
+            buffer->spill_mapped = 0;
+        }
+        void *map = mmap(NULL, buffer->spill_len, PROT_READ, MAP_SHARED, buffer->spill_fd, 0);
+        if (map == MAP_FAILED) {
+            log_error("Could not map scrollback file: %s", strerror(errno));
+            return NULL;
+        }
+        buffer->spill_map = map;
+        buffer->spill_mapped = buffer->spill_len;
+    }
+
+    off_t offset = g_array_index(buffer->spill_offsets, off_t, entry);
+    const char *pos = buffer->spill_map + offset;
+
+    SpillRecord record;
+    memcpy(&record, pos, sizeof(SpillRecord));
+    pos += sizeof(SpillRecord);
+
+    ProfBuffEntry *e = malloc(sizeof(struct prof_buff_entry_t));
+    e->show_char = record.show_char;
+    e->pad_indent = record.pad_indent;
+    e->flags = record.flags;
+    e->theme_item = record.theme_item;
+    e->time = g_date_time_new_from_unix_local(record.time);
+
+    e->from = NULL;
+    if (record.from_len >= 0) {
+        e->from = strndup(pos, record.from_len);
+        pos += record.from_len;
+    }
+    e->message = strndup(pos, record.message_len);
+    pos += record.message_len;
+    e->id = NULL;
+    if (record.id_len >= 0) {
+        e->id = strndup(pos, record.id_len);
+    }
+
+    e->receipt = NULL;
+    e->layout = NULL;
+    e->layout_bytes = 0;
+    if (record.receipt >= 0) {
+        e->receipt = malloc(sizeof(struct delivery_receipt_t));
+        e->receipt->received = record.receipt;
+    }
+
+    return e;
+}
+
+void
+buffer_free_spilled_entry(ProfBuffEntry *entry)
+{
+    if (entry) {
+        _free_entry(entry);
+    }
+}
+
+static int
+_slot(ProfBuff buffer, int entry)
+{
+    return (buffer->head + entry) % buffer->capacity;
+}
+
+static ProfBuffEntry*
+_create_entry(const char show_char, int pad_indent, GDateTime *time, int flags, theme_item_t theme_item,
+    const char *const from, const char *const message, DeliveryReceipt *receipt, const char *const id)
 {
     ProfBuffEntry *e = malloc(sizeof(struct prof_buff_entry_t));
     e->show_char = show_char;
@@ -92,71 +447,332 @@ buffer_append(ProfBuff buffer, const char show_char, int pad_indent, GDateTime *
     e->from = from ? strdup(from) : NULL;
     e->message = strdup(message);
     e->receipt = receipt;
+    e->layout = NULL;
+    e->layout_bytes = 0;
     if (id) {
         e->id = strdup(id);
     } else {
         e->id = NULL;
     }
 
-    if (g_slist_length(buffer->entries) == BUFF_SIZE) {
-        _free_entry(buffer->entries->data);
-        buffer->entries = g_slist_delete_link(buffer->entries, buffer->entries);
+    return e;
+}
+
+static void
+_account_added(ProfBuff buffer, ProfBuffEntry *entry)
+{
+    gsize bytes = _entry_bytes(entry);
+    buffer->bytes += bytes;
+    resident_bytes += bytes;
+
+    if (memory_budget > 0 && resident_bytes > memory_budget) {
+        _enforce_budget();
+    }
+}
+
+static gsize
+_entry_bytes(ProfBuffEntry *entry)
+{
+    gsize bytes = sizeof(struct prof_buff_entry_t) + BUFF_ENTRY_OVERHEAD;
+    bytes += strlen(entry->message) + 1;
+    if (entry->from) {
+        bytes += strlen(entry->from) + 1;
     }
+    if (entry->id) {
+        bytes += strlen(entry->id) + 1;
+    }
+    if (entry->receipt) {
+        bytes += sizeof(struct delivery_receipt_t);
+    }
+    bytes += entry->layout_bytes;
 
-    buffer->entries = g_slist_append(buffer->entries, e);
+    return bytes;
 }
 
-void
-buffer_remove_entry_by_id(ProfBuff buffer, const char *const id)
+static void
+_index_add(ProfBuff buffer, ProfBuffEntry *entry, int seq)
+{
+    if (!entry->id) {
+        return;
+    }
+
+    GQueue *seqs = g_hash_table_lookup(buffer->ids, entry->id);
+    if (!seqs) {
+        seqs = g_queue_new();
+        g_hash_table_insert(buffer->ids, strdup(entry->id), seqs);
+    }
+    g_queue_push_tail(seqs, GINT_TO_POINTER(seq));
+}
+
+// entries leave the ring oldest first, so the entry is the head of its queue
+static void
+_index_remove(ProfBuff buffer, ProfBuffEntry *entry)
+{
+    if (!entry->id) {
+        return;
+    }
+
+    GQueue *seqs = g_hash_table_lookup(buffer->ids, entry->id);
+    g_queue_pop_head(seqs);
+    if (g_queue_is_empty(seqs)) {
+        g_hash_table_remove(buffer->ids, entry->id);
+    }
+}
+
+// close up the holes left by removals, renumbering the index to match
+static void
+_compact(ProfBuff buffer)
+{
+    if (buffer->holes == 0) {
+        return;
+    }
+
+    g_hash_table_remove_all(buffer->ids);
+
+    int live = 0;
+    int i;
+    for (i = 0; i < buffer->size; i++) {
+        ProfBuffEntry *entry = buffer->entries[_slot(buffer, i)];
+        if (entry) {
+            buffer->entries[_slot(buffer, live)] = entry;
+            _index_add(buffer, entry, buffer->base + live);
+            live++;
+        }
+    }
+    for (i = live; i < buffer->size; i++) {
+        buffer->entries[_slot(buffer, i)] = NULL;
+    }
+
+    buffer->size = live;
+    buffer->holes = 0;
+}
+
+static void
+_evict_oldest(ProfBuff buffer)
 {
-    GSList *entries = buffer->entries;
-    while (entries) {
-        ProfBuffEntry *entry = entries->data;
-        if (entry->id && (g_strcmp0(entry->id, id) == 0)) {
-            buffer->entries = g_slist_delete_link(buffer->entries, entries);
+    _compact(buffer);
+
+    ProfBuffEntry *oldest = buffer->entries[buffer->head];
+    buffer->entries[buffer->head] = NULL;
+    buffer->head = (buffer->head + 1) % buffer->capacity;
+    buffer->size--;
+    buffer->base++;
+
+    gsize bytes = _entry_bytes(oldest);
+    buffer->bytes -= bytes;
+    resident_bytes -= bytes;
+
+    _index_remove(buffer, oldest);
+    if (spill_enabled) {
+        _spill_write(buffer, oldest);
+    } else {
+        if (buffer->spill_fd != -1) {
+            // the file would no longer run up to the buffer, drop it
+            _spill_reset(buffer);
         }
-        entries = g_slist_next(entries);
+        buffer->origin++;
     }
+    _free_entry(oldest);
 }
 
-gboolean
-buffer_mark_received(ProfBuff buffer, const char *const id)
+// trim the buffer holding the most memory until the total is within budget,
+// evicting in chunks so the search over all buffers is amortised
+static void
+_enforce_budget(void)
 {
-    GSList *entries = buffer->entries;
-    while (entries) {
-        ProfBuffEntry *entry = entries->data;
-        if (entry->receipt && g_strcmp0(entry->id, id) == 0) {
-            if (!entry->receipt->received) {
-                entry->receipt->received = TRUE;
-                return TRUE;
+    while (memory_budget > 0 && resident_bytes > memory_budget) {
+        ProfBuff largest = NULL;
+        GList *curr = buffers;
+        while (curr) {
+            ProfBuff buffer = curr->data;
+            _compact(buffer);
+            if (buffer->size > BUFF_MIN_RESIDENT && (!largest || buffer->bytes > largest->bytes)) {
+                largest = buffer;
             }
+            curr = g_list_next(curr);
+        }
+
+        if (!largest) {
+            return;
+        }
+
+        int chunk = MAX(1, (largest->size - BUFF_MIN_RESIDENT) / 8);
+        while (chunk-- > 0 && resident_bytes > memory_budget) {
+            _evict_oldest(largest);
         }
-        entries = g_slist_next(entries);
     }
+}
 
-    return FALSE;
+static gboolean
+_spill_open(ProfBuff buffer)
+{
+    char *dir = files_get_data_path(DIR_SCROLLBACK);
+    if (!mkdir_recursive(dir)) {
+        log_error("Error while creating directory %s", dir);
+        free(dir);
+        return FALSE;
+    }
+
+    char *template = g_strdup_printf("%s/scrollback-XXXXXX", dir);
+    free(dir);
+
+    int fd = g_mkstemp_full(template, O_RDWR, S_IRUSR | S_IWUSR);
+    if (fd == -1) {
+        log_error("Could not create scrollback file %s: %s", template, strerror(errno));
+        g_free(template);
+        return FALSE;
+    }
+
+    // only reachable through the descriptor, the kernel reclaims it on close or crash
+    g_unlink(template);
+    g_free(template);
+
+    buffer->spill_fd = fd;
+    buffer->spill_len = 0;
+    buffer->spill_offsets = g_array_new(FALSE, FALSE, sizeof(off_t));
+
+    return TRUE;
 }
 
-ProfBuffEntry*
-buffer_get_entry(ProfBuff buffer, int entry)
+static void
+_spill_close(ProfBuff buffer)
 {
-    GSList *node = g_slist_nth(buffer->entries, entry);
-    return node->data;
+    if (buffer->spill_map) {
+        munmap(buffer->spill_map, buffer->spill_mapped);
+    }
+    if (buffer->spill_fd != -1) {
+        close(buffer->spill_fd);
+    }
+    if (buffer->spill_offsets) {
+        g_array_free(buffer->spill_offsets, TRUE);
+    }
 }
 
-ProfBuffEntry*
-buffer_get_entry_by_id(ProfBuff buffer, const char *const id)
+static void
+_spill_reset(ProfBuff buffer)
+{
+    buffer->origin += buffer_spilled_size(buffer);
+    _spill_close(buffer);
+    buffer->spill_fd = -1;
+    buffer->spill_len = 0;
+    buffer->spill_map = NULL;
+    buffer->spill_mapped = 0;
+    buffer->spill_offsets = NULL;
+}
+
+static void
+_spill_write(ProfBuff buffer, ProfBuffEntry *entry)
+{
+    if (buffer->spill_fd == -1 && !_spill_open(buffer)) {
+        return;
+    }
+
+    SpillRecord record;
+    memset(&record, 0, sizeof(SpillRecord));
+    record.time = g_date_time_to_unix(entry->time);
+    record.flags = entry->flags;
+    record.theme_item = entry->theme_item;
+    record.pad_indent = entry->pad_indent;
+    record.from_len = entry->from ? strlen(entry->from) : -1;
+    record.message_len = strlen(entry->message);
+    record.id_len = entry->id ? strlen(entry->id) : -1;
+    record.show_char = entry->show_char;
+    record.receipt = entry->receipt ? entry->receipt->received : -1;
+
+    GString *data = g_string_sized_new(sizeof(SpillRecord) + record.message_len + 64);
+    g_string_append_len(data, (const gchar*)&record, sizeof(SpillRecord));
+    if (entry->from) {
+        g_string_append_len(data, entry->from, record.from_len);
+    }
+    g_string_append_len(data, entry->message, record.message_len);
+    if (entry->id) {
+        g_string_append_len(data, entry->id, record.id_len);
+    }
+
+    if (_write_all(buffer->spill_fd, data->str, data->len)) {
+        off_t offset = buffer->spill_len;
+        g_array_append_val(buffer->spill_offsets, offset);
+        buffer->spill_len += data->len;
+    } else {
+        log_error("Could not write scrollback file: %s", strerror(errno));
+        // drop back to the last complete record
+        if (ftruncate(buffer->spill_fd, buffer->spill_len) == -1) {
+            log_error("Could not truncate scrollback file: %s", strerror(errno));
+        }
+        lseek(buffer->spill_fd, buffer->spill_len, SEEK_SET);
+    }
+
+    g_string_free(data, TRUE);
+
+    if (buffer->spill_offsets->len >= BUFF_SPILL_MAX) {
+        _spill_compact(buffer);
+    }
+}
+
+// move the newest half of the scrollback file's records to its start
+static void
+_spill_compact(ProfBuff buffer)
 {
-    GSList *entries = buffer->entries;
-    while (entries) {
-        ProfBuffEntry *entry = entries->data;
-        if (g_strcmp0(entry->id, id) == 0) {
-            return entry;
+    int drop = buffer->spill_offsets->len / 2;
+    off_t base = g_array_index(buffer->spill_offsets, off_t, drop);
+    off_t keep = buffer->spill_len - base;
+
+    // records only move towards the start, so copying forwards is safe
+    char *chunk = malloc(BUFF_SPILL_CHUNK);
+    off_t copied = 0;
+    while (copied < keep) {
+        ssize_t n = pread(buffer->spill_fd, chunk, MIN(BUFF_SPILL_CHUNK, keep - copied), base + copied);
+        if (n == -1 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0 || lseek(buffer->spill_fd, copied, SEEK_SET) == -1 || !_write_all(buffer->spill_fd, chunk, n)) {
+            log_error("Could not compact scrollback file: %s", strerror(errno));
+            free(chunk);
+            _spill_reset(buffer);
+            return;
+        }
+        copied += n;
+    }
+    free(chunk);
+
+    if (ftruncate(buffer->spill_fd, keep) == -1) {
+        log_error("Could not truncate scrollback file: %s", strerror(errno));
+    }
+    lseek(buffer->spill_fd, keep, SEEK_SET);
+
+    // the mapping is longer than the file now, map again on the next read
+    if (buffer->spill_map) {
+        munmap(buffer->spill_map, buffer->spill_mapped);
+        buffer->spill_map = NULL;
+        buffer->spill_mapped = 0;
+    }
+
+    g_array_remove_range(buffer->spill_offsets, 0, drop);
+    guint i;
+    for (i = 0; i < buffer->spill_offsets->len; i++) {
+        g_array_index(buffer->spill_offsets, off_t, i) -= base;
+    }
+    buffer->spill_len = keep;
+    buffer->origin += drop;
+}
+
+static gboolean
+_write_all(int fd, const void *data, size_t len)
+{
+    const char *pos = data;
+    while (len > 0) {
+        ssize_t written = write(fd, pos, len);
+        if (written == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return FALSE;
         }
-        entries = g_slist_next(entries);
+        pos += written;
+        len -= written;
     }
 
-    return NULL;
+    return TRUE;
 }
 
 static void
@@ -166,6 +782,7 @@ _free_entry(ProfBuffEntry *entry)
     free(entry->from);
     free(entry->id);
     free(entry->receipt);
+    free(entry->layout);
     g_date_time_unref(entry->time);
     free(entry);
 }
@@ -45,6 +45,9 @@ typedef struct delivery_receipt_t {
     gboolean received;
 } DeliveryReceipt;
 
+// how the message wraps at one window width, built and read by window.c
+typedef struct prof_buff_layout_t ProfBuffLayout;
+
 typedef struct prof_buff_entry_t {
     char show_char;
     int pad_indent;
@@ -56,18 +59,38 @@ typedef struct prof_buff_entry_t {
     DeliveryReceipt *receipt;
     // message id, in case we have it
     char *id;
+    // cached wrapping of message, a single allocation of layout_bytes
+    ProfBuffLayout *layout;
+    gsize layout_bytes;
 } ProfBuffEntry;
 
 typedef struct prof_buff_t *ProfBuff;
 
-ProfBuff buffer_create();
+ProfBuff buffer_create(int max_entries);
 void buffer_free(ProfBuff buffer);
+void buffer_set_memory_budget(gsize bytes);
+void buffer_set_spill(gboolean spill);
 void buffer_append(ProfBuff buffer, const char show_char, int pad_indent, GDateTime *time,
     int flags, theme_item_t theme_item, const char *const from, const char *const message, DeliveryReceipt *receipt, const char *const id);
+// add an older entry before the first one, fails when the buffer is full
+gboolean buffer_prepend(ProfBuff buffer, const char show_char, int pad_indent, GDateTime *time,
+    int flags, theme_item_t theme_item, const char *const from, const char *const message);
 void buffer_remove_entry_by_id(ProfBuff buffer, const char *const id);
 int buffer_size(ProfBuff buffer);
 ProfBuffEntry* buffer_get_entry(ProfBuff buffer, int entry);
 ProfBuffEntry* buffer_get_entry_by_id(ProfBuff buffer, const char *const id);
 gboolean buffer_mark_received(ProfBuff buffer, const char *const id);
+gboolean buffer_update_entry_message(ProfBuff buffer, const char *const id, const char *const message);
+// count a newly cached layout of a buffer entry against the memory budget
+void buffer_set_layout_bytes(ProfBuff buffer, ProfBuffEntry *entry, gsize bytes);
+
+// entries evicted to the scrollback file, oldest first
+// spilled entries are decoded on demand and must be freed by the caller
+int buffer_spilled_size(ProfBuff buffer);
+// entries dropped from the front of the scrollback file or the buffer since
+// creation, less those prepended
+int buffer_origin(ProfBuff buffer);
+ProfBuffEntry* buffer_get_spilled_entry(ProfBuff buffer, int entry);
+void buffer_free_spilled_entry(ProfBuffEntry *entry);
 
 #endif
@@ -55,6 +55,9 @@
 #include "omemo/omemo.h"
 #endif
 
+// messages read from the chat log when a window is opened
+#define CHATWIN_HISTORY_SIZE 100
+
 static void _chatwin_history(ProfChatWin *chatwin, const char *const contact);
 
 ProfChatWin*
@@ -466,33 +469,19 @@ _chatwin_history(ProfChatWin *chatwin, const char *const contact)
 {
     if (!chatwin->history_shown) {
         Jid *jid = jid_create(connection_get_fulljid());
-        GSList *history = chat_log_get_previous(jid->barejid, contact);
+        chatwin->history = chat_log_history_new(jid->barejid, contact);
         jid_destroy(jid);
-        GSList *curr = history;
-        int idd = 0;
-        int imo = 0;
-        int iyy = 0;
 
+        // only the most recent messages, older ones are loaded when paging up
+        GSList *history = chat_log_history_previous(chatwin->history, CHATWIN_HISTORY_SIZE);
+        GSList *curr = history;
         while (curr) {
-            char *line = curr->data;
-            // entry, containing the actual entries with date followed by text
-            if (line[2] == ':') {
-                char hh[3]; memcpy(hh, &line[0], 2); hh[2] = '\0'; int ihh = atoi(hh);
-                char mm[3]; memcpy(mm, &line[3], 2); mm[2] = '\0'; int imm = atoi(mm);
-                char ss[3]; memcpy(ss, &line[6], 2); ss[2] = '\0'; int iss = atoi(ss);
-                GDateTime *timestamp = g_date_time_new_local(iyy, imo, idd, ihh, imm, iss);
-                win_print_history((ProfWin*)chatwin, timestamp, "%s", curr->data+11);
-                g_date_time_unref(timestamp);
-            // header, containing the date from filename "21/10/2019:"
-            } else {
-                char dd[3]; memcpy(dd, &line[0], 2); dd[2] = '\0'; idd = atoi(dd);
-                char mm[3]; memcpy(mm, &line[3], 2); mm[2] = '\0'; imo = atoi(mm);
-                char yy[5]; memcpy(yy, &line[6], 4); yy[4] = '\0'; iyy = atoi(yy);
-            }
+            ProfHistoryEntry *entry = curr->data;
+            win_print_history((ProfWin*)chatwin, entry->timestamp, "%s", entry->message);
             curr = g_slist_next(curr);
         }
         chatwin->history_shown = TRUE;
 
-        g_slist_free_full(history, free);
+        chat_log_history_free_entries(history);
     }
 }
@@ -1569,6 +1569,7 @@ cons_show_ui_prefs(void)
     cons_wintitle_setting();
     cons_presence_setting();
     cons_inpblock_setting();
+    cons_scrollback_setting();
     cons_titlebar_setting();
     cons_statusbar_setting();
 
@@ -1774,6 +1775,31 @@ cons_inpblock_setting(void)
     }
 }
 
+void
+cons_scrollback_setting(void)
+{
+    cons_show("Console scrollback (/scrollback)    : %d entries", prefs_get_scrollback("console"));
+    cons_show("Chat scrollback (/scrollback)       : %d entries", prefs_get_scrollback("chat"));
+    cons_show("Room scrollback (/scrollback)       : %d entries", prefs_get_scrollback("muc"));
+    cons_show("Private scrollback (/scrollback)    : %d entries", prefs_get_scrollback("private"));
+    cons_show("XML scrollback (/scrollback)        : %d entries", prefs_get_scrollback("xmlconsole"));
+    cons_show("Config scrollback (/scrollback)     : %d entries", prefs_get_scrollback("config"));
+    cons_show("Plugin scrollback (/scrollback)     : %d entries", prefs_get_scrollback("plugin"));
+
+    gint memory = prefs_get_scrollback_memory();
+    if (memory == 0) {
+        cons_show("Scrollback memory (/scrollback)     : unlimited");
+    } else {
+        cons_show("Scrollback memory (/scrollback)     : %d kilobytes", memory);
+    }
+
+    if (prefs_get_boolean(PREF_SCROLLBACK_SPILL)) {
+        cons_show("Scrollback spill (/scrollback)      : ON");
+    } else {
+        cons_show("Scrollback spill (/scrollback)      : OFF");
+    }
+}
+
 void
 cons_statusbar_setting(void)
 {
@@ -1854,6 +1880,13 @@ cons_logging_setting(void)
         cons_show("Groupchat logging (/logging group)  : ON");
     else
         cons_show("Groupchat logging (/logging group)  : OFF");
+
+    char *sync = prefs_get_string(PREF_LOG_SYNC);
+    cons_show("Log sync (/logging sync)            : %s", sync);
+    prefs_free_string(sync);
+
+    cons_show("Log writer queue                    : %u queued, %u peak, %u dropped",
+        chat_log_queue_depth(), chat_log_queue_peak(), chat_log_dropped());
 }
 
 void
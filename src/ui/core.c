@@ -100,6 +100,7 @@ ui_init(void)
     cbreak();
     noecho();
     keypad(stdscr, TRUE);
+    ui_scrollback_update();
     ui_load_colours();
     refresh();
     create_title_bar();
@@ -118,6 +119,13 @@ ui_init(void)
     win_update_virtual(window);
 }
 
+void
+ui_scrollback_update(void)
+{
+    buffer_set_spill(prefs_get_boolean(PREF_SCROLLBACK_SPILL));
+    buffer_set_memory_budget((gsize)prefs_get_scrollback_memory() * 1024);
+}
+
 void
 ui_sigwinch_handler(int sig)
 {
@@ -132,14 +140,23 @@ ui_update(void)
         win_move_to_end(current);
     }
 
-    win_update_virtual(current);
+    rosterwin_update();
+
+    // only refresh what changed since the last update, the title bar
+    // reflects the current window so follows its damage
+    gboolean damaged = win_update_damaged(current);
+    if (damaged) {
+        title_bar_damage();
+    }
 
     if (prefs_get_boolean(PREF_WINTITLE_SHOW)) {
         _ui_draw_term_title();
     }
-    title_bar_update_virtual();
-    status_bar_draw();
-    inp_put_back();
+    damaged = title_bar_update_virtual() || damaged;
+    damaged = status_bar_update_virtual() || damaged;
+    if (damaged) {
+        inp_put_back();
+    }
     doupdate();
 
     if (perform_resize) {
@@ -150,6 +167,15 @@ ui_update(void)
     }
 }
 
+void
+ui_damage_all(void)
+{
+    win_damage_virtual();
+    title_bar_damage();
+    status_bar_damage();
+    rosterwin_roster();
+}
+
 unsigned long
 ui_get_idle_time(void)
 {
@@ -202,6 +228,7 @@ ui_resize(void)
     wins_resize_all();
     status_bar_resize();
     inp_win_resize();
+    rosterwin_update();
     ProfWin *window = wins_get_current();
     win_update_virtual(window);
 }
@@ -228,6 +255,9 @@ ui_load_colours(void)
 void
 ui_contact_online(char *barejid, Resource *resource, GDateTime *last_activity)
 {
+    // the title bar shows the presence of the current chat contact
+    title_bar_damage();
+
     char *show_console = prefs_get_string(PREF_STATUSES_CONSOLE);
     char *show_chat_win = prefs_get_string(PREF_STATUSES_CHAT);
     PContact contact = roster_get_contact(barejid);
@@ -442,6 +472,17 @@ ui_handle_otr_error(const char *const barejid, const char *const message)
     }
 }
 
+void
+ui_handle_pgp_error(const char *const barejid, const char *const message)
+{
+    ProfChatWin *chatwin = wins_get_chat(barejid);
+    if (chatwin) {
+        win_println((ProfWin*)chatwin, THEME_ERROR, '!', "%s", message);
+    } else {
+        cons_show_error("%s - %s", barejid, message);
+    }
+}
+
 void
 ui_handle_error(const char *const err_msg)
 {
@@ -1033,6 +1074,8 @@ ui_ask_pgp_passphrase(const char *hint, int prev_fail)
 void
 ui_contact_offline(char *barejid, char *resource, char *status)
 {
+    title_bar_damage();
+
     char *show_console = prefs_get_string(PREF_STATUSES_CONSOLE);
     char *show_chat_win = prefs_get_string(PREF_STATUSES_CHAT);
     Jid *jid = jid_create_from_bare_and_resource(barejid, resource);
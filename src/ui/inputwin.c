@@ -155,17 +155,29 @@ create_input_window(void)
 }
 
 char*
-inp_readline(void)
+inp_readline(gint timeout, int xmpp_fd, int log_fd)
 {
     free(inp_line);
     inp_line = NULL;
-    p_rl_timeout.tv_sec = inp_timeout / 1000;
-    p_rl_timeout.tv_usec = inp_timeout % 1000 * 1000;
+    struct timeval *p_timeout = NULL;
+    if (timeout >= 0) {
+        p_rl_timeout.tv_sec = timeout / 1000;
+        p_rl_timeout.tv_usec = timeout % 1000 * 1000;
+        p_timeout = &p_rl_timeout;
+    }
+    int in_fd = fileno(rl_instream);
     FD_ZERO(&fds);
-    FD_SET(fileno(rl_instream), &fds);
+    FD_SET(in_fd, &fds);
+    if (xmpp_fd >= 0) {
+        FD_SET(xmpp_fd, &fds);
+    }
+    // wake up to log anything written to stderr
+    if (log_fd >= 0) {
+        FD_SET(log_fd, &fds);
+    }
     errno = 0;
     pthread_mutex_unlock(&lock);
-    r = select(FD_SETSIZE, &fds, NULL, NULL, &p_rl_timeout);
+    r = select(MAX(in_fd, MAX(xmpp_fd, log_fd)) + 1, &fds, NULL, NULL, p_timeout);
     pthread_mutex_lock(&lock);
     if (r < 0) {
         if (errno != EINTR) {
@@ -220,6 +232,12 @@ inp_win_resize(void)
     _inp_win_update_virtual();
 }
 
+gint
+inp_get_timeout(void)
+{
+    return inp_timeout;
+}
+
 void
 inp_nonblocking(gboolean reset)
 {
@@ -262,7 +280,7 @@ inp_get_line(void)
     doupdate();
     char *line = NULL;
     while (!line) {
-        line = inp_readline();
+        line = inp_readline(-1, -1, -1);
         ui_update();
     }
     status_bar_clear_prompt();
@@ -279,7 +297,7 @@ inp_get_password(void)
     char *password = NULL;
     get_password = TRUE;
     while (!password) {
-        password = inp_readline();
+        password = inp_readline(-1, -1, -1);
         ui_update();
     }
     get_password = FALSE;
@@ -35,27 +35,53 @@
  */
 
 #include <assert.h>
+#include <stdlib.h>
 
 #include "config/preferences.h"
 #include "ui/ui.h"
 #include "ui/window.h"
 #include "ui/window_list.h"
 
+typedef struct occupants_row_t {
+    int attrs;
+    gboolean newline;
+    gboolean wrap;
+    int indent;
+    char *text;
+} OccupantsRow;
+
+typedef struct occupants_row_pos_t {
+    int y;
+    int x;
+} OccupantsRowPos;
+
+// what was last drawn to the panel, so that an update only redraws from the
+// first row that changed
+typedef struct occupants_cache_t {
+    WINDOW *subwin;
+    int cols;
+    GPtrArray *rows;
+    GArray *positions;
+} OccupantsCache;
+
+static void _occupantswin_row_add(GPtrArray *rows, int attrs, gboolean newline, gboolean wrap, int indent, char *text);
+static void _occupantswin_row_free(OccupantsRow *row);
+static gboolean _occupantswin_row_equal(OccupantsRow *a, OccupantsRow *b);
+static void _occupantswin_header(GPtrArray *rows, const char *const prefix, const char *const title);
+static void _occuptantswin_occupant(GPtrArray *rows, Occupant *occupant, gboolean showjid);
+static void _occupantswin_draw(ProfMucWin *mucwin, ProfLayoutSplit *layout, GPtrArray *rows);
+
 static void
-_occuptantswin_occupant(ProfLayoutSplit *layout, Occupant *occupant, gboolean showjid)
+_occuptantswin_occupant(GPtrArray *rows, Occupant *occupant, gboolean showjid)
 {
     int colour;
-    theme_item_t presence_colour = THEME_ROSTER_ONLINE; //init to workaround compiler warning
 
     if (prefs_get_boolean(PREF_OCCUPANTS_COLOR_NICK)) {
         colour = theme_hash_attrs(occupant->nick);
-
-        wattron(layout->subwin, colour);
     } else {
         const char *presence_str = string_from_resource_presence(occupant->presence);
-        presence_colour = theme_main_presence_attrs(presence_str);
-
-        wattron(layout->subwin, theme_attrs(presence_colour));
+        theme_item_t presence_colour = theme_main_presence_attrs(presence_str);
+        colour = theme_attrs(presence_colour);
     }
 
     GString *spaces = g_string_new(" ");
@@ -80,27 +106,17 @@ _occuptantswin_occupant(ProfLayoutSplit *layout, Occupant *occupant, gboolean sh
     gboolean wrap = prefs_get_boolean(PREF_OCCUPANTS_WRAP);
 
     g_string_append(msg, occupant->nick);
-    win_sub_newline_lazy(layout->subwin);
-    win_sub_print(layout->subwin, msg->str, FALSE, wrap, current_indent);
-    g_string_free(msg, TRUE);
+    _occupantswin_row_add(rows, colour, FALSE, wrap, current_indent, g_string_free(msg, FALSE));
 
     if (showjid && occupant->jid) {
         GString *msg = g_string_new(spaces->str);
         g_string_append(msg, " ");
 
         g_string_append(msg, occupant->jid);
-        win_sub_newline_lazy(layout->subwin);
-        win_sub_print(layout->subwin, msg->str, FALSE, wrap, current_indent);
-        g_string_free(msg, TRUE);
+        _occupantswin_row_add(rows, colour, FALSE, wrap, current_indent, g_string_free(msg, FALSE));
     }
 
     g_string_free(spaces, TRUE);
-
-    if (prefs_get_boolean(PREF_OCCUPANTS_COLOR_NICK)) {
-        wattroff(layout->subwin, colour);
-    } else {
-        wattroff(layout->subwin, theme_attrs(presence_colour));
-    }
 }
 
 void
@@ -108,12 +124,12 @@ occupantswin_occupants(const char *const roomjid)
 {
     ProfMucWin *mucwin = wins_get_muc(roomjid);
     if (mucwin) {
-        GList *occupants = muc_roster(roomjid);
-        if (occupants) {
-            ProfLayoutSplit *layout = (ProfLayoutSplit*)mucwin->window.layout;
-            assert(layout->memcheck == LAYOUT_SPLIT_MEMCHECK);
+        ProfLayoutSplit *layout = (ProfLayoutSplit*)mucwin->window.layout;
+        assert(layout->memcheck == LAYOUT_SPLIT_MEMCHECK);
 
-            werase(layout->subwin);
+        GList *occupants = muc_roster(roomjid);
+        if (occupants && layout->subwin) {
+            GPtrArray *rows = g_ptr_array_new_with_free_func((GDestroyNotify)_occupantswin_row_free);
 
             GString *prefix = g_string_new(" ");
 
@@ -123,82 +139,64 @@ occupantswin_occupants(const char *const roomjid)
             }
 
             if (prefs_get_boolean(PREF_MUC_PRIVILEGES)) {
+                // single pass over the ordered roster, split by role
+                GPtrArray *moderators = g_ptr_array_new();
+                GPtrArray *participants = g_ptr_array_new();
+                GPtrArray *visitors = g_ptr_array_new();
 
-                GString *role = g_string_new(prefix->str);
-                g_string_append(role, "Moderators");
-
-                wattron(layout->subwin, theme_attrs(THEME_OCCUPANTS_HEADER));
-                win_sub_newline_lazy(layout->subwin);
-                win_sub_print(layout->subwin, role->str, TRUE, FALSE, 0);
-                wattroff(layout->subwin, theme_attrs(THEME_OCCUPANTS_HEADER));
-                g_string_free(role, TRUE);
                 GList *roster_curr = occupants;
                 while (roster_curr) {
                     Occupant *occupant = roster_curr->data;
                     if (occupant->role == MUC_ROLE_MODERATOR) {
-                        _occuptantswin_occupant(layout, occupant, mucwin->showjid);
+                        g_ptr_array_add(moderators, occupant);
+                    } else if (occupant->role == MUC_ROLE_PARTICIPANT) {
+                        g_ptr_array_add(participants, occupant);
+                    } else if (occupant->role == MUC_ROLE_VISITOR) {
+                        g_ptr_array_add(visitors, occupant);
                     }
                     roster_curr = g_list_next(roster_curr);
                 }
 
-                role = g_string_new(prefix->str);
-                g_string_append(role, "Participants");
-
-                wattron(layout->subwin, theme_attrs(THEME_OCCUPANTS_HEADER));
-                win_sub_newline_lazy(layout->subwin);
-                win_sub_print(layout->subwin, role->str, TRUE, FALSE, 0);
-                wattroff(layout->subwin, theme_attrs(THEME_OCCUPANTS_HEADER));
-                g_string_free(role, TRUE);
-                roster_curr = occupants;
-                while (roster_curr) {
-                    Occupant *occupant = roster_curr->data;
-                    if (occupant->role == MUC_ROLE_PARTICIPANT) {
-                        _occuptantswin_occupant(layout, occupant, mucwin->showjid);
-                    }
-                    roster_curr = g_list_next(roster_curr);
+                guint i;
+                _occupantswin_header(rows, prefix->str, "Moderators");
+                for (i = 0; i < moderators->len; i++) {
+                    _occuptantswin_occupant(rows, g_ptr_array_index(moderators, i), mucwin->showjid);
                 }
 
-                role = g_string_new(prefix->str);
-                g_string_append(role, "Visitors");
+                _occupantswin_header(rows, prefix->str, "Participants");
+                for (i = 0; i < participants->len; i++) {
+                    _occuptantswin_occupant(rows, g_ptr_array_index(participants, i), mucwin->showjid);
+                }
 
-                wattron(layout->subwin, theme_attrs(THEME_OCCUPANTS_HEADER));
-                win_sub_newline_lazy(layout->subwin);
-                win_sub_print(layout->subwin, role->str, TRUE, FALSE, 0);
-                wattroff(layout->subwin, theme_attrs(THEME_OCCUPANTS_HEADER));
-                g_string_free(role, TRUE);
-                roster_curr = occupants;
-                while (roster_curr) {
-                    Occupant *occupant = roster_curr->data;
-                    if (occupant->role == MUC_ROLE_VISITOR) {
-                        _occuptantswin_occupant(layout, occupant, mucwin->showjid);
-                    }
-                    roster_curr = g_list_next(roster_curr);
+                _occupantswin_header(rows, prefix->str, "Visitors");
+                for (i = 0; i < visitors->len; i++) {
+                    _occuptantswin_occupant(rows, g_ptr_array_index(visitors, i), mucwin->showjid);
                 }
-            } else {
-                GString *role = g_string_new(prefix->str);
-                g_string_append(role, "Occupants\n");
 
-                wattron(layout->subwin, theme_attrs(THEME_OCCUPANTS_HEADER));
-                win_sub_newline_lazy(layout->subwin);
-                win_sub_print(layout->subwin, role->str, TRUE, FALSE, 0);
-                wattroff(layout->subwin, theme_attrs(THEME_OCCUPANTS_HEADER));
-                g_string_free(role, TRUE);
+                g_ptr_array_free(moderators, TRUE);
+                g_ptr_array_free(participants, TRUE);
+                g_ptr_array_free(visitors, TRUE);
+            } else {
+                _occupantswin_header(rows, prefix->str, "Occupants\n");
 
                 GList *roster_curr = occupants;
                 while (roster_curr) {
                     Occupant *occupant = roster_curr->data;
-                    _occuptantswin_occupant(layout, occupant, mucwin->showjid);
+                    _occuptantswin_occupant(rows, occupant, mucwin->showjid);
                     roster_curr = g_list_next(roster_curr);
                 }
             }
 
             g_string_free(prefix, TRUE);
+
+            _occupantswin_draw(mucwin, layout, rows);
         }
 
         g_list_free(occupants);
     }
 }
 
+
 void
 occupantswin_occupants_all(void)
 {
@@ -215,3 +213,117 @@ occupantswin_occupants_all(void)
         curr = g_list_next(curr);
     }
 }
+
+void
+occupantswin_cache_free(ProfMucWin *mucwin)
+{
+    OccupantsCache *cache = mucwin->occupants_cache;
+    if (cache) {
+        g_ptr_array_free(cache->rows, TRUE);
+        g_array_free(cache->positions, TRUE);
+        free(cache);
+        mucwin->occupants_cache = NULL;
+    }
+}
+
+static void
+_occupantswin_header(GPtrArray *rows, const char *const prefix, const char *const title)
+{
+    GString *role = g_string_new(prefix);
+    g_string_append(role, title);
+    _occupantswin_row_add(rows, theme_attrs(THEME_OCCUPANTS_HEADER), TRUE, FALSE, 0, g_string_free(role, FALSE));
+}
+
+// takes ownership of text
+static void
+_occupantswin_row_add(GPtrArray *rows, int attrs, gboolean newline, gboolean wrap, int indent, char *text)
+{
+    OccupantsRow *row = malloc(sizeof(OccupantsRow));
+    row->attrs = attrs;
+    row->newline = newline;
+    row->wrap = wrap;
+    row->indent = indent;
+    row->text = text;
+    g_ptr_array_add(rows, row);
+}
+
+static void
+_occupantswin_row_free(OccupantsRow *row)
+{
+    if (row) {
+        g_free(row->text);
+        free(row);
+    }
+}
+
+static gboolean
+_occupantswin_row_equal(OccupantsRow *a, OccupantsRow *b)
+{
+    return a->attrs == b->attrs
+        && a->newline == b->newline
+        && a->wrap == b->wrap
+        && a->indent == b->indent
+        && g_strcmp0(a->text, b->text) == 0;
+}
+
+/*
+ * Draw rows to the panel, rows already on screen up to the first difference
+ * from the previous draw are left alone. Takes ownership of rows.
+ */
+static void
+_occupantswin_draw(ProfMucWin *mucwin, ProfLayoutSplit *layout, GPtrArray *rows)
+{
+    WINDOW *subwin = layout->subwin;
+    int cols = getmaxx(subwin);
+    OccupantsCache *cache = mucwin->occupants_cache;
+
+    if (cache && (cache->subwin != subwin || cache->cols != cols)) {
+        occupantswin_cache_free(mucwin);
+        cache = NULL;
+    }
+
+    guint first = 0;
+    if (cache) {
+        while (first < rows->len && first < cache->rows->len &&
+                _occupantswin_row_equal(g_ptr_array_index(rows, first), g_ptr_array_index(cache->rows, first))) {
+            first++;
+        }
+
+        if (first == rows->len && first == cache->rows->len) {
+            g_ptr_array_free(rows, TRUE);
+            return;
+        }
+
+        OccupantsRowPos *pos = &g_array_index(cache->positions, OccupantsRowPos, first);
+        wmove(subwin, pos->y, pos->x);
+        wclrtobot(subwin);
+        g_ptr_array_free(cache->rows, TRUE);
+        g_array_set_size(cache->positions, first);
+    } else {
+        cache = malloc(sizeof(OccupantsCache));
+        cache->subwin = subwin;
+        cache->cols = cols;
+        cache->positions = g_array_new(FALSE, FALSE, sizeof(OccupantsRowPos));
+        mucwin->occupants_cache = cache;
+        werase(subwin);
+    }
+    cache->rows = rows;
+
+    guint i;
+    for (i = first; i < rows->len; i++) {
+        OccupantsRow *row = g_ptr_array_index(rows, i);
+        OccupantsRowPos pos;
+        getyx(subwin, pos.y, pos.x);
+        g_array_append_val(cache->positions, pos);
+
+        wattron(subwin, row->attrs);
+        win_sub_newline_lazy(subwin);
+        win_sub_print(subwin, row->text, row->newline, row->wrap, row->indent);
+        wattroff(subwin, row->attrs);
+    }
+
+    // position after the last row, where a following row would start
+    OccupantsRowPos end;
+    getyx(subwin, end.y, end.x);
+    g_array_append_val(cache->positions, end);
+}
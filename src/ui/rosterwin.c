@@ -77,9 +77,35 @@ static GSList* _filter_contacts_with_presence(GSList *contacts, const char *cons
 static theme_item_t _get_roster_theme(roster_contact_theme_t theme_type, const char *presence);
 static int _compare_rooms_name(ProfMucWin *a, ProfMucWin *b);
 static int _compare_rooms_unread(ProfMucWin *a, ProfMucWin *b);
+static void _rosterwin_draw(void);
 
+// set when the roster panel needs redrawing on the next ui_update
+static gboolean roster_dirty = FALSE;
+
+/*
+ * Mark the roster panel for redrawing, many changes between two frames
+ * result in a single redraw
+ */
 void
 rosterwin_roster(void)
+{
+    roster_dirty = TRUE;
+}
+
+/*
+ * Redraw the roster panel if it has been marked since the last update
+ */
+void
+rosterwin_update(void)
+{
+    if (roster_dirty) {
+        roster_dirty = FALSE;
+        _rosterwin_draw();
+    }
+}
+
+static void
+_rosterwin_draw(void)
 {
     ProfWin *console = wins_get_console();
     if (!console) {
@@ -0,0 +1,89 @@
+/*
+ * searchwin.c
+ * vim: expandtab:ts=4:sts=4:sw=4
+ *
+ * Copyright (C) 2012 - 2019 James Booth <boothj5@gmail.com>
+ *
+ * This file is part of Profanity.
+ *
+ * Profanity is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Profanity is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Profanity.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link the code of portions of this program with the OpenSSL library under
+ * certain conditions as described in each individual source file, and
+ * distribute linked combinations including the two.
+ *
+ * You must obey the GNU General Public License in all respects for all of the
+ * code used other than OpenSSL. If you modify file(s) with this exception, you
+ * may extend this exception to your version of the file(s), but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version. If you delete this exception statement from all
+ * source files in the program, then also delete it here.
+ *
+ */
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "search.h"
+#include "ui/win_types.h"
+#include "ui/window_list.h"
+
+// most recent matches shown for a search
+#define SEARCHWIN_MAX_RESULTS 200
+
+void
+searchwin_search(ProfSearchWin *searchwin, const char *const text)
+{
+    assert(searchwin != NULL);
+
+    ProfWin *window = (ProfWin*)searchwin;
+    SearchQuery *query = search_query_parse(text);
+    if (query == NULL) {
+        win_println(window, THEME_ERROR, '!', "Invalid search: %s", text);
+        win_println(window, THEME_DEFAULT, '-', "Dates must be YYYY-MM-DD and at least one search word is needed.");
+        return;
+    }
+
+    gint64 started = g_get_monotonic_time();
+    GSList *results = search_run(query, SEARCHWIN_MAX_RESULTS);
+    gint64 elapsed = (g_get_monotonic_time() - started) / 1000;
+
+    win_println(window, THEME_DEFAULT, '-', "");
+    win_println(window, THEME_DEFAULT, '-', "Search: %s", text);
+
+    GSList *curr = results;
+    while (curr) {
+        SearchResult *result = curr->data;
+        gchar *date = g_date_time_format(result->timestamp, "%Y-%m-%d");
+        win_print_history(window, result->timestamp, "%s %s%s - %s", date, result->groupchat ? "room " : "",
+            result->jid, result->message);
+        g_free(date);
+        curr = g_slist_next(curr);
+    }
+
+    win_println(window, THEME_DEFAULT, '-', "%d results in %" G_GINT64_FORMAT " ms.", g_slist_length(results), elapsed);
+
+    search_results_free(results);
+    search_query_free(query);
+}
+
+char*
+searchwin_get_string(ProfSearchWin *searchwin)
+{
+    assert(searchwin != NULL);
+
+    return strdup("Search");
+}
@@ -68,6 +68,8 @@ typedef struct _status_bar_t {
     char *fulljid;
     GHashTable *tabs;
     int current_tab;
+    gboolean dirty;
+    gint64 time_checked;
 } StatusBar;
 
 static GTimeZone *tz;
@@ -75,6 +77,7 @@ static StatusBar *statusbar;
 static WINDOW *statusbar_win;
 
 static int _status_bar_draw_time(int pos);
+static gboolean _status_bar_time_changed(void);
 static void _status_bar_draw_maintext(int pos);
 static int _status_bar_draw_bracket(gboolean current, int pos, char* ch);
 static int _status_bar_draw_extended_tabs(int pos);
@@ -93,6 +96,8 @@ status_bar_init(void)
     statusbar->time = NULL;
     statusbar->prompt = NULL;
     statusbar->fulljid = NULL;
+    statusbar->dirty = FALSE;
+    statusbar->time_checked = 0;
     statusbar->tabs = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, (GDestroyNotify)_destroy_tab);
     StatusBarTab *console = calloc(1, sizeof(StatusBarTab));
     console->window_type = WIN_CONSOLE;
@@ -147,6 +152,7 @@ void
 status_bar_set_all_inactive(void)
 {
     g_hash_table_remove_all(statusbar->tabs);
+    statusbar->dirty = TRUE;
 }
 
 void
@@ -158,7 +164,7 @@ status_bar_current(int i)
         statusbar->current_tab = i;
     }
 
-    status_bar_draw();
+    statusbar->dirty = TRUE;
 }
 
 void
@@ -171,7 +177,7 @@ status_bar_inactive(const int win)
 
     g_hash_table_remove(statusbar->tabs, GINT_TO_POINTER(true_win));
 
-    status_bar_draw();
+    statusbar->dirty = TRUE;
 }
 
 void
@@ -212,7 +218,7 @@ _create_tab(const int win, win_type_t wintype, char *identifier, gboolean highli
 
     g_hash_table_replace(statusbar->tabs, GINT_TO_POINTER(true_win), tab);
 
-    status_bar_draw();
+    statusbar->dirty = TRUE;
 }
 
 void
@@ -259,7 +265,7 @@ status_bar_set_fulljid(const char *const fulljid)
     }
     statusbar->fulljid = strdup(fulljid);
 
-    status_bar_draw();
+    statusbar->dirty = TRUE;
 }
 
 void
@@ -270,7 +276,7 @@ status_bar_clear_fulljid(void)
         statusbar->fulljid = NULL;
     }
 
-    status_bar_draw();
+    statusbar->dirty = TRUE;
 }
 
 void
@@ -302,6 +308,31 @@ status_bar_draw(void)
 
     wnoutrefresh(statusbar_win);
     inp_put_back();
+    statusbar->dirty = FALSE;
+}
+
+gboolean
+status_bar_update_virtual(void)
+{
+    // the clock only needs checking once a second
+    gint64 now = g_get_real_time() / G_USEC_PER_SEC;
+    if (!statusbar->dirty && now != statusbar->time_checked) {
+        statusbar->time_checked = now;
+        statusbar->dirty = _status_bar_time_changed();
+    }
+
+    if (!statusbar->dirty) {
+        return FALSE;
+    }
+
+    status_bar_draw();
+    return TRUE;
+}
+
+void
+status_bar_damage(void)
+{
+    statusbar->dirty = TRUE;
 }
 
 static gboolean
@@ -457,6 +488,26 @@ _status_bar_draw_time(int pos)
     return pos;
 }
 
+static gboolean
+_status_bar_time_changed(void)
+{
+    char *time_pref = prefs_get_string(PREF_TIME_STATUSBAR);
+    if (g_strcmp0(time_pref, "off") == 0) {
+        prefs_free_string(time_pref);
+        return FALSE;
+    }
+
+    GDateTime *datetime = g_date_time_new_now(tz);
+    gchar *time = g_date_time_format(datetime, time_pref);
+    g_date_time_unref(datetime);
+    prefs_free_string(time_pref);
+
+    gboolean changed = g_strcmp0(time, statusbar->time) != 0;
+    g_free(time);
+
+    return changed;
+}
+
 static void
 _status_bar_draw_maintext(int pos)
 {
@@ -559,6 +610,8 @@ _display_name(StatusBarTab *tab)
         fullname = strdup("console");
     } else if (tab->window_type == WIN_XML) {
         fullname = strdup("xmlconsole");
+    } else if (tab->window_type == WIN_SEARCH) {
+        fullname = strdup("search");
     } else if (tab->window_type == WIN_PLUGIN) {
         fullname = strdup(tab->identifier);
     } else if (tab->window_type == WIN_CHAT) {
@@ -38,6 +38,8 @@
 
 void status_bar_init(void);
 void status_bar_draw(void);
+gboolean status_bar_update_virtual(void);
+void status_bar_damage(void);
 void status_bar_close(void);
 void status_bar_resize(void);
 void status_bar_set_prompt(const char *const prompt);
@@ -59,6 +59,9 @@ static gboolean is_connected;
 static gboolean typing;
 static GTimer *typing_elapsed;
 
+// set when the title bar content changes, drawn on the next ui_update
+static gboolean dirty;
+
 static void _title_bar_draw(void);
 static void _show_self_presence(void);
 static void _show_contact_presence(ProfChatWin *chatwin);
@@ -77,11 +80,10 @@ create_title_bar(void)
     title_bar_set_presence(CONTACT_OFFLINE);
     title_bar_set_tls(FALSE);
     title_bar_set_connected(FALSE);
-    wnoutrefresh(win);
-    inp_put_back();
+    _title_bar_draw();
 }
 
-void
+gboolean
 title_bar_update_virtual(void)
 {
     ProfWin *window = wins_get_current();
@@ -94,10 +96,23 @@ title_bar_update_virtual(void)
 
                 g_timer_destroy(typing_elapsed);
                 typing_elapsed = NULL;
+                dirty = TRUE;
             }
         }
     }
+
+    if (!dirty) {
+        return FALSE;
+    }
+
     _title_bar_draw();
+    return TRUE;
+}
+
+void
+title_bar_damage(void)
+{
+    dirty = TRUE;
 }
 
 void
@@ -127,28 +142,28 @@ title_bar_console(void)
     typing_elapsed = NULL;
     typing = FALSE;
 
-    _title_bar_draw();
+    dirty = TRUE;
 }
 
 void
 title_bar_set_presence(contact_presence_t presence)
 {
     current_presence = presence;
-    _title_bar_draw();
+    dirty = TRUE;
 }
 
 void
 title_bar_set_connected(gboolean connected)
 {
     is_connected = connected;
-    _title_bar_draw();
+    dirty = TRUE;
 }
 
 void
 title_bar_set_tls(gboolean secured)
 {
     tls_secured = secured;
-    _title_bar_draw();
+    dirty = TRUE;
 }
 
 void
@@ -160,7 +175,7 @@ title_bar_switch(void)
         typing = FALSE;
     }
 
-    _title_bar_draw();
+    dirty = TRUE;
 }
 
 void
@@ -177,7 +192,7 @@ title_bar_set_typing(gboolean is_typing)
     typing = is_typing;
 
 
-    _title_bar_draw();
+    dirty = TRUE;
 }
 
 static void
@@ -215,6 +230,7 @@ _title_bar_draw(void)
 
     wnoutrefresh(win);
     inp_put_back();
+    dirty = FALSE;
 }
 
 static void
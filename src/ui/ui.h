@@ -61,12 +61,15 @@
 void ui_init(void);
 void ui_load_colours(void);
 void ui_update(void);
+void ui_damage_all(void);
 void ui_close(void);
 void ui_redraw(void);
 void ui_resize(void);
+void ui_scrollback_update(void);
 void ui_focus_win(ProfWin *window);
 void ui_sigwinch_handler(int sig);
 void ui_handle_otr_error(const char *const barejid, const char *const message);
+void ui_handle_pgp_error(const char *const barejid, const char *const message);
 unsigned long ui_get_idle_time(void);
 void ui_reset_idle_time(void);
 void ui_print_system_msg_from_recipient(const char *const barejid, const char *message);
@@ -228,8 +231,13 @@ char* confwin_get_string(ProfConfWin *confwin);
 void xmlwin_show(ProfXMLWin *xmlwin, const char *const msg);
 char* xmlwin_get_string(ProfXMLWin *xmlwin);
 
+// search
+void searchwin_search(ProfSearchWin *searchwin, const char *const text);
+char* searchwin_get_string(ProfSearchWin *searchwin);
+
 // Input window
-char* inp_readline(void);
+char* inp_readline(gint timeout, int xmpp_fd, int log_fd);
+gint inp_get_timeout(void);
 void inp_nonblocking(gboolean reset);
 
 // Console window
@@ -315,6 +323,7 @@ void cons_autoping_setting(void);
 void cons_autoconnect_setting(void);
 void cons_room_cache_setting(void);
 void cons_inpblock_setting(void);
+void cons_scrollback_setting(void);
 void cons_statusbar_setting(void);
 void cons_winpos_setting(void);
 void cons_color_setting(void);
@@ -336,20 +345,25 @@ void status_bar_set_all_inactive(void);
 
 // roster window
 void rosterwin_roster(void);
+void rosterwin_update(void);
 
 // occupants window
 void occupantswin_occupants(const char *const room);
 void occupantswin_occupants_all(void);
+void occupantswin_cache_free(ProfMucWin *mucwin);
 
 // window interface
 ProfWin* win_create_console(void);
 ProfWin* win_create_xmlconsole(void);
+ProfWin* win_create_search(void);
 ProfWin* win_create_chat(const char *const barejid);
 ProfWin* win_create_muc(const char *const roomjid);
 ProfWin* win_create_config(const char *const title, DataForm *form, ProfConfWinCallback submit, ProfConfWinCallback cancel, const void *userdata);
 ProfWin* win_create_private(const char *const fulljid);
 ProfWin* win_create_plugin(const char *const plugin_name, const char *const tag);
 void win_update_virtual(ProfWin *window);
+gboolean win_update_damaged(ProfWin *window);
+void win_damage_virtual(void);
 void win_free(ProfWin *window);
 gboolean win_notify_remind(ProfWin *window);
 int win_unread(ProfWin *window);
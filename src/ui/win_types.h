@@ -58,6 +58,7 @@
 #define PROFCONFWIN_MEMCHECK        64334685
 #define PROFXMLWIN_MEMCHECK         87333463
 #define PROFPLUGINWIN_MEMCHECK      43434777
+#define PROFSEARCHWIN_MEMCHECK      36455218
 
 typedef enum {
     FIELD_HIDDEN,
@@ -112,6 +113,13 @@ typedef struct prof_layout_t {
     ProfBuff buffer;
     int y_pos;
     int paged;
+    // entries drawn into the pad, as positions counting the scrollback
+    // file's entries first and then the buffer's
+    int draw_from;
+    // position the pad stops short of, -1 when drawn to the newest entry
+    int draw_end;
+    // buffer origin the positions were taken at
+    int draw_origin;
 } ProfLayout;
 
 typedef struct prof_layout_simple_t {
@@ -132,7 +140,8 @@ typedef enum {
     WIN_CONFIG,
     WIN_PRIVATE,
     WIN_XML,
-    WIN_PLUGIN
+    WIN_PLUGIN,
+    WIN_SEARCH
 } win_type_t;
 
 typedef struct prof_win_t {
@@ -156,6 +165,8 @@ typedef struct prof_chat_win_t {
     gboolean is_omemo;
     char *resource_override;
     gboolean history_shown;
+    // older chat log history still to be loaded when paging up
+    struct chat_log_history_t *history;
     unsigned long memcheck;
     char *enctext;
     char *incoming_char;
@@ -174,6 +185,8 @@ typedef struct prof_muc_win_t {
     char *enctext;
     char *message_char;
     GDateTime *last_msg_timestamp;
+    // rows last drawn in the occupants panel
+    struct occupants_cache_t *occupants_cache;
 } ProfMucWin;
 
 typedef struct prof_conf_win_t ProfConfWin;
@@ -210,4 +223,9 @@ typedef struct prof_plugin_win_t {
     unsigned long memcheck;
 } ProfPluginWin;
 
+typedef struct prof_search_win_t {
+    ProfWin window;
+    unsigned long memcheck;
+} ProfSearchWin;
+
 #endif
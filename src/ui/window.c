@@ -49,6 +49,7 @@
 #include <ncurses.h>
 #endif
 
+#include "log.h"
 #include "config/theme.h"
 #include "config/preferences.h"
 #include "ui/ui.h"
@@ -59,14 +60,92 @@
 
 #define CONS_WIN_TITLE "Profanity. Type /help for help information."
 #define XML_WIN_TITLE "XML Console"
+#define SEARCH_WIN_TITLE "Search"
 
 #define CEILING(X) (X-(int)(X) > 0 ? (int)(X+1) : (int)(X))
 
+// What the main window area showed when it was last refreshed
+typedef struct prof_win_drawn_t {
+    ProfWin *window;
+    WINDOW *subwin;
+    int y_pos;
+    int sub_y_pos;
+    int row_start;
+    int row_end;
+    int cols;
+} ProfWinDrawn;
+
+static ProfWinDrawn drawn;
+
+// what to do at an offset of the message while printing its layout
+typedef enum {
+    LAYOUT_NEWLINE,     // break the line, then indent n
+    LAYOUT_INDENT,      // indent n
+    LAYOUT_SKIP         // leave out n bytes
+} layout_op_t;
+
+typedef struct prof_layout_op_t {
+    int offset;
+    layout_op_t op;
+    int n;
+} ProfLayoutOp;
+
+struct prof_buff_layout_t {
+    // what the layout was computed for
+    int width;
+    int startx;
+    int indent;
+    int pad_indent;
+    // rows below the first, and the column printing ends on
+    int lines;
+    int endx;
+    int n_ops;
+    ProfLayoutOp ops[];
+};
+
+// cursor position while laying out a message
+typedef struct prof_layout_cursor_t {
+    int x;
+    int y;
+    int width;
+    GArray *ops;
+} ProfLayoutCursor;
+
+// operations of the layout being computed, reused since only the ui thread lays out
+static GArray *layout_ops;
+
 static void _win_printf(ProfWin *window, const char show_char, int pad_indent, GDateTime *timestamp,
     int flags, theme_item_t theme_item, const char *const from, const char *const message, ...);
 static void _win_print(ProfWin *window, const char show_char, int pad_indent, GDateTime *time,
-    int flags, theme_item_t theme_item, const char *const from, const char *const message, DeliveryReceipt *receipt);
-static void _win_print_wrapped(WINDOW *win, const char *const message, size_t indent, int pad_indent);
+    int flags, theme_item_t theme_item, const char *const from, const char *const message, DeliveryReceipt *receipt,
+    ProfBuffLayout **layout);
+static void _win_print_wrapped(WINDOW *win, const char *const message, size_t indent, int pad_indent,
+    ProfBuffLayout **layout);
+static ProfBuffLayout* _win_layout(const char *const message, int width, int startx, int indent, int pad_indent);
+static void _win_layout_ops(ProfLayoutCursor *cursor, const char *const message, int indent, int pad_indent);
+static void _win_print_layout(WINDOW *win, const char *const message, ProfLayoutOp *ops, int n_ops);
+static void _win_print_appended(ProfWin *window);
+static void _layout_advance(ProfLayoutCursor *cursor, int cols);
+static void _layout_advance_char(ProfLayoutCursor *cursor, int cols);
+static void _layout_op(ProfLayoutCursor *cursor, int offset, layout_op_t op, int n);
+static void _layout_indent(ProfLayoutCursor *cursor, int offset, int indent, int pad_indent);
+static int _layout_char_width(const char *const ch);
+static gboolean _layout_valid_char(const char *const ch);
+static void _layout_skip_invalid(ProfLayoutCursor *cursor, const char *const message, const char *word,
+    const char *const word_end);
+static int _win_redraw_from(ProfWin *window, int mark);
+static void _win_redraw_tail(ProfWin *window);
+static int _win_pad_rows(void);
+static void _win_redraw_entry(ProfWin *window, ProfBuffEntry *e, gboolean resident);
+static gsize _win_layout_bytes(ProfBuffLayout *layout);
+static int _win_tail_start(ProfWin *window);
+static int _win_entry_rows(ProfBuffEntry *entry, int width);
+static int _win_line_start(ProfBuff buffer, int pos);
+static int _win_entry_flags(ProfBuff buffer, int pos);
+static void _win_draw_sync(ProfWin *window);
+static void _win_slide_down(ProfWin *window, int page_space);
+static int _win_load_history(ProfChatWin *chatwin, int count);
+static gboolean _win_viewport_touched(WINDOW *pad, int y_pos, int rows);
 
 int
 win_roster_cols(void)
@@ -84,35 +163,62 @@ win_occpuants_cols(void)
     return CEILING( (((double)cols) / 100) * occupants_win_percent);
 }
 
+static int
+_win_scrollback(win_type_t type)
+{
+    switch (type) {
+        case WIN_CHAT:
+            return prefs_get_scrollback("chat");
+        case WIN_MUC:
+            return prefs_get_scrollback("muc");
+        case WIN_CONFIG:
+            return prefs_get_scrollback("config");
+        case WIN_PRIVATE:
+            return prefs_get_scrollback("private");
+        case WIN_XML:
+            return prefs_get_scrollback("xmlconsole");
+        case WIN_PLUGIN:
+            return prefs_get_scrollback("plugin");
+        default:
+            return prefs_get_scrollback("console");
+    }
+}
+
 static ProfLayout*
-_win_create_simple_layout(void)
+_win_create_simple_layout(win_type_t type)
 {
     int cols = getmaxx(stdscr);
 
     ProfLayoutSimple *layout = malloc(sizeof(ProfLayoutSimple));
     layout->base.type = LAYOUT_SIMPLE;
-    layout->base.win = newpad(PAD_SIZE, cols);
+    layout->base.win = newpad(_win_pad_rows(), cols);
     wbkgd(layout->base.win, theme_attrs(THEME_TEXT));
-    layout->base.buffer = buffer_create();
+    layout->base.buffer = buffer_create(_win_scrollback(type));
     layout->base.y_pos = 0;
     layout->base.paged = 0;
+    layout->base.draw_from = 0;
+    layout->base.draw_end = -1;
+    layout->base.draw_origin = 0;
     scrollok(layout->base.win, TRUE);
 
     return &layout->base;
 }
 
 static ProfLayout*
-_win_create_split_layout(void)
+_win_create_split_layout(win_type_t type)
 {
     int cols = getmaxx(stdscr);
 
     ProfLayoutSplit *layout = malloc(sizeof(ProfLayoutSplit));
     layout->base.type = LAYOUT_SPLIT;
-    layout->base.win = newpad(PAD_SIZE, cols);
+    layout->base.win = newpad(_win_pad_rows(), cols);
     wbkgd(layout->base.win, theme_attrs(THEME_TEXT));
-    layout->base.buffer = buffer_create();
+    layout->base.buffer = buffer_create(_win_scrollback(type));
     layout->base.y_pos = 0;
     layout->base.paged = 0;
+    layout->base.draw_from = 0;
+    layout->base.draw_end = -1;
+    layout->base.draw_origin = 0;
     scrollok(layout->base.win, TRUE);
     layout->subwin = NULL;
     layout->sub_y_pos = 0;
@@ -126,7 +232,7 @@ win_create_console(void)
 {
     ProfConsoleWin *new_win = malloc(sizeof(ProfConsoleWin));
     new_win->window.type = WIN_CONSOLE;
-    new_win->window.layout = _win_create_split_layout();
+    new_win->window.layout = _win_create_split_layout(WIN_CONSOLE);
 
     return &new_win->window;
 }
@@ -136,7 +242,7 @@ win_create_chat(const char *const barejid)
 {
     ProfChatWin *new_win = malloc(sizeof(ProfChatWin));
     new_win->window.type = WIN_CHAT;
-    new_win->window.layout = _win_create_simple_layout();
+    new_win->window.layout = _win_create_simple_layout(WIN_CHAT);
 
     new_win->barejid = strdup(barejid);
     new_win->resource_override = NULL;
@@ -146,6 +252,7 @@ win_create_chat(const char *const barejid)
     new_win->pgp_send = FALSE;
     new_win->is_omemo = FALSE;
     new_win->history_shown = FALSE;
+    new_win->history = NULL;
     new_win->unread = 0;
     new_win->state = chat_state_new();
     new_win->enctext = NULL;
@@ -164,26 +271,28 @@ win_create_muc(const char *const roomjid)
     int cols = getmaxx(stdscr);
 
     new_win->window.type = WIN_MUC;
-    new_win->window.layout = _win_create_simple_layout();
     ProfLayoutSplit *layout = malloc(sizeof(ProfLayoutSplit));
     layout->base.type = LAYOUT_SPLIT;
 
     if (prefs_get_boolean(PREF_OCCUPANTS)) {
         int subwin_cols = win_occpuants_cols();
-        layout->base.win = newpad(PAD_SIZE, cols - subwin_cols);
+        layout->base.win = newpad(_win_pad_rows(), cols - subwin_cols);
         wbkgd(layout->base.win, theme_attrs(THEME_TEXT));
         layout->subwin = newpad(PAD_SIZE, subwin_cols);;
         wbkgd(layout->subwin, theme_attrs(THEME_TEXT));
     } else {
-        layout->base.win = newpad(PAD_SIZE, (cols));
+        layout->base.win = newpad(_win_pad_rows(), (cols));
         wbkgd(layout->base.win, theme_attrs(THEME_TEXT));
         layout->subwin = NULL;
     }
     layout->sub_y_pos = 0;
     layout->memcheck = LAYOUT_SPLIT_MEMCHECK;
-    layout->base.buffer = buffer_create();
+    layout->base.buffer = buffer_create(_win_scrollback(WIN_MUC));
     layout->base.y_pos = 0;
     layout->base.paged = 0;
+    layout->base.draw_from = 0;
+    layout->base.draw_end = -1;
+    layout->base.draw_origin = 0;
     scrollok(layout->base.win, TRUE);
     new_win->window.layout = (ProfLayout*)layout;
 
@@ -199,6 +308,7 @@ win_create_muc(const char *const roomjid)
     new_win->enctext = NULL;
     new_win->message_char = NULL;
     new_win->is_omemo = FALSE;
+    new_win->occupants_cache = NULL;
 
     new_win->memcheck = PROFMUCWIN_MEMCHECK;
 
@@ -210,7 +320,7 @@ win_create_config(const char *const roomjid, DataForm *form, ProfConfWinCallback
 {
     ProfConfWin *new_win = malloc(sizeof(ProfConfWin));
     new_win->window.type = WIN_CONFIG;
-    new_win->window.layout = _win_create_simple_layout();
+    new_win->window.layout = _win_create_simple_layout(WIN_CONFIG);
     new_win->roomjid = strdup(roomjid);
     new_win->form = form;
     new_win->submit = submit;
@@ -227,7 +337,7 @@ win_create_private(const char *const fulljid)
 {
     ProfPrivateWin *new_win = malloc(sizeof(ProfPrivateWin));
     new_win->window.type = WIN_PRIVATE;
-    new_win->window.layout = _win_create_simple_layout();
+    new_win->window.layout = _win_create_simple_layout(WIN_PRIVATE);
     new_win->fulljid = strdup(fulljid);
     new_win->unread = 0;
     new_win->occupant_offline = FALSE;
@@ -243,19 +353,31 @@ win_create_xmlconsole(void)
 {
     ProfXMLWin *new_win = malloc(sizeof(ProfXMLWin));
     new_win->window.type = WIN_XML;
-    new_win->window.layout = _win_create_simple_layout();
+    new_win->window.layout = _win_create_simple_layout(WIN_XML);
 
     new_win->memcheck = PROFXMLWIN_MEMCHECK;
 
     return &new_win->window;
 }
 
+ProfWin*
+win_create_search(void)
+{
+    ProfSearchWin *new_win = malloc(sizeof(ProfSearchWin));
+    new_win->window.type = WIN_SEARCH;
+    new_win->window.layout = _win_create_simple_layout(WIN_SEARCH);
+
+    new_win->memcheck = PROFSEARCHWIN_MEMCHECK;
+
+    return &new_win->window;
+}
+
 ProfWin*
 win_create_plugin(const char *const plugin_name, const char *const tag)
 {
     ProfPluginWin *new_win = malloc(sizeof(ProfPluginWin));
     new_win->window.type = WIN_PLUGIN;
-    new_win->window.layout = _win_create_simple_layout();
+    new_win->window.layout = _win_create_simple_layout(WIN_PLUGIN);
 
     new_win->tag = strdup(tag);
     new_win->plugin_name = strdup(plugin_name);
@@ -315,6 +437,9 @@ win_get_title(ProfWin *window)
     if (window->type == WIN_XML) {
         return strdup(XML_WIN_TITLE);
     }
+    if (window->type == WIN_SEARCH) {
+        return strdup(SEARCH_WIN_TITLE);
+    }
     if (window->type == WIN_PLUGIN) {
         ProfPluginWin *pluginwin = (ProfPluginWin*) window;
         assert(pluginwin->memcheck == PROFPLUGINWIN_MEMCHECK);
@@ -363,6 +488,10 @@ win_get_tab_identifier(ProfWin *window)
         {
             return strdup("xmlconsole");
         }
+        case WIN_SEARCH:
+        {
+            return strdup("search");
+        }
         default:
             return strdup("UNKNOWN");
     }
@@ -404,6 +533,11 @@ win_to_string(ProfWin *window)
             ProfXMLWin *xmlwin = (ProfXMLWin*)window;
             return xmlwin_get_string(xmlwin);
         }
+        case WIN_SEARCH:
+        {
+            ProfSearchWin *searchwin = (ProfSearchWin*)window;
+            return searchwin_get_string(searchwin);
+        }
         case WIN_PLUGIN:
         {
             ProfPluginWin *pluginwin = (ProfPluginWin*)window;
@@ -428,12 +562,15 @@ win_hide_subwin(ProfWin *window)
         }
         layout->subwin = NULL;
         layout->sub_y_pos = 0;
+        if (window->type == WIN_MUC) {
+            occupantswin_cache_free((ProfMucWin*)window);
+        }
         int cols = getmaxx(stdscr);
-        wresize(layout->base.win, PAD_SIZE, cols);
+        wresize(layout->base.win, _win_pad_rows(), cols);
         win_redraw(window);
     } else {
         int cols = getmaxx(stdscr);
-        wresize(window->layout->win, PAD_SIZE, cols);
+        wresize(window->layout->win, _win_pad_rows(), cols);
         win_redraw(window);
     }
 }
@@ -457,13 +594,17 @@ win_show_subwin(ProfWin *window)
     ProfLayoutSplit *layout = (ProfLayoutSplit*)window->layout;
     layout->subwin = newpad(PAD_SIZE, subwin_cols);
     wbkgd(layout->subwin, theme_attrs(THEME_TEXT));
-    wresize(layout->base.win, PAD_SIZE, cols - subwin_cols);
+    wresize(layout->base.win, _win_pad_rows(), cols - subwin_cols);
     win_redraw(window);
 }
 
 void
 win_free(ProfWin* window)
 {
+    if (drawn.window == window) {
+        drawn.window = NULL;
+    }
+
     if (window->layout->type == LAYOUT_SPLIT) {
         ProfLayoutSplit *layout = (ProfLayoutSplit*)window->layout;
         if (layout->subwin) {
@@ -487,6 +628,7 @@ win_free(ProfWin* window)
         free(chatwin->incoming_char);
         free(chatwin->outgoing_char);
         chat_state_free(chatwin->state);
+        chat_log_history_free(chatwin->history);
         break;
     }
     case WIN_MUC:
@@ -495,6 +637,7 @@ win_free(ProfWin* window)
         free(mucwin->roomjid);
         free(mucwin->enctext);
         free(mucwin->message_char);
+        occupantswin_cache_free(mucwin);
         break;
     }
     case WIN_CONFIG:
@@ -531,6 +674,52 @@ win_page_up(ProfWin *window)
     int y = getcury(window->layout->win);
     int page_space = rows - 4;
     int *page_start = &(window->layout->y_pos);
+    ProfBuff buffer = window->layout->buffer;
+    int spilled = buffer_spilled_size(buffer);
+
+    _win_draw_sync(window);
+    window->layout->paged = 1;
+
+    // at the top of the pad, draw a page of the entries above it, from the
+    // buffer or the scrollback file
+    if (*page_start == 0 && window->layout->draw_from > 0) {
+        int prev_from = window->layout->draw_from;
+        int width = getmaxx(window->layout->win);
+        int from = prev_from;
+        int page_rows = 0;
+        while (from > 0 && page_rows < page_space) {
+            from--;
+            // spilled entries are not laid out, count them as a row each
+            page_rows += from < spilled ? 1 : _win_entry_rows(buffer_get_entry(buffer, from - spilled), width);
+        }
+        window->layout->draw_from = _win_line_start(buffer, from);
+        int loaded = prev_from - window->layout->draw_from;
+
+        int prev_top = _win_redraw_from(window, loaded);
+        *page_start = prev_top - page_space;
+        if (*page_start < 0)
+            *page_start = 0;
+
+        win_update_virtual(window);
+        return;
+    }
+
+    // at the top of the pad with nothing spilled, bring back a page of older chat log history
+    if (*page_start == 0 && spilled == 0 && window->type == WIN_CHAT) {
+        int loaded = _win_load_history((ProfChatWin*)window, page_space);
+        if (loaded > 0) {
+            // the loaded entries moved everything down, draw from the first of them
+            _win_draw_sync(window);
+            window->layout->draw_from = 0;
+            int prev_top = _win_redraw_from(window, loaded);
+            *page_start = prev_top - page_space;
+            if (*page_start < 0)
+                *page_start = 0;
+
+            win_update_virtual(window);
+            return;
+        }
+    }
 
     *page_start -= page_space;
 
@@ -538,7 +727,6 @@ win_page_up(ProfWin *window)
     if (*page_start < 0)
         *page_start = 0;
 
-    window->layout->paged = 1;
     win_update_virtual(window);
 
     // switch off page if last line and space line visible
@@ -555,6 +743,8 @@ win_page_down(ProfWin *window)
     int page_space = rows - 4;
     int *page_start = &(window->layout->y_pos);
 
+    _win_draw_sync(window);
+
     *page_start += page_space;
 
     // only got half a screen, show full screen
@@ -566,11 +756,26 @@ win_page_down(ProfWin *window)
         *page_start = y - page_space - 1;
 
     window->layout->paged = 1;
+
+    // at the bottom of a pad that stops short of the newest entries, draw the ones below
+    if ((y) - *page_start == page_space && window->layout->draw_end >= 0) {
+        _win_slide_down(window, page_space);
+        win_update_virtual(window);
+        return;
+    }
+
     win_update_virtual(window);
 
     // switch off page if last line and space line visible
     if ((y) - *page_start == page_space) {
         window->layout->paged = 0;
+
+        // back to following the end, drop the entries paged in above it
+        if (window->layout->draw_from != _win_tail_start(window)) {
+            _win_redraw_tail(window);
+            win_move_to_end(window);
+            win_update_virtual(window);
+        }
     }
 }
 
@@ -647,7 +852,7 @@ win_resize(ProfWin *window)
                 subwin_cols = win_occpuants_cols();
             }
             wbkgd(layout->base.win, theme_attrs(THEME_TEXT));
-            wresize(layout->base.win, PAD_SIZE, cols - subwin_cols);
+            wresize(layout->base.win, _win_pad_rows(), cols - subwin_cols);
             wbkgd(layout->subwin, theme_attrs(THEME_TEXT));
             wresize(layout->subwin, PAD_SIZE, subwin_cols);
             if (window->type == WIN_CONSOLE) {
@@ -659,11 +864,11 @@ win_resize(ProfWin *window)
             }
         } else {
             wbkgd(layout->base.win, theme_attrs(THEME_TEXT));
-            wresize(layout->base.win, PAD_SIZE, cols);
+            wresize(layout->base.win, _win_pad_rows(), cols);
         }
     } else {
         wbkgd(window->layout->win, theme_attrs(THEME_TEXT));
-        wresize(window->layout->win, PAD_SIZE, cols);
+        wresize(window->layout->win, _win_pad_rows(), cols);
     }
 
     win_redraw(window);
@@ -693,6 +898,65 @@ win_update_virtual(ProfWin *window)
     } else {
         pnoutrefresh(window->layout->win, window->layout->y_pos, 0, row_start, 0, row_end, cols-1);
     }
+
+    drawn.window = window;
+    drawn.subwin = NULL;
+    drawn.sub_y_pos = 0;
+    if (window->layout->type == LAYOUT_SPLIT) {
+        ProfLayoutSplit *layout = (ProfLayoutSplit*)window->layout;
+        drawn.subwin = layout->subwin;
+        drawn.sub_y_pos = layout->sub_y_pos;
+    }
+    drawn.y_pos = window->layout->y_pos;
+    drawn.row_start = row_start;
+    drawn.row_end = row_end;
+    drawn.cols = cols;
+}
+
+gboolean
+win_update_damaged(ProfWin *window)
+{
+    int cols = getmaxx(stdscr);
+    int row_start = screen_mainwin_row_start();
+    int row_end = screen_mainwin_row_end();
+
+    WINDOW *subwin = NULL;
+    int sub_y_pos = 0;
+    if (window->layout->type == LAYOUT_SPLIT) {
+        ProfLayoutSplit *layout = (ProfLayoutSplit*)window->layout;
+        subwin = layout->subwin;
+        sub_y_pos = layout->sub_y_pos;
+    }
+
+    gboolean damaged = drawn.window != window
+        || drawn.subwin != subwin
+        || drawn.y_pos != window->layout->y_pos
+        || drawn.sub_y_pos != sub_y_pos
+        || drawn.row_start != row_start
+        || drawn.row_end != row_end
+        || drawn.cols != cols;
+
+    // curses marks lines touched until they are next refreshed
+    int rows = row_end - row_start + 1;
+    if (!damaged) {
+        damaged = _win_viewport_touched(window->layout->win, window->layout->y_pos, rows);
+    }
+    if (!damaged && subwin) {
+        damaged = _win_viewport_touched(subwin, sub_y_pos, rows);
+    }
+
+    if (!damaged) {
+        return FALSE;
+    }
+
+    win_update_virtual(window);
+    return TRUE;
+}
+
+void
+win_damage_virtual(void)
+{
+    drawn.window = NULL;
 }
 
 void
@@ -733,6 +997,11 @@ win_move_to_end(ProfWin *window)
 {
     window->layout->paged = 0;
 
+    // the pad stops short of the newest entries, draw the end of the buffer again
+    if (window->layout->draw_end >= 0) {
+        _win_redraw_tail(window);
+    }
+
     int rows = getmaxy(stdscr);
     int y = getcury(window->layout->win);
     int size = rows - 3;
@@ -1105,7 +1374,7 @@ win_println_them_message(ProfWin *window, char ch, int flags, const char *const
 
     buffer_append(window->layout->buffer, ch, 0, timestamp, flags | NO_ME, THEME_TEXT_THEM, them, fmt_msg->str, NULL, NULL);
 
-    _win_print(window, ch, 0, timestamp, flags | NO_ME, THEME_TEXT_THEM, them, fmt_msg->str, NULL);
+    _win_print_appended(window);
     inp_nonblocking(TRUE);
     g_date_time_unref(timestamp);
 
@@ -1125,7 +1394,7 @@ win_println_me_message(ProfWin *window, char ch, const char *const me, const cha
 
     buffer_append(window->layout->buffer, ch, 0, timestamp, 0, THEME_TEXT_ME, me, fmt_msg->str, NULL, NULL);
 
-    _win_print(window, ch, 0, timestamp, 0, THEME_TEXT_ME, me, fmt_msg->str, NULL);
+    _win_print_appended(window);
     inp_nonblocking(TRUE);
     g_date_time_unref(timestamp);
 
@@ -1145,7 +1414,7 @@ win_print_outgoing(ProfWin *window, const char ch, const char *const message, ..
 
     buffer_append(window->layout->buffer, ch, 0, timestamp, 0, THEME_TEXT_ME, "me", fmt_msg->str, NULL, NULL);
 
-    _win_print(window, ch, 0, timestamp, 0, THEME_TEXT_ME, "me", fmt_msg->str, NULL);
+    _win_print_appended(window);
     inp_nonblocking(TRUE);
     g_date_time_unref(timestamp);
 
@@ -1164,7 +1433,7 @@ win_print_history(ProfWin *window, GDateTime *timestamp, const char *const messa
     g_string_vprintf(fmt_msg, message, arg);
 
     buffer_append(window->layout->buffer, '-', 0, timestamp, 0, THEME_TEXT_HISTORY, "", fmt_msg->str, NULL, NULL);
-    _win_print(window, '-', 0, timestamp, 0, THEME_TEXT_HISTORY, "", fmt_msg->str, NULL);
+    _win_print_appended(window);
 
     inp_nonblocking(TRUE);
     g_date_time_unref(timestamp);
@@ -1185,7 +1454,7 @@ win_print(ProfWin *window, theme_item_t theme_item, const char ch, const char *c
 
     buffer_append(window->layout->buffer, ch, 0, timestamp, NO_EOL, theme_item, "", fmt_msg->str, NULL, NULL);
 
-    _win_print(window, ch, 0, timestamp, NO_EOL, theme_item, "", fmt_msg->str, NULL);
+    _win_print_appended(window);
     inp_nonblocking(TRUE);
     g_date_time_unref(timestamp);
 
@@ -1205,7 +1474,7 @@ win_println(ProfWin *window, theme_item_t theme_item, const char ch, const char
 
     buffer_append(window->layout->buffer, ch, 0, timestamp, 0, theme_item, "", fmt_msg->str, NULL, NULL);
 
-    _win_print(window, ch, 0, timestamp, 0, theme_item, "", fmt_msg->str, NULL);
+    _win_print_appended(window);
     inp_nonblocking(TRUE);
     g_date_time_unref(timestamp);
 
@@ -1225,7 +1494,7 @@ win_println_indent(ProfWin *window, int pad, const char *const message, ...)
 
     buffer_append(window->layout->buffer, '-', pad, timestamp, 0, THEME_DEFAULT, "", fmt_msg->str, NULL, NULL);
 
-    _win_print(window, '-', pad, timestamp, 0, THEME_DEFAULT, "", fmt_msg->str, NULL);
+    _win_print_appended(window);
     inp_nonblocking(TRUE);
     g_date_time_unref(timestamp);
 
@@ -1245,7 +1514,7 @@ win_append(ProfWin *window, theme_item_t theme_item, const char *const message,
 
     buffer_append(window->layout->buffer, '-', 0, timestamp, NO_DATE | NO_EOL, theme_item, "", fmt_msg->str, NULL, NULL);
 
-    _win_print(window, '-', 0, timestamp, NO_DATE | NO_EOL, theme_item, "", fmt_msg->str, NULL);
+    _win_print_appended(window);
     inp_nonblocking(TRUE);
     g_date_time_unref(timestamp);
 
@@ -1265,7 +1534,7 @@ win_appendln(ProfWin *window, theme_item_t theme_item, const char *const message
 
     buffer_append(window->layout->buffer, '-', 0, timestamp, NO_DATE, theme_item, "", fmt_msg->str, NULL, NULL);
 
-    _win_print(window, '-', 0, timestamp, NO_DATE, theme_item, "", fmt_msg->str, NULL);
+    _win_print_appended(window);
     inp_nonblocking(TRUE);
     g_date_time_unref(timestamp);
 
@@ -1285,7 +1554,7 @@ win_append_highlight(ProfWin *window, theme_item_t theme_item, const char *const
 
     buffer_append(window->layout->buffer, '-', 0, timestamp, NO_DATE | NO_ME | NO_EOL, theme_item, "", fmt_msg->str, NULL, NULL);
 
-    _win_print(window, '-', 0, timestamp, NO_DATE | NO_ME | NO_EOL, theme_item, "", fmt_msg->str, NULL);
+    _win_print_appended(window);
     inp_nonblocking(TRUE);
     g_date_time_unref(timestamp);
 
@@ -1305,7 +1574,7 @@ win_appendln_highlight(ProfWin *window, theme_item_t theme_item, const char *con
 
     buffer_append(window->layout->buffer, '-', 0, timestamp, NO_DATE | NO_ME, theme_item, "", fmt_msg->str, NULL, NULL);
 
-    _win_print(window, '-', 0, timestamp, NO_DATE | NO_ME, theme_item, "", fmt_msg->str, NULL);
+    _win_print_appended(window);
     inp_nonblocking(TRUE);
     g_date_time_unref(timestamp);
 
@@ -1328,7 +1597,7 @@ win_print_with_receipt(ProfWin *window, const char show_char, const char *const
     receipt->received = FALSE;
 
     buffer_append(window->layout->buffer, show_char, 0, time, 0, THEME_TEXT_ME, from, message, receipt, id);
-    _win_print(window, show_char, 0, time, 0, THEME_TEXT_ME, from, message, receipt);
+    _win_print_appended(window);
     // TODO: cross-reference.. this should be replaced by a real event-based system
     inp_nonblocking(TRUE);
     g_date_time_unref(time);
@@ -1346,10 +1615,7 @@ win_mark_received(ProfWin *window, const char *const id)
 void
 win_update_entry_message(ProfWin *window, const char *const id, const char *const message)
 {
-    ProfBuffEntry *entry = buffer_get_entry_by_id(window->layout->buffer, id);
-    if (entry) {
-        free(entry->message);
-        entry->message = strdup(message);
+    if (buffer_update_entry_message(window->layout->buffer, id, message)) {
         win_redraw(window);
     }
 }
@@ -1384,7 +1650,7 @@ _win_printf(ProfWin *window, const char show_char, int pad_indent, GDateTime *ti
 
     buffer_append(window->layout->buffer, show_char, pad_indent, timestamp, flags, theme_item, from, fmt_msg->str, NULL, NULL);
 
-    _win_print(window, show_char, pad_indent, timestamp, flags, theme_item, from, fmt_msg->str, NULL);
+    _win_print_appended(window);
     inp_nonblocking(TRUE);
     g_date_time_unref(timestamp);
 
@@ -1394,7 +1660,8 @@ _win_printf(ProfWin *window, const char show_char, int pad_indent, GDateTime *ti
 
 static void
 _win_print(ProfWin *window, const char show_char, int pad_indent, GDateTime *time,
-    int flags, theme_item_t theme_item, const char *const from, const char *const message, DeliveryReceipt *receipt)
+    int flags, theme_item_t theme_item, const char *const from, const char *const message, DeliveryReceipt *receipt,
+    ProfBuffLayout **layout)
 {
     // flags : 1st bit =  0/1 - me/not me
     //         2nd bit =  0/1 - date/no date
@@ -1402,30 +1669,31 @@ _win_print(ProfWin *window, const char show_char, int pad_indent, GDateTime *tim
     //         4th bit =  0/1 - color from/no color from
     //         5th bit =  0/1 - color date/no date
     //         6th bit =  0/1 - trusted/untrusted
+
     gboolean me_message = FALSE;
     int offset = 0;
     int colour = theme_attrs(THEME_ME);
     size_t indent = 0;
 
-    char *time_pref = NULL;
+    const char *time_pref = NULL;
     switch (window->type) {
         case WIN_CHAT:
-            time_pref = prefs_get_string(PREF_TIME_CHAT);
+            time_pref = prefs_get_string_cached(PREF_TIME_CHAT);
             break;
         case WIN_MUC:
-            time_pref = prefs_get_string(PREF_TIME_MUC);
+            time_pref = prefs_get_string_cached(PREF_TIME_MUC);
             break;
         case WIN_CONFIG:
-            time_pref = prefs_get_string(PREF_TIME_CONFIG);
+            time_pref = prefs_get_string_cached(PREF_TIME_CONFIG);
             break;
         case WIN_PRIVATE:
-            time_pref = prefs_get_string(PREF_TIME_PRIVATE);
+            time_pref = prefs_get_string_cached(PREF_TIME_PRIVATE);
             break;
         case WIN_XML:
-            time_pref = prefs_get_string(PREF_TIME_XMLCONSOLE);
+            time_pref = prefs_get_string_cached(PREF_TIME_XMLCONSOLE);
             break;
         default:
-            time_pref = prefs_get_string(PREF_TIME_CONSOLE);
+            time_pref = prefs_get_string_cached(PREF_TIME_CONSOLE);
             break;
     }
 
@@ -1435,7 +1703,6 @@ _win_print(ProfWin *window, const char show_char, int pad_indent, GDateTime *tim
     } else {
         date_fmt = g_date_time_format(time, time_pref);
     }
-    prefs_free_string(time_pref);
     assert(date_fmt != NULL);
 
     if(strlen(date_fmt) != 0){
@@ -1460,11 +1727,10 @@ _win_print(ProfWin *window, const char show_char, int pad_indent, GDateTime *tim
             colour = theme_attrs(THEME_THEM);
         }
 
-        char *color_pref = prefs_get_string(PREF_COLOR_NICK);
+        const char *color_pref = prefs_get_string_cached(PREF_COLOR_NICK);
         if (color_pref != NULL && (strcmp(color_pref, "false") != 0)) {
             colour = theme_hash_attrs(from);
         }
-        prefs_free_string(color_pref);
 
         if (flags & NO_COLOUR_FROM) {
             colour = 0;
@@ -1500,7 +1766,7 @@ _win_print(ProfWin *window, const char show_char, int pad_indent, GDateTime *tim
     }
 
     if (prefs_get_boolean(PREF_WRAP)) {
-        _win_print_wrapped(window->layout->win, message+offset, indent, pad_indent);
+        _win_print_wrapped(window->layout->win, message+offset, indent, pad_indent, layout);
     } else {
         wprintw(window->layout->win, "%s", message+offset);
     }
@@ -1528,126 +1794,260 @@ _win_print(ProfWin *window, const char show_char, int pad_indent, GDateTime *tim
 static void
 _win_indent(WINDOW *win, int size)
 {
-    int i = 0;
-    for (i = 0; i < size; i++) {
-        waddch(win, ' ');
+    static const char spaces[] = "                                ";
+
+    while (size > 0) {
+        int n = MIN(size, (int)sizeof(spaces) - 1);
+        waddnstr(win, spaces, n);
+        size -= n;
+    }
+}
+
+/*
+ * Print message wrapped at word boundaries, continuation lines indented
+ * by indent + pad_indent. When layout is given, the wrapping computed for
+ * this width and position is kept there and reused on later redraws.
+ */
+static void
+_win_print_wrapped(WINDOW *win, const char *const message, size_t indent, int pad_indent, ProfBuffLayout **layout)
+{
+    int width = getmaxx(win);
+    int startx = getcurx(win);
+
+    // lines without a buffer entry are printed straight from the reused operations
+    if (layout == NULL) {
+        ProfLayoutCursor cursor = { startx, 0, MAX(width, 1), NULL };
+        _win_layout_ops(&cursor, message, indent, pad_indent);
+        _win_print_layout(win, message, (ProfLayoutOp*)cursor.ops->data, cursor.ops->len);
+        return;
+    }
+
+    ProfBuffLayout *cached = *layout;
+    if (cached == NULL || cached->width != width || cached->startx != startx || cached->indent != (int)indent
+            || cached->pad_indent != pad_indent) {
+        free(cached);
+        cached = _win_layout(message, width, startx, indent, pad_indent);
+        *layout = cached;
+    }
+
+    _win_print_layout(win, message, cached->ops, cached->n_ops);
+}
+
+static void
+_layout_advance(ProfLayoutCursor *cursor, int cols)
+{
+    cursor->x += cols;
+    if (cursor->x >= cursor->width) {
+        cursor->y += cursor->x / cursor->width;
+        cursor->x = cursor->x % cursor->width;
+    }
+}
+
+// curses puts a character that does not fit in the rest of the line at the
+// start of the next one
+static void
+_layout_advance_char(ProfLayoutCursor *cursor, int cols)
+{
+    if (cursor->x > 0 && cursor->x + cols > cursor->width) {
+        cursor->y++;
+        cursor->x = 0;
+    }
+    _layout_advance(cursor, cols);
+}
+
+static void
+_layout_op(ProfLayoutCursor *cursor, int offset, layout_op_t op, int n)
+{
+    ProfLayoutOp layout_op = { offset, op, n };
+    g_array_append_val(cursor->ops, layout_op);
+
+    if (op == LAYOUT_NEWLINE) {
+        cursor->x = 0;
+        cursor->y++;
+    }
+    if (op != LAYOUT_SKIP) {
+        _layout_advance(cursor, n);
     }
 }
 
+// indent a word about to be printed when the cursor is left of the margin
 static void
-_win_print_wrapped(WINDOW *win, const char *const message, size_t indent, int pad_indent)
+_layout_indent(ProfLayoutCursor *cursor, int offset, int indent, int pad_indent)
+{
+    gboolean firstline = cursor->y == 0;
+    if (firstline && cursor->x < indent) {
+        _layout_op(cursor, offset, LAYOUT_INDENT, indent);
+    }
+    if (!firstline && cursor->x < (indent + pad_indent)) {
+        _layout_op(cursor, offset, LAYOUT_INDENT, indent + pad_indent);
+    }
+}
+
+static int
+_layout_char_width(const char *const ch)
 {
-    int starty = getcury(win);
-    int wordi = 0;
-    char *word = malloc(strlen(message) + 1);
+    return g_unichar_iswide(g_utf8_get_char(ch)) ? 2 : 1;
+}
 
-    gchar *curr_ch = g_utf8_offset_to_pointer(message, 0);
+// bytes that are not a complete character are left out when printing
+static gboolean
+_layout_valid_char(const char *const ch)
+{
+    size_t ch_len = mbrlen(ch, MB_CUR_MAX, NULL);
+    return ch_len != (size_t)-2 && ch_len != (size_t)-1;
+}
+
+static void
+_layout_skip_invalid(ProfLayoutCursor *cursor, const char *const message, const char *word, const char *const word_end)
+{
+    while (word < word_end) {
+        if (!_layout_valid_char(word)) {
+            _layout_op(cursor, word - message, LAYOUT_SKIP, 1);
+            word++;
+        } else {
+            word = g_utf8_next_char(word);
+        }
+    }
+}
+
+/*
+ * Work out where message wraps without touching curses, tracking the
+ * cursor the way printing word by word into a window of width columns
+ * starting at column startx would move it.
+ */
+static ProfBuffLayout*
+_win_layout(const char *const message, int width, int startx, int indent, int pad_indent)
+{
+    ProfLayoutCursor cursor = { startx, 0, MAX(width, 1), NULL };
+    _win_layout_ops(&cursor, message, indent, pad_indent);
+
+    ProfBuffLayout *layout = malloc(sizeof(ProfBuffLayout) + cursor.ops->len * sizeof(ProfLayoutOp));
+    layout->width = width;
+    layout->startx = startx;
+    layout->indent = indent;
+    layout->pad_indent = pad_indent;
+    layout->lines = cursor.y;
+    layout->endx = cursor.x;
+    layout->n_ops = cursor.ops->len;
+    memcpy(layout->ops, cursor.ops->data, cursor.ops->len * sizeof(ProfLayoutOp));
+
+    return layout;
+}
+
+// move the cursor through message, leaving the operations in layout_ops
+static void
+_win_layout_ops(ProfLayoutCursor *cursor, const char *const message, int indent, int pad_indent)
+{
+    if (layout_ops == NULL) {
+        layout_ops = g_array_new(FALSE, FALSE, sizeof(ProfLayoutOp));
+    }
+    g_array_set_size(layout_ops, 0);
+    cursor->ops = layout_ops;
+
+    const gchar *curr_ch = message;
 
     while (*curr_ch != '\0') {
 
         // handle space
         if (*curr_ch == ' ') {
-            waddch(win, ' ');
+            _layout_advance(cursor, 1);
             curr_ch = g_utf8_next_char(curr_ch);
 
         // handle newline
         } else if (*curr_ch == '\n') {
-            waddch(win, '\n');
-            _win_indent(win, indent + pad_indent);
             curr_ch = g_utf8_next_char(curr_ch);
+            cursor->x = 0;
+            cursor->y++;
+            _layout_op(cursor, curr_ch - message, LAYOUT_INDENT, indent + pad_indent);
 
         // handle word
         } else {
-            wordi = 0;
+            const gchar *word = curr_ch;
             int wordlen = 0;
             while (*curr_ch != ' ' && *curr_ch != '\n' && *curr_ch != '\0') {
-                size_t ch_len = mbrlen(curr_ch, MB_CUR_MAX, NULL);
-                if ((ch_len == (size_t)-2) || (ch_len == (size_t)-1)) {
+                if (!_layout_valid_char(curr_ch)) {
                     curr_ch++;
                     continue;
                 }
-                int offset = 0;
-                while (offset < ch_len) {
-                    word[wordi++] = curr_ch[offset++];
-                }
+                wordlen += _layout_char_width(curr_ch);
                 curr_ch = g_utf8_next_char(curr_ch);
             }
-            word[wordi] = '\0';
-            wordlen = utf8_display_len(word);
-
-            int curx = getcurx(win);
-            int cury;
-            int maxx = getmaxx(win);
+            const gchar *word_end = curr_ch;
 
             // wrap required
-            if (curx + wordlen > maxx) {
-                int linelen = maxx - (indent + pad_indent);
+            if (cursor->x + wordlen > cursor->width) {
+                int linelen = cursor->width - (indent + pad_indent);
 
-                // word larger than line
+                // word larger than line, printed a character at a time
                 if (wordlen > linelen) {
-                    gchar *word_ch = g_utf8_offset_to_pointer(word, 0);
-                    while(*word_ch != '\0') {
-                        curx = getcurx(win);
-                        cury = getcury(win);
-                        gboolean firstline = cury == starty;
-
-                        if (firstline && curx < indent) {
-                            _win_indent(win, indent);
+                    const gchar *word_ch = word;
+                    while (word_ch < word_end) {
+                        if (!_layout_valid_char(word_ch)) {
+                            _layout_op(cursor, word_ch - message, LAYOUT_SKIP, 1);
+                            word_ch++;
+                            continue;
                         }
-                        if (!firstline && curx < (indent + pad_indent)) {
-                            _win_indent(win, indent + pad_indent);
-                        }
-
-                        gchar copy[wordi+1];
-                        g_utf8_strncpy(copy, word_ch, 1);
-                        waddstr(win, copy);
-
+                        _layout_indent(cursor, word_ch - message, indent, pad_indent);
+                        _layout_advance_char(cursor, _layout_char_width(word_ch));
                         word_ch = g_utf8_next_char(word_ch);
                     }
 
                 // newline and print word
                 } else {
-                    waddch(win, '\n');
-                    curx = getcurx(win);
-                    cury = getcury(win);
-                    gboolean firstline = cury == starty;
-
-                    if (firstline && curx < indent) {
-                        _win_indent(win, indent);
-                    }
-                    if (!firstline && curx < (indent + pad_indent)) {
-                        _win_indent(win, indent + pad_indent);
-                    }
-                    waddstr(win, word);
+                    _layout_op(cursor, word - message, LAYOUT_NEWLINE, 0);
+                    _layout_indent(cursor, word - message, indent, pad_indent);
+                    _layout_skip_invalid(cursor, message, word, word_end);
+                    _layout_advance(cursor, wordlen);
                 }
 
             // no wrap required
             } else {
-                curx = getcurx(win);
-                cury = getcury(win);
-                gboolean firstline = cury == starty;
-
-                if (firstline && curx < indent) {
-                    _win_indent(win, indent);
-                }
-                if (!firstline && curx < (indent + pad_indent)) {
-                    _win_indent(win, indent + pad_indent);
-                }
-                waddstr(win, word);
+                _layout_indent(cursor, word - message, indent, pad_indent);
+                _layout_skip_invalid(cursor, message, word, word_end);
+                _layout_advance(cursor, wordlen);
             }
         }
 
         // consume first space of next line
-        int curx = getcurx(win);
-        int cury = getcury(win);
-        gboolean firstline = (cury == starty);
-
-        if (!firstline && curx == 0 && *curr_ch == ' ') {
+        if (cursor->y != 0 && cursor->x == 0 && *curr_ch == ' ') {
+            _layout_op(cursor, curr_ch - message, LAYOUT_SKIP, 1);
             curr_ch = g_utf8_next_char(curr_ch);
         }
     }
+}
+
+// print message in runs between the layout's operations
+static void
+_win_print_layout(WINDOW *win, const char *const message, ProfLayoutOp *ops, int n_ops)
+{
+    const char *pos = message;
+    int i = 0;
+
+    for (i = 0; i < n_ops; i++) {
+        ProfLayoutOp *op = &ops[i];
+        const char *at = message + op->offset;
+        if (at > pos) {
+            waddnstr(win, pos, at - pos);
+            pos = at;
+        }
 
-    free(word);
+        switch (op->op) {
+            case LAYOUT_NEWLINE:
+                waddch(win, '\n');
+                _win_indent(win, op->n);
+                break;
+            case LAYOUT_INDENT:
+                _win_indent(win, op->n);
+                break;
+            case LAYOUT_SKIP:
+                pos += op->n;
+                break;
+        }
+    }
+
+    if (*pos != '\0') {
+        waddstr(win, pos);
+    }
 }
 
 void
@@ -1662,24 +2062,283 @@ win_print_separator(ProfWin *window)
     wprintw(window->layout->win, "\n");
 }
 
-void
-win_redraw(ProfWin *window)
+// resident is FALSE for entries read back from the scrollback file, which are
+// not counted against the memory budget
+static void
+_win_redraw_entry(ProfWin *window, ProfBuffEntry *e, gboolean resident)
+{
+    if (e->from == NULL && e->message && e->message[0] == '-') {
+        // just an indicator to print the separator not the actual message
+        win_print_separator(window);
+    } else {
+        // regular thing to print
+        _win_print(window, e->show_char, e->pad_indent, e->time, e->flags, e->theme_item, e->from, e->message, e->receipt,
+            &e->layout);
+        if (resident) {
+            buffer_set_layout_bytes(window->layout->buffer, e, _win_layout_bytes(e->layout));
+        }
+    }
+}
+
+// print the entry just added to the buffer, keeping its layout for redraws
+static void
+_win_print_appended(ProfWin *window)
+{
+    ProfBuff buffer = window->layout->buffer;
+
+    // new entries are not drawn while the pad stops short of the newest
+    // ones, and stop it when it fills while paging
+    if (window->layout->draw_end >= 0) {
+        return;
+    }
+    WINDOW *win = window->layout->win;
+    if (window->layout->paged && getcury(win) >= getmaxy(win) - 1) {
+        _win_draw_sync(window);
+        window->layout->draw_end = buffer_spilled_size(buffer) + buffer_size(buffer) - 1;
+        return;
+    }
+
+    ProfBuffEntry *e = buffer_get_entry(buffer, buffer_size(buffer) - 1);
+    _win_print(window, e->show_char, e->pad_indent, e->time, e->flags, e->theme_item, e->from, e->message, e->receipt,
+        &e->layout);
+    buffer_set_layout_bytes(buffer, e, _win_layout_bytes(e->layout));
+
+    // following the end, draw the last screens again once the pad fills
+    // rather than let older lines scroll off its top
+    if (!window->layout->paged && getcury(win) >= getmaxy(win) - 1) {
+        _win_redraw_tail(window);
+    }
+}
+
+static gsize
+_win_layout_bytes(ProfBuffLayout *layout)
+{
+    if (layout == NULL) {
+        return 0;
+    }
+
+    return sizeof(ProfBuffLayout) + layout->n_ops * sizeof(ProfLayoutOp);
+}
+
+// redraw the pad from the draw_from position until the pad is full
+// returns the pad row at which the mark'th drawn entry starts
+static int
+_win_redraw_from(ProfWin *window, int mark)
 {
-    int i, size;
+    ProfBuff buffer = window->layout->buffer;
+    int spilled = buffer_spilled_size(buffer);
+    int total = spilled + buffer_size(buffer);
+    int mark_y = 0;
+    int i;
+
+    _win_draw_sync(window);
+    int draw_from = CLAMP(window->layout->draw_from, 0, total);
+    window->layout->draw_from = draw_from;
+    window->layout->draw_end = -1;
+
     werase(window->layout->win);
-    size = buffer_size(window->layout->buffer);
 
-    for (i = 0; i < size; i++) {
-        ProfBuffEntry *e = buffer_get_entry(window->layout->buffer, i);
+    for (i = draw_from; i < total; i++) {
+        // while paging keep the start visible rather than scrolling the pad,
+        // the rest is drawn when paging down reaches it
+        if (window->layout->paged && getcury(window->layout->win) >= getmaxy(window->layout->win) - 1) {
+            window->layout->draw_end = i;
+            return mark_y;
+        }
+        if (i - draw_from == mark) {
+            mark_y = getcury(window->layout->win);
+        }
 
-        if (e->from == NULL && e->message && e->message[0] == '-') {
-            // just an indicator to print the separator not the actual message
-            win_print_separator(window);
+        if (i < spilled) {
+            ProfBuffEntry *e = buffer_get_spilled_entry(buffer, i);
+            if (e) {
+                _win_redraw_entry(window, e, FALSE);
+                buffer_free_spilled_entry(e);
+            }
         } else {
-            // regular thing to print
-            _win_print(window, e->show_char, e->pad_indent, e->time, e->flags, e->theme_item, e->from, e->message, e->receipt);
+            _win_redraw_entry(window, buffer_get_entry(buffer, i - spilled), TRUE);
+        }
+    }
+
+    return mark_y;
+}
+
+// draw the last screens of the buffer to follow its end
+static void
+_win_redraw_tail(ProfWin *window)
+{
+    _win_draw_sync(window);
+    window->layout->draw_from = _win_tail_start(window);
+    _win_redraw_from(window, 0);
+
+    // entries not laid out at this width were counted as a row each and may
+    // have scrolled the pad, they are laid out now so the tail start is exact
+    WINDOW *win = window->layout->win;
+    if (getcury(win) >= getmaxy(win) - 1) {
+        window->layout->draw_from = _win_tail_start(window);
+        _win_redraw_from(window, 0);
+    }
+}
+
+// rows of a window's pad, enough for the drawn tail and a page either side
+static int
+_win_pad_rows(void)
+{
+    return PAD_SCREENS * getmaxy(stdscr);
+}
+
+// move the pad's entries down to continue from draw_end, keeping about a
+// page above it so paging back up needs no redraw
+static void
+_win_slide_down(ProfWin *window, int page_space)
+{
+    ProfBuff buffer = window->layout->buffer;
+    int spilled = buffer_spilled_size(buffer);
+    int width = getmaxx(window->layout->win);
+    int prev_from = window->layout->draw_from;
+    int prev_end = window->layout->draw_end;
+
+    int from = prev_end;
+    int rows = 0;
+    while (from > prev_from + 1 && rows < page_space) {
+        from--;
+        // spilled entries are not laid out, count them as a row each
+        rows += from < spilled ? 1 : _win_entry_rows(buffer_get_entry(buffer, from - spilled), width);
+    }
+    from = _win_line_start(buffer, from);
+    if (from <= prev_from) {
+        from = prev_end;
+    }
+
+    window->layout->draw_from = from;
+    int mark_y = _win_redraw_from(window, prev_end - from);
+
+    int y = getcury(window->layout->win);
+    window->layout->y_pos = MIN(mark_y, MAX(y - page_space, 0));
+}
+
+// shift the drawn positions by the entries dropped from the front of the
+// buffer since they were taken
+static void
+_win_draw_sync(ProfWin *window)
+{
+    ProfLayout *layout = window->layout;
+    int shift = buffer_origin(layout->buffer) - layout->draw_origin;
+    if (shift == 0) {
+        return;
+    }
+
+    layout->draw_from = MAX(layout->draw_from - shift, 0);
+    if (layout->draw_end >= 0) {
+        layout->draw_end = MAX(layout->draw_end - shift, 0);
+    }
+    layout->draw_origin += shift;
+}
+
+// position to draw from for the last two screens of the buffer
+static int
+_win_tail_start(ProfWin *window)
+{
+    ProfBuff buffer = window->layout->buffer;
+    int needed = 2 * getmaxy(stdscr);
+    int width = getmaxx(window->layout->win);
+    int rows = 0;
+
+    int i = buffer_size(buffer);
+    while (i > 0 && rows < needed) {
+        i--;
+        rows += _win_entry_rows(buffer_get_entry(buffer, i), width);
+    }
+
+    return _win_line_start(buffer, buffer_spilled_size(buffer) + i);
+}
+
+// move back to the position of the entry starting the line pos is printed on
+static int
+_win_line_start(ProfBuff buffer, int pos)
+{
+    while (pos > 0 && (_win_entry_flags(buffer, pos - 1) & NO_EOL)) {
+        pos--;
+    }
+
+    return pos;
+}
+
+static int
+_win_entry_flags(ProfBuff buffer, int pos)
+{
+    int spilled = buffer_spilled_size(buffer);
+    if (pos >= spilled) {
+        return buffer_get_entry(buffer, pos - spilled)->flags;
+    }
+
+    ProfBuffEntry *e = buffer_get_spilled_entry(buffer, pos);
+    if (!e) {
+        return 0;
+    }
+    int flags = e->flags;
+    buffer_free_spilled_entry(e);
+
+    return flags;
+}
+
+// rows an entry takes at width, one when it has not been laid out at that width
+static int
+_win_entry_rows(ProfBuffEntry *entry, int width)
+{
+    if (entry->flags & NO_EOL) {
+        return 0;
+    }
+
+    ProfBuffLayout *layout = entry->layout;
+    if (layout == NULL || layout->width != width) {
+        return 1;
+    }
+
+    // a message ending on the last column leaves the cursor on the next row
+    return layout->endx > 0 ? layout->lines + 1 : layout->lines;
+}
+
+// prepend up to count older chat log entries to the buffer, returns how many were added
+static int
+_win_load_history(ProfChatWin *chatwin, int count)
+{
+    if (!chat_log_history_has_more(chatwin->history)) {
+        return 0;
+    }
+
+    ProfBuff buffer = chatwin->window.layout->buffer;
+    GSList *entries = g_slist_reverse(chat_log_history_previous(chatwin->history, count));
+    int loaded = 0;
+
+    // newest first, so the oldest entry ends up at the top
+    GSList *curr = entries;
+    while (curr) {
+        ProfHistoryEntry *entry = curr->data;
+        if (!buffer_prepend(buffer, '-', 0, entry->timestamp, 0, THEME_TEXT_HISTORY, "", entry->message)) {
+            // buffer is full, older history can not be shown
+            chat_log_history_free(chatwin->history);
+            chatwin->history = NULL;
+            break;
         }
+        loaded++;
+        curr = g_slist_next(curr);
     }
+    chat_log_history_free_entries(entries);
+
+    return loaded;
+}
+
+void
+win_redraw(ProfWin *window)
+{
+    // when following the end only the last entries are drawn, paging up
+    // draws the ones above as they are needed
+    if (!window->layout->paged) {
+        _win_redraw_tail(window);
+        return;
+    }
+    _win_redraw_from(window, 0);
 }
 
 gboolean
@@ -1759,7 +2418,7 @@ win_sub_print(WINDOW *win, char *msg, gboolean newline, gboolean wrap, int inden
     int cury = getcury(win);
 
     if (wrap) {
-        _win_print_wrapped(win, msg, 1, indent);
+        _win_print_wrapped(win, msg, 1, indent, NULL);
     } else {
         waddnstr(win, msg, maxx - curx);
     }
@@ -1839,18 +2498,9 @@ win_handle_command_exec_result_note(ProfWin *window, const char *const type, con
 void
 win_insert_last_read_position_marker(ProfWin *window, char* id)
 {
-    int i, size;
-    size = buffer_size(window->layout->buffer);
-
-    // TODO: this is somewhat costly. We should improve this later.
-    // check if we already have a separator present
-    for (i = 0; i < size; i++) {
-        ProfBuffEntry *e = buffer_get_entry(window->layout->buffer, i);
-
-        // if yes, don't print a new one
-        if (e->id && (g_strcmp0(e->id, id) == 0)) {
-            return;
-        }
+    // check if we already have a separator present, if yes, don't print a new one
+    if (buffer_get_entry_by_id(window->layout->buffer, id)) {
+        return;
     }
 
     GDateTime *time = g_date_time_new_now_local();
@@ -1864,3 +2514,16 @@ win_insert_last_read_position_marker(ProfWin *window, char* id)
     g_date_time_unref(time);
 }
 
+static gboolean
+_win_viewport_touched(WINDOW *pad, int y_pos, int rows)
+{
+    int y = y_pos < 0 ? 0 : y_pos;
+    int last = MIN(y_pos + rows, getmaxy(pad));
+    for (; y < last; y++) {
+        if (is_linetouched(pad, y)) {
+            return TRUE;
+        }
+    }
+
+    return FALSE;
+}
@@ -53,7 +53,10 @@
 #include "xmpp/contact.h"
 #include "xmpp/muc.h"
 
+// rows of the roster and occupants pads
 #define PAD_SIZE 1000
+// screens of rows in a window's pad, the drawn part of its buffer moves through them
+#define PAD_SCREENS 4
 
 void win_move_to_end(ProfWin *window);
 void win_show_status_string(ProfWin *window, const char *const from,
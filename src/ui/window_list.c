@@ -56,14 +56,30 @@ static int current;
 static Autocomplete wins_ac;
 static Autocomplete wins_close_ac;
 
+// lookup indexes by identifier, values are borrowed from windows
+static GHashTable *chats_by_barejid;
+static GHashTable *mucs_by_roomjid;
+static GHashTable *confs_by_roomjid;
+static GHashTable *privates_by_fulljid;
+static GHashTable *plugins_by_tag;
+
 static int _wins_cmp_num(gconstpointer a, gconstpointer b);
 static int _wins_get_next_available_num(GList *used);
+static GHashTable* _wins_index(ProfWin *window, const char **key);
+static void _wins_index_add(ProfWin *window);
+static void _wins_index_remove(ProfWin *window);
 
 void
 wins_init(void)
 {
     windows = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, (GDestroyNotify)win_free);
 
+    chats_by_barejid = g_hash_table_new_full(g_str_hash, g_str_equal, free, NULL);
+    mucs_by_roomjid = g_hash_table_new_full(g_str_hash, g_str_equal, free, NULL);
+    confs_by_roomjid = g_hash_table_new_full(g_str_hash, g_str_equal, free, NULL);
+    privates_by_fulljid = g_hash_table_new_full(g_str_hash, g_str_equal, free, NULL);
+    plugins_by_tag = g_hash_table_new_full(g_str_hash, g_str_equal, free, NULL);
+
     ProfWin *console = win_create_console();
     g_hash_table_insert(windows, GINT_TO_POINTER(1), console);
 
@@ -93,23 +109,11 @@ wins_chat_exists(const char *const barejid)
 ProfChatWin*
 wins_get_chat(const char *const barejid)
 {
-    GList *values = g_hash_table_get_values(windows);
-    GList *curr = values;
-
-    while (curr) {
-        ProfWin *window = curr->data;
-        if (window->type == WIN_CHAT) {
-            ProfChatWin *chatwin = (ProfChatWin*)window;
-            if (g_strcmp0(chatwin->barejid, barejid) == 0) {
-                g_list_free(values);
-                return chatwin;
-            }
-        }
-        curr = g_list_next(curr);
+    if (barejid == NULL) {
+        return NULL;
     }
 
-    g_list_free(values);
-    return NULL;
+    return g_hash_table_lookup(chats_by_barejid, barejid);
 }
 
 static gint
@@ -144,89 +148,41 @@ wins_get_chat_unsubscribed(void)
 ProfConfWin*
 wins_get_conf(const char *const roomjid)
 {
-    GList *values = g_hash_table_get_values(windows);
-    GList *curr = values;
-
-    while (curr) {
-        ProfWin *window = curr->data;
-        if (window->type == WIN_CONFIG) {
-            ProfConfWin *confwin = (ProfConfWin*)window;
-            if (g_strcmp0(confwin->roomjid, roomjid) == 0) {
-                g_list_free(values);
-                return confwin;
-            }
-        }
-        curr = g_list_next(curr);
+    if (roomjid == NULL) {
+        return NULL;
     }
 
-    g_list_free(values);
-    return NULL;
+    return g_hash_table_lookup(confs_by_roomjid, roomjid);
 }
 
 ProfMucWin*
 wins_get_muc(const char *const roomjid)
 {
-    GList *values = g_hash_table_get_values(windows);
-    GList *curr = values;
-
-    while (curr) {
-        ProfWin *window = curr->data;
-        if (window->type == WIN_MUC) {
-            ProfMucWin *mucwin = (ProfMucWin*)window;
-            if (g_strcmp0(mucwin->roomjid, roomjid) == 0) {
-                g_list_free(values);
-                return mucwin;
-            }
-        }
-        curr = g_list_next(curr);
+    if (roomjid == NULL) {
+        return NULL;
     }
 
-    g_list_free(values);
-    return NULL;
+    return g_hash_table_lookup(mucs_by_roomjid, roomjid);
 }
 
 ProfPrivateWin*
 wins_get_private(const char *const fulljid)
 {
-    GList *values = g_hash_table_get_values(windows);
-    GList *curr = values;
-
-    while (curr) {
-        ProfWin *window = curr->data;
-        if (window->type == WIN_PRIVATE) {
-            ProfPrivateWin *privatewin = (ProfPrivateWin*)window;
-            if (g_strcmp0(privatewin->fulljid, fulljid) == 0) {
-                g_list_free(values);
-                return privatewin;
-            }
-        }
-        curr = g_list_next(curr);
+    if (fulljid == NULL) {
+        return NULL;
     }
 
-    g_list_free(values);
-    return NULL;
+    return g_hash_table_lookup(privates_by_fulljid, fulljid);
 }
 
 ProfPluginWin*
 wins_get_plugin(const char *const tag)
 {
-    GList *values = g_hash_table_get_values(windows);
-    GList *curr = values;
-
-    while (curr) {
-        ProfWin *window = curr->data;
-        if (window->type == WIN_PLUGIN) {
-            ProfPluginWin *pluginwin = (ProfPluginWin*)window;
-            if (g_strcmp0(pluginwin->tag, tag) == 0) {
-                g_list_free(values);
-                return pluginwin;
-            }
-        }
-        curr = g_list_next(curr);
+    if (tag == NULL) {
+        return NULL;
     }
 
-    g_list_free(values);
-    return NULL;
+    return g_hash_table_lookup(plugins_by_tag, tag);
 }
 
 void
@@ -249,16 +205,13 @@ wins_get_private_chats(const char *const roomjid)
     GList *result = NULL;
     GString *prefix = g_string_new(roomjid);
     g_string_append(prefix, "/");
-    GList *values = g_hash_table_get_values(windows);
+    GList *values = g_hash_table_get_values(privates_by_fulljid);
     GList *curr = values;
 
     while (curr) {
-        ProfWin *window = curr->data;
-        if (window->type == WIN_PRIVATE) {
-            ProfPrivateWin *privatewin = (ProfPrivateWin*)window;
-            if (roomjid == NULL || g_str_has_prefix(privatewin->fulljid, prefix->str)) {
-                result = g_list_append(result, privatewin);
-            }
+        ProfPrivateWin *privatewin = curr->data;
+        if (roomjid == NULL || g_str_has_prefix(privatewin->fulljid, prefix->str)) {
+            result = g_list_append(result, privatewin);
         }
         curr = g_list_next(curr);
     }
@@ -275,10 +228,12 @@ wins_private_nick_change(const char *const roomjid, const char *const oldnick, c
 
     ProfPrivateWin *privwin = wins_get_private(oldjid->fulljid);
     if (privwin) {
+        _wins_index_remove((ProfWin*)privwin);
         free(privwin->fulljid);
 
         Jid *newjid = jid_create_from_bare_and_resource(roomjid, newnick);
         privwin->fulljid = strdup(newjid->fulljid);
+        _wins_index_add((ProfWin*)privwin);
         win_println((ProfWin*)privwin, THEME_THEM, '!', "** %s is now known as %s.", oldjid->resourcepart, newjid->resourcepart);
 
         autocomplete_remove(wins_ac, oldjid->fulljid);
@@ -378,6 +333,11 @@ wins_get_by_string(const char *str)
             return (ProfWin*)xmlwin;
     }
 
+    if (g_strcmp0(str, "search") == 0) {
+        ProfSearchWin *searchwin = wins_get_search();
+        return (ProfWin*)searchwin;
+    }
+
     ProfChatWin *chatwin = wins_get_chat(str);
     if (chatwin) {
         return (ProfWin*)chatwin;
@@ -574,6 +534,12 @@ wins_close_by_num(int i)
                 autocomplete_remove(wins_close_ac, "xmlconsole");
                 break;
             }
+            case WIN_SEARCH:
+            {
+                autocomplete_remove(wins_ac, "search");
+                autocomplete_remove(wins_close_ac, "search");
+                break;
+            }
             case WIN_PLUGIN:
             {
                 ProfPluginWin *pluginwin = (ProfPluginWin*)window;
@@ -586,6 +552,8 @@ wins_close_by_num(int i)
             default:
                 break;
             }
+
+            _wins_index_remove(window);
         }
 
         g_hash_table_remove(windows, GINT_TO_POINTER(i));
@@ -618,6 +586,19 @@ wins_new_xmlconsole(void)
     return newwin;
 }
 
+ProfWin*
+wins_new_search(void)
+{
+    GList *keys = g_hash_table_get_keys(windows);
+    int result = _wins_get_next_available_num(keys);
+    g_list_free(keys);
+    ProfWin *newwin = win_create_search();
+    g_hash_table_insert(windows, GINT_TO_POINTER(result), newwin);
+    autocomplete_add(wins_ac, "search");
+    autocomplete_add(wins_close_ac, "search");
+    return newwin;
+}
+
 ProfWin*
 wins_new_chat(const char *const barejid)
 {
@@ -626,6 +607,7 @@ wins_new_chat(const char *const barejid)
     g_list_free(keys);
     ProfWin *newwin = win_create_chat(barejid);
     g_hash_table_insert(windows, GINT_TO_POINTER(result), newwin);
+    _wins_index_add(newwin);
 
     autocomplete_add(wins_ac, barejid);
     autocomplete_add(wins_close_ac, barejid);
@@ -649,6 +631,7 @@ wins_new_muc(const char *const roomjid)
     g_list_free(keys);
     ProfWin *newwin = win_create_muc(roomjid);
     g_hash_table_insert(windows, GINT_TO_POINTER(result), newwin);
+    _wins_index_add(newwin);
     autocomplete_add(wins_ac, roomjid);
     autocomplete_add(wins_close_ac, roomjid);
     return newwin;
@@ -662,6 +645,7 @@ wins_new_config(const char *const roomjid, DataForm *form, ProfConfWinCallback s
     g_list_free(keys);
     ProfWin *newwin = win_create_config(roomjid, form, submit, cancel, userdata);
     g_hash_table_insert(windows, GINT_TO_POINTER(result), newwin);
+    _wins_index_add(newwin);
     return newwin;
 }
 
@@ -673,6 +657,7 @@ wins_new_private(const char *const fulljid)
     g_list_free(keys);
     ProfWin *newwin = win_create_private(fulljid);
     g_hash_table_insert(windows, GINT_TO_POINTER(result), newwin);
+    _wins_index_add(newwin);
     autocomplete_add(wins_ac, fulljid);
     autocomplete_add(wins_close_ac, fulljid);
     return newwin;
@@ -686,6 +671,7 @@ wins_new_plugin(const char *const plugin_name, const char * const tag)
     g_list_free(keys);
     ProfWin *newwin = win_create_plugin(plugin_name, tag);
     g_hash_table_insert(windows, GINT_TO_POINTER(result), newwin);
+    _wins_index_add(newwin);
     autocomplete_add(wins_ac, tag);
     autocomplete_add(wins_close_ac, tag);
     return newwin;
@@ -780,6 +766,27 @@ wins_get_xmlconsole(void)
     return NULL;
 }
 
+ProfSearchWin*
+wins_get_search(void)
+{
+    GList *values = g_hash_table_get_values(windows);
+    GList *curr = values;
+
+    while (curr) {
+        ProfWin *window = curr->data;
+        if (window->type == WIN_SEARCH) {
+            ProfSearchWin *searchwin = (ProfSearchWin*)window;
+            assert(searchwin->memcheck == PROFSEARCHWIN_MEMCHECK);
+            g_list_free(values);
+            return searchwin;
+        }
+        curr = g_list_next(curr);
+    }
+
+    g_list_free(values);
+    return NULL;
+}
+
 GSList*
 wins_get_chat_recipients(void)
 {
@@ -1120,6 +1127,11 @@ void
 wins_destroy(void)
 {
     g_hash_table_destroy(windows);
+    g_hash_table_destroy(chats_by_barejid);
+    g_hash_table_destroy(mucs_by_roomjid);
+    g_hash_table_destroy(confs_by_roomjid);
+    g_hash_table_destroy(privates_by_fulljid);
+    g_hash_table_destroy(plugins_by_tag);
     autocomplete_free(wins_ac);
     autocomplete_free(wins_close_ac);
 }
@@ -1149,3 +1161,50 @@ wins_get_next_unread(void)
     g_list_free(values);
     return NULL;
 }
+
+static GHashTable*
+_wins_index(ProfWin *window, const char **key)
+{
+    switch (window->type) {
+    case WIN_CHAT:
+        *key = ((ProfChatWin*)window)->barejid;
+        return chats_by_barejid;
+    case WIN_MUC:
+        *key = ((ProfMucWin*)window)->roomjid;
+        return mucs_by_roomjid;
+    case WIN_CONFIG:
+        *key = ((ProfConfWin*)window)->roomjid;
+        return confs_by_roomjid;
+    case WIN_PRIVATE:
+        *key = ((ProfPrivateWin*)window)->fulljid;
+        return privates_by_fulljid;
+    case WIN_PLUGIN:
+        *key = ((ProfPluginWin*)window)->tag;
+        return plugins_by_tag;
+    default:
+        *key = NULL;
+        return NULL;
+    }
+}
+
+static void
+_wins_index_add(ProfWin *window)
+{
+    const char *key = NULL;
+    GHashTable *index = _wins_index(window, &key);
+    if (index && key) {
+        g_hash_table_replace(index, strdup(key), window);
+    }
+}
+
+static void
+_wins_index_remove(ProfWin *window)
+{
+    const char *key = NULL;
+    GHashTable *index = _wins_index(window, &key);
+
+    // only drop the entry if it still refers to this window
+    if (index && key && g_hash_table_lookup(index, key) == window) {
+        g_hash_table_remove(index, key);
+    }
+}
@@ -41,6 +41,7 @@
 void wins_init(void);
 
 ProfWin* wins_new_xmlconsole(void);
+ProfWin* wins_new_search(void);
 ProfWin* wins_new_chat(const char *const barejid);
 ProfWin* wins_new_muc(const char *const roomjid);
 ProfWin* wins_new_config(const char *const roomjid, DataForm *form, ProfConfWinCallback submit, ProfConfWinCallback cancel, const void *userdata);
@@ -61,6 +62,7 @@ ProfConfWin* wins_get_conf(const char *const roomjid);
 ProfPrivateWin* wins_get_private(const char *const fulljid);
 ProfPluginWin* wins_get_plugin(const char *const tag);
 ProfXMLWin* wins_get_xmlconsole(void);
+ProfSearchWin* wins_get_search(void);
 
 void wins_close_plugin(char *tag);
 
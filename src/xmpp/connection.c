@@ -60,10 +60,13 @@
 #include "xmpp/session.h"
 #include "xmpp/iq.h"
 
+#define XMPP_DRAIN_RUNS 4
+
 typedef struct prof_conn_t {
     xmpp_log_t *xmpp_log;
     xmpp_ctx_t *xmpp_ctx;
     xmpp_conn_t *xmpp_conn;
+    int xmpp_fd;
     gboolean xmpp_in_event_loop;
     jabber_conn_status_t conn_status;
     xmpp_conn_event_t conn_last_event;
@@ -90,6 +93,10 @@ TLSCertificate* _xmppcert_to_profcert(xmpp_tlscert_t *xmpptlscert);
 static int _connection_certfail_cb(xmpp_tlscert_t *xmpptlscert, const char *const errormsg);
 #endif
 
+#ifdef HAVE_XMPP_CONN_SET_SOCKOPT_CALLBACK
+static int _connection_sockopt_cb(xmpp_conn_t *xmpp_conn, void *sock);
+#endif
+
 static void _random_bytes_init(void);
 static void _random_bytes_close(void);
 static void _compute_identifier(const char *barejid);
@@ -100,6 +107,7 @@ connection_init(void)
     xmpp_initialize();
     conn.xmpp_conn = NULL;
     conn.xmpp_ctx = NULL;
+    conn.xmpp_fd = -1;
     conn.xmpp_in_event_loop = FALSE;
     conn.conn_status = JABBER_DISCONNECTED;
     conn.conn_last_event = XMPP_CONN_DISCONNECT;
@@ -116,10 +124,29 @@ void
 connection_check_events(void)
 {
     conn.xmpp_in_event_loop = TRUE;
-    xmpp_run_once(conn.xmpp_ctx, 10);
+    if (connection_get_fd() >= 0) {
+        // the main loop already waited on the socket, libstrophe reads at most
+        // 4KB per run so drain whatever a full TLS record left buffered
+        int i;
+        for (i = 0; i < XMPP_DRAIN_RUNS && conn.conn_status == JABBER_CONNECTED; i++) {
+            xmpp_run_once(conn.xmpp_ctx, 0);
+        }
+    } else {
+        xmpp_run_once(conn.xmpp_ctx, 10);
+    }
     conn.xmpp_in_event_loop = FALSE;
 }
 
+int
+connection_get_fd(void)
+{
+    if (conn.conn_status != JABBER_CONNECTED) {
+        return -1;
+    }
+
+    return conn.xmpp_fd;
+}
+
 void
 connection_shutdown(void)
 {
@@ -172,6 +199,10 @@ connection_connect(const char *const jid, const char *const passwd, const char *
         log_warning("Failed to get libstrophe conn during connect");
         return JABBER_DISCONNECTED;
     }
+    conn.xmpp_fd = -1;
+#ifdef HAVE_XMPP_CONN_SET_SOCKOPT_CALLBACK
+    xmpp_conn_set_sockopt_callback(conn.xmpp_conn, _connection_sockopt_cb);
+#endif
     xmpp_conn_set_jid(conn.xmpp_conn, jid);
     xmpp_conn_set_pass(conn.xmpp_conn, passwd);
 
@@ -550,6 +581,7 @@ _connection_handler(xmpp_conn_t *const xmpp_conn, const xmpp_conn_event_t status
 
         // close stream response from server after disconnect is handled
         conn.conn_status = JABBER_DISCONNECTED;
+        conn.xmpp_fd = -1;
 
         break;
 
@@ -565,6 +597,17 @@ _connection_handler(xmpp_conn_t *const xmpp_conn, const xmpp_conn_event_t status
     }
 }
 
+#ifdef HAVE_XMPP_CONN_SET_SOCKOPT_CALLBACK
+static int
+_connection_sockopt_cb(xmpp_conn_t *xmpp_conn, void *sock)
+{
+    // remember the socket so the main loop can wait on it with stdin
+    conn.xmpp_fd = *(int*)sock;
+
+    return xmpp_sockopt_cb_keepalive(xmpp_conn, sock);
+}
+#endif
+
 #ifdef HAVE_LIBMESODE
 static int
 _connection_certfail_cb(xmpp_tlscert_t *xmpptlscert, const char *const errormsg)
@@ -153,13 +153,15 @@ _iq_handler(xmpp_conn_t *const conn, xmpp_stanza_t *const stanza, void *const us
 {
     log_debug("iq stanza handler fired");
 
-    char *text;
-    size_t text_size;
-    xmpp_stanza_to_text(stanza, &text, &text_size);
-    gboolean cont = plugins_on_iq_stanza_receive(text);
-    xmpp_free(connection_get_ctx(), text);
-    if (!cont) {
-        return 1;
+    if (plugins_hook_subscribed(PLUGIN_HOOK_IQ_STANZA_RECEIVE)) {
+        char *text;
+        size_t text_size;
+        xmpp_stanza_to_text(stanza, &text, &text_size);
+        gboolean cont = plugins_on_iq_stanza_receive(text);
+        xmpp_free(connection_get_ctx(), text);
+        if (!cont) {
+            return 1;
+        }
     }
 
     const char *type = xmpp_stanza_get_type(stanza);
@@ -2396,11 +2398,17 @@ _disco_items_result_handler(xmpp_stanza_t *const stanza)
 void
 iq_send_stanza(xmpp_stanza_t *const stanza)
 {
+    xmpp_conn_t *conn = connection_get_conn();
+
+    if (!plugins_hook_subscribed(PLUGIN_HOOK_IQ_STANZA_SEND)) {
+        xmpp_send(conn, stanza);
+        return;
+    }
+
     char *text;
     size_t text_size;
     xmpp_stanza_to_text(stanza, &text, &text_size);
 
-    xmpp_conn_t *conn = connection_get_conn();
     char *plugin_text = plugins_on_iq_stanza_send(text);
     if (plugin_text) {
         xmpp_send_raw_string(conn, "%s", plugin_text);
@@ -87,6 +87,20 @@ static void _handle_receipt_received(xmpp_stanza_t *const stanza);
 static void _handle_chat(xmpp_stanza_t *const stanza);
 
 static void _send_message_stanza(xmpp_stanza_t *const stanza);
+static void _send_chat_pgp(const char *const jid, const char *const id, const char *const msg, const char *const encrypted,
+    const char *const state, gboolean request_receipt);
+
+#ifdef HAVE_LIBGPGME
+typedef struct pgp_message_t {
+    char *jid;
+    char *id;
+    char *msg;
+    char *state;
+    gboolean request_receipt;
+} PGPMessage;
+
+static void _message_send_chat_pgp_encrypted(const char *const encrypted, gboolean current, void *userdata);
+#endif
 
 static GHashTable *pubsub_event_handlers;
 
@@ -95,13 +109,15 @@ _message_handler(xmpp_conn_t *const conn, xmpp_stanza_t *const stanza, void *con
 {
     log_debug("Message stanza handler fired");
 
-    char *text;
-    size_t text_size;
-    xmpp_stanza_to_text(stanza, &text, &text_size);
-    gboolean cont = plugins_on_message_stanza_receive(text);
-    xmpp_free(connection_get_ctx(), text);
-    if (!cont) {
-        return 1;
+    if (plugins_hook_subscribed(PLUGIN_HOOK_MESSAGE_STANZA_RECEIVE)) {
+        char *text;
+        size_t text_size;
+        xmpp_stanza_to_text(stanza, &text, &text_size);
+        gboolean cont = plugins_on_message_stanza_receive(text);
+        xmpp_free(connection_get_ctx(), text);
+        if (!cont) {
+            return 1;
+        }
     }
 
     const char *type = xmpp_stanza_get_type(stanza);
@@ -288,58 +304,34 @@ message_send_chat(const char *const barejid, const char *const msg, const char *
 char*
 message_send_chat_pgp(const char *const barejid, const char *const msg, gboolean request_receipt)
 {
-    xmpp_ctx_t * const ctx = connection_get_ctx();
-
     char *state = chat_session_get_state(barejid);
     char *jid = chat_session_get_jid(barejid);
     char *id = connection_create_stanza_id();
 
-    xmpp_stanza_t *message = NULL;
 #ifdef HAVE_LIBGPGME
     char *account_name = session_get_account_name();
     ProfAccount *account = accounts_get_account(account_name);
     if (account->pgp_keyid) {
+        // encrypted off the main loop, sent from p_gpg_poll in submission order
+        PGPMessage *pgp_message = malloc(sizeof(PGPMessage));
+        pgp_message->jid = jid;
+        pgp_message->id = strdup(id);
+        pgp_message->msg = strdup(msg);
+        pgp_message->state = state;
+        pgp_message->request_receipt = request_receipt;
+
         Jid *jidp = jid_create(jid);
-        char *encrypted = p_gpg_encrypt(jidp->barejid, msg, account->pgp_keyid);
-        if (encrypted) {
-            message = xmpp_message_new(ctx, STANZA_TYPE_CHAT, jid, id);
-            xmpp_message_set_body(message, "This message is encrypted (XEP-0027).");
-            xmpp_stanza_t *x = xmpp_stanza_new(ctx);
-            xmpp_stanza_set_name(x, STANZA_NAME_X);
-            xmpp_stanza_set_ns(x, STANZA_NS_ENCRYPTED);
-            xmpp_stanza_t *enc_st = xmpp_stanza_new(ctx);
-            xmpp_stanza_set_text(enc_st, encrypted);
-            xmpp_stanza_add_child(x, enc_st);
-            xmpp_stanza_release(enc_st);
-            xmpp_stanza_add_child(message, x);
-            xmpp_stanza_release(x);
-            free(encrypted);
-        } else {
-            message = xmpp_message_new(ctx, STANZA_TYPE_CHAT, jid, id);
-            xmpp_message_set_body(message, msg);
-        }
+        p_gpg_encrypt_async(jidp->barejid, msg, account->pgp_keyid, _message_send_chat_pgp_encrypted, pgp_message);
         jid_destroy(jidp);
-    } else {
-        message = xmpp_message_new(ctx, STANZA_TYPE_CHAT, jid, id);
-        xmpp_message_set_body(message, msg);
+        account_free(account);
+
+        return id;
     }
     account_free(account);
-#else
-    message = xmpp_message_new(ctx, STANZA_TYPE_CHAT, jid, id);
-    xmpp_message_set_body(message, msg);
 #endif
-    free(jid);
-
-    if (state) {
-        stanza_attach_state(ctx, message, state);
-    }
-
-    if (request_receipt) {
-        stanza_attach_receipt_request(ctx, message);
-    }
 
-    _send_message_stanza(message);
-    xmpp_stanza_release(message);
+    _send_chat_pgp(jid, id, msg, NULL, state, request_receipt);
+    free(jid);
 
     return id;
 }
@@ -1163,11 +1155,17 @@ _handle_chat(xmpp_stanza_t *const stanza)
 static void
 _send_message_stanza(xmpp_stanza_t *const stanza)
 {
+    xmpp_conn_t *conn = connection_get_conn();
+
+    if (!plugins_hook_subscribed(PLUGIN_HOOK_MESSAGE_STANZA_SEND)) {
+        xmpp_send(conn, stanza);
+        return;
+    }
+
     char *text;
     size_t text_size;
     xmpp_stanza_to_text(stanza, &text, &text_size);
 
-    xmpp_conn_t *conn = connection_get_conn();
     char *plugin_text = plugins_on_message_stanza_send(text);
     if (plugin_text) {
         xmpp_send_raw_string(conn, "%s", plugin_text);
@@ -1222,3 +1220,61 @@ message_is_sent_by_us(ProfMessage *message, bool checkOID) {
 
     return  ret;
 }
+
+static void
+_send_chat_pgp(const char *const jid, const char *const id, const char *const msg, const char *const encrypted,
+    const char *const state, gboolean request_receipt)
+{
+    xmpp_ctx_t * const ctx = connection_get_ctx();
+
+    xmpp_stanza_t *message = xmpp_message_new(ctx, STANZA_TYPE_CHAT, jid, id);
+    if (encrypted) {
+        xmpp_message_set_body(message, "This message is encrypted (XEP-0027).");
+        xmpp_stanza_t *x = xmpp_stanza_new(ctx);
+        xmpp_stanza_set_name(x, STANZA_NAME_X);
+        xmpp_stanza_set_ns(x, STANZA_NS_ENCRYPTED);
+        xmpp_stanza_t *enc_st = xmpp_stanza_new(ctx);
+        xmpp_stanza_set_text(enc_st, encrypted);
+        xmpp_stanza_add_child(x, enc_st);
+        xmpp_stanza_release(enc_st);
+        xmpp_stanza_add_child(message, x);
+        xmpp_stanza_release(x);
+    } else {
+        xmpp_message_set_body(message, msg);
+    }
+
+    if (state) {
+        stanza_attach_state(ctx, message, state);
+    }
+
+    if (request_receipt) {
+        stanza_attach_receipt_request(ctx, message);
+    }
+
+    _send_message_stanza(message);
+    xmpp_stanza_release(message);
+}
+
+#ifdef HAVE_LIBGPGME
+static void
+_message_send_chat_pgp_encrypted(const char *const encrypted, gboolean current, void *userdata)
+{
+    PGPMessage *pgp_message = userdata;
+
+    // never send on a session other than the one the message was written in
+    if (current && connection_get_status() == JABBER_CONNECTED) {
+        _send_chat_pgp(pgp_message->jid, pgp_message->id, pgp_message->msg, encrypted, pgp_message->state,
+            pgp_message->request_receipt);
+    } else {
+        log_warning("Dropping PGP message %s, disconnected while encrypting", pgp_message->id);
+        Jid *jidp = jid_create(pgp_message->jid);
+        ui_handle_pgp_error(jidp->barejid, "Message not sent, the connection closed while it was being encrypted.");
+        jid_destroy(jidp);
+    }
+
+    free(pgp_message->jid);
+    free(pgp_message->id);
+    free(pgp_message->msg);
+    free(pgp_message);
+}
+#endif
@@ -41,6 +41,7 @@
 
 #include "common.h"
 #include "tools/autocomplete.h"
+#include "tools/matcher.h"
 #include "ui/ui.h"
 #include "ui/window_list.h"
 #include "xmpp/jid.h"
@@ -60,12 +61,18 @@ typedef struct _muc_room_t {
     gboolean autojoin;
     gboolean pending_nick_change;
     GHashTable *roster;
+    // occupants ordered by nick, borrowed from roster
+    GSequence *occupants;
     Autocomplete nick_ac;
     Autocomplete jid_ac;
     GHashTable *nick_changes;
     gboolean roster_received;
     muc_member_type_t member_type;
     muc_anonymity_type_t anonymity_type;
+    // compiled nick for mention search, rebuilt on nick or setting change
+    Matcher mention_matcher;
+    gboolean mention_whole_word;
+    gboolean mention_case_sensitive;
 } ChatRoom;
 
 GHashTable *rooms = NULL;
@@ -75,6 +82,8 @@ Autocomplete confservers_ac = NULL;
 
 static void _free_room(ChatRoom *room);
 static gint _compare_occupants(Occupant *a, Occupant *b);
+static gint _compare_occupants_data(gconstpointer a, gconstpointer b, gpointer data);
+static void _roster_remove(ChatRoom *chat_room, const char *const nick);
 static muc_role_t _role_from_string(const char *const role);
 static muc_affiliation_t _affiliation_from_string(const char *const affiliation);
 static char* _role_to_string(muc_role_t role);
@@ -220,6 +229,7 @@ muc_join(const char *const room, const char *const nick, const char *const passw
     new_room->pending_broadcasts = NULL;
     new_room->pending_config = FALSE;
     new_room->roster = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, (GDestroyNotify)_occupant_free);
+    new_room->occupants = g_sequence_new(NULL);
     new_room->nick_ac = autocomplete_new();
     new_room->jid_ac = autocomplete_new();
     new_room->nick_changes = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
@@ -228,6 +238,9 @@ muc_join(const char *const room, const char *const nick, const char *const passw
     new_room->autojoin = autojoin;
     new_room->member_type = MUC_MEMBER_TYPE_UNKNOWN;
     new_room->anonymity_type = MUC_ANONYMITY_TYPE_UNKNOWN;
+    new_room->mention_matcher = NULL;
+    new_room->mention_whole_word = FALSE;
+    new_room->mention_case_sensitive = FALSE;
 
     g_hash_table_insert(rooms, strdup(room), new_room);
 }
@@ -394,12 +407,13 @@ muc_nick_change_complete(const char *const room, const char *const nick)
 {
     ChatRoom *chat_room = g_hash_table_lookup(rooms, room);
     if (chat_room) {
-        g_hash_table_remove(chat_room->roster, chat_room->nick);
-        autocomplete_remove(chat_room->nick_ac, chat_room->nick);
+        _roster_remove(chat_room, chat_room->nick);
         free(chat_room->nick);
         chat_room->nick = strdup(nick);
         chat_room->pending_nick_change = FALSE;
         g_hash_table_remove(chat_room->nick_changes, nick);
+        matcher_free(chat_room->mention_matcher);
+        chat_room->mention_matcher = NULL;
     }
 }
 
@@ -429,6 +443,49 @@ muc_nick(const char *const room)
     }
 }
 
+/*
+ * Return character offsets of mentions of our nick in message, the list
+ * should be freed with g_slist_free
+ */
+GSList*
+muc_nick_mentions(const char *const room, const char *const message, gboolean whole_word, gboolean case_sensitive)
+{
+    ChatRoom *chat_room = g_hash_table_lookup(rooms, room);
+    if (chat_room == NULL || message == NULL) {
+        return NULL;
+    }
+
+    if (chat_room->mention_matcher
+            && (chat_room->mention_whole_word != whole_word || chat_room->mention_case_sensitive != case_sensitive)) {
+        matcher_free(chat_room->mention_matcher);
+        chat_room->mention_matcher = NULL;
+    }
+
+    if (chat_room->mention_matcher == NULL) {
+        char *nick_search = case_sensitive ? g_strdup(chat_room->nick) : g_utf8_strdown(chat_room->nick, -1);
+        chat_room->mention_matcher = matcher_new();
+        matcher_add(chat_room->mention_matcher, nick_search, 0, whole_word);
+        chat_room->mention_whole_word = whole_word;
+        chat_room->mention_case_sensitive = case_sensitive;
+        g_free(nick_search);
+    }
+
+    char *message_search = case_sensitive ? g_strdup(message) : g_utf8_strdown(message, -1);
+    GSList *hits = matcher_find(chat_room->mention_matcher, message_search);
+    g_free(message_search);
+
+    GSList *mentions = NULL;
+    GSList *curr = hits;
+    while (curr) {
+        MatcherHit *hit = curr->data;
+        mentions = g_slist_prepend(mentions, GINT_TO_POINTER(hit->offset));
+        curr = g_slist_next(curr);
+    }
+    g_slist_free_full(hits, free);
+
+    return g_slist_reverse(mentions);
+}
+
 /*
  * Return password for the specified room
  * The password is owned by the chat room and should not be modified or freed
@@ -485,7 +542,14 @@ muc_roster_add(const char *const room, const char *const nick, const char *const
         muc_role_t role_t = _role_from_string(role);
         muc_affiliation_t affiliation_t = _affiliation_from_string(affiliation);
         Occupant *occupant = _muc_occupant_new(nick, jid, role_t, affiliation_t, presence, status);
+        if (old) {
+            GSequenceIter *iter = g_sequence_lookup(chat_room->occupants, old, _compare_occupants_data, NULL);
+            if (iter) {
+                g_sequence_remove(iter);
+            }
+        }
         g_hash_table_replace(chat_room->roster, strdup(nick), occupant);
+        g_sequence_insert_sorted(chat_room->occupants, occupant, _compare_occupants_data, NULL);
 
         if (jid) {
             Jid *jidp = jid_create(jid);
@@ -507,8 +571,7 @@ muc_roster_remove(const char *const room, const char *const nick)
 {
     ChatRoom *chat_room = g_hash_table_lookup(rooms, room);
     if (chat_room) {
-        g_hash_table_remove(chat_room->roster, nick);
-        autocomplete_remove(chat_room->nick_ac, nick);
+        _roster_remove(chat_room, nick);
     }
 }
 
@@ -526,6 +589,7 @@ muc_roster_item(const char *const room, const char *const nick)
 
 /*
  * Return a list of PContacts representing the room members in the room's roster
+ * ordered by nick, the occupants are owned by the room
  */
 GList*
 muc_roster(const char *const room)
@@ -533,16 +597,13 @@ muc_roster(const char *const room)
     ChatRoom *chat_room = g_hash_table_lookup(rooms, room);
     if (chat_room) {
         GList *result = NULL;
-        GList *occupants = g_hash_table_get_values(chat_room->roster);
 
-        GList *curr = occupants;
-        while (curr) {
-            result = g_list_insert_sorted(result, curr->data, (GCompareFunc)_compare_occupants);
-            curr = g_list_next(curr);
+        GSequenceIter *iter = g_sequence_get_end_iter(chat_room->occupants);
+        while (!g_sequence_iter_is_begin(iter)) {
+            iter = g_sequence_iter_prev(iter);
+            result = g_list_prepend(result, g_sequence_get(iter));
         }
 
-        g_list_free(occupants);
-
         return result;
     } else {
         return NULL;
@@ -624,15 +685,13 @@ muc_occupants_by_role(const char *const room, muc_role_t role)
     ChatRoom *chat_room = g_hash_table_lookup(rooms, room);
     if (chat_room) {
         GSList *result = NULL;
-        GHashTableIter iter;
-        gpointer key;
-        gpointer value;
 
-        g_hash_table_iter_init(&iter, chat_room->roster);
-        while (g_hash_table_iter_next(&iter, &key, &value)) {
-            Occupant *occupant = (Occupant *)value;
+        GSequenceIter *iter = g_sequence_get_end_iter(chat_room->occupants);
+        while (!g_sequence_iter_is_begin(iter)) {
+            iter = g_sequence_iter_prev(iter);
+            Occupant *occupant = g_sequence_get(iter);
             if (occupant->role == role) {
-                result = g_slist_insert_sorted(result, value, (GCompareFunc)_compare_occupants);
+                result = g_slist_prepend(result, occupant);
             }
         }
         return result;
@@ -647,15 +706,13 @@ muc_occupants_by_affiliation(const char *const room, muc_affiliation_t affiliati
     ChatRoom *chat_room = g_hash_table_lookup(rooms, room);
     if (chat_room) {
         GSList *result = NULL;
-        GHashTableIter iter;
-        gpointer key;
-        gpointer value;
 
-        g_hash_table_iter_init(&iter, chat_room->roster);
-        while (g_hash_table_iter_next(&iter, &key, &value)) {
-            Occupant *occupant = (Occupant *)value;
+        GSequenceIter *iter = g_sequence_get_end_iter(chat_room->occupants);
+        while (!g_sequence_iter_is_begin(iter)) {
+            iter = g_sequence_iter_prev(iter);
+            Occupant *occupant = g_sequence_get(iter);
             if (occupant->affiliation == affiliation) {
-                result = g_slist_insert_sorted(result, value, (GCompareFunc)_compare_occupants);
+                result = g_slist_prepend(result, occupant);
             }
         }
         return result;
@@ -868,6 +925,9 @@ _free_room(ChatRoom *room)
         free(room->subject);
         free(room->password);
         free(room->autocomplete_prefix);
+        if (room->occupants) {
+            g_sequence_free(room->occupants);
+        }
         if (room->roster) {
             g_hash_table_destroy(room->roster);
         }
@@ -879,6 +939,7 @@ _free_room(ChatRoom *room)
         if (room->pending_broadcasts) {
             g_list_free_full(room->pending_broadcasts, free);
         }
+        matcher_free(room->mention_matcher);
         free(room);
     }
 }
@@ -890,10 +951,33 @@ _compare_occupants(Occupant *a, Occupant *b)
     const char * utf8_str_b = b->nick_collate_key;
 
     gint result = g_strcmp0(utf8_str_a, utf8_str_b);
+    if (result == 0) {
+        result = g_strcmp0(a->nick, b->nick);
+    }
 
     return result;
 }
 
+static gint
+_compare_occupants_data(gconstpointer a, gconstpointer b, gpointer data)
+{
+    return _compare_occupants((Occupant*)a, (Occupant*)b);
+}
+
+static void
+_roster_remove(ChatRoom *chat_room, const char *const nick)
+{
+    Occupant *occupant = g_hash_table_lookup(chat_room->roster, nick);
+    if (occupant) {
+        GSequenceIter *iter = g_sequence_lookup(chat_room->occupants, occupant, _compare_occupants_data, NULL);
+        if (iter) {
+            g_sequence_remove(iter);
+        }
+    }
+    g_hash_table_remove(chat_room->roster, nick);
+    autocomplete_remove(chat_room->nick_ac, nick);
+}
+
 static muc_role_t
 _role_from_string(const char *const role)
 {
@@ -95,6 +95,8 @@ void muc_set_features(const char *const room, GSList *features);
 
 char* muc_nick(const char *const room);
 char* muc_password(const char *const room);
+GSList* muc_nick_mentions(const char *const room, const char *const message, gboolean whole_word,
+    gboolean case_sensitive);
 
 void muc_nick_change_start(const char *const room, const char *const new_nick);
 void muc_nick_change_complete(const char *const room, const char *const nick);
@@ -359,14 +359,15 @@ _presence_handler(xmpp_conn_t *const conn, xmpp_stanza_t *const stanza, void *co
 {
     log_debug("Presence stanza handler fired");
 
-    char *text = NULL;
-    size_t text_size;
-    xmpp_stanza_to_text(stanza, &text, &text_size);
-
-    gboolean cont = plugins_on_presence_stanza_receive(text);
-    xmpp_free(connection_get_ctx(), text);
-    if (!cont) {
-        return 1;
+    if (plugins_hook_subscribed(PLUGIN_HOOK_PRESENCE_STANZA_RECEIVE)) {
+        char *text;
+        size_t text_size;
+        xmpp_stanza_to_text(stanza, &text, &text_size);
+        gboolean cont = plugins_on_presence_stanza_receive(text);
+        xmpp_free(connection_get_ctx(), text);
+        if (!cont) {
+            return 1;
+        }
     }
 
     const char *type = xmpp_stanza_get_type(stanza);
@@ -899,11 +900,17 @@ _muc_user_handler(xmpp_stanza_t *const stanza)
 static void
 _send_presence_stanza(xmpp_stanza_t *const stanza)
 {
+    xmpp_conn_t *conn = connection_get_conn();
+
+    if (!plugins_hook_subscribed(PLUGIN_HOOK_PRESENCE_STANZA_SEND)) {
+        xmpp_send(conn, stanza);
+        return;
+    }
+
     char *text;
     size_t text_size;
     xmpp_stanza_to_text(stanza, &text, &text_size);
 
-    xmpp_conn_t *conn = connection_get_conn();
     char *plugin_text = plugins_on_presence_stanza_send(text);
     if (plugin_text) {
         xmpp_send_raw_string(conn, "%s", plugin_text);
@@ -75,6 +75,7 @@ typedef struct _group_data {
 static int _group_add_id_handler(xmpp_stanza_t *const stanza, void *const userdata);
 static int _group_remove_id_handler(xmpp_stanza_t *const stanza, void *const userdata);
 static void _free_group_data(GroupData *data);
+static void _free_roster_item(ProfRosterItem *item);
 
 void
 roster_request(void)
@@ -277,13 +278,14 @@ roster_result_handler(xmpp_stanza_t *const stanza)
         return;
     }
 
-    // handle initial roster response
+    // handle initial roster response, adding all contacts at once
     xmpp_stanza_t *query = xmpp_stanza_get_child_by_name(stanza, STANZA_NAME_QUERY);
     xmpp_stanza_t *item = xmpp_stanza_get_children(query);
+    GSList *items = NULL;
+    int count = 0;
 
     while (item) {
         const char *barejid = xmpp_stanza_get_attribute(item, STANZA_ATTR_JID);
-        gchar *barejid_lower = g_utf8_strdown(barejid, -1);
         const char *name = xmpp_stanza_get_attribute(item, STANZA_ATTR_NAME);
         const char *sub = xmpp_stanza_get_attribute(item, STANZA_ATTR_SUBSCRIPTION);
 
@@ -296,17 +298,25 @@ roster_result_handler(xmpp_stanza_t *const stanza)
             pending_out = TRUE;
         }
 
-        GSList *groups = roster_get_groups_from_item(item);
-
-        gboolean added = roster_add(barejid_lower, name, groups, sub, pending_out);
-        if (!added) {
-            log_warning("Attempt to add contact twice: %s", barejid_lower);
-        }
+        ProfRosterItem *roster_item = malloc(sizeof(ProfRosterItem));
+        roster_item->barejid = g_utf8_strdown(barejid, -1);
+        roster_item->name = name ? strdup(name) : NULL;
+        roster_item->groups = roster_get_groups_from_item(item);
+        roster_item->subscription = sub ? strdup(sub) : NULL;
+        roster_item->pending_out = pending_out;
+        items = g_slist_prepend(items, roster_item);
+        count++;
 
-        g_free(barejid_lower);
         item = xmpp_stanza_get_next(item);
     }
 
+    items = g_slist_reverse(items);
+    int added = roster_add_all(items);
+    if (added < count) {
+        log_warning("Ignored %d duplicate contacts in roster", count - added);
+    }
+    g_slist_free_full(items, (GDestroyNotify)_free_roster_item);
+
     sv_ev_roster_received();
 
     return;
@@ -340,3 +350,15 @@ _free_group_data(GroupData *data)
         free(data);
     }
 }
+
+static void
+_free_roster_item(ProfRosterItem *item)
+{
+    if (item) {
+        g_free(item->barejid);
+        free(item->name);
+        g_slist_free_full(item->groups, g_free);
+        free(item->subscription);
+        free(item);
+    }
+}
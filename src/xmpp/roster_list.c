@@ -134,7 +134,8 @@ roster_update_presence(const char *const barejid, Resource *resource, GDateTime
         if (last_activity) {
             g_date_time_ref(last_activity);
         }
-        roster_pending_presence = g_slist_append(roster_pending_presence, presence);
+        // prepended, reversed when the roster arrives
+        roster_pending_presence = g_slist_prepend(roster_pending_presence, presence);
         return FALSE;
     }
 
@@ -386,6 +387,67 @@ roster_add(const char *const barejid, const char *const name, GSList *groups, co
     return TRUE;
 }
 
+/*
+ * Add the contacts from a roster result in one pass, filling the
+ * autocompleters once at the end. The groups of each added item are
+ * taken by its contact and set to NULL, returns the number added.
+ */
+int
+roster_add_all(GSList *items)
+{
+    assert(roster != NULL);
+
+    GPtrArray *barejids = g_ptr_array_new();
+    GPtrArray *names = g_ptr_array_new();
+    GPtrArray *groups = g_ptr_array_new();
+    int added = 0;
+
+    GSList *curr = items;
+    while (curr) {
+        ProfRosterItem *item = curr->data;
+        curr = g_slist_next(curr);
+
+        if (roster_get_contact(item->barejid)) {
+            continue;
+        }
+
+        PContact contact = p_contact_new(item->barejid, item->name, item->groups, item->subscription, NULL,
+            item->pending_out);
+        item->groups = NULL;
+        g_hash_table_insert(roster->contacts, strdup(item->barejid), contact);
+        added++;
+
+        GSList *curr_group = p_contact_groups(contact);
+        while (curr_group) {
+            char *group = curr_group->data;
+            int count = GPOINTER_TO_INT(g_hash_table_lookup(roster->group_count, group));
+            if (count == 0) {
+                g_ptr_array_add(groups, group);
+            }
+            g_hash_table_insert(roster->group_count, strdup(group), GINT_TO_POINTER(count + 1));
+            curr_group = g_slist_next(curr_group);
+        }
+
+        const char *barejid = p_contact_barejid(contact);
+        const char *name = p_contact_name(contact) ? p_contact_name(contact) : barejid;
+        g_ptr_array_add(barejids, (char*)barejid);
+        g_ptr_array_add(names, (char*)name);
+        g_hash_table_insert(roster->name_to_barejid, strdup(name), strdup(barejid));
+    }
+
+    g_ptr_array_add(barejids, NULL);
+    g_ptr_array_add(names, NULL);
+    g_ptr_array_add(groups, NULL);
+    autocomplete_add_all(roster->barejid_ac, (char**)barejids->pdata);
+    autocomplete_add_all(roster->name_ac, (char**)names->pdata);
+    autocomplete_add_all(roster->groups_ac, (char**)groups->pdata);
+    g_ptr_array_free(barejids, TRUE);
+    g_ptr_array_free(names, TRUE);
+    g_ptr_array_free(groups, TRUE);
+
+    return added;
+}
+
 char*
 roster_barejid_from_name(const char *const name)
 {
@@ -412,10 +474,12 @@ roster_get_contacts_by_presence(const char *const presence)
     while (g_hash_table_iter_next(&iter, &key, &value)) {
         PContact contact = (PContact)value;
         if (g_strcmp0(p_contact_presence(contact), presence) == 0) {
-            result = g_slist_insert_sorted(result, value, (GCompareFunc)roster_compare_name);
+            result = g_slist_prepend(result, value);
         }
     }
 
+    result = g_slist_sort(result, (GCompareFunc)roster_compare_name);
+
     // return all contact structs
     return result;
 }
@@ -439,9 +503,11 @@ roster_get_contacts(roster_ord_t order)
 
     g_hash_table_iter_init(&iter, roster->contacts);
     while (g_hash_table_iter_next(&iter, &key, &value)) {
-        result = g_slist_insert_sorted(result, value, cmp_func);
+        result = g_slist_prepend(result, value);
     }
 
+    result = g_slist_sort(result, cmp_func);
+
     // return all contact structs
     return result;
 }
@@ -459,9 +525,11 @@ roster_get_contacts_online(void)
     g_hash_table_iter_init(&iter, roster->contacts);
     while (g_hash_table_iter_next(&iter, &key, &value)) {
         if(strcmp(p_contact_presence(value), "offline"))
-            result = g_slist_insert_sorted(result, value, (GCompareFunc)roster_compare_name);
+            result = g_slist_prepend(result, value);
     }
 
+    result = g_slist_sort(result, (GCompareFunc)roster_compare_name);
+
     // return all contact structs
     return result;
 }
@@ -524,12 +592,12 @@ roster_get_group(const char *const group, roster_ord_t order)
         GSList *groups = p_contact_groups(value);
         if (group == NULL) {
             if (groups == NULL) {
-                result = g_slist_insert_sorted(result, value, cmp_func);
+                result = g_slist_prepend(result, value);
             }
         } else {
             while (groups) {
                 if (strcmp(groups->data, group) == 0) {
-                    result = g_slist_insert_sorted(result, value, cmp_func);
+                    result = g_slist_prepend(result, value);
                     break;
                 }
                 groups = g_slist_next(groups);
@@ -537,6 +605,8 @@ roster_get_group(const char *const group, roster_ord_t order)
         }
     }
 
+    result = g_slist_sort(result, cmp_func);
+
     // return all contact structs
     return result;
 }
@@ -695,6 +765,7 @@ void
 roster_process_pending_presence(void)
 {
     roster_received = TRUE;
+    roster_pending_presence = g_slist_reverse(roster_pending_presence);
 
     GSList *iter;
     for (iter = roster_pending_presence; iter != NULL; iter = iter->next) {
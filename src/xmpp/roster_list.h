@@ -41,6 +41,14 @@
 #include "xmpp/resource.h"
 #include "xmpp/contact.h"
 
+typedef struct roster_item_t {
+    char *barejid;
+    char *name;
+    GSList *groups;
+    char *subscription;
+    gboolean pending_out;
+} ProfRosterItem;
+
 typedef enum {
     ROSTER_ORD_NAME,
     ROSTER_ORD_PRESENCE
@@ -59,6 +67,7 @@ void roster_update(const char *const barejid, const char *const name, GSList *gr
     gboolean pending_out);
 gboolean roster_add(const char *const barejid, const char *const name, GSList *groups, const char *const subscription,
     gboolean pending_out);
+int roster_add_all(GSList *items);
 char* roster_barejid_from_name(const char *const name);
 GSList* roster_get_contacts(roster_ord_t order);
 GSList* roster_get_contacts_online(void);
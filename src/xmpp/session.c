@@ -269,6 +269,12 @@ session_process_events(void)
     }
 }
 
+gboolean
+session_reconnect_pending(void)
+{
+    return (prefs_get_reconnect() != 0) && reconnect_timer;
+}
+
 char*
 session_get_account_name(void)
 {
@@ -45,5 +45,6 @@ void session_autoping_fail(void);
 
 void session_init_activity(void);
 void session_check_autoaway(void);
+gboolean session_reconnect_pending(void);
 
 #endif
@@ -152,6 +152,7 @@ void session_process_events(void);
 char* session_get_account_name(void);
 
 jabber_conn_status_t connection_get_status(void);
+int connection_get_fd(void);
 char *connection_get_presence_msg(void);
 void connection_set_presence_msg(const char *const message);
 const char* connection_get_fulljid(void);
@@ -1,3 +1,5 @@
+#include "config.h"
+
 #include <setjmp.h>
 #include <stdarg.h>
 #include <stddef.h>
@@ -6,6 +8,11 @@
 #include <glib.h>
 #include <stdio.h>
 #include <unistd.h>
+#ifdef HAVE_NCURSESW_NCURSES_H
+#include <ncursesw/ncurses.h>
+#elif HAVE_NCURSES_H
+#include <ncurses.h>
+#endif
 
 #include "common.h"
 #include "helpers.h"
@@ -58,6 +65,29 @@ void close_preferences(void **state)
     rmdir("./tests/files");
 }
 
+static FILE *colour_out = NULL;
+static SCREEN *colour_screen = NULL;
+
+// a screen on a 256 colour terminal so colour pairs can be defined
+void start_colours(void **state)
+{
+    colour_out = fopen("/dev/null", "w");
+    assert_non_null(colour_out);
+    colour_screen = newterm("xterm-256color", colour_out, stdin);
+    assert_non_null(colour_screen);
+    start_color();
+    use_default_colors();
+}
+
+void stop_colours(void **state)
+{
+    endwin();
+    delscreen(colour_screen);
+    colour_screen = NULL;
+    fclose(colour_out);
+    colour_out = NULL;
+}
+
 void init_chat_sessions(void **state)
 {
     load_preferences(NULL);
@@ -1,7 +1,11 @@
 #include "glib.h"
 
+void create_data_dir(void **state);
+void remove_data_dir(void **state);
 void load_preferences(void **state);
 void close_preferences(void **state);
+void start_colours(void **state);
+void stop_colours(void **state);
 
 void init_chat_sessions(void **state);
 void close_chat_sessions(void **state);
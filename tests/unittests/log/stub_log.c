@@ -52,6 +52,10 @@ log_level_t log_level_from_string(char *log_level)
 void log_stderr_init(log_level_t level) {}
 void log_stderr_close(void) {}
 void log_stderr_handler(void) {}
+int log_stderr_fd(void)
+{
+    return -1;
+}
 
 void chat_log_init(void) {}
 
@@ -65,12 +69,27 @@ void chat_log_otr_msg_in(ProfMessage *message) {}
 void chat_log_pgp_msg_in(ProfMessage *message) {}
 void chat_log_omemo_msg_in(ProfMessage *message) {}
 
+void chat_log_flush(void) {}
+void chat_log_poll(void) {}
+guint chat_log_queue_depth(void) { return 0; }
+guint chat_log_queue_peak(void) { return 0; }
+guint chat_log_dropped(void) { return 0; }
 void chat_log_close(void) {}
-GSList * chat_log_get_previous(const gchar * const login,
+ChatLogHistory * chat_log_history_new(const gchar * const login,
     const gchar * const recipient)
 {
-    return mock_ptr_type(GSList *);
+    return NULL;
+}
+GSList * chat_log_history_previous(ChatLogHistory *history, int count)
+{
+    return NULL;
+}
+gboolean chat_log_history_has_more(ChatLogHistory *history)
+{
+    return FALSE;
 }
+void chat_log_history_free_entries(GSList *entries) {}
+void chat_log_history_free(ChatLogHistory *history) {}
 
 void groupchat_log_init(void) {}
 void groupchat_log_msg_in(const gchar *const room, const gchar *const nick, const gchar *const msg) {}
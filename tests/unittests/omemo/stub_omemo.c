@@ -5,6 +5,7 @@
 
 void omemo_init(void) {}
 void omemo_close(void) {}
+void omemo_poll(void) {}
 
 char*
 omemo_fingerprint_autocomplete(const char *const search_str, gboolean previous)
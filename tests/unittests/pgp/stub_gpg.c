@@ -67,3 +67,15 @@ p_gpg_format_fp_str(char *fp)
     return NULL;
 }
 
+void p_gpg_encrypt_async(const char *const barejid, const char *const message, const char *const fp,
+    p_gpg_encrypted_cb callback, void *userdata) {}
+
+int p_gpg_poll(void)
+{
+    return 0;
+}
+
+gboolean p_gpg_pending(void)
+{
+    return FALSE;
+}
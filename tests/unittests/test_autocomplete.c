@@ -216,3 +216,56 @@ void complete_previous(void **state)
     free(result3);
     free(result4);
 }
+
+void complete_cycles_in_item_order(void **state)
+{
+    Autocomplete ac = autocomplete_new();
+    autocomplete_add(ac, "bob");
+    autocomplete_add(ac, "Bill");
+    autocomplete_add(ac, "alice");
+    autocomplete_add(ac, "Ben");
+
+    char *result1 = autocomplete_complete(ac, "b", TRUE, FALSE);
+    char *result2 = autocomplete_complete(ac, result1, TRUE, FALSE);
+    char *result3 = autocomplete_complete(ac, result2, TRUE, FALSE);
+    char *result4 = autocomplete_complete(ac, result3, TRUE, FALSE);
+
+    assert_string_equal("Ben", result1);
+    assert_string_equal("Bill", result2);
+    assert_string_equal("bob", result3);
+    assert_string_equal("Ben", result4);
+
+    autocomplete_free(ac);
+
+    free(result1);
+    free(result2);
+    free(result3);
+    free(result4);
+}
+
+void complete_continues_after_remove_and_add(void **state)
+{
+    Autocomplete ac = autocomplete_new();
+    autocomplete_add(ac, "Buddy1");
+    autocomplete_add(ac, "Buddy2");
+    autocomplete_add(ac, "Buddy4");
+
+    char *result1 = autocomplete_complete(ac, "bud", TRUE, FALSE);
+    autocomplete_add(ac, "Buddy3");
+    autocomplete_remove(ac, "Buddy2");
+    char *result2 = autocomplete_complete(ac, result1, TRUE, FALSE);
+    char *result3 = autocomplete_complete(ac, result2, TRUE, FALSE);
+
+    assert_string_equal("Buddy1", result1);
+    assert_string_equal("Buddy3", result2);
+    assert_string_equal("Buddy4", result3);
+    assert_true(autocomplete_contains(ac, "Buddy3"));
+    assert_false(autocomplete_contains(ac, "Buddy2"));
+    assert_int_equal(3, autocomplete_length(ac));
+
+    autocomplete_free(ac);
+
+    free(result1);
+    free(result2);
+    free(result3);
+}
@@ -14,3 +14,5 @@ void complete_both_with_accented(void **state);
 void complete_both_with_base(void **state);
 void complete_ignores_case(void **state);
 void complete_previous(void **state);
+void complete_cycles_in_item_order(void **state);
+void complete_continues_after_remove_and_add(void **state);
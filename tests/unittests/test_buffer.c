@@ -0,0 +1,414 @@
+#include <glib.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "helpers.h"
+#include "ui/ui.h"
+#include "ui/buffer.h"
+
+static void
+_append(ProfBuff buffer, int num)
+{
+    GDateTime *time = g_date_time_new_now_local();
+    char *message = g_strdup_printf("message %d", num);
+    buffer_append(buffer, '-', 0, time, 0, THEME_TEXT, NULL, message, NULL, NULL);
+    g_free(message);
+    g_date_time_unref(time);
+}
+
+static void
+_append_many(ProfBuff buffer, int from, int to)
+{
+    int i;
+    for (i = from; i < to; i++) {
+        _append(buffer, i);
+    }
+}
+
+static void
+_append_id(ProfBuff buffer, int num, const char *const id)
+{
+    GDateTime *time = g_date_time_new_now_local();
+    char *message = g_strdup_printf("message %d", num);
+    buffer_append(buffer, '-', 0, time, 0, THEME_TEXT, NULL, message, NULL, id);
+    g_free(message);
+    g_date_time_unref(time);
+}
+
+static void
+_assert_message(ProfBuffEntry *entry, int num)
+{
+    char *expected = g_strdup_printf("message %d", num);
+    assert_non_null(entry);
+    assert_string_equal(expected, entry->message);
+    g_free(expected);
+}
+
+static void
+_assert_spilled_message(ProfBuff buffer, int entry, int num)
+{
+    ProfBuffEntry *spilled = buffer_get_spilled_entry(buffer, entry);
+    _assert_message(spilled, num);
+    buffer_free_spilled_entry(spilled);
+}
+
+void spill_setup(void **state)
+{
+    create_data_dir(state);
+    buffer_set_spill(TRUE);
+}
+
+void spill_teardown(void **state)
+{
+    buffer_set_spill(FALSE);
+    rmdir("./tests/files/xdg_data_home/profanity/scrollback");
+    remove_data_dir(state);
+}
+
+void append_evicts_oldest_first(void **state)
+{
+    ProfBuff buffer = buffer_create(3);
+
+    _append_many(buffer, 0, 5);
+
+    assert_int_equal(3, buffer_size(buffer));
+    _assert_message(buffer_get_entry(buffer, 0), 2);
+    _assert_message(buffer_get_entry(buffer, 1), 3);
+    _assert_message(buffer_get_entry(buffer, 2), 4);
+    assert_null(buffer_get_entry(buffer, 3));
+
+    buffer_free(buffer);
+}
+
+void evicted_entries_discarded_without_spill(void **state)
+{
+    ProfBuff buffer = buffer_create(3);
+
+    _append_many(buffer, 0, 5);
+
+    assert_int_equal(0, buffer_spilled_size(buffer));
+    assert_null(buffer_get_spilled_entry(buffer, 0));
+
+    buffer_free(buffer);
+}
+
+void evicted_entries_spill_oldest_first(void **state)
+{
+    ProfBuff buffer = buffer_create(3);
+
+    _append_many(buffer, 0, 7);
+
+    assert_int_equal(4, buffer_spilled_size(buffer));
+    int i;
+    for (i = 0; i < 4; i++) {
+        _assert_spilled_message(buffer, i, i);
+    }
+    assert_null(buffer_get_spilled_entry(buffer, 4));
+
+    buffer_free(buffer);
+}
+
+void spilled_entry_reads_back_all_fields(void **state)
+{
+    ProfBuff buffer = buffer_create(1);
+    GDateTime *time = g_date_time_new_local(2019, 6, 1, 12, 30, 15);
+    DeliveryReceipt *receipt = malloc(sizeof(struct delivery_receipt_t));
+    receipt->received = TRUE;
+
+    buffer_append(buffer, '!', 3, time, NO_EOL, THEME_TEXT_ME, "me", "héllo wörld", receipt, "id1");
+    _append(buffer, 1);
+
+    assert_int_equal(1, buffer_spilled_size(buffer));
+    ProfBuffEntry *entry = buffer_get_spilled_entry(buffer, 0);
+    assert_non_null(entry);
+    assert_int_equal('!', entry->show_char);
+    assert_int_equal(3, entry->pad_indent);
+    assert_int_equal(NO_EOL, entry->flags);
+    assert_int_equal(THEME_TEXT_ME, entry->theme_item);
+    assert_string_equal("me", entry->from);
+    assert_string_equal("héllo wörld", entry->message);
+    assert_string_equal("id1", entry->id);
+    assert_non_null(entry->receipt);
+    assert_true(entry->receipt->received);
+    assert_true(g_date_time_to_unix(time) == g_date_time_to_unix(entry->time));
+    buffer_free_spilled_entry(entry);
+
+    // entries without optional fields read back as NULL
+    _append(buffer, 2);
+    entry = buffer_get_spilled_entry(buffer, 1);
+    assert_non_null(entry);
+    assert_null(entry->from);
+    assert_null(entry->id);
+    assert_null(entry->receipt);
+    buffer_free_spilled_entry(entry);
+
+    g_date_time_unref(time);
+    buffer_free(buffer);
+}
+
+void spilled_entries_follow_resident_ones(void **state)
+{
+    ProfBuff buffer = buffer_create(2);
+
+    // read back between writes so the file is mapped again as it grows
+    _append_many(buffer, 0, 4);
+    _assert_spilled_message(buffer, 1, 1);
+    _append_many(buffer, 4, 6);
+    _assert_spilled_message(buffer, 3, 3);
+
+    assert_int_equal(4, buffer_spilled_size(buffer));
+    assert_int_equal(2, buffer_size(buffer));
+    _assert_spilled_message(buffer, 0, 0);
+    _assert_message(buffer_get_entry(buffer, 0), 4);
+    _assert_message(buffer_get_entry(buffer, 1), 5);
+
+    buffer_free(buffer);
+}
+
+void spill_drops_oldest_half_when_full(void **state)
+{
+    ProfBuff buffer = buffer_create(1);
+
+    _append_many(buffer, 0, 50001);
+
+    assert_int_equal(25000, buffer_spilled_size(buffer));
+    assert_int_equal(25000, buffer_origin(buffer));
+    _assert_spilled_message(buffer, 0, 25000);
+    _assert_spilled_message(buffer, 24999, 49999);
+    _assert_message(buffer_get_entry(buffer, 0), 50000);
+
+    // records written after compacting follow the kept ones
+    _append(buffer, 50001);
+    assert_int_equal(25001, buffer_spilled_size(buffer));
+    _assert_spilled_message(buffer, 25000, 50000);
+
+    buffer_free(buffer);
+}
+
+void budget_trims_each_buffer_oldest_first(void **state)
+{
+    ProfBuff first = buffer_create(1000);
+    ProfBuff second = buffer_create(1000);
+    _append_many(first, 0, 150);
+    _append_many(second, 0, 300);
+
+    buffer_set_memory_budget(1);
+
+    assert_int_equal(100, buffer_size(first));
+    _assert_message(buffer_get_entry(first, 0), 50);
+    _assert_message(buffer_get_entry(first, 99), 149);
+    assert_int_equal(100, buffer_size(second));
+    _assert_message(buffer_get_entry(second, 0), 200);
+    _assert_message(buffer_get_entry(second, 99), 299);
+
+    buffer_set_memory_budget(0);
+    buffer_free(first);
+    buffer_free(second);
+}
+
+void budget_keeps_minimum_resident_entries(void **state)
+{
+    ProfBuff buffer = buffer_create(1000);
+    _append_many(buffer, 0, 500);
+
+    buffer_set_memory_budget(1);
+
+    assert_int_equal(100, buffer_size(buffer));
+    _assert_message(buffer_get_entry(buffer, 0), 400);
+
+    // appending past the budget keeps trimming the oldest
+    _append_many(buffer, 500, 510);
+    assert_int_equal(100, buffer_size(buffer));
+    _assert_message(buffer_get_entry(buffer, 0), 410);
+    _assert_message(buffer_get_entry(buffer, 99), 509);
+
+    buffer_set_memory_budget(0);
+    buffer_free(buffer);
+}
+
+void entries_within_budget_are_kept(void **state)
+{
+    ProfBuff buffer = buffer_create(1000);
+
+    buffer_set_memory_budget(10 * 1024 * 1024);
+    _append_many(buffer, 0, 500);
+
+    assert_int_equal(500, buffer_size(buffer));
+    _assert_message(buffer_get_entry(buffer, 0), 0);
+
+    buffer_set_memory_budget(0);
+    buffer_free(buffer);
+}
+
+void budget_counts_cached_layouts(void **state)
+{
+    ProfBuff first = buffer_create(1000);
+    ProfBuff second = buffer_create(1000);
+    _append_many(first, 0, 150);
+    _append_many(second, 0, 150);
+
+    buffer_set_memory_budget(12 * 1024 * 1024);
+    assert_int_equal(150, buffer_size(first));
+
+    int i;
+    for (i = 0; i < 150; i++) {
+        buffer_set_layout_bytes(first, buffer_get_entry(first, i), 100 * 1024);
+    }
+    buffer_set_memory_budget(12 * 1024 * 1024);
+
+    // only the buffer holding the layouts is over its share
+    assert_true(buffer_size(first) < 150);
+    assert_true(buffer_size(first) > 100);
+    _assert_message(buffer_get_entry(first, buffer_size(first) - 1), 149);
+    assert_int_equal(150, buffer_size(second));
+
+    buffer_set_memory_budget(0);
+    buffer_free(first);
+    buffer_free(second);
+}
+
+void origin_follows_entries_dropped_and_prepended(void **state)
+{
+    ProfBuff buffer = buffer_create(3);
+    GDateTime *time = g_date_time_new_now_local();
+
+    _append_many(buffer, 0, 3);
+    assert_int_equal(0, buffer_origin(buffer));
+
+    _append_many(buffer, 3, 5);
+    assert_int_equal(2, buffer_origin(buffer));
+
+    buffer_free(buffer);
+
+    buffer = buffer_create(3);
+    assert_true(buffer_prepend(buffer, '-', 0, time, 0, THEME_TEXT, "", "older"));
+    assert_int_equal(-1, buffer_origin(buffer));
+
+    g_date_time_unref(time);
+    buffer_free(buffer);
+}
+
+void origin_unchanged_when_spilling(void **state)
+{
+    ProfBuff buffer = buffer_create(3);
+
+    _append_many(buffer, 0, 10);
+
+    assert_int_equal(0, buffer_origin(buffer));
+    assert_int_equal(7, buffer_spilled_size(buffer));
+
+    buffer_free(buffer);
+}
+
+void remove_by_id_keeps_order_of_others(void **state)
+{
+    ProfBuff buffer = buffer_create(5);
+    _append_id(buffer, 0, "a");
+    _append_id(buffer, 1, "b");
+    _append_id(buffer, 2, "c");
+    _append_id(buffer, 3, "d");
+
+    buffer_remove_entry_by_id(buffer, "b");
+    buffer_remove_entry_by_id(buffer, "missing");
+
+    assert_null(buffer_get_entry_by_id(buffer, "b"));
+    _assert_message(buffer_get_entry_by_id(buffer, "c"), 2);
+    assert_int_equal(3, buffer_size(buffer));
+    _assert_message(buffer_get_entry(buffer, 0), 0);
+    _assert_message(buffer_get_entry(buffer, 1), 2);
+    _assert_message(buffer_get_entry(buffer, 2), 3);
+    _assert_message(buffer_get_entry_by_id(buffer, "d"), 3);
+
+    buffer_free(buffer);
+}
+
+void remove_by_id_removes_every_duplicate(void **state)
+{
+    ProfBuff buffer = buffer_create(5);
+    _append_id(buffer, 0, "a");
+    _append_id(buffer, 1, "dup");
+    _append_id(buffer, 2, "b");
+    _append_id(buffer, 3, "dup");
+
+    // the oldest entry carrying an id is found
+    _assert_message(buffer_get_entry_by_id(buffer, "dup"), 1);
+
+    buffer_remove_entry_by_id(buffer, "dup");
+
+    assert_null(buffer_get_entry_by_id(buffer, "dup"));
+    assert_int_equal(2, buffer_size(buffer));
+    _assert_message(buffer_get_entry(buffer, 0), 0);
+    _assert_message(buffer_get_entry(buffer, 1), 2);
+
+    buffer_free(buffer);
+}
+
+void remove_by_id_frees_space_for_appends(void **state)
+{
+    ProfBuff buffer = buffer_create(3);
+    _append_id(buffer, 0, "a");
+    _append_id(buffer, 1, "b");
+    _append_id(buffer, 2, "c");
+
+    buffer_remove_entry_by_id(buffer, "a");
+    buffer_remove_entry_by_id(buffer, "c");
+    _append_id(buffer, 3, "d");
+    _append_id(buffer, 4, "e");
+
+    assert_int_equal(0, buffer_origin(buffer));
+    assert_int_equal(3, buffer_size(buffer));
+    _assert_message(buffer_get_entry(buffer, 0), 1);
+    _assert_message(buffer_get_entry(buffer, 2), 4);
+    _assert_message(buffer_get_entry_by_id(buffer, "b"), 1);
+    _assert_message(buffer_get_entry_by_id(buffer, "e"), 4);
+
+    // the ring wraps past the slots that held removed entries
+    _append_id(buffer, 5, "f");
+    assert_int_equal(1, buffer_origin(buffer));
+    assert_null(buffer_get_entry_by_id(buffer, "b"));
+    _assert_message(buffer_get_entry(buffer, 0), 3);
+    _assert_message(buffer_get_entry_by_id(buffer, "d"), 3);
+    _assert_message(buffer_get_entry_by_id(buffer, "f"), 5);
+
+    buffer_free(buffer);
+}
+
+void entry_by_id_follows_eviction_of_duplicates(void **state)
+{
+    ProfBuff buffer = buffer_create(3);
+    _append_id(buffer, 0, "dup");
+    _append_id(buffer, 1, "dup");
+    _append(buffer, 2);
+
+    _append(buffer, 3);
+    _assert_message(buffer_get_entry_by_id(buffer, "dup"), 1);
+
+    _append(buffer, 4);
+    assert_null(buffer_get_entry_by_id(buffer, "dup"));
+
+    buffer_free(buffer);
+}
+
+void entry_by_id_after_prepend(void **state)
+{
+    ProfBuff buffer = buffer_create(4);
+    GDateTime *time = g_date_time_new_now_local();
+    _append_id(buffer, 0, "a");
+    _append_id(buffer, 1, "b");
+
+    assert_true(buffer_prepend(buffer, '-', 0, time, 0, THEME_TEXT, NULL, "older"));
+    _assert_message(buffer_get_entry_by_id(buffer, "a"), 0);
+    _assert_message(buffer_get_entry_by_id(buffer, "b"), 1);
+
+    buffer_remove_entry_by_id(buffer, "a");
+    assert_int_equal(2, buffer_size(buffer));
+    assert_string_equal("older", buffer_get_entry(buffer, 0)->message);
+    _assert_message(buffer_get_entry_by_id(buffer, "b"), 1);
+
+    g_date_time_unref(time);
+    buffer_free(buffer);
+}
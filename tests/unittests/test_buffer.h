@@ -0,0 +1,20 @@
+void spill_setup(void **state);
+void spill_teardown(void **state);
+
+void append_evicts_oldest_first(void **state);
+void evicted_entries_discarded_without_spill(void **state);
+void evicted_entries_spill_oldest_first(void **state);
+void spilled_entry_reads_back_all_fields(void **state);
+void spilled_entries_follow_resident_ones(void **state);
+void spill_drops_oldest_half_when_full(void **state);
+void budget_trims_each_buffer_oldest_first(void **state);
+void budget_keeps_minimum_resident_entries(void **state);
+void entries_within_budget_are_kept(void **state);
+void budget_counts_cached_layouts(void **state);
+void origin_follows_entries_dropped_and_prepended(void **state);
+void origin_unchanged_when_spilling(void **state);
+void remove_by_id_keeps_order_of_others(void **state);
+void remove_by_id_removes_every_duplicate(void **state);
+void remove_by_id_frees_space_for_appends(void **state);
+void entry_by_id_follows_eviction_of_duplicates(void **state);
+void entry_by_id_after_prepend(void **state);
@@ -373,6 +373,19 @@ void prof_partial_occurrences_tests(void **state)
     expected = g_slist_append(expected, GINT_TO_POINTER(29));
     assert_true(_lists_equal(prof_occurrences("boothj5", "hiboothj5 hello boothj5there boothj5s", 0, FALSE, &actual), expected)); g_slist_free(actual); actual = NULL;
     g_slist_free(expected); expected = NULL;
+
+    expected = g_slist_append(expected, GINT_TO_POINTER(16));
+    expected = g_slist_append(expected, GINT_TO_POINTER(29));
+    assert_true(_lists_equal(prof_occurrences("boothj5", "hiboothj5 hello boothj5there boothj5s", 3, FALSE, &actual), expected)); g_slist_free(actual); actual = NULL;
+    g_slist_free(expected); expected = NULL;
+
+    expected = g_slist_append(expected, GINT_TO_POINTER(0));
+    expected = g_slist_append(expected, GINT_TO_POINTER(1));
+    expected = g_slist_append(expected, GINT_TO_POINTER(5));
+    assert_true(_lists_equal(prof_occurrences("我我", "我我我 h我我", 0, FALSE, &actual), expected)); g_slist_free(actual); actual = NULL;
+    g_slist_free(expected); expected = NULL;
+
+    assert_true(_lists_equal(prof_occurrences("", "boothj5", 0, FALSE, &actual), expected)); g_slist_free(actual); actual = NULL;
 }
 
 void prof_whole_occurrences_tests(void **state)
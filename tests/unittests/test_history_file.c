@@ -0,0 +1,421 @@
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "common.h"
+#include "tools/history_file.h"
+
+#define HISTORY_LOG "./tests/files/2019_01_02.log"
+#define HISTORY_INDEX "./tests/files/" HISTORY_INDEX_NAME
+
+static HistoryFile*
+_history_file(const char *const contents)
+{
+    assert_true(mkdir_recursive("./tests/files"));
+    assert_true(g_file_set_contents(HISTORY_LOG, contents, -1, NULL));
+    return history_file_new(HISTORY_LOG, 2019, 1, 2, strlen(contents));
+}
+
+// read the whole file count messages at a time
+static GSList*
+_read_all(HistoryFile *file, int count)
+{
+    GSList *entries = NULL;
+    while (!history_file_done(file)) {
+        int found = history_file_read_back(file, count, &entries);
+        assert_true(found <= count);
+        assert_true(found == count || history_file_done(file));
+    }
+    return entries;
+}
+
+static void
+_assert_messages(GSList *entries, GPtrArray *expected)
+{
+    assert_int_equal(expected->len, g_slist_length(entries));
+    guint i = 0;
+    GSList *curr = entries;
+    while (curr) {
+        ProfHistoryEntry *entry = curr->data;
+        assert_string_equal(g_ptr_array_index(expected, i), entry->message);
+        curr = g_slist_next(curr);
+        i++;
+    }
+}
+
+static void
+_free_entries(GSList *entries)
+{
+    GSList *curr = entries;
+    while (curr) {
+        ProfHistoryEntry *entry = curr->data;
+        g_date_time_unref(entry->timestamp);
+        g_free(entry->message);
+        free(entry);
+        curr = g_slist_next(curr);
+    }
+    g_slist_free(entries);
+}
+
+static void
+_assert_day(GArray *days, guint index, int year, int month, int day, goffset size, int count)
+{
+    assert_true(index < days->len);
+    HistoryDay *found = &g_array_index(days, HistoryDay, index);
+    assert_int_equal(year, found->year);
+    assert_int_equal(month, found->month);
+    assert_int_equal(day, found->day);
+    assert_int_equal(size, found->size);
+    assert_int_equal(count, found->count);
+}
+
+static void
+_remove_history_dir(void)
+{
+    g_remove(HISTORY_INDEX);
+    g_remove(HISTORY_LOG);
+    g_remove("./tests/files/2019_01_01.log");
+    g_remove("./tests/files/notes.txt");
+    g_rmdir("./tests/files");
+}
+
+static void
+_remove_history_file(HistoryFile *file)
+{
+    history_file_free(file);
+    g_remove(HISTORY_LOG);
+    g_rmdir("./tests/files");
+}
+
+void history_reads_messages_oldest_first(void **state)
+{
+    HistoryFile *file = _history_file(
+        "10:00:00 - me: one\n"
+        "10:00:01 - bob: two\n"
+        "10:00:02 - me: three\n");
+
+    GSList *entries = NULL;
+    assert_int_equal(3, history_file_read_back(file, 10, &entries));
+    assert_true(history_file_done(file));
+
+    assert_int_equal(3, g_slist_length(entries));
+    ProfHistoryEntry *first = entries->data;
+    assert_string_equal("me: one", first->message);
+    assert_int_equal(2019, g_date_time_get_year(first->timestamp));
+    assert_int_equal(1, g_date_time_get_month(first->timestamp));
+    assert_int_equal(2, g_date_time_get_day_of_month(first->timestamp));
+    assert_int_equal(10, g_date_time_get_hour(first->timestamp));
+    assert_int_equal(0, g_date_time_get_second(first->timestamp));
+    ProfHistoryEntry *last = g_slist_last(entries)->data;
+    assert_string_equal("me: three", last->message);
+    assert_int_equal(2, g_date_time_get_second(last->timestamp));
+
+    _free_entries(entries);
+    _remove_history_file(file);
+}
+
+void history_reads_newest_messages_first(void **state)
+{
+    HistoryFile *file = _history_file(
+        "10:00:00 - me: one\n"
+        "10:00:01 - bob: two\n"
+        "10:00:02 - me: three\n");
+
+    GSList *entries = NULL;
+    assert_int_equal(2, history_file_read_back(file, 2, &entries));
+    assert_false(history_file_done(file));
+    assert_string_equal("bob: two", ((ProfHistoryEntry*)entries->data)->message);
+
+    assert_int_equal(1, history_file_read_back(file, 2, &entries));
+    assert_true(history_file_done(file));
+    assert_int_equal(3, g_slist_length(entries));
+    assert_string_equal("me: one", ((ProfHistoryEntry*)entries->data)->message);
+
+    _free_entries(entries);
+    _remove_history_file(file);
+}
+
+void history_joins_continuation_lines(void **state)
+{
+    HistoryFile *file = _history_file(
+        "10:00:00 - me: one\n"
+        "two\n"
+        "\n"
+        "three\n"
+        "10:00:01 - bob: four\n");
+
+    GSList *entries = _read_all(file, 1);
+
+    GPtrArray *expected = g_ptr_array_new();
+    g_ptr_array_add(expected, "me: one\ntwo\n\nthree");
+    g_ptr_array_add(expected, "bob: four");
+    _assert_messages(entries, expected);
+
+    g_ptr_array_free(expected, TRUE);
+    _free_entries(entries);
+    _remove_history_file(file);
+}
+
+void history_reads_lines_straddling_chunks(void **state)
+{
+    GString *contents = g_string_new(NULL);
+    GPtrArray *expected = g_ptr_array_new_with_free_func(g_free);
+    int i;
+    for (i = 0; i < 120; i++) {
+        GString *message = g_string_new(NULL);
+        g_string_append_printf(message, "me: %d ", i);
+        // lengths vary so the chunk boundaries fall at different places in the lines
+        int len = (i * 397) % 900;
+        int j;
+        for (j = 0; j < len; j++) {
+            g_string_append_c(message, 'a' + (i + j) % 26);
+        }
+        if (i % 5 == 0) {
+            g_string_append(message, "\ncontinued");
+        }
+        g_string_append_printf(contents, "10:%02d:%02d - %s\n", i / 60, i % 60, message->str);
+        g_ptr_array_add(expected, g_string_free(message, FALSE));
+    }
+    assert_true(contents->len > 4 * HISTORY_FILE_CHUNK);
+
+    int counts[] = { 1, 7, 1000 };
+    for (i = 0; i < 3; i++) {
+        HistoryFile *file = _history_file(contents->str);
+        GSList *entries = _read_all(file, counts[i]);
+        _assert_messages(entries, expected);
+        _free_entries(entries);
+        _remove_history_file(file);
+    }
+
+    g_ptr_array_free(expected, TRUE);
+    g_string_free(contents, TRUE);
+}
+
+void history_reads_message_longer_than_chunk(void **state)
+{
+    GString *message = g_string_new("me: ");
+    while (message->len < 3 * HISTORY_FILE_CHUNK) {
+        g_string_append(message, "long message ");
+    }
+    gchar *contents = g_strdup_printf("10:00:00 - me: before\n10:00:01 - %s\n10:00:02 - me: after\n", message->str);
+    HistoryFile *file = _history_file(contents);
+
+    GSList *entries = _read_all(file, 2);
+
+    GPtrArray *expected = g_ptr_array_new();
+    g_ptr_array_add(expected, "me: before");
+    g_ptr_array_add(expected, message->str);
+    g_ptr_array_add(expected, "me: after");
+    _assert_messages(entries, expected);
+
+    g_ptr_array_free(expected, TRUE);
+    _free_entries(entries);
+    _remove_history_file(file);
+    g_free(contents);
+    g_string_free(message, TRUE);
+}
+
+void history_reads_multibyte_text_split_by_chunk(void **state)
+{
+    // three byte characters, the chunk boundary falls inside one of them
+    GString *message = g_string_new("me: ab");
+    int i;
+    for (i = 0; i < 3000; i++) {
+        g_string_append(message, "\xe2\x82\xac");
+    }
+    gchar *contents = g_strdup_printf("10:00:00 - %s\n10:00:01 - me: \xc3\xbc\xc3\xb1\xc3\xaf!\n", message->str);
+    gsize boundary = strlen(contents) - HISTORY_FILE_CHUNK;
+    assert_true(boundary > strlen("10:00:00 - me: ab"));
+    assert_true((boundary - strlen("10:00:00 - me: ab")) % 3 != 0);
+    HistoryFile *file = _history_file(contents);
+
+    GSList *entries = _read_all(file, 1);
+
+    GPtrArray *expected = g_ptr_array_new();
+    g_ptr_array_add(expected, message->str);
+    g_ptr_array_add(expected, "me: \xc3\xbc\xc3\xb1\xc3\xaf!");
+    _assert_messages(entries, expected);
+    assert_true(g_utf8_validate(((ProfHistoryEntry*)entries->data)->message, -1, NULL));
+
+    g_ptr_array_free(expected, TRUE);
+    _free_entries(entries);
+    _remove_history_file(file);
+    g_free(contents);
+    g_string_free(message, TRUE);
+}
+
+void history_missing_file_is_done(void **state)
+{
+    HistoryFile *file = history_file_new("./tests/files/missing.log", 2019, 1, 2, 100);
+
+    GSList *entries = NULL;
+    assert_int_equal(0, history_file_read_back(file, 10, &entries));
+    assert_null(entries);
+    assert_true(history_file_done(file));
+
+    history_file_free(file);
+}
+
+void history_files_sort_newest_day_first(void **state)
+{
+    HistoryFile *dec_31 = history_file_new("2018_12_31.log", 2018, 12, 31, 1);
+    HistoryFile *jan_02 = history_file_new("2019_01_02.log", 2019, 1, 2, 1);
+    HistoryFile *jan_10 = history_file_new("2019_01_10.log", 2019, 1, 10, 1);
+    HistoryFile *feb_01 = history_file_new("2019_02_01.log", 2019, 2, 1, 1);
+
+    assert_true(history_file_cmp(&jan_02, &dec_31) < 0);
+    assert_true(history_file_cmp(&dec_31, &jan_02) > 0);
+    assert_true(history_file_cmp(&feb_01, &jan_10) < 0);
+    assert_true(history_file_cmp(&jan_10, &jan_02) < 0);
+    assert_true(history_file_cmp(&jan_02, &feb_01) > 0);
+    assert_int_equal(0, history_file_cmp(&jan_10, &jan_10));
+
+    history_file_free(dec_31);
+    history_file_free(jan_02);
+    history_file_free(jan_10);
+    history_file_free(feb_01);
+}
+
+void history_counts_messages_not_lines(void **state)
+{
+    const char *contents =
+        "10:00:00 - me: one\n"
+        "two\n"
+        "10:00:01 - bob: three\n";
+    HistoryFile *file = _history_file(contents);
+
+    goffset size;
+    assert_int_equal(2, history_file_count(HISTORY_LOG, &size));
+    assert_int_equal(strlen(contents), size);
+
+    assert_int_equal(0, history_file_count("./tests/files/missing.log", &size));
+    assert_int_equal(0, size);
+
+    _remove_history_file(file);
+}
+
+void history_index_missing_is_null(void **state)
+{
+    guint records = 10;
+    assert_null(history_index_read("./tests/files/missing", &records));
+    assert_int_equal(0, records);
+}
+
+void history_index_keeps_latest_record_of_each_day(void **state)
+{
+    assert_true(mkdir_recursive("./tests/files"));
+    assert_true(g_file_set_contents(HISTORY_INDEX,
+        "2019_01_01 20 1\n"
+        "2019_01_02 10 1\n"
+        "2019_01_01 45 2\n"
+        "garbage\n"
+        "2019_01_02 30 3\n", -1, NULL));
+
+    guint records;
+    GArray *days = history_index_read("./tests/files", &records);
+
+    assert_int_equal(5, records);
+    assert_int_equal(2, days->len);
+    _assert_day(days, 0, 2019, 1, 2, 30, 3);
+    _assert_day(days, 1, 2019, 1, 1, 45, 2);
+
+    g_array_free(days, TRUE);
+    _remove_history_dir();
+}
+
+void history_index_ignores_torn_record(void **state)
+{
+    assert_true(mkdir_recursive("./tests/files"));
+    assert_true(g_file_set_contents(HISTORY_INDEX,
+        "2019_01_02 10 1\n"
+        "2019_01_02 3", -1, NULL));
+
+    guint records;
+    GArray *days = history_index_read("./tests/files", &records);
+    assert_int_equal(1, records);
+    _assert_day(days, 0, 2019, 1, 2, 10, 1);
+    g_array_free(days, TRUE);
+
+    // a record appended after the torn one is still read
+    HistoryDay day = { 2019, 1, 2, 40, 4 };
+    assert_true(history_index_append("./tests/files", &day));
+
+    days = history_index_read("./tests/files", &records);
+
+    assert_int_equal(3, records);
+    assert_int_equal(1, days->len);
+    _assert_day(days, 0, 2019, 1, 2, 40, 4);
+
+    g_array_free(days, TRUE);
+    _remove_history_dir();
+}
+
+void history_index_append_replaces_day(void **state)
+{
+    assert_true(mkdir_recursive("./tests/files"));
+    HistoryDay first = { 2019, 1, 1, 100, 2 };
+    HistoryDay second = { 2019, 1, 2, 50, 1 };
+    HistoryDay later = { 2019, 1, 2, 90, 2 };
+    assert_true(history_index_append("./tests/files", &first));
+    assert_true(history_index_append("./tests/files", &second));
+    assert_true(history_index_append("./tests/files", &later));
+
+    guint records;
+    GArray *days = history_index_read("./tests/files", &records);
+
+    assert_int_equal(3, records);
+    assert_int_equal(2, days->len);
+    _assert_day(days, 0, 2019, 1, 2, 90, 2);
+    _assert_day(days, 1, 2019, 1, 1, 100, 2);
+
+    // compacting keeps one record per day
+    assert_true(history_index_write("./tests/files", days));
+    g_array_free(days, TRUE);
+    days = history_index_read("./tests/files", &records);
+
+    assert_int_equal(2, records);
+    _assert_day(days, 0, 2019, 1, 2, 90, 2);
+    _assert_day(days, 1, 2019, 1, 1, 100, 2);
+
+    g_array_free(days, TRUE);
+    _remove_history_dir();
+}
+
+void history_index_scan_lists_day_logs(void **state)
+{
+    const char *older = "09:00:00 - me: one\n";
+    const char *newer = "10:00:00 - me: two\nmore\n10:00:01 - bob: three\n";
+    assert_true(mkdir_recursive("./tests/files"));
+    assert_true(g_file_set_contents("./tests/files/2019_01_01.log", older, -1, NULL));
+    assert_true(g_file_set_contents(HISTORY_LOG, newer, -1, NULL));
+    assert_true(g_file_set_contents("./tests/files/notes.txt", "10:00:00 - me: not a log\n", -1, NULL));
+
+    GArray *days = history_index_scan("./tests/files", TRUE);
+    assert_int_equal(2, days->len);
+    _assert_day(days, 0, 2019, 1, 2, strlen(newer), 2);
+    _assert_day(days, 1, 2019, 1, 1, strlen(older), 1);
+    g_array_free(days, TRUE);
+
+    days = history_index_scan("./tests/files", FALSE);
+    assert_int_equal(2, days->len);
+    _assert_day(days, 0, 2019, 1, 2, strlen(newer), -1);
+    _assert_day(days, 1, 2019, 1, 1, strlen(older), -1);
+    g_array_free(days, TRUE);
+
+    _remove_history_dir();
+}
+
+void history_day_filename_matches_log_name(void **state)
+{
+    HistoryDay day = { 2019, 1, 2, 0, 0 };
+    gchar *filename = history_day_filename("./tests/files", &day);
+
+    assert_string_equal(HISTORY_LOG, filename);
+
+    g_free(filename);
+}
@@ -0,0 +1,15 @@
+void history_reads_messages_oldest_first(void **state);
+void history_reads_newest_messages_first(void **state);
+void history_joins_continuation_lines(void **state);
+void history_reads_lines_straddling_chunks(void **state);
+void history_reads_message_longer_than_chunk(void **state);
+void history_reads_multibyte_text_split_by_chunk(void **state);
+void history_missing_file_is_done(void **state);
+void history_files_sort_newest_day_first(void **state);
+void history_counts_messages_not_lines(void **state);
+void history_index_missing_is_null(void **state);
+void history_index_keeps_latest_record_of_each_day(void **state);
+void history_index_ignores_torn_record(void **state);
+void history_index_append_replaces_day(void **state);
+void history_index_scan_lists_day_logs(void **state);
+void history_day_filename_matches_log_name(void **state);
@@ -0,0 +1,206 @@
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "common.h"
+#include "tools/keyfile_journal.h"
+
+#define STORE "./tests/files/store.txt"
+#define STORE_JOURNAL STORE ".journal"
+
+static void
+_remove_store(void)
+{
+    g_remove(STORE);
+    g_remove(STORE_JOURNAL);
+}
+
+static void
+_write_file(const char *const filename, const char *const contents)
+{
+    assert_true(mkdir_recursive("./tests/files"));
+    assert_true(g_file_set_contents(filename, contents, -1, NULL));
+}
+
+static void
+_assert_file(const char *const filename, const char *const expected)
+{
+    gchar *contents = NULL;
+    assert_true(g_file_get_contents(filename, &contents, NULL, NULL));
+    assert_string_equal(expected, contents);
+    g_free(contents);
+}
+
+static void
+_assert_value(GKeyFile *keyfile, const char *const key, const char *const expected)
+{
+    gchar *value = g_key_file_get_string(keyfile, "g", key, NULL);
+    if (expected) {
+        assert_string_equal(expected, value);
+    } else {
+        assert_null(value);
+    }
+    g_free(value);
+}
+
+static void
+_set(KeyfileJournal *journal, GKeyFile *keyfile, const char *const key, const char *const value)
+{
+    if (value) {
+        g_key_file_set_string(keyfile, "g", key, value);
+    } else {
+        g_key_file_remove_key(keyfile, "g", key, NULL);
+    }
+    assert_true(keyfile_journal_record(journal, keyfile, "g", key, NULL));
+}
+
+// load the store as it is on disk
+static GKeyFile*
+_reload(void)
+{
+    KeyfileJournal journal;
+    GKeyFile *keyfile = g_key_file_new();
+    keyfile_journal_init(&journal, STORE);
+    assert_true(keyfile_journal_load(&journal, keyfile, NULL));
+    assert_true(keyfile_journal_close(&journal, NULL));
+    return keyfile;
+}
+
+void keyfile_journal_replays_records_over_store(void **state)
+{
+    _remove_store();
+    _write_file(STORE, "[g]\na=1\nc=3\n");
+
+    KeyfileJournal journal;
+    GKeyFile *keyfile = g_key_file_new();
+    keyfile_journal_init(&journal, STORE);
+    assert_true(keyfile_journal_load(&journal, keyfile, NULL));
+    _set(&journal, keyfile, "a", "2");
+    _set(&journal, keyfile, "b", "tab\tand\nnewline");
+    _set(&journal, keyfile, "c", NULL);
+    assert_true(keyfile_journal_close(&journal, NULL));
+    g_key_file_free(keyfile);
+
+    // only the journal was written to
+    _assert_file(STORE, "[g]\na=1\nc=3\n");
+
+    keyfile = _reload();
+    _assert_value(keyfile, "a", "2");
+    _assert_value(keyfile, "b", "tab\tand\nnewline");
+    _assert_value(keyfile, "c", NULL);
+    g_key_file_free(keyfile);
+
+    _remove_store();
+}
+
+void keyfile_journal_replays_without_store(void **state)
+{
+    _remove_store();
+    _write_file(STORE_JOURNAL, "+\tg\ta\t1\n");
+
+    GKeyFile *keyfile = _reload();
+    _assert_value(keyfile, "a", "1");
+    g_key_file_free(keyfile);
+
+    _remove_store();
+}
+
+void keyfile_journal_cuts_torn_final_record(void **state)
+{
+    _remove_store();
+    _write_file(STORE, "[g]\na=1\n");
+    _write_file(STORE_JOURNAL, "+\tg\ta\t2\n+\tg\tb\tpar");
+
+    KeyfileJournal journal;
+    GKeyFile *keyfile = g_key_file_new();
+    keyfile_journal_init(&journal, STORE);
+    assert_true(keyfile_journal_load(&journal, keyfile, NULL));
+    _assert_value(keyfile, "a", "2");
+    _assert_value(keyfile, "b", NULL);
+    _assert_file(STORE_JOURNAL, "+\tg\ta\t2\n");
+
+    // the next record starts on a line of its own
+    _set(&journal, keyfile, "c", "3");
+    assert_true(keyfile_journal_close(&journal, NULL));
+    g_key_file_free(keyfile);
+
+    keyfile = _reload();
+    _assert_value(keyfile, "a", "2");
+    _assert_value(keyfile, "b", NULL);
+    _assert_value(keyfile, "c", "3");
+    g_key_file_free(keyfile);
+
+    _remove_store();
+}
+
+void keyfile_journal_compacts_into_store(void **state)
+{
+    _remove_store();
+
+    KeyfileJournal journal;
+    GKeyFile *keyfile = g_key_file_new();
+    keyfile_journal_init(&journal, STORE);
+    GError *error = NULL;
+    assert_false(keyfile_journal_load(&journal, keyfile, &error));
+    assert_true(g_error_matches(error, G_FILE_ERROR, G_FILE_ERROR_NOENT));
+    g_error_free(error);
+
+    _set(&journal, keyfile, "a", "1");
+    assert_false(g_file_test(STORE, G_FILE_TEST_EXISTS));
+
+    gchar *large = g_strnfill(KEYFILE_JOURNAL_COMPACT_SIZE, 'x');
+    _set(&journal, keyfile, "b", large);
+    _assert_file(STORE_JOURNAL, "");
+
+    // records after compaction go to the emptied journal
+    _set(&journal, keyfile, "c", "3");
+    _assert_file(STORE_JOURNAL, "+\tg\tc\t3\n");
+    assert_true(keyfile_journal_close(&journal, NULL));
+    g_key_file_free(keyfile);
+
+    keyfile = _reload();
+    _assert_value(keyfile, "a", "1");
+    _assert_value(keyfile, "b", large);
+    _assert_value(keyfile, "c", "3");
+    g_key_file_free(keyfile);
+    g_free(large);
+
+    _remove_store();
+}
+
+void keyfile_journal_keeps_unreadable_store(void **state)
+{
+    _remove_store();
+    _write_file(STORE, "not a key file\n");
+    _write_file(STORE_JOURNAL, "+\tg\ta\t1\n");
+
+    KeyfileJournal journal;
+    GKeyFile *keyfile = g_key_file_new();
+    keyfile_journal_init(&journal, STORE);
+    GError *error = NULL;
+    assert_false(keyfile_journal_load(&journal, keyfile, &error));
+    assert_non_null(error);
+    g_error_free(error);
+
+    // changes are still journalled but the store is never rewritten
+    _set(&journal, keyfile, "b", "2");
+    assert_false(keyfile_journal_save(&journal, keyfile, NULL));
+    gchar *large = g_strnfill(KEYFILE_JOURNAL_COMPACT_SIZE, 'x');
+    _set(&journal, keyfile, "c", large);
+    g_free(large);
+    assert_true(keyfile_journal_close(&journal, NULL));
+    g_key_file_free(keyfile);
+
+    _assert_file(STORE, "not a key file\n");
+    gchar *contents = NULL;
+    assert_true(g_file_get_contents(STORE_JOURNAL, &contents, NULL, NULL));
+    assert_true(g_str_has_prefix(contents, "+\tg\ta\t1\n+\tg\tb\t2\n+\tg\tc\t"));
+    g_free(contents);
+
+    _remove_store();
+}
@@ -0,0 +1,5 @@
+void keyfile_journal_replays_records_over_store(void **state);
+void keyfile_journal_replays_without_store(void **state);
+void keyfile_journal_cuts_torn_final_record(void **state);
+void keyfile_journal_compacts_into_store(void **state);
+void keyfile_journal_keeps_unreadable_store(void **state);
@@ -0,0 +1,184 @@
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "common.h"
+#include "tools/log_writer.h"
+
+#define LOG_FILE "./tests/files/writer.log"
+#define THREADS 8
+#define LINES 2000
+
+typedef struct test_logger_t {
+    LogWriter writer;
+    int num;
+} TestLogger;
+
+// the message a thread logs as its index'th line, of varying length
+static gchar*
+_message(int thread, int index)
+{
+    GString *message = g_string_new(NULL);
+    g_string_printf(message, "thread %d line %05d ", thread, index);
+    int i;
+    for (i = 0; i < (index * 7 + thread) % 100; i++) {
+        g_string_append_c(message, 'a' + (i % 26));
+    }
+    return g_string_free(message, FALSE);
+}
+
+static void*
+_log_lines(void *data)
+{
+    TestLogger *logger = data;
+    int i;
+    for (i = 0; i < LINES; i++) {
+        gchar *message = _message(logger->num, i);
+        // errors are written straight away, mixing in early writes
+        log_level_t level = i % 500 == 0 ? PROF_LEVEL_ERROR : PROF_LEVEL_INFO;
+        log_writer_append(logger->writer, level, "test", message);
+        g_free(message);
+    }
+    return NULL;
+}
+
+static void
+_remove_logs(void)
+{
+    g_remove(LOG_FILE);
+    int i;
+    for (i = 1; i < 100; i++) {
+        gchar *rotated = g_strdup_printf("%s.%02d", LOG_FILE, i);
+        g_remove(rotated);
+        g_free(rotated);
+    }
+}
+
+// the message of a log line after its timestamp and area, checking both
+static const gchar*
+_line_message(const gchar *const line, const gchar *const area)
+{
+    // dd/mm/yyyy hh:mm:ss
+    assert_true(strlen(line) > 19);
+    assert_int_equal('/', line[2]);
+    assert_int_equal(':', line[13]);
+    const gchar *rest = line + 19;
+
+    gchar *prefix = g_strdup_printf(": %s: ", area);
+    assert_true(g_str_has_prefix(rest, prefix));
+    rest += strlen(prefix);
+    g_free(prefix);
+
+    assert_true(g_str_has_prefix(rest, "INF: ") || g_str_has_prefix(rest, "ERR: "));
+    return rest + strlen("INF: ");
+}
+
+static gchar**
+_read_lines(const char *const filename)
+{
+    gchar *contents = NULL;
+    assert_true(g_file_get_contents(filename, &contents, NULL, NULL));
+    assert_true(contents[0] == '\0' || g_str_has_suffix(contents, "\n"));
+    gchar **lines = g_strsplit(contents, "\n", -1);
+    g_free(contents);
+    return lines;
+}
+
+void log_writer_keeps_lines_from_threads_intact(void **state)
+{
+    _remove_logs();
+    assert_true(mkdir_recursive("./tests/files"));
+    LogWriter writer = log_writer_open(LOG_FILE, "prof", PROF_LEVEL_DEBUG, FALSE, 0);
+    assert_non_null(writer);
+
+    pthread_t threads[THREADS];
+    TestLogger loggers[THREADS];
+    int i;
+    for (i = 0; i < THREADS; i++) {
+        loggers[i].writer = writer;
+        loggers[i].num = i;
+        assert_int_equal(0, pthread_create(&threads[i], NULL, _log_lines, &loggers[i]));
+    }
+    for (i = 0; i < THREADS; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    log_writer_close(writer);
+
+    // every line is whole, and each thread's lines are in the order logged
+    int next[THREADS] = { 0 };
+    gchar **lines = _read_lines(LOG_FILE);
+    int count = 0;
+    for (i = 0; lines[i] && lines[i][0]; i++) {
+        const gchar *message = _line_message(lines[i], "test");
+        int thread = -1;
+        int index = -1;
+        assert_int_equal(2, sscanf(message, "thread %d line %d", &thread, &index));
+        assert_true(thread >= 0 && thread < THREADS);
+        assert_int_equal(next[thread], index);
+        gchar *expected = _message(thread, index);
+        assert_string_equal(expected, message);
+        g_free(expected);
+        next[thread]++;
+        count++;
+    }
+    g_strfreev(lines);
+
+    assert_int_equal(THREADS * LINES, count);
+    _remove_logs();
+}
+
+void log_writer_rotates_without_losing_lines(void **state)
+{
+    _remove_logs();
+    assert_true(mkdir_recursive("./tests/files"));
+    LogWriter writer = log_writer_open(LOG_FILE, "prof", PROF_LEVEL_DEBUG, TRUE, 4096);
+    assert_non_null(writer);
+
+    TestLogger logger = { writer, 0 };
+    _log_lines(&logger);
+    log_writer_close(writer);
+
+    // rotated files oldest first, then the current one
+    GPtrArray *files = g_ptr_array_new_with_free_func(g_free);
+    int i;
+    for (i = 1; i < 100; i++) {
+        gchar *rotated = g_strdup_printf("%s.%02d", LOG_FILE, i);
+        if (!g_file_test(rotated, G_FILE_TEST_EXISTS)) {
+            g_free(rotated);
+            break;
+        }
+        g_ptr_array_add(files, rotated);
+    }
+    int rotated = files->len;
+    g_ptr_array_add(files, g_strdup(LOG_FILE));
+
+    int notes = 0;
+    int next = 0;
+    guint file;
+    for (file = 0; file < files->len; file++) {
+        gchar **lines = _read_lines(g_ptr_array_index(files, file));
+        for (i = 0; lines[i] && lines[i][0]; i++) {
+            if (g_str_has_suffix(lines[i], ": prof: INF: Log has been rotated")) {
+                notes++;
+                continue;
+            }
+            gchar *expected = _message(0, next);
+            assert_string_equal(expected, _line_message(lines[i], "test"));
+            g_free(expected);
+            next++;
+        }
+        g_strfreev(lines);
+    }
+    g_ptr_array_free(files, TRUE);
+
+    assert_int_equal(LINES, next);
+    assert_true(rotated > 0);
+    assert_int_equal(rotated, notes);
+    _remove_logs();
+}
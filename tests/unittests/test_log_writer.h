@@ -0,0 +1,2 @@
+void log_writer_keeps_lines_from_threads_intact(void **state);
+void log_writer_rotates_without_losing_lines(void **state);
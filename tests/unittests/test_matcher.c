@@ -0,0 +1,204 @@
+#include <glib.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <stdlib.h>
+
+#include "tools/matcher.h"
+
+static void
+_assert_hits(GSList *hits, const int *const ids, const int *const offsets, int count)
+{
+    assert_int_equal(count, g_slist_length(hits));
+    int i = 0;
+    GSList *curr = hits;
+    while (curr) {
+        MatcherHit *hit = curr->data;
+        assert_int_equal(ids[i], hit->id);
+        assert_int_equal(offsets[i], hit->offset);
+        curr = g_slist_next(curr);
+        i++;
+    }
+}
+
+void matcher_finds_overlapping_occurrences(void **state)
+{
+    Matcher matcher = matcher_new();
+    matcher_add(matcher, "aa", 1, FALSE);
+
+    GSList *hits = matcher_find(matcher, "aaaa");
+
+    int ids[] = { 1, 1, 1 };
+    int offsets[] = { 0, 1, 2 };
+    _assert_hits(hits, ids, offsets, 3);
+
+    g_slist_free_full(hits, free);
+    matcher_free(matcher);
+}
+
+void matcher_finds_overlapping_patterns(void **state)
+{
+    Matcher matcher = matcher_new();
+    matcher_add(matcher, "he", 1, FALSE);
+    matcher_add(matcher, "she", 2, FALSE);
+    matcher_add(matcher, "his", 3, FALSE);
+    matcher_add(matcher, "hers", 4, FALSE);
+
+    GSList *hits = matcher_find(matcher, "ushers");
+
+    // in the order they end, longest first when they end together
+    int ids[] = { 2, 1, 4 };
+    int offsets[] = { 1, 2, 2 };
+    _assert_hits(hits, ids, offsets, 3);
+
+    g_slist_free_full(hits, free);
+    matcher_free(matcher);
+}
+
+void matcher_finds_pattern_that_is_suffix_of_another(void **state)
+{
+    Matcher matcher = matcher_new();
+    matcher_add(matcher, "cd", 1, FALSE);
+    matcher_add(matcher, "abcd", 2, FALSE);
+
+    GSList *hits = matcher_find(matcher, "xabcdxcd");
+
+    int ids[] = { 2, 1, 1 };
+    int offsets[] = { 1, 3, 6 };
+    _assert_hits(hits, ids, offsets, 3);
+
+    g_slist_free_full(hits, free);
+    matcher_free(matcher);
+}
+
+void matcher_finds_pattern_inside_another(void **state)
+{
+    Matcher matcher = matcher_new();
+    matcher_add(matcher, "abcd", 1, FALSE);
+    matcher_add(matcher, "bc", 2, FALSE);
+
+    GSList *hits = matcher_find(matcher, "abcd");
+
+    int ids[] = { 2, 1 };
+    int offsets[] = { 1, 0 };
+    _assert_hits(hits, ids, offsets, 2);
+
+    g_slist_free_full(hits, free);
+    matcher_free(matcher);
+}
+
+void matcher_ignores_empty_pattern(void **state)
+{
+    Matcher matcher = matcher_new();
+    matcher_add(matcher, "", 1, FALSE);
+    matcher_add(matcher, NULL, 2, FALSE);
+
+    assert_null(matcher_find(matcher, "some text"));
+
+    matcher_add(matcher, "t", 3, FALSE);
+    GSList *hits = matcher_find(matcher, "text");
+
+    int ids[] = { 3, 3 };
+    int offsets[] = { 0, 3 };
+    _assert_hits(hits, ids, offsets, 2);
+
+    g_slist_free_full(hits, free);
+    matcher_free(matcher);
+}
+
+void matcher_finds_nothing_in_empty_text(void **state)
+{
+    Matcher matcher = matcher_new();
+    matcher_add(matcher, "nick", 1, FALSE);
+
+    assert_null(matcher_find(matcher, ""));
+    assert_null(matcher_find(matcher, NULL));
+
+    matcher_free(matcher);
+}
+
+void matcher_counts_offsets_in_characters(void **state)
+{
+    Matcher matcher = matcher_new();
+    matcher_add(matcher, "nick", 1, FALSE);
+    matcher_add(matcher, "吞下", 2, FALSE);
+
+    GSList *hits = matcher_find(matcher, "我能吞下 nick ünïcode nick");
+
+    int ids[] = { 2, 1, 1 };
+    int offsets[] = { 2, 5, 18 };
+    _assert_hits(hits, ids, offsets, 3);
+
+    g_slist_free_full(hits, free);
+    matcher_free(matcher);
+}
+
+void matcher_whole_word_needs_boundaries(void **state)
+{
+    Matcher matcher = matcher_new();
+    matcher_add(matcher, "nick", 1, TRUE);
+
+    GSList *hits = matcher_find(matcher, "nick nickname @nick, unick nick");
+
+    int ids[] = { 1, 1, 1 };
+    int offsets[] = { 0, 15, 27 };
+    _assert_hits(hits, ids, offsets, 3);
+
+    g_slist_free_full(hits, free);
+    matcher_free(matcher);
+}
+
+void matcher_whole_word_treats_unicode_letters_as_word(void **state)
+{
+    Matcher matcher = matcher_new();
+    matcher_add(matcher, "nick", 1, TRUE);
+
+    assert_null(matcher_find(matcher, "ünick nické 我nick"));
+
+    GSList *hits = matcher_find(matcher, "«nick» —nick—");
+
+    int ids[] = { 1, 1 };
+    int offsets[] = { 1, 8 };
+    _assert_hits(hits, ids, offsets, 2);
+
+    g_slist_free_full(hits, free);
+    matcher_free(matcher);
+}
+
+void matcher_mixes_whole_word_and_partial_patterns(void **state)
+{
+    Matcher matcher = matcher_new();
+    matcher_add(matcher, "nick", 1, TRUE);
+    matcher_add(matcher, "nick", 2, FALSE);
+
+    GSList *hits = matcher_find(matcher, "nickname nick");
+
+    int ids[] = { 2, 2, 1 };
+    int offsets[] = { 0, 9, 9 };
+    _assert_hits(hits, ids, offsets, 3);
+
+    g_slist_free_full(hits, free);
+    matcher_free(matcher);
+}
+
+void matcher_rebuilds_after_add(void **state)
+{
+    Matcher matcher = matcher_new();
+    matcher_add(matcher, "one", 1, FALSE);
+
+    GSList *hits = matcher_find(matcher, "one two");
+    int first_ids[] = { 1 };
+    int first_offsets[] = { 0 };
+    _assert_hits(hits, first_ids, first_offsets, 1);
+    g_slist_free_full(hits, free);
+
+    matcher_add(matcher, "two", 2, FALSE);
+    hits = matcher_find(matcher, "one two");
+    int ids[] = { 1, 2 };
+    int offsets[] = { 0, 4 };
+    _assert_hits(hits, ids, offsets, 2);
+
+    g_slist_free_full(hits, free);
+    matcher_free(matcher);
+}
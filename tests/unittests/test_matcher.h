@@ -0,0 +1,11 @@
+void matcher_finds_overlapping_occurrences(void **state);
+void matcher_finds_overlapping_patterns(void **state);
+void matcher_finds_pattern_that_is_suffix_of_another(void **state);
+void matcher_finds_pattern_inside_another(void **state);
+void matcher_ignores_empty_pattern(void **state);
+void matcher_finds_nothing_in_empty_text(void **state);
+void matcher_counts_offsets_in_characters(void **state);
+void matcher_whole_word_needs_boundaries(void **state);
+void matcher_whole_word_treats_unicode_letters_as_word(void **state);
+void matcher_mixes_whole_word_and_partial_patterns(void **state);
+void matcher_rebuilds_after_add(void **state);
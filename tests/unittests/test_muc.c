@@ -76,3 +76,48 @@ void test_muc_active(void **state)
 
     assert_true(room_is_active);
 }
+
+void test_muc_roster_sorted_by_nick(void **state)
+{
+    char *room = "room@server.org";
+    muc_join(room, "bob", NULL, FALSE);
+    muc_roster_add(room, "mike", NULL, "participant", "none", NULL, NULL);
+    muc_roster_add(room, "alice", NULL, "moderator", "owner", NULL, NULL);
+    muc_roster_add(room, "zed", NULL, "visitor", "none", NULL, NULL);
+    muc_roster_add(room, "carol", NULL, "participant", "none", NULL, NULL);
+
+    GList *occupants = muc_roster(room);
+
+    assert_int_equal(4, g_list_length(occupants));
+    assert_string_equal("alice", ((Occupant*)g_list_nth_data(occupants, 0))->nick);
+    assert_string_equal("carol", ((Occupant*)g_list_nth_data(occupants, 1))->nick);
+    assert_string_equal("mike", ((Occupant*)g_list_nth_data(occupants, 2))->nick);
+    assert_string_equal("zed", ((Occupant*)g_list_nth_data(occupants, 3))->nick);
+
+    g_list_free(occupants);
+}
+
+void test_muc_roster_update_and_remove_keep_order(void **state)
+{
+    char *room = "room@server.org";
+    muc_join(room, "bob", NULL, FALSE);
+    muc_roster_add(room, "mike", NULL, "participant", "none", NULL, NULL);
+    muc_roster_add(room, "alice", NULL, "participant", "none", NULL, NULL);
+    muc_roster_add(room, "carol", NULL, "participant", "none", NULL, NULL);
+    muc_roster_add(room, "alice", NULL, "moderator", "none", "away", NULL);
+    muc_roster_remove(room, "carol");
+
+    GList *occupants = muc_roster(room);
+
+    assert_int_equal(2, g_list_length(occupants));
+    Occupant *alice = g_list_nth_data(occupants, 0);
+    assert_string_equal("alice", alice->nick);
+    assert_int_equal(MUC_ROLE_MODERATOR, alice->role);
+    assert_string_equal("mike", ((Occupant*)g_list_nth_data(occupants, 1))->nick);
+
+    GSList *moderators = muc_occupants_by_role(room, MUC_ROLE_MODERATOR);
+    assert_int_equal(1, g_slist_length(moderators));
+
+    g_slist_free(moderators);
+    g_list_free(occupants);
+}
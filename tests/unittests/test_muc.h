@@ -7,3 +7,5 @@ void test_muc_invites_count_0(void **state);
 void test_muc_invites_count_5(void **state);
 void test_muc_room_is_not_active(void **state);
 void test_muc_active(void **state);
+void test_muc_roster_sorted_by_nick(void **state);
+void test_muc_roster_update_and_remove_keep_order(void **state);
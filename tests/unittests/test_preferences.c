@@ -34,3 +34,21 @@ void statuses_muc_defaults_to_all(void **state)
     assert_string_equal("all", setting);
     prefs_free_string(setting);
 }
+
+void cached_string_updated_when_set(void **state)
+{
+    assert_string_equal("all", prefs_get_string_cached(PREF_STATUSES_CONSOLE));
+
+    prefs_set_string(PREF_STATUSES_CONSOLE, "online");
+
+    assert_string_equal("online", prefs_get_string_cached(PREF_STATUSES_CONSOLE));
+}
+
+void cached_boolean_updated_when_set(void **state)
+{
+    assert_true(prefs_get_boolean(PREF_WRAP));
+
+    prefs_set_boolean(PREF_WRAP, FALSE);
+
+    assert_false(prefs_get_boolean(PREF_WRAP));
+}
@@ -1,3 +1,5 @@
 void statuses_console_defaults_to_all(void **state);
 void statuses_chat_defaults_to_all(void **state);
 void statuses_muc_defaults_to_all(void **state);
+void cached_string_updated_when_set(void **state);
+void cached_boolean_updated_when_set(void **state);
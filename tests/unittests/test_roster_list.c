@@ -657,3 +657,90 @@ void remove_contact_with_remaining_in_group(void **state)
     g_list_free_full(groups_res, free);
     roster_destroy();
 }
+
+static ProfRosterItem*
+_roster_item(const char *const barejid, const char *const name, GSList *groups)
+{
+    ProfRosterItem *item = malloc(sizeof(ProfRosterItem));
+    item->barejid = strdup(barejid);
+    item->name = name ? strdup(name) : NULL;
+    item->groups = groups;
+    item->subscription = NULL;
+    item->pending_out = FALSE;
+
+    return item;
+}
+
+static void
+_free_roster_item(ProfRosterItem *item)
+{
+    free(item->barejid);
+    free(item->name);
+    g_slist_free_full(item->groups, free);
+    free(item);
+}
+
+void add_all_adds_contacts_names_and_groups(void **state)
+{
+    roster_create();
+
+    GSList *groups1 = NULL;
+    groups1 = g_slist_append(groups1, strdup("friends"));
+    groups1 = g_slist_append(groups1, strdup("work"));
+    GSList *groups2 = NULL;
+    groups2 = g_slist_append(groups2, strdup("friends"));
+
+    GSList *items = NULL;
+    items = g_slist_append(items, _roster_item("person@server.org", "Person", groups1));
+    items = g_slist_append(items, _roster_item("bob@server.org", NULL, groups2));
+
+    int added = roster_add_all(items);
+    assert_int_equal(2, added);
+
+    GSList *contacts = roster_get_contacts(ROSTER_ORD_NAME);
+    assert_int_equal(2, g_slist_length(contacts));
+    g_slist_free(contacts);
+
+    assert_string_equal("person@server.org", roster_barejid_from_name("Person"));
+    assert_string_equal("bob@server.org", roster_barejid_from_name("bob@server.org"));
+
+    char *complete = roster_contact_autocomplete("Per", FALSE);
+    assert_string_equal("Person", complete);
+    free(complete);
+
+    GList *groups_res = roster_get_groups();
+    assert_int_equal(2, g_list_length(groups_res));
+    g_list_free_full(groups_res, free);
+
+    g_slist_free_full(items, (GDestroyNotify)_free_roster_item);
+    roster_destroy();
+}
+
+void add_all_skips_duplicates(void **state)
+{
+    roster_create();
+    roster_add("bob@server.org", NULL, NULL, NULL, FALSE);
+
+    GSList *groups = NULL;
+    groups = g_slist_append(groups, strdup("friends"));
+
+    GSList *items = NULL;
+    items = g_slist_append(items, _roster_item("bob@server.org", "Bob", groups));
+    items = g_slist_append(items, _roster_item("person@server.org", NULL, NULL));
+
+    int added = roster_add_all(items);
+    assert_int_equal(1, added);
+
+    // the duplicate keeps its groups, the caller frees them
+    ProfRosterItem *dup = items->data;
+    assert_non_null(dup->groups);
+
+    PContact bob = roster_get_contact("bob@server.org");
+    assert_null(p_contact_name(bob));
+
+    GList *groups_res = roster_get_groups();
+    assert_null(groups_res);
+
+    g_slist_free_full(items, (GDestroyNotify)_free_roster_item);
+    roster_destroy();
+}
@@ -30,3 +30,5 @@ void add_contacts_with_different_groups(void **state);
 void add_contacts_with_same_groups(void **state);
 void add_contacts_with_overlapping_groups(void **state);
 void remove_contact_with_remaining_in_group(void **state);
+void add_all_adds_contacts_names_and_groups(void **state);
+void add_all_skips_duplicates(void **state);
@@ -0,0 +1,336 @@
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "helpers.h"
+#include "common.h"
+#include "search.h"
+
+#define DATA_DIR "./tests/files/xdg_data_home/profanity"
+#define BOB_LOGS DATA_DIR "/chatlogs/me_at_ex.org/bob_at_ex.org"
+#define ROOM_LOGS DATA_DIR "/chatlogs/me_at_ex.org/rooms/fruit_at_conf.ex.org"
+
+static void
+_write_log(const char *const dir, const char *const name, const char *const contents)
+{
+    assert_true(mkdir_recursive(dir));
+    gchar *path = g_build_filename(dir, name, NULL);
+    assert_true(g_file_set_contents(path, contents, -1, NULL));
+    g_free(path);
+}
+
+static void
+_remove_tree(const char *const path)
+{
+    GDir *dir = g_dir_open(path, 0, NULL);
+    if (dir) {
+        const gchar *name;
+        while ((name = g_dir_read_name(dir)) != NULL) {
+            gchar *child = g_build_filename(path, name, NULL);
+            _remove_tree(child);
+            g_free(child);
+        }
+        g_dir_close(dir);
+    }
+    g_remove(path);
+}
+
+static GSList*
+_search(const char *const text, int max_results)
+{
+    SearchQuery *query = search_query_parse(text);
+    assert_non_null(query);
+    GSList *results = search_run(query, max_results);
+    search_query_free(query);
+    return results;
+}
+
+// wait for the indexer to reach the messages matching text
+static void
+_wait_for(const char *const text, guint count)
+{
+    GSList *results = NULL;
+    int tries;
+    for (tries = 0; tries < 500; tries++) {
+        results = _search(text, 100);
+        if (g_slist_length(results) == count) {
+            break;
+        }
+        search_results_free(results);
+        results = NULL;
+        g_usleep(10000);
+    }
+    assert_int_equal(count, g_slist_length(results));
+    search_results_free(results);
+}
+
+static void
+_assert_result(GSList *results, int index, const char *const jid, gboolean groupchat, const char *const message)
+{
+    SearchResult *result = g_slist_nth_data(results, index);
+    assert_non_null(result);
+    assert_string_equal(jid, result->jid);
+    assert_int_equal(groupchat, result->groupchat);
+    assert_string_equal(message, result->message);
+}
+
+static void
+_assert_terms(SearchQuery *query, const char *const *expected)
+{
+    assert_non_null(query);
+    guint i;
+    for (i = 0; expected[i]; i++) {
+        assert_true(i < query->terms->len);
+        assert_string_equal(expected[i], g_ptr_array_index(query->terms, i));
+    }
+    assert_int_equal(i, query->terms->len);
+}
+
+void search_setup(void **state)
+{
+    create_data_dir(state);
+    _write_log(BOB_LOGS, "2019_01_01.log",
+        "10:00:00 - bob@ex.org: hello apples\n"
+        "10:01:00 - me: apples and\n"
+        "pears\n");
+    _write_log(BOB_LOGS, "2019_01_02.log",
+        "09:00:00 - bob@ex.org: more apples\n");
+    _write_log(ROOM_LOGS, "2019_01_03.log",
+        "11:00:00 - alice: apples in the room\n");
+
+    search_init();
+    _wait_for("apples", 4);
+}
+
+void search_teardown(void **state)
+{
+    search_close();
+    _remove_tree(DATA_DIR "/chatlogs");
+    _remove_tree(DATA_DIR "/searchindex");
+    remove_data_dir(state);
+}
+
+void query_splits_terms_on_punctuation(void **state)
+{
+    SearchQuery *query = search_query_parse("Hello, world!  see-you");
+
+    const char *expected[] = { "hello", "world", "see", "you", NULL };
+    _assert_terms(query, expected);
+
+    search_query_free(query);
+}
+
+void query_drops_single_character_terms(void **state)
+{
+    SearchQuery *query = search_query_parse("a to b");
+
+    const char *expected[] = { "to", NULL };
+    _assert_terms(query, expected);
+
+    search_query_free(query);
+}
+
+void query_truncates_long_terms(void **state)
+{
+    SearchQuery *query = search_query_parse("xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx");
+
+    const char *expected[] = { "xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx", NULL };
+    _assert_terms(query, expected);
+
+    search_query_free(query);
+}
+
+void query_lowercases_multibyte_terms(void **state)
+{
+    SearchQuery *query = search_query_parse("\xc3\x84rger \xc3\x89T\xc3\x89");
+
+    const char *expected[] = { "\xc3\xa4rger", "\xc3\xa9t\xc3\xa9", NULL };
+    _assert_terms(query, expected);
+
+    search_query_free(query);
+}
+
+void query_splits_terms_on_invalid_utf8(void **state)
+{
+    SearchQuery *query = search_query_parse("ab\xff" "cd");
+
+    const char *expected[] = { "ab", "cd", NULL };
+    _assert_terms(query, expected);
+
+    search_query_free(query);
+}
+
+void query_parses_filters(void **state)
+{
+    SearchQuery *query = search_query_parse("with:bob@ex.org room:fruit@conf.ex.org since:2019-01-02 until:2019-02-03 hi");
+
+    const char *expected[] = { "hi", NULL };
+    _assert_terms(query, expected);
+    assert_string_equal("bob@ex.org", query->with);
+    assert_string_equal("fruit@conf.ex.org", query->room);
+    assert_int_equal(20190102, query->since);
+    assert_int_equal(20190203, query->until);
+
+    search_query_free(query);
+}
+
+void query_without_dates_matches_all_days(void **state)
+{
+    SearchQuery *query = search_query_parse("hello");
+
+    assert_null(query->with);
+    assert_null(query->room);
+    assert_int_equal(0, query->since);
+    assert_int_equal(G_MAXUINT32, query->until);
+
+    search_query_free(query);
+}
+
+void query_with_invalid_date_is_null(void **state)
+{
+    assert_null(search_query_parse("since:2019-13-01 hello"));
+    assert_null(search_query_parse("until:yesterday hello"));
+}
+
+void query_without_terms_is_null(void **state)
+{
+    assert_null(search_query_parse("with:bob@ex.org"));
+    assert_null(search_query_parse(""));
+}
+
+void search_returns_most_recent_oldest_first(void **state)
+{
+    GSList *results = _search("apples", 2);
+
+    assert_int_equal(2, g_slist_length(results));
+    _assert_result(results, 0, "bob@ex.org", FALSE, "bob@ex.org: more apples");
+    _assert_result(results, 1, "fruit@conf.ex.org", TRUE, "alice: apples in the room");
+
+    search_results_free(results);
+}
+
+void search_orders_messages_of_a_day_as_logged(void **state)
+{
+    GSList *results = _search("apples until:2019-01-01", 10);
+
+    assert_int_equal(2, g_slist_length(results));
+    _assert_result(results, 0, "bob@ex.org", FALSE, "bob@ex.org: hello apples");
+    _assert_result(results, 1, "bob@ex.org", FALSE, "me: apples and\npears");
+
+    search_results_free(results);
+}
+
+void search_matches_all_terms(void **state)
+{
+    GSList *results = _search("APPLES hello", 10);
+
+    assert_int_equal(1, g_slist_length(results));
+    _assert_result(results, 0, "bob@ex.org", FALSE, "bob@ex.org: hello apples");
+
+    search_results_free(results);
+}
+
+void search_matches_continuation_lines(void **state)
+{
+    GSList *results = _search("pears", 10);
+
+    assert_int_equal(1, g_slist_length(results));
+    _assert_result(results, 0, "bob@ex.org", FALSE, "me: apples and\npears");
+
+    search_results_free(results);
+}
+
+void search_filters_by_contact_and_room(void **state)
+{
+    GSList *results = _search("apples with:bob@ex.org", 10);
+    assert_int_equal(3, g_slist_length(results));
+    search_results_free(results);
+
+    results = _search("apples room:fruit@conf.ex.org", 10);
+    assert_int_equal(1, g_slist_length(results));
+    _assert_result(results, 0, "fruit@conf.ex.org", TRUE, "alice: apples in the room");
+    search_results_free(results);
+}
+
+void search_filters_by_date(void **state)
+{
+    GSList *results = _search("apples since:2019-01-02 until:2019-01-02", 10);
+
+    assert_int_equal(1, g_slist_length(results));
+    _assert_result(results, 0, "bob@ex.org", FALSE, "bob@ex.org: more apples");
+
+    search_results_free(results);
+}
+
+void search_without_matches_is_empty(void **state)
+{
+    GSList *results = _search("bananas", 10);
+
+    assert_null(results);
+}
+
+void search_matches_continuation_written_later(void **state)
+{
+    _write_log(BOB_LOGS, "2019_01_02.log",
+        "09:00:00 - bob@ex.org: more apples\n"
+        "and bananas\n");
+    search_log_updated(BOB_LOGS "/2019_01_02.log");
+    _wait_for("bananas", 1);
+
+    GSList *results = _search("apples bananas", 10);
+    assert_int_equal(1, g_slist_length(results));
+    _assert_result(results, 0, "bob@ex.org", FALSE, "bob@ex.org: more apples\nand bananas");
+    search_results_free(results);
+
+    // the message indexed again is only found once
+    results = _search("apples since:2019-01-02 until:2019-01-02", 10);
+    assert_int_equal(1, g_slist_length(results));
+    search_results_free(results);
+}
+
+void search_keeps_results_across_merges(void **state)
+{
+    int i;
+    for (i = 0; i < 10; i++) {
+        // closing writes the pending postings to a segment
+        search_close();
+        gchar *name = g_strdup_printf("2019_02_%02d.log", i + 1);
+        gchar *contents = g_strdup_printf("11:00:00 - alice: word%d shared\n", i);
+        _write_log(ROOM_LOGS, name, contents);
+        g_free(contents);
+        g_free(name);
+        search_init();
+        _wait_for("shared", i + 1);
+    }
+    search_close();
+    search_init();
+
+    _wait_for("shared", 10);
+    _wait_for("apples", 4);
+    for (i = 0; i < 10; i++) {
+        gchar *word = g_strdup_printf("word%d", i);
+        GSList *results = _search(word, 10);
+        assert_int_equal(1, g_slist_length(results));
+        search_results_free(results);
+        g_free(word);
+    }
+
+    // segments of a similar size were merged
+    int segments = 0;
+    GDir *dir = g_dir_open(DATA_DIR "/searchindex", 0, NULL);
+    assert_non_null(dir);
+    const gchar *name;
+    while ((name = g_dir_read_name(dir)) != NULL) {
+        if (g_str_has_prefix(name, "segment-")) {
+            segments++;
+        }
+    }
+    g_dir_close(dir);
+    assert_true(segments > 0);
+    assert_true(segments < 10);
+}
@@ -0,0 +1,21 @@
+void search_setup(void **state);
+void search_teardown(void **state);
+
+void query_splits_terms_on_punctuation(void **state);
+void query_drops_single_character_terms(void **state);
+void query_truncates_long_terms(void **state);
+void query_lowercases_multibyte_terms(void **state);
+void query_splits_terms_on_invalid_utf8(void **state);
+void query_parses_filters(void **state);
+void query_without_dates_matches_all_days(void **state);
+void query_with_invalid_date_is_null(void **state);
+void query_without_terms_is_null(void **state);
+void search_returns_most_recent_oldest_first(void **state);
+void search_orders_messages_of_a_day_as_logged(void **state);
+void search_matches_all_terms(void **state);
+void search_matches_continuation_lines(void **state);
+void search_filters_by_contact_and_room(void **state);
+void search_filters_by_date(void **state);
+void search_without_matches_is_empty(void **state);
+void search_matches_continuation_written_later(void **state);
+void search_keeps_results_across_merges(void **state);
@@ -0,0 +1,205 @@
+#include "config.h"
+
+#include <glib.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#ifdef HAVE_NCURSESW_NCURSES_H
+#include <ncursesw/ncurses.h>
+#elif HAVE_NCURSES_H
+#include <ncurses.h>
+#endif
+
+#include "helpers.h"
+#include "common.h"
+#include "config/preferences.h"
+#include "config/theme.h"
+#include "config/color.h"
+
+#define THEMES_DIR "./tests/files/xdg_config_home/profanity/themes"
+
+static const char *nicks[] = { "alice", "bob", "carol", "dave", "eve", "mallory", "trent", "peggy" };
+#define NICK_COUNT (sizeof(nicks) / sizeof(nicks[0]))
+
+static short
+_pair_fg(int attrs)
+{
+    short fg, bg;
+    assert_int_equal(OK, pair_content(PAIR_NUMBER(attrs), &fg, &bg));
+    return fg;
+}
+
+static void
+_assert_pair(int pair, short expected_fg, short expected_bg)
+{
+    short fg, bg;
+    assert_int_equal(OK, pair_content(pair, &fg, &bg));
+    assert_int_equal(expected_fg, fg);
+    assert_int_equal(expected_bg, bg);
+}
+
+// the colour each nick hashes to when nothing is cached
+static void
+_uncached_nick_colours(short *colours)
+{
+    guint i;
+    for (i = 0; i < NICK_COUNT; i++) {
+        theme_init_colours();
+        colours[i] = _pair_fg(theme_hash_attrs(nicks[i]));
+    }
+    theme_init_colours();
+}
+
+void theme_setup(void **state)
+{
+    load_preferences(state);
+    start_colours(state);
+    theme_init("default");
+    theme_init_colours();
+}
+
+void theme_teardown(void **state)
+{
+    theme_close();
+    remove(THEMES_DIR "/bright");
+    rmdir(THEMES_DIR);
+    stop_colours(state);
+    close_preferences(state);
+}
+
+void theme_attrs_resolve_theme_colours(void **state)
+{
+    int error = theme_attrs(THEME_ERROR);
+
+    assert_int_equal(COLOR_PAIR(color_pair_cache_get("red_default")), error);
+    assert_int_equal(COLOR_PAIR(color_pair_cache_get("green_default")), theme_attrs(THEME_ONLINE));
+    assert_int_equal(COLOR_PAIR(color_pair_cache_get("white_blue")), theme_attrs(THEME_TITLE_TEXT));
+    assert_int_equal(error, theme_attrs(THEME_ERROR));
+}
+
+void theme_attrs_follow_theme_load(void **state)
+{
+    int text = theme_attrs(THEME_TEXT);
+    assert_int_equal(0, text & A_BOLD);
+
+    assert_true(mkdir_recursive(THEMES_DIR));
+    assert_true(g_file_set_contents(THEMES_DIR "/bright", "[colours]\nmain.text=bold_magenta\n", -1, NULL));
+    assert_true(theme_load("bright"));
+
+    text = theme_attrs(THEME_TEXT);
+    assert_int_equal(COLOR_PAIR(color_pair_cache_get("magenta_default")) | A_BOLD, text);
+}
+
+void theme_attrs_follow_colour_reset(void **state)
+{
+    // pairs are numbered in the order they are first used
+    int error = theme_attrs(THEME_ERROR);
+    int online = theme_attrs(THEME_ONLINE);
+    assert_int_not_equal(error, online);
+
+    theme_init_colours();
+
+    assert_int_equal(error, theme_attrs(THEME_ONLINE));
+    assert_int_equal(COLOR_PAIR(color_pair_cache_get("red_default")), theme_attrs(THEME_ERROR));
+}
+
+void theme_hash_attrs_match_uncached_colours(void **state)
+{
+    short expected[NICK_COUNT];
+    _uncached_nick_colours(expected);
+
+    int attrs[NICK_COUNT];
+    int i;
+    for (i = NICK_COUNT - 1; i >= 0; i--) {
+        attrs[i] = theme_hash_attrs(nicks[i]);
+        assert_int_equal(expected[i], _pair_fg(attrs[i]));
+    }
+
+    int round;
+    for (round = 0; round < 3; round++) {
+        for (i = 0; i < NICK_COUNT; i++) {
+            assert_int_equal(attrs[i], theme_hash_attrs(nicks[i]));
+        }
+    }
+}
+
+void theme_hash_attrs_follow_colour_profile(void **state)
+{
+    short plain[NICK_COUNT];
+    _uncached_nick_colours(plain);
+    prefs_set_string(PREF_COLOR_NICK, "redgreen");
+    short redgreen[NICK_COUNT];
+    _uncached_nick_colours(redgreen);
+    prefs_set_string(PREF_COLOR_NICK, "false");
+
+    // carol's hue is moved to the other half of the wheel
+    assert_int_not_equal(plain[2], redgreen[2]);
+
+    guint i;
+    for (i = 0; i < NICK_COUNT; i++) {
+        assert_int_equal(plain[i], _pair_fg(theme_hash_attrs(nicks[i])));
+    }
+    prefs_set_string(PREF_COLOR_NICK, "redgreen");
+    for (i = 0; i < NICK_COUNT; i++) {
+        assert_int_equal(redgreen[i], _pair_fg(theme_hash_attrs(nicks[i])));
+    }
+    prefs_set_string(PREF_COLOR_NICK, "false");
+    for (i = 0; i < NICK_COUNT; i++) {
+        assert_int_equal(plain[i], _pair_fg(theme_hash_attrs(nicks[i])));
+    }
+}
+
+void theme_hash_attrs_cleared_on_theme_load(void **state)
+{
+    int bob = theme_hash_attrs("bob");
+    short colour = _pair_fg(bob);
+
+    assert_true(mkdir_recursive(THEMES_DIR));
+    assert_true(g_file_set_contents(THEMES_DIR "/bright", "[colours]\nmain.text=bold_magenta\n", -1, NULL));
+    assert_true(theme_load("bright"));
+
+    // the pair bob had is given to the first pair used after the load
+    assert_int_equal(PAIR_NUMBER(bob), color_pair_cache_get("red_blue"));
+    assert_int_equal(colour, _pair_fg(theme_hash_attrs("bob")));
+}
+
+void colour_pair_index_matches_uncached_pairs(void **state)
+{
+    const char *names[] = { "red_blue", "blue_red", "white_default", "default_green", "lightred_black" };
+    const short colours[][2] = { { 1, 4 }, { 4, 1 }, { 7, -1 }, { -1, 2 }, { 9, 0 } };
+    int pairs[5];
+
+    int i;
+    for (i = 0; i < 5; i++) {
+        pairs[i] = color_pair_cache_get(names[i]);
+        assert_true(pairs[i] > 0);
+        _assert_pair(pairs[i], colours[i][0], colours[i][1]);
+    }
+
+    int j;
+    for (i = 0; i < 5; i++) {
+        assert_int_equal(pairs[i], color_pair_cache_get(names[i]));
+        for (j = i + 1; j < 5; j++) {
+            assert_int_not_equal(pairs[i], pairs[j]);
+        }
+    }
+    assert_int_equal(0, color_pair_cache_get("default_default"));
+}
+
+void colour_pair_index_cleared_on_colour_reset(void **state)
+{
+    int red_blue = color_pair_cache_get("red_blue");
+    int blue_red = color_pair_cache_get("blue_red");
+
+    theme_init_colours();
+
+    // pairs are numbered afresh in the order they are used
+    assert_int_equal(red_blue, color_pair_cache_get("blue_red"));
+    assert_int_equal(blue_red, color_pair_cache_get("red_blue"));
+    _assert_pair(red_blue, 4, 1);
+    _assert_pair(blue_red, 1, 4);
+}
@@ -0,0 +1,11 @@
+void theme_setup(void **state);
+void theme_teardown(void **state);
+
+void theme_attrs_resolve_theme_colours(void **state);
+void theme_attrs_follow_theme_load(void **state);
+void theme_attrs_follow_colour_reset(void **state);
+void theme_hash_attrs_match_uncached_colours(void **state);
+void theme_hash_attrs_follow_colour_profile(void **state);
+void theme_hash_attrs_cleared_on_theme_load(void **state);
+void colour_pair_index_matches_uncached_pairs(void **state);
+void colour_pair_index_cleared_on_colour_reset(void **state);
@@ -0,0 +1,179 @@
+#include <glib.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <stdlib.h>
+
+#include "tools/worker.h"
+
+typedef struct test_job_t {
+    int num;
+    int delay;
+    gint release;
+    gint ran;
+    GSList **run_order;
+    GSList **done_order;
+} TestJob;
+
+static void
+_run(void *data)
+{
+    TestJob *job = data;
+    while (!g_atomic_int_get(&job->release)) {
+        g_usleep(1000);
+    }
+    g_usleep(job->delay * 1000);
+    if (job->run_order) {
+        *job->run_order = g_slist_append(*job->run_order, GINT_TO_POINTER(job->num));
+    }
+    g_atomic_int_set(&job->ran, 1);
+}
+
+static void
+_done(void *data)
+{
+    TestJob *job = data;
+    if (job->done_order) {
+        *job->done_order = g_slist_append(*job->done_order, GINT_TO_POINTER(job->num));
+    }
+}
+
+static void
+_job_init(TestJob *job, int num, gboolean release, GSList **run_order, GSList **done_order)
+{
+    job->num = num;
+    job->delay = 0;
+    job->release = release;
+    job->ran = 0;
+    job->run_order = run_order;
+    job->done_order = done_order;
+}
+
+static int
+_poll_until(Worker worker, int expected)
+{
+    int count = 0;
+    int tries = 0;
+    while (count < expected && tries++ < 5000) {
+        count += worker_poll(worker);
+        if (count < expected) {
+            g_usleep(1000);
+        }
+    }
+
+    return count;
+}
+
+void done_callbacks_run_in_submit_order(void **state)
+{
+    GSList *run_order = NULL;
+    GSList *done_order = NULL;
+    TestJob jobs[5];
+    Worker worker = worker_new();
+
+    int i;
+    for (i = 0; i < 5; i++) {
+        _job_init(&jobs[i], i, TRUE, &run_order, &done_order);
+        worker_submit(worker, _run, _done, &jobs[i]);
+    }
+
+    assert_int_equal(5, _poll_until(worker, 5));
+
+    assert_int_equal(5, g_slist_length(run_order));
+    assert_int_equal(5, g_slist_length(done_order));
+    for (i = 0; i < 5; i++) {
+        assert_int_equal(i, GPOINTER_TO_INT(g_slist_nth_data(run_order, i)));
+        assert_int_equal(i, GPOINTER_TO_INT(g_slist_nth_data(done_order, i)));
+    }
+
+    worker_free(worker);
+    g_slist_free(run_order);
+    g_slist_free(done_order);
+}
+
+void poll_runs_nothing_before_job_finishes(void **state)
+{
+    GSList *done_order = NULL;
+    TestJob job;
+    _job_init(&job, 1, FALSE, NULL, &done_order);
+    Worker worker = worker_new();
+
+    worker_submit(worker, _run, _done, &job);
+    g_usleep(10000);
+
+    assert_int_equal(0, worker_poll(worker));
+    assert_null(done_order);
+
+    g_atomic_int_set(&job.release, 1);
+    assert_int_equal(1, _poll_until(worker, 1));
+    assert_int_equal(1, g_slist_length(done_order));
+
+    worker_free(worker);
+    g_slist_free(done_order);
+}
+
+void pending_counts_jobs_until_done_called(void **state)
+{
+    TestJob first;
+    TestJob second;
+    _job_init(&first, 1, FALSE, NULL, NULL);
+    _job_init(&second, 2, TRUE, NULL, NULL);
+    Worker worker = worker_new();
+
+    assert_int_equal(0, worker_pending(worker));
+
+    worker_submit(worker, _run, _done, &first);
+    worker_submit(worker, _run, NULL, &second);
+    assert_int_equal(2, worker_pending(worker));
+
+    g_atomic_int_set(&first.release, 1);
+    assert_int_equal(2, _poll_until(worker, 2));
+    assert_int_equal(0, worker_pending(worker));
+
+    worker_free(worker);
+}
+
+void free_waits_for_running_job(void **state)
+{
+    GSList *done_order = NULL;
+    TestJob job;
+    _job_init(&job, 1, TRUE, NULL, &done_order);
+    job.delay = 50;
+    Worker worker = worker_new();
+
+    worker_submit(worker, _run, _done, &job);
+    g_usleep(10000);
+    assert_int_equal(0, g_atomic_int_get(&job.ran));
+
+    worker_free(worker);
+
+    assert_int_equal(1, g_atomic_int_get(&job.ran));
+    assert_int_equal(1, g_slist_length(done_order));
+
+    g_slist_free(done_order);
+}
+
+void free_runs_done_of_queued_jobs(void **state)
+{
+    GSList *run_order = NULL;
+    GSList *done_order = NULL;
+    TestJob jobs[3];
+    Worker worker = worker_new();
+
+    int i;
+    for (i = 0; i < 3; i++) {
+        _job_init(&jobs[i], i, TRUE, &run_order, &done_order);
+        worker_submit(worker, _run, _done, &jobs[i]);
+    }
+    worker_free(worker);
+
+    assert_int_equal(3, g_slist_length(run_order));
+    assert_int_equal(3, g_slist_length(done_order));
+    for (i = 0; i < 3; i++) {
+        assert_int_equal(i, GPOINTER_TO_INT(g_slist_nth_data(done_order, i)));
+    }
+
+    g_slist_free(run_order);
+    g_slist_free(done_order);
+}
@@ -0,0 +1,5 @@
+void done_callbacks_run_in_submit_order(void **state);
+void poll_runs_nothing_before_job_finishes(void **state);
+void pending_counts_jobs_until_done_called(void **state);
+void free_waits_for_running_job(void **state);
+void free_runs_done_of_queued_jobs(void **state);
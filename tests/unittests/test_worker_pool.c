@@ -0,0 +1,145 @@
+#include <glib.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <stdlib.h>
+
+#include "tools/worker_pool.h"
+
+#define JOB_COUNT 500
+
+typedef struct test_state_t {
+    int num;
+    gint calls;
+} TestState;
+
+typedef struct test_jobs_t {
+    gint next;
+    gint ran[JOB_COUNT];
+    TestState *ran_on[JOB_COUNT];
+} TestJobs;
+
+static gint inits;
+static gint frees;
+
+static void*
+_init(void *userdata)
+{
+    int num = g_atomic_int_add(&inits, 1);
+    gboolean *fail_odd = userdata;
+    if (fail_odd && *fail_odd && num % 2 == 1) {
+        return NULL;
+    }
+
+    TestState *state = malloc(sizeof(TestState));
+    state->num = num;
+    state->calls = 0;
+    return state;
+}
+
+static void
+_free_state(void *state)
+{
+    g_atomic_int_inc(&frees);
+    free(state);
+}
+
+static void
+_run(void *state, void *data)
+{
+    TestState *test_state = state;
+    TestJobs *jobs = data;
+    g_atomic_int_inc(&test_state->calls);
+
+    gint i;
+    while ((i = g_atomic_int_add(&jobs->next, 1)) < JOB_COUNT) {
+        g_atomic_int_inc(&jobs->ran[i]);
+        jobs->ran_on[i] = test_state;
+        g_usleep(10);
+    }
+}
+
+static void
+_reset_counts(void)
+{
+    g_atomic_int_set(&inits, 0);
+    g_atomic_int_set(&frees, 0);
+}
+
+void worker_pool_runs_every_job_once(void **state)
+{
+    _reset_counts();
+    WorkerPool pool = worker_pool_new(4, _init, _free_state, NULL);
+    assert_int_equal(4, worker_pool_size(pool));
+
+    TestState caller = { -1, 0 };
+    int run;
+    for (run = 0; run < 20; run++) {
+        TestJobs *jobs = calloc(1, sizeof(TestJobs));
+        worker_pool_run(pool, 4, _run, jobs, &caller);
+        int i;
+        for (i = 0; i < JOB_COUNT; i++) {
+            assert_int_equal(1, jobs->ran[i]);
+        }
+        free(jobs);
+    }
+
+    // the same states serve every run
+    assert_int_equal(4, g_atomic_int_get(&inits));
+    assert_int_equal(20, caller.calls);
+
+    worker_pool_free(pool);
+    assert_int_equal(4, g_atomic_int_get(&frees));
+}
+
+void worker_pool_runs_only_caller_without_workers(void **state)
+{
+    _reset_counts();
+    WorkerPool pool = worker_pool_new(4, _init, _free_state, NULL);
+
+    TestState caller = { -1, 0 };
+    TestJobs *jobs = calloc(1, sizeof(TestJobs));
+    worker_pool_run(pool, 0, _run, jobs, &caller);
+
+    int i;
+    for (i = 0; i < JOB_COUNT; i++) {
+        assert_int_equal(1, jobs->ran[i]);
+        assert_ptr_equal(&caller, jobs->ran_on[i]);
+    }
+    free(jobs);
+
+    worker_pool_free(pool);
+}
+
+void worker_pool_skips_threads_without_state(void **state)
+{
+    _reset_counts();
+    gboolean fail_odd = TRUE;
+    WorkerPool pool = worker_pool_new(4, _init, _free_state, &fail_odd);
+    assert_int_equal(2, worker_pool_size(pool));
+
+    TestState caller = { -1, 0 };
+    TestJobs *jobs = calloc(1, sizeof(TestJobs));
+    worker_pool_run(pool, 4, _run, jobs, &caller);
+
+    int i;
+    for (i = 0; i < JOB_COUNT; i++) {
+        assert_int_equal(1, jobs->ran[i]);
+        assert_true(jobs->ran_on[i] == &caller || jobs->ran_on[i]->num % 2 == 0);
+    }
+    free(jobs);
+
+    worker_pool_free(pool);
+    assert_int_equal(2, g_atomic_int_get(&frees));
+}
+
+void worker_pool_free_without_runs(void **state)
+{
+    _reset_counts();
+    WorkerPool pool = worker_pool_new(3, _init, _free_state, NULL);
+
+    worker_pool_free(pool);
+    assert_int_equal(3, g_atomic_int_get(&frees));
+    worker_pool_free(NULL);
+}
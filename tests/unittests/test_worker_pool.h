@@ -0,0 +1,4 @@
+void worker_pool_runs_every_job_once(void **state);
+void worker_pool_runs_only_caller_without_workers(void **state);
+void worker_pool_skips_threads_without_state(void **state);
+void worker_pool_free_without_runs(void **state);
@@ -53,9 +53,11 @@ expect_win_println(char *message)
 void ui_init(void) {}
 void ui_load_colours(void) {}
 void ui_update(void) {}
+void ui_damage_all(void) {}
 void ui_close(void) {}
 void ui_redraw(void) {}
 void ui_resize(void) {}
+void ui_scrollback_update(void) {}
 
 void ui_focus_win(ProfWin *win) {}
 
@@ -142,6 +144,7 @@ char *ui_get_line(void)
 }
 
 void xmlwin_show(ProfXMLWin *xmlwin, const char * const msg) {}
+void searchwin_search(ProfSearchWin *searchwin, const char *const text) {}
 
 // ui events
 void ui_contact_online(char *barejid, Resource *resource, GDateTime *last_activity)
@@ -290,11 +293,16 @@ void ui_handle_login_account_success(ProfAccount *account, int secured) {}
 void ui_update_presence(const resource_presence_t resource_presence,
     const char * const message, const char * const show) {}
 
-char* inp_readline(void)
+char* inp_readline(gint timeout, int xmpp_fd, int log_fd)
 {
     return NULL;
 }
 
+gint inp_get_timeout(void)
+{
+    return 0;
+}
+
 void inp_nonblocking(gboolean reset) {}
 
 void ui_inp_history_append(char *inp) {}
@@ -448,6 +456,7 @@ void cons_autoping_setting(void) {}
 void cons_autoconnect_setting(void) {}
 void cons_rooms_cache_setting(void) {}
 void cons_inpblock_setting(void) {}
+void cons_scrollback_setting(void) {}
 void cons_winpos_setting(void) {}
 void cons_statusbar_setting(void) {}
 void cons_tray_setting(void) {}
@@ -474,10 +483,12 @@ void status_bar_set_all_inactive(void) {}
 
 // roster window
 void rosterwin_roster(void) {}
+void rosterwin_update(void) {}
 
 // occupants window
 void occupantswin_occupants(const char * const room) {}
 void occupantswin_occupants_all(void) {}
+void occupantswin_cache_free(ProfMucWin *mucwin) {}
 
 // window interface
 ProfWin* win_create_console(void)
@@ -488,6 +499,10 @@ ProfWin* win_create_xmlconsole(void)
 {
     return NULL;
 }
+ProfWin* win_create_search(void)
+{
+    return NULL;
+}
 ProfWin* win_create_chat(const char * const barejid)
 {
     return mock_ptr_type(ProfWin*);
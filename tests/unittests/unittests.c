@@ -38,6 +38,15 @@
 #include "test_form.h"
 #include "test_callbacks.h"
 #include "test_plugins_disco.h"
+#include "test_worker.h"
+#include "test_worker_pool.h"
+#include "test_log_writer.h"
+#include "test_buffer.h"
+#include "test_theme.h"
+#include "test_search.h"
+#include "test_history_file.h"
+#include "test_matcher.h"
+#include "test_keyfile_journal.h"
 
 int main(int argc, char* argv[]) {
     setlocale(LC_ALL, "en_GB.UTF-8");
@@ -105,6 +114,8 @@ int main(int argc, char* argv[]) {
         unit_test(complete_both_with_base),
         unit_test(complete_ignores_case),
         unit_test(complete_previous),
+        unit_test(complete_cycles_in_item_order),
+        unit_test(complete_continues_after_remove_and_add),
 
         unit_test(create_jid_from_null_returns_null),
         unit_test(create_jid_from_empty_string_returns_null),
@@ -215,6 +226,8 @@ int main(int argc, char* argv[]) {
         unit_test(add_contacts_with_same_groups),
         unit_test(add_contacts_with_overlapping_groups),
         unit_test(remove_contact_with_remaining_in_group),
+        unit_test(add_all_adds_contacts_names_and_groups),
+        unit_test(add_all_skips_duplicates),
 
         unit_test_setup_teardown(returns_false_when_chat_session_does_not_exist,
             init_chat_sessions,
@@ -440,6 +453,12 @@ int main(int argc, char* argv[]) {
         unit_test_setup_teardown(statuses_muc_defaults_to_all,
             load_preferences,
             close_preferences),
+        unit_test_setup_teardown(cached_string_updated_when_set,
+            load_preferences,
+            close_preferences),
+        unit_test_setup_teardown(cached_boolean_updated_when_set,
+            load_preferences,
+            close_preferences),
 
         unit_test_setup_teardown(console_shows_online_presence_when_set_online,
             load_preferences,
@@ -481,6 +500,8 @@ int main(int argc, char* argv[]) {
         unit_test_setup_teardown(test_muc_invites_count_5, muc_before_test, muc_after_test),
         unit_test_setup_teardown(test_muc_room_is_not_active, muc_before_test, muc_after_test),
         unit_test_setup_teardown(test_muc_active, muc_before_test, muc_after_test),
+        unit_test_setup_teardown(test_muc_roster_sorted_by_nick, muc_before_test, muc_after_test),
+        unit_test_setup_teardown(test_muc_roster_update_and_remove_keep_order, muc_before_test, muc_after_test),
 
         unit_test(cmd_bookmark_shows_message_when_disconnected),
         unit_test(cmd_bookmark_shows_message_when_disconnecting),
@@ -624,6 +645,100 @@ int main(int argc, char* argv[]) {
         unit_test(does_not_add_duplicate_feature),
         unit_test(removes_plugin_features),
         unit_test(does_not_remove_feature_when_more_than_one_reference),
+
+        unit_test(done_callbacks_run_in_submit_order),
+        unit_test(poll_runs_nothing_before_job_finishes),
+        unit_test(pending_counts_jobs_until_done_called),
+        unit_test(free_waits_for_running_job),
+        unit_test(free_runs_done_of_queued_jobs),
+
+        unit_test(worker_pool_runs_every_job_once),
+        unit_test(worker_pool_runs_only_caller_without_workers),
+        unit_test(worker_pool_skips_threads_without_state),
+        unit_test(worker_pool_free_without_runs),
+
+        unit_test(log_writer_keeps_lines_from_threads_intact),
+        unit_test(log_writer_rotates_without_losing_lines),
+
+        unit_test(append_evicts_oldest_first),
+        unit_test(evicted_entries_discarded_without_spill),
+        unit_test_setup_teardown(evicted_entries_spill_oldest_first, spill_setup, spill_teardown),
+        unit_test_setup_teardown(spilled_entry_reads_back_all_fields, spill_setup, spill_teardown),
+        unit_test_setup_teardown(spilled_entries_follow_resident_ones, spill_setup, spill_teardown),
+        unit_test_setup_teardown(spill_drops_oldest_half_when_full, spill_setup, spill_teardown),
+        unit_test(budget_trims_each_buffer_oldest_first),
+        unit_test(budget_keeps_minimum_resident_entries),
+        unit_test(entries_within_budget_are_kept),
+        unit_test(budget_counts_cached_layouts),
+        unit_test(origin_follows_entries_dropped_and_prepended),
+        unit_test_setup_teardown(origin_unchanged_when_spilling, spill_setup, spill_teardown),
+        unit_test(remove_by_id_keeps_order_of_others),
+        unit_test(remove_by_id_removes_every_duplicate),
+        unit_test(remove_by_id_frees_space_for_appends),
+        unit_test(entry_by_id_follows_eviction_of_duplicates),
+        unit_test(entry_by_id_after_prepend),
+
+        unit_test_setup_teardown(theme_attrs_resolve_theme_colours, theme_setup, theme_teardown),
+        unit_test_setup_teardown(theme_attrs_follow_theme_load, theme_setup, theme_teardown),
+        unit_test_setup_teardown(theme_attrs_follow_colour_reset, theme_setup, theme_teardown),
+        unit_test_setup_teardown(theme_hash_attrs_match_uncached_colours, theme_setup, theme_teardown),
+        unit_test_setup_teardown(theme_hash_attrs_follow_colour_profile, theme_setup, theme_teardown),
+        unit_test_setup_teardown(theme_hash_attrs_cleared_on_theme_load, theme_setup, theme_teardown),
+        unit_test_setup_teardown(colour_pair_index_matches_uncached_pairs, theme_setup, theme_teardown),
+        unit_test_setup_teardown(colour_pair_index_cleared_on_colour_reset, theme_setup, theme_teardown),
+
+        unit_test(query_splits_terms_on_punctuation),
+        unit_test(query_drops_single_character_terms),
+        unit_test(query_truncates_long_terms),
+        unit_test(query_lowercases_multibyte_terms),
+        unit_test(query_splits_terms_on_invalid_utf8),
+        unit_test(query_parses_filters),
+        unit_test(query_without_dates_matches_all_days),
+        unit_test(query_with_invalid_date_is_null),
+        unit_test(query_without_terms_is_null),
+        unit_test_setup_teardown(search_returns_most_recent_oldest_first, search_setup, search_teardown),
+        unit_test_setup_teardown(search_orders_messages_of_a_day_as_logged, search_setup, search_teardown),
+        unit_test_setup_teardown(search_matches_all_terms, search_setup, search_teardown),
+        unit_test_setup_teardown(search_matches_continuation_lines, search_setup, search_teardown),
+        unit_test_setup_teardown(search_filters_by_contact_and_room, search_setup, search_teardown),
+        unit_test_setup_teardown(search_filters_by_date, search_setup, search_teardown),
+        unit_test_setup_teardown(search_without_matches_is_empty, search_setup, search_teardown),
+        unit_test_setup_teardown(search_matches_continuation_written_later, search_setup, search_teardown),
+        unit_test_setup_teardown(search_keeps_results_across_merges, search_setup, search_teardown),
+
+        unit_test(history_reads_messages_oldest_first),
+        unit_test(history_reads_newest_messages_first),
+        unit_test(history_joins_continuation_lines),
+        unit_test(history_reads_lines_straddling_chunks),
+        unit_test(history_reads_message_longer_than_chunk),
+        unit_test(history_reads_multibyte_text_split_by_chunk),
+        unit_test(history_missing_file_is_done),
+        unit_test(history_files_sort_newest_day_first),
+        unit_test(history_counts_messages_not_lines),
+        unit_test(history_index_missing_is_null),
+        unit_test(history_index_keeps_latest_record_of_each_day),
+        unit_test(history_index_ignores_torn_record),
+        unit_test(history_index_append_replaces_day),
+        unit_test(history_index_scan_lists_day_logs),
+        unit_test(history_day_filename_matches_log_name),
+
+        unit_test(matcher_finds_overlapping_occurrences),
+        unit_test(matcher_finds_overlapping_patterns),
+        unit_test(matcher_finds_pattern_that_is_suffix_of_another),
+        unit_test(matcher_finds_pattern_inside_another),
+        unit_test(matcher_ignores_empty_pattern),
+        unit_test(matcher_finds_nothing_in_empty_text),
+        unit_test(matcher_counts_offsets_in_characters),
+        unit_test(matcher_whole_word_needs_boundaries),
+        unit_test(matcher_whole_word_treats_unicode_letters_as_word),
+        unit_test(matcher_mixes_whole_word_and_partial_patterns),
+        unit_test(matcher_rebuilds_after_add),
+
+        unit_test(keyfile_journal_replays_records_over_store),
+        unit_test(keyfile_journal_replays_without_store),
+        unit_test(keyfile_journal_cuts_torn_final_record),
+        unit_test(keyfile_journal_compacts_into_store),
+        unit_test(keyfile_journal_keeps_unreadable_store),
     };
 
     return run_tests(all_tests);
@@ -9,6 +9,10 @@
 void session_init(void) {}
 void session_init_activity(void) {}
 void session_check_autoaway(void) {}
+gboolean session_reconnect_pending(void)
+{
+    return FALSE;
+}
 
 jabber_conn_status_t session_connect_with_details(const char * const jid,
     const char * const passwd, const char * const altdomain, const int port, const char *const tls_policy)
@@ -63,6 +67,11 @@ jabber_conn_status_t connection_get_status(void)
     return mock_type(jabber_conn_status_t);
 }
 
+int connection_get_fd(void)
+{
+    return -1;
+}
+
 char* connection_get_presence_msg(void)
 {
     return mock_ptr_type(char*);